@@ -25,6 +25,7 @@
     [TMAPIClient sharedInstance].OAuthConsumerSecret = @"";
     [TMAPIClient sharedInstance].OAuthToken = @"";
     [TMAPIClient sharedInstance].OAuthTokenSecret = @"";
+    [[TMAPIClient sharedInstance] prewarmConnections];
     
     self.window = [[UIWindow alloc] initWithFrame:[[UIScreen mainScreen] bounds]];
     self.window.rootViewController = [[UINavigationController alloc] initWithRootViewController:[[TMDashboardViewController alloc] init]];
@@ -6,6 +6,8 @@
 //  Copyright (c) 2014 Tumblr. All rights reserved.
 //
 
+@class TMCancellationToken;
+
 typedef void (^TMCoreDataControllerBlock)(NSManagedObjectContext *context);
 
 /**
@@ -33,6 +35,16 @@ typedef void (^TMCoreDataControllerBlock)(NSManagedObjectContext *context);
  */
 - (void)performBackgroundBlockAndWait:(TMCoreDataControllerBlock)block;
 
+/**
+ *  Like `performBackgroundBlockAndWait:`, except that the block is skipped if the token has already been cancelled or 
+ *  has expired, and the context is rolled back instead of saved if that happens while the block is being performed. 
+ *  Long-running blocks should also check the token between units of work.
+ *
+ *  @param block Block provided with a private queue context and performed on the aforementioned queue.
+ *  @param token Token for the work the block belongs to, or `nil`.
+ */
+- (void)performBackgroundBlockAndWait:(TMCoreDataControllerBlock)block token:(TMCancellationToken *)token;
+
 /**
  *  Provides a block with the main queue context and performs the block on the main queue, synchronously.
  *  Saves the context (and any ancestor contexts, recursively) afterwards.
@@ -7,6 +7,7 @@
 //
 
 #import "TMCoreDataController.h"
+#import "TMCancellationToken.h"
 
 static NSString * const ManagedObjectModelResourceName = @"CoreDataExample";
 static NSString * const ManagedObjectModelExtension = @"momd";
@@ -130,6 +131,18 @@ static NSString * const PersistentStorePath = @"Tumblr.sqlite";
  *  parent context(s) (recursively).
  */
 - (void)performBackgroundBlockAndWait:(TMCoreDataControllerBlock)block {
+    [self performBackgroundBlockAndWait:block token:nil];
+}
+
+/**
+ *  Perform a block on a new context unless the token has been cancelled or has expired, and then save the context as 
+ *  well as its parent context(s) (recursively) unless that has happened in the meantime.
+ */
+- (void)performBackgroundBlockAndWait:(TMCoreDataControllerBlock)block token:(TMCancellationToken *)token {
+    if (token.error) {
+        return;
+    }
+    
     NSManagedObjectContext *backgroundContext = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSPrivateQueueConcurrencyType];
     backgroundContext.parentContext = self.mainContext;
     
@@ -137,6 +150,12 @@ static NSString * const PersistentStorePath = @"Tumblr.sqlite";
         [backgroundContext performBlockAndWait:^{
             block(backgroundContext);
             
+            // Changes made for work that is no longer wanted never reach the main context or the store
+            if (token.error) {
+                [backgroundContext rollback];
+                return;
+            }
+            
             [self saveContext:backgroundContext];
         }];
     }
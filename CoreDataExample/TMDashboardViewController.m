@@ -8,14 +8,21 @@
 
 #import "TMDashboardViewController.h"
 #import "TMFetchedResultsControllerDelegate.h"
+#import "TMPrefetchScheduler.h"
 #import "TMPost.h"
 #import "TMAPIClient.h"
 #import "TMCoreDataController.h"
 
+static NSUInteger const TMDashboardImportBatchSize = 10;
+
+static NSTimeInterval const TMDashboardRefreshTimeout = 30;
+
 @interface TMDashboardViewController()
 
 @property (nonatomic) NSFetchedResultsController *fetchedResultsController;
 @property (nonatomic) TMFetchedResultsControllerDelegate *fetchedResultsControllerDelegate;
+@property (nonatomic) TMPrefetchScheduler *prefetchScheduler;
+@property (nonatomic) dispatch_queue_t importQueue;
 
 @end
 
@@ -24,6 +31,7 @@
 - (id)initWithStyle:(UITableViewStyle)style {
     if (self = [super initWithStyle:style]) {
         self.title = @"Dashboard";
+        self.importQueue = dispatch_queue_create("com.tumblr.CoreDataExample.import", DISPATCH_QUEUE_SERIAL);
     }
     
     return self;
@@ -47,34 +55,61 @@
 
     [self.fetchedResultsController performFetch:nil];
     
+    self.prefetchScheduler = [[TMPrefetchScheduler alloc] initWithTableView:self.tableView
+                                                   fetchedResultsController:self.fetchedResultsController];
+    
     [self refresh];
 }
 
+- (void)viewDidDisappear:(BOOL)animated {
+    [super viewDidDisappear:animated];
+    
+    // Nothing still downloading, parsing or importing is of use once the dashboard is gone
+    if ([self isMovingFromParentViewController] || [self isBeingDismissed]) {
+        [[TMAPIClient sharedInstance] cancelRequestsForOwner:self];
+    }
+}
+
 #pragma mark - Actions
 
 - (void)refresh {
-    [[TMAPIClient sharedInstance] dashboard:nil callback:^(NSDictionary *response, NSError *error) {
-        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-            [[TMCoreDataController sharedInstance] performBackgroundBlockAndWait:^(NSManagedObjectContext *context) {
-                // Delete all existing posts
-                
-                NSArray *cachedPosts = [context executeFetchRequest:[TMPost allPostsFetchRequest] error:nil];
-                
-                for (TMPost *cachedPost in [cachedPosts reverseObjectEnumerator]) {
-                    [context deleteObject:cachedPost];
-                }
-                
-                // Create new posts out of API response
-                
-                NSArray *responsePostDictionaries = response[@"posts"];
-                
-                for (NSDictionary *responsePostDictionary in responsePostDictionaries) {
-                    [context insertObject:[TMPost postFromDictionary:responsePostDictionary inContext:context]];
-                }
-            }];
+    /*
+     Posts are imported in batches as they stream in, so that downloading, parsing, and inserting overlap. Each batch 
+     replaces the cached copies of its own posts; the remaining cached posts are only deleted once the whole response 
+     has been received and its `meta.status` checked, so a bad response never empties the dashboard.
+     */
+    
+    dispatch_queue_t importQueue = self.importQueue;
+    NSMutableArray *pendingPostDictionaries = [NSMutableArray array];
+    NSMutableSet *refreshedPostIDs = [NSMutableSet set];
+    
+    TMCancellationToken *token = [[[TMAPIClient sharedInstance] cancellationTokenForOwner:self]
+                                  childTokenWithTimeout:TMDashboardRefreshTimeout];
+    
+    [[TMAPIClient sharedInstance] dashboard:nil token:token postBlock:^(NSDictionary *postDictionary) {
+        [pendingPostDictionaries addObject:postDictionary];
+        
+        if ([pendingPostDictionaries count] == TMDashboardImportBatchSize) {
+            NSArray *batch = [pendingPostDictionaries copy];
+            [pendingPostDictionaries removeAllObjects];
+            
+            dispatch_async(importQueue, ^{
+                [self importPostDictionaries:batch refreshedPostIDs:refreshedPostIDs token:token];
+            });
+        }
+    } callback:^(id response, NSError *error) {
+        NSArray *batch = [pendingPostDictionaries copy];
+        
+        dispatch_async(importQueue, ^{
+            [self importPostDictionaries:batch refreshedPostIDs:refreshedPostIDs token:token];
+            
+            if (!error) {
+                [self deleteCachedPostsExceptPostIDs:refreshedPostIDs token:token];
+            }
             
             dispatch_async(dispatch_get_main_queue(), ^{
                 [self.refreshControl endRefreshing];
+                [self.prefetchScheduler updatePrefetchWindow];
             });
         });
     }];
@@ -104,7 +139,101 @@
     cell.textLabel.text = post.blogName;
     cell.detailTextLabel.text = post.postID;
     
+    NSData *avatarData = [self.prefetchScheduler cachedAvatarDataForBlogName:post.blogName];
+    cell.imageView.image = avatarData ? [UIImage imageWithData:avatarData] : nil;
+    
+    if (!avatarData) {
+        NSString *blogName = post.blogName;
+        
+        [self.prefetchScheduler fetchAvatarDataForBlogName:blogName callback:^(NSData *data) {
+            if (data) {
+                [self showAvatarData:data forBlogName:blogName];
+            }
+        }];
+    }
+    
     return cell;
 }
 
+#pragma mark - UIScrollViewDelegate
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView {
+    [self.prefetchScheduler scrollViewDidScroll:scrollView];
+}
+
+#pragma mark - Private
+
+/**
+ *  Insert posts, replacing any cached copies of them, and add their IDs to `refreshedPostIDs`. Must be called on the 
+ *  import queue.
+ */
+- (void)importPostDictionaries:(NSArray *)postDictionaries refreshedPostIDs:(NSMutableSet *)refreshedPostIDs
+                         token:(TMCancellationToken *)token {
+    if (![postDictionaries count]) {
+        return;
+    }
+    
+    NSMutableArray *postIDs = [NSMutableArray arrayWithCapacity:[postDictionaries count]];
+    
+    for (NSDictionary *postDictionary in postDictionaries) {
+        NSString *postID = [postDictionary[@"id"] stringValue];
+        
+        if (postID) {
+            [postIDs addObject:postID];
+        }
+    }
+    
+    [[TMCoreDataController sharedInstance] performBackgroundBlockAndWait:^(NSManagedObjectContext *context) {
+        NSFetchRequest *fetchRequest = [TMPost allPostsFetchRequest];
+        fetchRequest.predicate = [NSPredicate predicateWithFormat:@"postID IN %@", postIDs];
+        
+        for (TMPost *cachedPost in [context executeFetchRequest:fetchRequest error:nil]) {
+            [context deleteObject:cachedPost];
+        }
+        
+        for (NSDictionary *postDictionary in postDictionaries) {
+            if (token.error) {
+                break;
+            }
+            
+            [context insertObject:[TMPost postFromDictionary:postDictionary inContext:context]];
+        }
+    } token:token];
+    
+    if (!token.error) {
+        [refreshedPostIDs addObjectsFromArray:postIDs];
+    }
+}
+
+/**
+ *  Delete every cached post that the latest refresh didn't return. Must be called on the import queue.
+ */
+- (void)deleteCachedPostsExceptPostIDs:(NSSet *)postIDs token:(TMCancellationToken *)token {
+    [[TMCoreDataController sharedInstance] performBackgroundBlockAndWait:^(NSManagedObjectContext *context) {
+        NSFetchRequest *fetchRequest = [TMPost allPostsFetchRequest];
+        fetchRequest.predicate = [NSPredicate predicateWithFormat:@"postID != nil AND NOT (postID IN %@)", postIDs];
+        
+        for (TMPost *cachedPost in [context executeFetchRequest:fetchRequest error:nil]) {
+            [context deleteObject:cachedPost];
+        }
+    } token:token];
+}
+
+/**
+ *  Set an avatar on every visible cell displaying a post from the given blog.
+ */
+- (void)showAvatarData:(NSData *)data forBlogName:(NSString *)blogName {
+    UIImage *image = [UIImage imageWithData:data];
+    
+    for (NSIndexPath *indexPath in [self.tableView indexPathsForVisibleRows]) {
+        TMPost *post = [self.fetchedResultsController objectAtIndexPath:indexPath];
+        
+        if ([post.blogName isEqualToString:blogName]) {
+            UITableViewCell *cell = [self.tableView cellForRowAtIndexPath:indexPath];
+            cell.imageView.image = image;
+            [cell setNeedsLayout];
+        }
+    }
+}
+
 @end
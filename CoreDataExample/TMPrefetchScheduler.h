@@ -0,0 +1,78 @@
+//
+//  TMPrefetchScheduler.h
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+typedef void (^TMPrefetchSchedulerCallback)(NSData *data);
+
+/**
+ *  Fetches blog avatars for rows that are about to scroll on screen, ahead of `tableView:cellForRowAtIndexPath:` being
+ *  called for them.
+ *
+ *  The look-ahead window grows with scroll velocity and is biased in the direction of travel. Fetches for rows that
+ *  leave the window before they start are dropped, and in-flight fetches for them are cancelled.
+ *
+ *  Prefetches run on a private low-priority queue and are bounded by both `maximumConcurrentPrefetchCount` and
+ *  `maximumPrefetchBytesInFlight`. No new prefetch is started while a request on `TMAPIClient`'s queue is waiting for
+ *  a slot, or while starting one would leave the API host with fewer than two free connections, so that prefetching
+ *  never delays interactive requests.
+ *
+ *  All methods must be called on the main thread.
+ */
+@interface TMPrefetchScheduler : NSObject
+
+/// Avatar size (in pixels) requested from the API. Default: 64
+@property (nonatomic) NSUInteger avatarSize;
+
+/// Number of rows past the visible range to prefetch while stationary. Default: 5
+@property (nonatomic) NSUInteger minimumLookaheadRowCount;
+
+/// Upper bound on the number of rows past the visible range to prefetch while scrolling quickly. Default: 40
+@property (nonatomic) NSUInteger maximumLookaheadRowCount;
+
+/// Seconds of scrolling (at the current velocity) that the look-ahead window should cover. Default: 1.0
+@property (nonatomic) NSTimeInterval lookaheadInterval;
+
+/// Maximum number of prefetches executing at once. Default: 2
+@property (nonatomic) NSUInteger maximumConcurrentPrefetchCount;
+
+/// Maximum number of response bytes (expected or received) that in-flight prefetches may account for. Default: 256 KB
+@property (nonatomic) long long maximumPrefetchBytesInFlight;
+
+/// Maximum number of bytes of avatar data kept in memory. Default: 4 MB
+@property (nonatomic) NSUInteger maximumCachedBytes;
+
+- (instancetype)initWithTableView:(UITableView *)tableView fetchedResultsController:(NSFetchedResultsController *)controller;
+
+/**
+ *  Avatar data for a blog if it has already been fetched, otherwise `nil`.
+ */
+- (NSData *)cachedAvatarDataForBlogName:(NSString *)blogName;
+
+/**
+ *  Fetch a blog's avatar for a row that is on screen now. If a prefetch for the blog is already in flight the callback
+ *  is attached to it, otherwise the avatar is requested through `TMAPIClient`'s (interactive) queue.
+ *
+ *  @param callback Called on the main queue, with `nil` if the avatar could not be fetched.
+ */
+- (void)fetchAvatarDataForBlogName:(NSString *)blogName callback:(TMPrefetchSchedulerCallback)callback;
+
+/**
+ *  Recompute the look-ahead window. Should be called from the table view delegate's `scrollViewDidScroll:`.
+ */
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView;
+
+/**
+ *  Recompute the look-ahead window without updating the scroll velocity, e.g. after the table view is reloaded.
+ */
+- (void)updatePrefetchWindow;
+
+/**
+ *  Cancel all pending and in-flight prefetches.
+ */
+- (void)cancelAllPrefetches;
+
+@end
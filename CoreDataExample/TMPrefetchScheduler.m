@@ -0,0 +1,386 @@
+//
+//  TMPrefetchScheduler.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMPrefetchScheduler.h"
+#import "TMAPIClient.h"
+#import "TMPost.h"
+
+static NSUInteger const TMPrefetchSchedulerDefaultAvatarSize = 64;
+static NSUInteger const TMPrefetchSchedulerDefaultMinimumLookaheadRowCount = 5;
+static NSUInteger const TMPrefetchSchedulerDefaultMaximumLookaheadRowCount = 40;
+static NSTimeInterval const TMPrefetchSchedulerDefaultLookaheadInterval = 1.0;
+static NSUInteger const TMPrefetchSchedulerDefaultMaximumConcurrentPrefetchCount = 2;
+static long long const TMPrefetchSchedulerDefaultMaximumPrefetchBytesInFlight = 256 * 1024;
+static NSUInteger const TMPrefetchSchedulerDefaultMaximumCachedBytes = 4 * 1024 * 1024;
+
+/// Scroll events further apart than this are treated as the start of a new gesture, rather than used for velocity
+static NSTimeInterval const TMPrefetchSchedulerVelocitySampleTimeout = 0.25;
+
+/// How long to wait before retrying when prefetching is held back by interactive requests
+static NSTimeInterval const TMPrefetchSchedulerRetryInterval = 0.25;
+
+static CGFloat const TMPrefetchSchedulerDefaultRowHeight = 44;
+
+/// Connections to the API host that prefetches never take, so that a user-visible request can always start right away
+static NSUInteger const TMPrefetchSchedulerReservedConnectionCount = 2;
+
+@interface TMPrefetchScheduler()
+
+@property (nonatomic, weak) UITableView *tableView;
+@property (nonatomic, weak) NSFetchedResultsController *fetchedResultsController;
+@property (nonatomic) NSCache *avatarCache;
+@property (nonatomic) JXHTTPOperationQueue *prefetchQueue;
+@property (nonatomic) NSMutableOrderedSet *pendingBlogNames;
+@property (nonatomic) NSMutableDictionary *prefetchOperations;
+@property (nonatomic) NSMutableDictionary *callbacks;
+@property (nonatomic) CGFloat lastContentOffset;
+@property (nonatomic) NSTimeInterval lastScrollTimestamp;
+@property (nonatomic) CGFloat scrollVelocity;
+@property (nonatomic) BOOL retryScheduled;
+
+@end
+
+@implementation TMPrefetchScheduler
+
+- (instancetype)initWithTableView:(UITableView *)tableView fetchedResultsController:(NSFetchedResultsController *)controller {
+    if (self = [super init]) {
+        _tableView = tableView;
+        _fetchedResultsController = controller;
+
+        _avatarSize = TMPrefetchSchedulerDefaultAvatarSize;
+        _minimumLookaheadRowCount = TMPrefetchSchedulerDefaultMinimumLookaheadRowCount;
+        _maximumLookaheadRowCount = TMPrefetchSchedulerDefaultMaximumLookaheadRowCount;
+        _lookaheadInterval = TMPrefetchSchedulerDefaultLookaheadInterval;
+        _maximumConcurrentPrefetchCount = TMPrefetchSchedulerDefaultMaximumConcurrentPrefetchCount;
+        _maximumPrefetchBytesInFlight = TMPrefetchSchedulerDefaultMaximumPrefetchBytesInFlight;
+
+        _avatarCache = [[NSCache alloc] init];
+        _avatarCache.totalCostLimit = TMPrefetchSchedulerDefaultMaximumCachedBytes;
+
+        _prefetchQueue = [[JXHTTPOperationQueue alloc] init];
+        _prefetchQueue.maxConcurrentOperationCount = (NSInteger)_maximumConcurrentPrefetchCount;
+
+        _pendingBlogNames = [[NSMutableOrderedSet alloc] init];
+        _prefetchOperations = [[NSMutableDictionary alloc] init];
+        _callbacks = [[NSMutableDictionary alloc] init];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_prefetchQueue cancelAllOperations];
+}
+
+#pragma mark - Accessors
+
+- (NSUInteger)maximumCachedBytes {
+    return self.avatarCache.totalCostLimit;
+}
+
+- (void)setMaximumCachedBytes:(NSUInteger)maximumCachedBytes {
+    self.avatarCache.totalCostLimit = maximumCachedBytes;
+}
+
+- (void)setMaximumConcurrentPrefetchCount:(NSUInteger)maximumConcurrentPrefetchCount {
+    _maximumConcurrentPrefetchCount = maximumConcurrentPrefetchCount;
+
+    self.prefetchQueue.maxConcurrentOperationCount = (NSInteger)maximumConcurrentPrefetchCount;
+
+    [self startPendingPrefetches];
+}
+
+#pragma mark - Public
+
+- (NSData *)cachedAvatarDataForBlogName:(NSString *)blogName {
+    return blogName ? [self.avatarCache objectForKey:blogName] : nil;
+}
+
+- (void)fetchAvatarDataForBlogName:(NSString *)blogName callback:(TMPrefetchSchedulerCallback)callback {
+    if (!blogName) {
+        if (callback) {
+            callback(nil);
+        }
+
+        return;
+    }
+
+    NSData *cachedData = [self cachedAvatarDataForBlogName:blogName];
+
+    if (cachedData) {
+        if (callback) {
+            callback(cachedData);
+        }
+
+        return;
+    }
+
+    BOOL requestInFlight = self.callbacks[blogName] != nil || self.prefetchOperations[blogName] != nil;
+
+    NSMutableArray *callbacks = self.callbacks[blogName];
+
+    if (!callbacks) {
+        self.callbacks[blogName] = callbacks = [[NSMutableArray alloc] init];
+    }
+
+    if (callback) {
+        [callbacks addObject:[callback copy]];
+    }
+
+    // An in-flight prefetch will deliver the data, otherwise the row is on screen and shouldn't wait behind prefetches
+
+    if (requestInFlight) {
+        return;
+    }
+
+    [self.pendingBlogNames removeObject:blogName];
+
+    __weak TMPrefetchScheduler *weakSelf = self;
+
+    [[TMAPIClient sharedInstance] avatar:blogName size:self.avatarSize queue:[NSOperationQueue mainQueue]
+                                callback:^(NSData *data, NSError *error) {
+        [weakSelf completeFetchForBlogName:blogName data:error ? nil : data];
+    }];
+}
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView {
+    NSTimeInterval timestamp = [NSDate timeIntervalSinceReferenceDate];
+    NSTimeInterval elapsed = timestamp - self.lastScrollTimestamp;
+    CGFloat contentOffset = scrollView.contentOffset.y;
+
+    if (elapsed > 0 && elapsed < TMPrefetchSchedulerVelocitySampleTimeout) {
+        self.scrollVelocity = (CGFloat)((contentOffset - self.lastContentOffset) / elapsed);
+    } else {
+        self.scrollVelocity = 0;
+    }
+
+    self.lastContentOffset = contentOffset;
+    self.lastScrollTimestamp = timestamp;
+
+    [self updatePrefetchWindow];
+}
+
+- (void)updatePrefetchWindow {
+    NSArray *visibleIndexPaths = [[self.tableView indexPathsForVisibleRows] sortedArrayUsingSelector:@selector(compare:)];
+
+    if ([visibleIndexPaths count] == 0) {
+        return;
+    }
+
+    CGFloat rowHeight = self.tableView.rowHeight > 0 ? self.tableView.rowHeight : TMPrefetchSchedulerDefaultRowHeight;
+    CGFloat rowsCovered = (CGFloat)fabs(self.scrollVelocity * self.lookaheadInterval) / rowHeight;
+
+    NSUInteger lookahead = MIN(self.maximumLookaheadRowCount, self.minimumLookaheadRowCount + (NSUInteger)rowsCovered);
+    BOOL scrollingUp = self.scrollVelocity < 0;
+
+    NSUInteger rowsBelow = scrollingUp ? self.minimumLookaheadRowCount : lookahead;
+    NSUInteger rowsAbove = scrollingUp ? lookahead : self.minimumLookaheadRowCount;
+
+    NSArray *below = [self indexPathsFromIndexPath:[visibleIndexPaths lastObject] count:rowsBelow forward:YES];
+    NSArray *above = [self indexPathsFromIndexPath:[visibleIndexPaths firstObject] count:rowsAbove forward:NO];
+
+    // Nearest rows in the direction of travel first, then the rows behind us
+
+    NSMutableOrderedSet *window = [[NSMutableOrderedSet alloc] init];
+
+    for (NSIndexPath *indexPath in scrollingUp ? [above arrayByAddingObjectsFromArray:below]
+                                               : [below arrayByAddingObjectsFromArray:above]) {
+        NSString *blogName = [self blogNameAtIndexPath:indexPath];
+
+        if (blogName) {
+            [window addObject:blogName];
+        }
+    }
+
+    // Cancel prefetches for rows that have left the window, unless an on-screen row is waiting on them
+
+    for (NSString *blogName in [self.prefetchOperations allKeys]) {
+        if (![window containsObject:blogName] && !self.callbacks[blogName]) {
+            [self.prefetchOperations[blogName] cancel];
+            [self.prefetchOperations removeObjectForKey:blogName];
+        }
+    }
+
+    [self.pendingBlogNames removeAllObjects];
+
+    for (NSString *blogName in window) {
+        if (![self cachedAvatarDataForBlogName:blogName] && !self.prefetchOperations[blogName] && !self.callbacks[blogName]) {
+            [self.pendingBlogNames addObject:blogName];
+        }
+    }
+
+    [self startPendingPrefetches];
+}
+
+- (void)cancelAllPrefetches {
+    [self.pendingBlogNames removeAllObjects];
+
+    for (NSString *blogName in [self.prefetchOperations allKeys]) {
+        if (!self.callbacks[blogName]) {
+            [self.prefetchOperations[blogName] cancel];
+            [self.prefetchOperations removeObjectForKey:blogName];
+        }
+    }
+}
+
+#pragma mark - Private
+
+- (NSArray *)indexPathsFromIndexPath:(NSIndexPath *)indexPath count:(NSUInteger)count forward:(BOOL)forward {
+    NSArray *sections = self.fetchedResultsController.sections;
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] initWithCapacity:count];
+
+    NSInteger section = indexPath.section;
+    NSInteger row = indexPath.row;
+
+    while ([indexPaths count] < count) {
+        row += forward ? 1 : -1;
+
+        while (section >= 0 && section < (NSInteger)[sections count] &&
+               (row < 0 || row >= (NSInteger)[sections[section] numberOfObjects])) {
+            section += forward ? 1 : -1;
+
+            if (section < 0 || section >= (NSInteger)[sections count]) {
+                break;
+            }
+
+            row = forward ? 0 : (NSInteger)[sections[section] numberOfObjects] - 1;
+        }
+
+        if (section < 0 || section >= (NSInteger)[sections count]) {
+            break;
+        }
+
+        [indexPaths addObject:[NSIndexPath indexPathForRow:row inSection:section]];
+    }
+
+    return indexPaths;
+}
+
+- (NSString *)blogNameAtIndexPath:(NSIndexPath *)indexPath {
+    TMPost *post = [self.fetchedResultsController objectAtIndexPath:indexPath];
+
+    return post.blogName;
+}
+
+/**
+ *  Bytes that in-flight prefetches have received, or are expected to receive once the response length is known.
+ */
+- (long long)prefetchBytesInFlight {
+    long long bytes = 0;
+
+    for (JXHTTPOperation *operation in [self.prefetchOperations allValues]) {
+        long long expectedLength = operation.response.expectedContentLength;
+
+        bytes += MAX(expectedLength, operation.bytesDownloaded);
+    }
+
+    return bytes;
+}
+
+/**
+ *  Whether interactive requests have capacity to spare. Prefetches hold off while any request on `TMAPIClient`'s queue
+ *  is waiting for a slot, and while the API host has fewer free connections than are reserved for interactive requests.
+ */
+- (BOOL)interactiveQueueHasCapacity {
+    TMAPIClient *client = [TMAPIClient sharedInstance];
+
+    if (client.queue.waitingOperationCount > 0) {
+        return NO;
+    }
+
+    JXHTTPConnectionManager *connectionManager = client.connectionManager;
+
+    if (!connectionManager) {
+        return YES;
+    }
+
+    NSUInteger activeConnectionCount = [connectionManager activeConnectionCountForURL:client.baseURL];
+
+    return activeConnectionCount + TMPrefetchSchedulerReservedConnectionCount < connectionManager.maximumConnectionsPerHost;
+}
+
+- (void)startPendingPrefetches {
+    while ([self.pendingBlogNames count] > 0
+           && [self.prefetchOperations count] < self.maximumConcurrentPrefetchCount
+           && [self prefetchBytesInFlight] < self.maximumPrefetchBytesInFlight) {
+        if (![self interactiveQueueHasCapacity]) {
+            [self scheduleRetry];
+
+            return;
+        }
+
+        NSString *blogName = [self.pendingBlogNames firstObject];
+        [self.pendingBlogNames removeObjectAtIndex:0];
+
+        [self startPrefetchForBlogName:blogName];
+    }
+}
+
+- (void)scheduleRetry {
+    if (self.retryScheduled) {
+        return;
+    }
+
+    self.retryScheduled = YES;
+
+    __weak TMPrefetchScheduler *weakSelf = self;
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(TMPrefetchSchedulerRetryInterval * NSEC_PER_SEC)),
+                   dispatch_get_main_queue(), ^{
+        weakSelf.retryScheduled = NO;
+        [weakSelf startPendingPrefetches];
+    });
+}
+
+- (void)startPrefetchForBlogName:(NSString *)blogName {
+    JXHTTPOperation *request = [[TMAPIClient sharedInstance] avatarRequest:blogName size:self.avatarSize];
+    request.queuePriority = NSOperationQueuePriorityVeryLow;
+    request.priorityClass = JXHTTPOperationPriorityClassPrefetch;
+    request.requestNetworkServiceType = NSURLNetworkServiceTypeBackground;
+    request.updatesNetworkActivityIndicator = NO;
+    request.continuesInAppBackground = NO;
+    request.performsBlocksOnMainQueue = YES;
+
+    __weak TMPrefetchScheduler *weakSelf = self;
+
+    request.didReceiveResponseBlock = ^(JXHTTPOperation *operation) {
+        // Now that the expected length is known the byte budget may have room (or not) for another prefetch
+        [weakSelf startPendingPrefetches];
+    };
+
+    request.didFinishLoadingBlock = ^(JXHTTPOperation *operation) {
+        [weakSelf completeFetchForBlogName:blogName data:operation.responseStatusCode/100 == 2 ? operation.responseData : nil];
+    };
+
+    request.didFailBlock = ^(JXHTTPOperation *operation) {
+        [weakSelf completeFetchForBlogName:blogName data:nil];
+    };
+
+    self.prefetchOperations[blogName] = request;
+
+    [self.prefetchQueue addOperation:request];
+}
+
+- (void)completeFetchForBlogName:(NSString *)blogName data:(NSData *)data {
+    [self.prefetchOperations removeObjectForKey:blogName];
+
+    if (data) {
+        [self.avatarCache setObject:data forKey:blogName cost:[data length]];
+    }
+
+    NSArray *callbacks = self.callbacks[blogName];
+    [self.callbacks removeObjectForKey:blogName];
+
+    for (TMPrefetchSchedulerCallback callback in callbacks) {
+        callback(data);
+    }
+
+    [self startPendingPrefetches];
+}
+
+@end
@@ -0,0 +1,181 @@
+//
+//  JXHTTPDownloadResumeTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "JXHTTP.h"
+#import "TMStandInServer.h"
+
+static NSUInteger const JXHTTPDownloadResumeTestsBodyLength = 512 * 1024;
+static NSUInteger const JXHTTPDownloadResumeTestsSegmentCount = 4;
+static NSUInteger const JXHTTPDownloadResumeTestsInterruptedLength = 48 * 1024;
+static NSTimeInterval const JXHTTPDownloadResumeTestsTimeout = 30;
+
+@interface JXHTTPDownloadResumeTests : XCTestCase
+
+@property (nonatomic, strong) TMStandInServer *server;
+@property (nonatomic, strong) JXHTTPOperationQueue *queue;
+@property (nonatomic, strong) NSData *body;
+@property (nonatomic, copy) NSString *directory;
+@property (nonatomic, copy) NSString *filePath;
+
+@end
+
+@implementation JXHTTPDownloadResumeTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.body = [self randomDataWithLength:JXHTTPDownloadResumeTestsBodyLength];
+
+    self.server = [[TMStandInServer alloc] init];
+    [self replayBody:self.body entityTag:@"\"1\""];
+    [self.server start];
+
+    self.queue = [[JXHTTPOperationQueue alloc] init];
+
+    NSString *directoryName = [NSString stringWithFormat:@"JXHTTPDownloadResumeTests-%@", [[NSUUID UUID] UUIDString]];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:directoryName];
+    self.filePath = [self.directory stringByAppendingPathComponent:@"video.mp4"];
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil
+                                                    error:nil];
+}
+
+- (void)tearDown {
+    [self.queue cancelAllOperations];
+    [self.server stop];
+
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Single stream
+
+- (void)testResumesAnInterruptedDownload {
+    [self.server dropNextResponseAfterLength:JXHTTPDownloadResumeTestsInterruptedLength];
+
+    JXHTTPOperation *operation = [self downloadOperation];
+    [operation startAndWaitUntilFinished];
+
+    XCTAssertEqual(operation.error.code, (NSInteger)NSURLErrorNetworkConnectionLost);
+    XCTAssertEqual([self fileLength], (unsigned long long)JXHTTPDownloadResumeTestsInterruptedLength);
+
+    JXHTTPOperation *resumedOperation = [self downloadOperation];
+    [resumedOperation startAndWaitUntilFinished];
+
+    XCTAssertNil(resumedOperation.error);
+    XCTAssertEqual(resumedOperation.responseStatusCode, (NSInteger)206);
+    XCTAssertEqual(resumedOperation.resumedLength, (long long)JXHTTPDownloadResumeTestsInterruptedLength);
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:self.filePath], self.body);
+
+    // Nothing that had already arrived was sent again
+    XCTAssertEqual(self.server.bytesSent, (unsigned long long)JXHTTPDownloadResumeTestsBodyLength);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self.filePath stringByAppendingString:@".jxresume"]]);
+}
+
+#pragma mark - Segments
+
+- (void)testAssemblesSegmentsInPlace {
+    JXHTTPSegmentedDownload *download = [self segmentedDownload];
+
+    NSError *error = [self runDownload:download];
+
+    XCTAssertNil(error);
+    XCTAssertEqual(download.segmentCount, JXHTTPDownloadResumeTestsSegmentCount);
+    XCTAssertEqual(download.bytesDownloaded, (long long)JXHTTPDownloadResumeTestsBodyLength);
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:self.filePath], self.body);
+
+    // The probe, then one range request per segment
+    XCTAssertEqual(self.server.requestCount, JXHTTPDownloadResumeTestsSegmentCount + 1);
+    XCTAssertEqual(self.server.bytesSent, (unsigned long long)JXHTTPDownloadResumeTestsBodyLength);
+}
+
+- (void)testStartsOverWhenTheEntityChanges {
+    [self.server dropNextResponseAfterLength:JXHTTPDownloadResumeTestsInterruptedLength];
+
+    NSError *error = [self runDownload:[self segmentedDownload]];
+    NSString *progressFilePath = [self.filePath stringByAppendingString:@".jxsegments"];
+
+    XCTAssertEqual(error.code, (NSInteger)NSURLErrorNetworkConnectionLost);
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:progressFilePath]);
+
+    // Same length, different bytes, so only the validator tells the two apart
+    NSData *changedBody = [self randomDataWithLength:JXHTTPDownloadResumeTestsBodyLength];
+
+    [self.server removeAllRecordings];
+    [self replayBody:changedBody entityTag:@"\"2\""];
+
+    JXHTTPSegmentedDownload *download = [self segmentedDownload];
+
+    error = [self runDownload:download];
+
+    XCTAssertNil(error);
+    XCTAssertEqual(download.segmentCount, JXHTTPDownloadResumeTestsSegmentCount);
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:self.filePath], changedBody);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:progressFilePath]);
+}
+
+#pragma mark - Private
+
+- (void)replayBody:(NSData *)body entityTag:(NSString *)entityTag {
+    [self.server replayResponseWithStatusCode:200
+                                      headers:@{ @"Content-Type" : @"video/mp4", @"ETag" : entityTag }
+                                         body:body forMethod:nil pathPattern:@"video.mp4"];
+}
+
+- (NSURL *)URL {
+    return [self.server.baseURL URLByAppendingPathComponent:@"video.mp4"];
+}
+
+- (JXHTTPOperation *)downloadOperation {
+    JXHTTPOperation *operation = [[JXHTTPOperation alloc] initWithURL:[self URL]];
+    operation.responseDataFilePath = self.filePath;
+    operation.resumesDownload = YES;
+
+    return operation;
+}
+
+- (JXHTTPSegmentedDownload *)segmentedDownload {
+    JXHTTPSegmentedDownload *download = [JXHTTPSegmentedDownload withURL:[self URL] filePath:self.filePath];
+    download.queue = self.queue;
+    download.maximumSegmentCount = JXHTTPDownloadResumeTestsSegmentCount;
+    download.minimumSegmentLength = JXHTTPDownloadResumeTestsBodyLength / JXHTTPDownloadResumeTestsSegmentCount;
+
+    return download;
+}
+
+// Starts the download and waits for it to finish or fail
+- (NSError *)runDownload:(JXHTTPSegmentedDownload *)download {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+
+    download.didFinishBlock = ^(JXHTTPSegmentedDownload *download) {
+        dispatch_semaphore_signal(semaphore);
+    };
+
+    [download start];
+
+    long result = dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW,
+                                                                   (int64_t)(JXHTTPDownloadResumeTestsTimeout * NSEC_PER_SEC)));
+    XCTAssertEqual(result, 0L, @"The download timed out");
+
+    return download.error;
+}
+
+- (unsigned long long)fileLength {
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:self.filePath error:nil] fileSize];
+}
+
+- (NSData *)randomDataWithLength:(NSUInteger)length {
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:length];
+    arc4random_buf(data.mutableBytes, data.length);
+
+    return data;
+}
+
+@end
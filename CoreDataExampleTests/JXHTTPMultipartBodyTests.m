@@ -0,0 +1,180 @@
+//
+//  JXHTTPMultipartBodyTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <mach/mach.h>
+#import "JXHTTP.h"
+#import "TMBenchmark.h"
+
+static NSUInteger const JXHTTPMultipartBodyTestsFileCount = 2;
+static unsigned long long const JXHTTPMultipartBodyTestsFileLength = 160 * 1024 * 1024;
+static NSUInteger const JXHTTPMultipartBodyTestsWriteLength = 1024 * 1024;
+static NSUInteger const JXHTTPMultipartBodyTestsReadLength = 64 * 1024;
+static NSUInteger const JXHTTPMultipartBodyTestsRunCount = 3;
+
+// Far below the size of the body, but with room for the stream buffers and the test's own allocations
+static unsigned long long const JXHTTPMultipartBodyTestsMaximumFootprintGrowth = 32 * 1024 * 1024;
+
+@interface JXHTTPMultipartBodyTests : XCTestCase
+
+@property (nonatomic, strong) NSArray *filePaths;
+
+@end
+
+@implementation JXHTTPMultipartBodyTests
+
+- (void)setUp {
+    [super setUp];
+
+    NSMutableArray *filePaths = [[NSMutableArray alloc] initWithCapacity:JXHTTPMultipartBodyTestsFileCount];
+    NSMutableData *chunk = [[NSMutableData alloc] initWithLength:JXHTTPMultipartBodyTestsWriteLength];
+
+    for (NSUInteger i = 0; i < JXHTTPMultipartBodyTestsFileCount; i++) {
+        NSString *fileName = [NSString stringWithFormat:@"JXHTTPMultipartBodyTests-%@", [[NSUUID UUID] UUIDString]];
+        NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:fileName];
+
+        [[NSFileManager defaultManager] createFileAtPath:filePath contents:nil attributes:nil];
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:filePath];
+
+        for (unsigned long long written = 0; written < JXHTTPMultipartBodyTestsFileLength; written += chunk.length) {
+            @autoreleasepool {
+                arc4random_buf(chunk.mutableBytes, chunk.length);
+                [fileHandle writeData:chunk];
+            }
+        }
+
+        [fileHandle closeFile];
+        [filePaths addObject:filePath];
+    }
+
+    self.filePaths = filePaths;
+}
+
+- (void)tearDown {
+    for (NSString *filePath in self.filePaths) {
+        [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+    }
+
+    [super tearDown];
+}
+
+#pragma mark - Streaming
+
+/**
+ Streams a body of several hundred megabytes of file parts the way a connection reads it, checking that memory stays
+ bounded throughout rather than growing with the body. Throughput is logged against reading the files directly.
+ */
+- (void)testStreamsLargeFilesInBoundedMemory {
+    __block unsigned long long bodyLength = 0;
+    __block unsigned long long peakFootprintGrowth = 0;
+    __block NSData *bodyEnd = nil;
+
+    NSTimeInterval baselineDuration = TMBenchmarkMedianDuration(JXHTTPMultipartBodyTestsRunCount, ^{
+        for (NSString *filePath in self.filePaths) {
+            [self readStream:[NSInputStream inputStreamWithFileAtPath:filePath] peakFootprintGrowth:NULL end:NULL];
+        }
+    });
+
+    NSTimeInterval duration = TMBenchmarkMedianDuration(JXHTTPMultipartBodyTestsRunCount, ^{
+        JXHTTPMultipartBody *body = [self body];
+
+        // The operation is never started, it only provides the thread the body writes its stream on
+        JXHTTPOperation *operation = [[JXHTTPOperation alloc] initWithURL:[NSURL URLWithString:@"http://jxhttp.com/"]];
+        [body httpOperationWillStart:operation];
+
+        unsigned long long footprintGrowth = 0;
+        NSData *end = nil;
+
+        bodyLength = [self readStream:[body httpInputStream] peakFootprintGrowth:&footprintGrowth end:&end];
+        peakFootprintGrowth = MAX(peakFootprintGrowth, footprintGrowth);
+        bodyEnd = end;
+
+        [body httpOperationDidFinishLoading:operation];
+
+        XCTAssertEqual((long long)bodyLength, [body httpContentLength]);
+    });
+
+    XCTAssertGreaterThan(bodyLength, JXHTTPMultipartBodyTestsFileCount * JXHTTPMultipartBodyTestsFileLength);
+    XCTAssertTrue([[[NSString alloc] initWithData:bodyEnd encoding:NSASCIIStringEncoding] hasSuffix:@"--\r\n"]);
+    XCTAssertLessThan(peakFootprintGrowth, JXHTTPMultipartBodyTestsMaximumFootprintGrowth);
+
+    TMBenchmarkLog(@"Multipart streaming (vs. reading the files)", baselineDuration, duration);
+    NSLog(@"%.0f MB/s, peak footprint growth %.1f MB", bodyLength / duration / (1024 * 1024),
+          peakFootprintGrowth / (1024.0 * 1024));
+}
+
+#pragma mark - Private
+
+- (JXHTTPMultipartBody *)body {
+    JXHTTPMultipartBody *body = [JXHTTPMultipartBody withDictionary:@{ @"type" : @"video", @"caption" : @"Large" }];
+
+    for (NSString *filePath in self.filePaths) {
+        [body addFile:filePath forKey:@"data[]" contentType:@"video/mp4" fileName:[filePath lastPathComponent]];
+    }
+
+    return body;
+}
+
+/**
+ Reads a stream to the end, as a connection would, sampling the process's memory footprint as it goes.
+
+ @param peakFootprintGrowth Set to how far the footprint rose above where it started, if not `NULL`
+ @param end Set to the last bytes read, if not `NULL`
+ @return Number of bytes read
+ */
+- (unsigned long long)readStream:(NSInputStream *)stream peakFootprintGrowth:(unsigned long long *)peakFootprintGrowth
+                             end:(NSData **)end {
+    uint8_t buffer[JXHTTPMultipartBodyTestsReadLength];
+    unsigned long long length = 0;
+    unsigned long long initialFootprint = [self footprint];
+    unsigned long long peakFootprint = initialFootprint;
+    NSInteger readLength = 0;
+    NSInteger lastReadLength = 0;
+
+    [stream open];
+
+    while ((readLength = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        length += (unsigned long long)readLength;
+        lastReadLength = readLength;
+
+        // Every megabyte, which is often enough to catch a buffer growing with the body
+        if (peakFootprintGrowth && length % JXHTTPMultipartBodyTestsWriteLength < (unsigned long long)readLength) {
+            peakFootprint = MAX(peakFootprint, [self footprint]);
+        }
+    }
+
+    XCTAssertEqual(readLength, (NSInteger)0, @"%@", stream.streamError);
+
+    [stream close];
+
+    // A read that returns 0 leaves the buffer alone, so it still holds the last bytes
+    if (end) {
+        *end = [NSData dataWithBytes:buffer length:(NSUInteger)lastReadLength];
+    }
+
+    if (peakFootprintGrowth) {
+        *peakFootprintGrowth = MAX(peakFootprint, [self footprint]) - initialFootprint;
+    }
+
+    return length;
+}
+
+// Dirty memory the process is charged for. Unlike the resident size, this leaves out the clean pages of mapped files,
+// which the system can drop at any time.
+- (unsigned long long)footprint {
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+
+    return info.phys_footprint;
+}
+
+@end
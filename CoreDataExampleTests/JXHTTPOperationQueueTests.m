@@ -0,0 +1,135 @@
+//
+//  JXHTTPOperationQueueTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "JXHTTP.h"
+#import "TMStandInServer.h"
+
+static NSUInteger const JXHTTPOperationQueueTestsBodyLength = 100 * 1024;
+static NSUInteger const JXHTTPOperationQueueTestsBytesPerSecond = 100 * 1024;
+static NSUInteger const JXHTTPOperationQueueTestsOperationCount = 8;
+static NSTimeInterval const JXHTTPOperationQueueTestsTimeout = 30;
+
+@interface JXHTTPOperationQueueTests : XCTestCase
+
+@property (nonatomic, strong) TMStandInServer *server;
+@property (nonatomic, strong) JXHTTPOperationQueue *queue;
+@property (nonatomic, strong) dispatch_semaphore_t finished;
+
+@end
+
+@implementation JXHTTPOperationQueueTests
+
+- (void)setUp {
+    [super setUp];
+
+    NSMutableData *body = [[NSMutableData alloc] initWithLength:JXHTTPOperationQueueTestsBodyLength];
+    arc4random_buf(body.mutableBytes, body.length);
+
+    // Throttled, so that operations are still receiving when they're cancelled
+    self.server = [[TMStandInServer alloc] init];
+    self.server.bytesPerSecond = JXHTTPOperationQueueTestsBytesPerSecond;
+    [self.server replayResponseWithStatusCode:200 headers:@{ @"Content-Type" : @"application/octet-stream" } body:body
+                                    forMethod:nil pathPattern:@"*"];
+    [self.server start];
+
+    self.finished = dispatch_semaphore_create(0);
+
+    self.queue = [[JXHTTPOperationQueue alloc] init];
+    self.queue.progressInterval = 0;
+
+    __weak JXHTTPOperationQueueTests *weakSelf = self;
+
+    self.queue.didFinishBlock = ^(JXHTTPOperationQueue *queue) {
+        dispatch_semaphore_signal(weakSelf.finished);
+    };
+}
+
+- (void)tearDown {
+    [self.queue cancelAllOperations];
+    [self.server stop];
+
+    [super tearDown];
+}
+
+#pragma mark - Progress
+
+- (void)testCancellingMidTransferTakesBackEverythingReported {
+    __block int64_t maximumBytesDownloaded = 0;
+
+    self.queue.didDownloadBlock = ^(JXHTTPOperationQueue *queue) {
+        @synchronized (queue) {
+            maximumBytesDownloaded = MAX(maximumBytesDownloaded, [queue.bytesDownloaded longLongValue]);
+        }
+    };
+
+    for (NSUInteger i = 0; i < JXHTTPOperationQueueTestsOperationCount; i++) {
+        JXHTTPOperation *operation = [self operationWithIndex:i];
+
+        operation.didReceiveDataBlock = ^(JXHTTPOperation *operation) {
+            [operation cancel];
+        };
+
+        [self.queue addOperation:operation];
+    }
+
+    [self waitUntilFinished];
+
+    XCTAssertGreaterThan(maximumBytesDownloaded, 0LL);
+    XCTAssertEqualObjects(self.queue.bytesDownloaded, @0LL);
+    XCTAssertEqualObjects(self.queue.expectedDownloadBytes, @0LL);
+    XCTAssertEqualObjects(self.queue.bytesUploaded, @0LL);
+    XCTAssertEqualObjects(self.queue.expectedUploadBytes, @0LL);
+}
+
+- (void)testFinishedOperationsKeepWhatTheyReported {
+    JXHTTPOperation *finishing = [[JXHTTPOperation alloc] initWithURL:[self.server.baseURL URLByAppendingPathComponent:@"finishing"]];
+    [self.queue addOperation:finishing];
+
+    for (NSUInteger i = 0; i < JXHTTPOperationQueueTestsOperationCount; i++) {
+        JXHTTPOperation *operation = [self operationWithIndex:i];
+
+        operation.didReceiveDataBlock = ^(JXHTTPOperation *operation) {
+            [operation cancel];
+        };
+
+        [self.queue addOperation:operation];
+    }
+
+    [self waitUntilFinished];
+
+    XCTAssertFalse(finishing.isCancelled);
+    XCTAssertEqualObjects(self.queue.bytesDownloaded, @((long long)JXHTTPOperationQueueTestsBodyLength));
+    XCTAssertEqualObjects(self.queue.expectedDownloadBytes, @((long long)JXHTTPOperationQueueTestsBodyLength));
+    XCTAssertEqualObjects(self.queue.bytesUploaded, @0LL);
+    XCTAssertEqualObjects(self.queue.expectedUploadBytes, @0LL);
+}
+
+#pragma mark - Private
+
+// Every other operation uploads a body, so that expected upload bytes are reported too
+- (JXHTTPOperation *)operationWithIndex:(NSUInteger)index {
+    NSURL *URL = [self.server.baseURL URLByAppendingPathComponent:[NSString stringWithFormat:@"%lu", (unsigned long)index]];
+    JXHTTPOperation *operation = [[JXHTTPOperation alloc] initWithURL:URL];
+
+    if (index % 2) {
+        NSMutableData *body = [[NSMutableData alloc] initWithLength:JXHTTPOperationQueueTestsBodyLength / 10];
+        operation.requestBody = [JXHTTPDataBody withData:body];
+        operation.requestMethod = @"POST";
+    }
+
+    return operation;
+}
+
+- (void)waitUntilFinished {
+    long result = dispatch_semaphore_wait(self.finished, dispatch_time(DISPATCH_TIME_NOW,
+                                                                       (int64_t)(JXHTTPOperationQueueTestsTimeout * NSEC_PER_SEC)));
+    XCTAssertEqual(result, 0L, @"The queue never finished");
+}
+
+@end
@@ -0,0 +1,140 @@
+//
+//  JXNetworkThreadPoolTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "JXHTTP.h"
+#import "TMLoopbackServer.h"
+
+static NSUInteger const JXNetworkThreadPoolTestsThreadCount = 4;
+static NSUInteger const JXNetworkThreadPoolTestsOperationCount = 200;
+static NSTimeInterval const JXNetworkThreadPoolTestsBusyInterval = 1;
+
+/**
+ Records the thread its connection was started on.
+ */
+@interface JXThreadRecordingOperation : JXHTTPOperation
+
+@property (strong) NSThread *startThread;
+
+@end
+
+@implementation JXThreadRecordingOperation
+
+- (void)didStartConnection {
+    self.startThread = [NSThread currentThread];
+
+    [super didStartConnection];
+}
+
+@end
+
+@interface JXNetworkThreadPoolTests : XCTestCase
+
+@property (nonatomic, strong) TMLoopbackServer *server;
+
+@end
+
+@implementation JXNetworkThreadPoolTests
+
+- (void)setUp {
+    [super setUp];
+
+    NSMutableData *body = [[NSMutableData alloc] initWithLength:64 * 1024];
+    arc4random_buf(body.mutableBytes, body.length);
+
+    self.server = [[TMLoopbackServer alloc] init];
+    self.server.responseBody = body;
+
+    XCTAssertTrue([self.server start]);
+}
+
+- (void)tearDown {
+    [self.server stop];
+
+    [super tearDown];
+}
+
+#pragma mark - Loopback
+
+- (void)testSpreadsConnectionsAcrossPoolThreads {
+    JXNetworkThreadPool *pool = [[JXNetworkThreadPool alloc] initWithThreadCount:JXNetworkThreadPoolTestsThreadCount
+                                                                            name:@"tests"];
+    JXHTTPOperationQueue *queue = [[JXHTTPOperationQueue alloc] init];
+    queue.maxConcurrentOperationCount = 16;
+
+    NSMutableArray *operations = [[NSMutableArray alloc] initWithCapacity:JXNetworkThreadPoolTestsOperationCount];
+
+    for (NSUInteger i = 0; i < JXNetworkThreadPoolTestsOperationCount; i++) {
+        NSURL *URL = [NSURL URLWithString:[NSString stringWithFormat:@"%lu", (unsigned long)i]
+                            relativeToURL:self.server.baseURL];
+
+        JXThreadRecordingOperation *operation = [[JXThreadRecordingOperation alloc] initWithURL:URL];
+        operation.connectionThread = [pool nextThread];
+
+        [operations addObject:operation];
+        [queue addOperation:operation];
+    }
+
+    [queue waitUntilAllOperationsAreFinished];
+
+    NSMutableSet *startThreads = [[NSMutableSet alloc] init];
+
+    for (JXThreadRecordingOperation *operation in operations) {
+        XCTAssertNil(operation.error);
+        XCTAssertEqual(operation.responseStatusCode, (NSInteger)200);
+        XCTAssertEqualObjects(operation.responseData, self.server.responseBody);
+        XCTAssertEqualObjects(operation.startThread, operation.connectionThread);
+
+        if (operation.startThread) {
+            [startThreads addObject:operation.startThread];
+        }
+    }
+
+    XCTAssertEqualObjects(startThreads, [NSSet setWithArray:pool.threads]);
+    XCTAssertEqual(self.server.requestCount, JXNetworkThreadPoolTestsOperationCount);
+}
+
+- (void)testStartingAndCancellingDoesNotWaitForABusyThread {
+    JXNetworkThreadPool *pool = [[JXNetworkThreadPool alloc] initWithThreadCount:1 name:@"tests"];
+    NSThread *thread = [pool nextThread];
+
+    [JXNetworkThreadPool performBlock:^{
+        [NSThread sleepForTimeInterval:JXNetworkThreadPoolTestsBusyInterval];
+    } onThread:thread waitUntilDone:NO];
+
+    JXThreadRecordingOperation *operation = [[JXThreadRecordingOperation alloc] initWithURL:self.server.baseURL];
+    operation.connectionThread = thread;
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    [operation start];
+    [operation cancel];
+
+    XCTAssertLessThan(CFAbsoluteTimeGetCurrent() - start, JXNetworkThreadPoolTestsBusyInterval / 2);
+    XCTAssertTrue(operation.isFinished);
+
+    // The connection is never started once the thread gets to it
+    [JXNetworkThreadPool performBlock:^{} onThread:thread waitUntilDone:YES];
+
+    XCTAssertNil(operation.startThread);
+}
+
+- (void)testCompletesOnAThreadOfItsOwn {
+    JXNetworkThreadPool *pool = [[JXNetworkThreadPool alloc] initWithThreadCount:1 name:@"tests"];
+
+    JXThreadRecordingOperation *operation = [[JXThreadRecordingOperation alloc] initWithURL:self.server.baseURL];
+    operation.connectionThread = [pool nextThread];
+
+    [operation startAndWaitUntilFinished];
+
+    XCTAssertEqual(operation.responseStatusCode, (NSInteger)200);
+    XCTAssertEqualObjects(operation.startThread, pool.threads[0]);
+    XCTAssertEqual(self.server.acceptedConnectionCount, (NSUInteger)1);
+}
+
+@end
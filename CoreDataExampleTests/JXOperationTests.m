@@ -0,0 +1,228 @@
+//
+//  JXOperationTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "JXHTTP.h"
+#import "TMBenchmark.h"
+
+static NSUInteger const JXOperationTestsOperationCount = 10000;
+static NSUInteger const JXOperationTestsRunCount = 5;
+
+/**
+ Finishes as soon as it starts, so that only the cost of the operation itself is measured.
+ */
+@interface JXFinishingOperation : JXOperation
+
+@end
+
+@implementation JXFinishingOperation
+
+- (void)main {
+    [self finish];
+}
+
+@end
+
+/**
+ Reference for the benchmarks: `JXOperation` as it was when it guarded its state with a serial dispatch queue of its
+ own, created and named in `init`.
+ */
+@interface JXSerialQueueOperation : NSOperation
+
+@property (assign) BOOL isExecuting;
+@property (assign) BOOL isFinished;
+@property (strong) dispatch_queue_t stateQueue;
+
+- (void)finish;
+
+@end
+
+@implementation JXSerialQueueOperation
+
+- (id)init {
+    if (self = [super init]) {
+        NSString *queueName = [[NSString alloc] initWithFormat:@"%@.%p.state", NSStringFromClass([self class]), self];
+        self.stateQueue = dispatch_queue_create([queueName UTF8String], DISPATCH_QUEUE_SERIAL);
+    }
+
+    return self;
+}
+
+- (BOOL)isConcurrent {
+    return YES;
+}
+
+- (void)start {
+    __block BOOL shouldStart = YES;
+
+    dispatch_sync(self.stateQueue, ^{
+        if (![self isReady] || [self isCancelled] || self.isExecuting || self.isFinished) {
+            shouldStart = NO;
+        } else {
+            [self willChangeValueForKey:@"isExecuting"];
+            self.isExecuting = YES;
+            [self didChangeValueForKey:@"isExecuting"];
+        }
+    });
+
+    if (!shouldStart || [self isCancelled]) {
+        return;
+    }
+
+    @autoreleasepool {
+        [self main];
+    }
+}
+
+- (void)main {
+    [self finish];
+}
+
+- (void)cancel {
+    [super cancel];
+
+    [self finish];
+}
+
+- (void)finish {
+    dispatch_sync(self.stateQueue, ^{
+        if (self.isFinished) {
+            return;
+        }
+
+        if (self.isExecuting) {
+            [self willChangeValueForKey:@"isExecuting"];
+            [self willChangeValueForKey:@"isFinished"];
+            self.isExecuting = NO;
+            self.isFinished = YES;
+            [self didChangeValueForKey:@"isExecuting"];
+            [self didChangeValueForKey:@"isFinished"];
+        } else {
+            self.isFinished = YES;
+        }
+    });
+}
+
+@end
+
+/**
+ Reference for the benchmarks: `JXHTTPOperation` with the setup it used to do on top of its current one, a named serial
+ queue for its state and another for its blocks, and a globally unique string. Finishing goes through the state queue,
+ as it did then.
+ */
+@interface JXSerialQueueHTTPOperation : JXHTTPOperation
+
+@property (strong) dispatch_queue_t stateQueue;
+@property (strong) dispatch_queue_t legacyBlockQueue;
+@property (copy) NSString *legacyUniqueString;
+
+@end
+
+@implementation JXSerialQueueHTTPOperation
+
+- (id)init {
+    if (self = [super init]) {
+        NSString *stateQueueName = [[NSString alloc] initWithFormat:@"%@.%p.state", NSStringFromClass([self class]), self];
+        self.stateQueue = dispatch_queue_create([stateQueueName UTF8String], DISPATCH_QUEUE_SERIAL);
+
+        NSString *blockQueueName = [[NSString alloc] initWithFormat:@"%@.%p.blocks", NSStringFromClass([self class]), self];
+        self.legacyBlockQueue = dispatch_queue_create([blockQueueName UTF8String], DISPATCH_QUEUE_SERIAL);
+
+        self.legacyUniqueString = [[NSProcessInfo processInfo] globallyUniqueString];
+    }
+
+    return self;
+}
+
+- (void)willFinish {
+    dispatch_sync(self.stateQueue, ^{});
+
+    [super willFinish];
+}
+
+@end
+
+@interface JXOperationTests : XCTestCase
+
+@end
+
+@implementation JXOperationTests
+
+#pragma mark - Benchmarks
+
+- (void)testStartingAndFinishingOperations {
+    __block JXSerialQueueOperation *lastReferenceOperation = nil;
+    __block JXFinishingOperation *lastOperation = nil;
+
+    NSTimeInterval baselineDuration = TMBenchmarkMedianDuration(JXOperationTestsRunCount, ^{
+        for (NSUInteger i = 0; i < JXOperationTestsOperationCount; i++) {
+            @autoreleasepool {
+                JXSerialQueueOperation *operation = [[JXSerialQueueOperation alloc] init];
+                [operation start];
+
+                lastReferenceOperation = operation;
+            }
+        }
+    });
+
+    NSTimeInterval duration = TMBenchmarkMedianDuration(JXOperationTestsRunCount, ^{
+        for (NSUInteger i = 0; i < JXOperationTestsOperationCount; i++) {
+            @autoreleasepool {
+                JXFinishingOperation *operation = [[JXFinishingOperation alloc] init];
+                [operation start];
+
+                lastOperation = operation;
+            }
+        }
+    });
+
+    XCTAssertTrue(lastReferenceOperation.isFinished);
+    XCTAssertTrue(lastOperation.isFinished);
+    XCTAssertFalse(lastOperation.isExecuting);
+
+    TMBenchmarkLog([NSString stringWithFormat:@"JXOperation create, start and finish x%lu (vs. a serial queue each)",
+                    (unsigned long)JXOperationTestsOperationCount], baselineDuration, duration);
+}
+
+// Requests are created and cancelled without being sent, which is all of their setup and teardown without the network
+- (void)testCreatingAndCancellingHTTPOperations {
+    NSURL *URL = [NSURL URLWithString:@"http://api.tumblr.invalid/v2/user/dashboard"];
+    __block JXHTTPOperation *lastReferenceOperation = nil;
+    __block JXHTTPOperation *lastOperation = nil;
+
+    NSTimeInterval baselineDuration = TMBenchmarkMedianDuration(JXOperationTestsRunCount, ^{
+        for (NSUInteger i = 0; i < JXOperationTestsOperationCount; i++) {
+            @autoreleasepool {
+                JXHTTPOperation *operation = [[JXSerialQueueHTTPOperation alloc] initWithURL:URL];
+                [operation cancel];
+
+                lastReferenceOperation = operation;
+            }
+        }
+    });
+
+    NSTimeInterval duration = TMBenchmarkMedianDuration(JXOperationTestsRunCount, ^{
+        for (NSUInteger i = 0; i < JXOperationTestsOperationCount; i++) {
+            @autoreleasepool {
+                JXHTTPOperation *operation = [[JXHTTPOperation alloc] initWithURL:URL];
+                [operation cancel];
+
+                lastOperation = operation;
+            }
+        }
+    });
+
+    XCTAssertTrue(lastReferenceOperation.isFinished);
+    XCTAssertTrue(lastOperation.isFinished);
+    XCTAssertTrue(lastOperation.isCancelled);
+
+    TMBenchmarkLog([NSString stringWithFormat:@"JXHTTPOperation create and cancel x%lu (vs. serial queues each)",
+                    (unsigned long)JXOperationTestsOperationCount], baselineDuration, duration);
+}
+
+@end
@@ -0,0 +1,282 @@
+//
+//  JXURLEncodingTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "JXHTTP.h"
+#import "TMBenchmark.h"
+
+static NSUInteger const JXURLEncodingTestsRandomDictionaryCount = 500;
+static unsigned int const JXURLEncodingTestsSeed = 4600;
+static NSUInteger const JXURLEncodingTestsEncodeCount = 10000;
+static NSUInteger const JXURLEncodingTestsRunCount = 5;
+
+/**
+ Reference for the tests: `JXURLEncoding` as it was before it encoded into a byte buffer, escaping every string with
+ `CFURLCreateStringByAddingPercentEscapes` and joining the pairs with `NSString`.
+
+ It sorted keys with `localizedCaseInsensitiveCompare:`, whose order depends on the user's locale. The current encoder
+ deliberately doesn't, so the reference sorts with the same locale independent comparison the current encoder uses
+ instead. Everything else is as it was.
+ */
+@interface JXReferenceURLEncoding : NSObject
+
++ (NSString *)encodedString:(NSString *)string;
++ (NSString *)formEncodedString:(NSString *)string;
++ (NSString *)encodedDictionary:(NSDictionary *)dictionary;
++ (NSString *)formEncodedDictionary:(NSDictionary *)dictionary;
+
+@end
+
+@implementation JXReferenceURLEncoding
+
++ (NSString *)encodedString:(NSString *)string {
+    if (![string length]) {
+        return @"";
+    }
+
+    CFStringRef static const charsToLeave = CFSTR("-._~"); // RFC 3986 unreserved
+    CFStringRef static const charsToEscape = CFSTR(":/?#[]@!$&'()*+,;="); // RFC 3986 reserved
+    CFStringRef escapedString = CFURLCreateStringByAddingPercentEscapes(kCFAllocatorDefault, (__bridge CFStringRef)string,
+                                                                        charsToLeave, charsToEscape,
+                                                                        kCFStringEncodingUTF8);
+    return (__bridge_transfer NSString *)escapedString;
+}
+
++ (NSString *)formEncodedString:(NSString *)string {
+    if (![string length]) {
+        return @"";
+    }
+
+    return [[self encodedString:string] stringByReplacingOccurrencesOfString:@"%20" withString:@"+"];
+}
+
++ (NSString *)encodedDictionary:(NSDictionary *)dictionary {
+    if (![dictionary count]) {
+        return @"";
+    }
+
+    NSMutableArray *arguments = [[NSMutableArray alloc] initWithCapacity:[dictionary count]];
+
+    for (NSString *key in [self sortedKeysOfDictionary:dictionary]) {
+        [self encodeObject:[dictionary objectForKey:key] withKey:key andSubKey:nil intoArray:arguments];
+    }
+
+    return [arguments componentsJoinedByString:@"&"];
+}
+
++ (NSString *)formEncodedDictionary:(NSDictionary *)dictionary {
+    if (![dictionary count]) {
+        return @"";
+    }
+
+    return [[self encodedDictionary:dictionary] stringByReplacingOccurrencesOfString:@"%20" withString:@"+"];
+}
+
+#pragma mark - Private
+
++ (NSArray *)sortedKeysOfDictionary:(NSDictionary *)dictionary {
+    return [[dictionary allKeys] sortedArrayUsingComparator:^NSComparisonResult(NSString *key, NSString *otherKey) {
+        NSComparisonResult result = [key compare:otherKey options:NSCaseInsensitiveSearch | NSLiteralSearch];
+
+        return result != NSOrderedSame ? result : [key compare:otherKey options:NSLiteralSearch];
+    }];
+}
+
++ (void)encodeObject:(id)object withKey:(NSString *)key andSubKey:(NSString *)subKey intoArray:(NSMutableArray *)array {
+    if (!object || ![key length]) {
+        return;
+    }
+
+    NSString *objectKey = nil;
+
+    if (subKey) {
+        objectKey = [[NSString alloc] initWithFormat:@"%@[%@]", [self encodedString:key], [self encodedString:subKey]];
+    } else {
+        objectKey = [self encodedString:key];
+    }
+
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        for (NSString *insideKey in [self sortedKeysOfDictionary:object]) {
+            [self encodeObject:[object objectForKey:insideKey] withKey:objectKey andSubKey:insideKey intoArray:array];
+        }
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        for (NSString *arrayObject in (NSArray *)object) {
+            NSString *arrayKey = [[NSString alloc] initWithFormat:@"%@[]", objectKey];
+            [self encodeObject:arrayObject withKey:arrayKey andSubKey:nil intoArray:array];
+        }
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        [array addObject:[[NSString alloc] initWithFormat:@"%@=%@", objectKey, [object stringValue]]];
+    } else {
+        NSString *encodedString = [self encodedString:object];
+        [array addObject:[[NSString alloc] initWithFormat:@"%@=%@", objectKey, encodedString]];
+    }
+}
+
+@end
+
+@interface JXURLEncodingTests : XCTestCase
+
+@end
+
+@implementation JXURLEncodingTests
+
+#pragma mark - Parity
+
+- (void)testEncodesStringsAsBefore {
+    for (NSString *string in [self strings]) {
+        XCTAssertEqualObjects([JXURLEncoding encodedString:string], [JXReferenceURLEncoding encodedString:string]);
+        XCTAssertEqualObjects([JXURLEncoding formEncodedString:string], [JXReferenceURLEncoding formEncodedString:string]);
+    }
+}
+
+- (void)testEncodesNestedParametersAsBefore {
+    NSDictionary *parameters = [self parameters];
+
+    XCTAssertEqualObjects([JXURLEncoding encodedDictionary:parameters],
+                          [JXReferenceURLEncoding encodedDictionary:parameters]);
+    XCTAssertEqualObjects([JXURLEncoding formEncodedDictionary:parameters],
+                          [JXReferenceURLEncoding formEncodedDictionary:parameters]);
+}
+
+- (void)testEncodesRandomParametersAsBefore {
+    srandom(JXURLEncodingTestsSeed);
+
+    for (NSUInteger i = 0; i < JXURLEncodingTestsRandomDictionaryCount; i++) {
+        NSDictionary *parameters = [self randomDictionaryWithDepth:3];
+
+        XCTAssertEqualObjects([JXURLEncoding encodedDictionary:parameters],
+                              [JXReferenceURLEncoding encodedDictionary:parameters], @"%@", parameters);
+        XCTAssertEqualObjects([JXURLEncoding formEncodedDictionary:parameters],
+                              [JXReferenceURLEncoding formEncodedDictionary:parameters], @"%@", parameters);
+    }
+}
+
+#pragma mark - Benchmarks
+
+- (void)testEncodingParameters {
+    NSDictionary *parameters = [self parameters];
+    __block NSString *referenceEncoding = nil;
+    __block NSString *encoding = nil;
+
+    NSTimeInterval baselineDuration = TMBenchmarkMedianDuration(JXURLEncodingTestsRunCount, ^{
+        for (NSUInteger i = 0; i < JXURLEncodingTestsEncodeCount; i++) {
+            @autoreleasepool {
+                referenceEncoding = [JXReferenceURLEncoding encodedDictionary:parameters];
+            }
+        }
+    });
+
+    NSTimeInterval duration = TMBenchmarkMedianDuration(JXURLEncodingTestsRunCount, ^{
+        for (NSUInteger i = 0; i < JXURLEncodingTestsEncodeCount; i++) {
+            @autoreleasepool {
+                encoding = [JXURLEncoding encodedDictionary:parameters];
+            }
+        }
+    });
+
+    XCTAssertEqualObjects(encoding, referenceEncoding);
+
+    // The reference's locale independent sort is cheaper than the localized one it used to do, if anything this
+    // understates the difference
+    TMBenchmarkLog([NSString stringWithFormat:@"URL encoding x%lu (vs. escaping and joining strings)",
+                    (unsigned long)JXURLEncodingTestsEncodeCount], baselineDuration, duration);
+}
+
+#pragma mark - Private
+
+- (NSArray *)strings {
+    unichar loneSurrogate = 0xD800;
+
+    return @[ @"", @"plain", @"with space", @"  leading and trailing  ", @"-._~", @":/?#[]@!$&'()*+,;=",
+              @"\"<>\\^`{|}", @"50% off", @"%20", @"a+b", @"tab\tnew\nline", @"Café crème", @"ключ", @"日本語",
+              @"\U0001F600 grinning", @"é", [NSString stringWithCharacters:&loneSurrogate length:1] ];
+}
+
+// Parameters as the API client sends them, with the kinds of keys and values that sort or escape differently
+- (NSDictionary *)parameters {
+    return @{
+             @"type" : @"text",
+             @"Tags" : @"one, two",
+             @"tags" : @[ @"first tag", @"second+tag", @"third/tag" ],
+             @"tag" : @"50% off",
+             @"tag_id" : @3,
+             @"reblog_key" : @"AbC123",
+             @"api_key" : @"consumer key",
+             @"limit" : @20,
+             @"offset" : @0,
+             @"rating" : @3.5,
+             @"notes_info" : @YES,
+             @"caption" : @"Hello, world! :/?#[]@!$&'()*+,;=",
+             @"empty" : @"",
+             @"" : @"no key",
+             @"with space" : @"value with space",
+             @"café" : @"crème brûlée",
+             @"ключ" : @"значение",
+             @"filter" : @{
+                     @"npf" : @"true",
+                     @"Type" : @[ @"text", @"photo" ],
+                     @"type" : @"quote",
+                     @"sub key" : @{ @"deep key" : @"deep value", @"Deep" : @[ @1, @2 ] },
+                     @"é" : @"accent",
+                     },
+             @"blocks" : @[
+                     @{ @"type" : @"text", @"text" : @"Café ☕" },
+                     @{ @"type" : @"image", @"media" : @[ @{ @"url" : @"https://example.com/a b.png" } ] },
+                     @[ @"nested", @"array" ],
+                     ],
+             };
+}
+
+- (NSDictionary *)randomDictionaryWithDepth:(NSUInteger)depth {
+    NSUInteger count = 1 + (NSUInteger)(random() % 6);
+    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] initWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; i++) {
+        dictionary[[self randomString]] = [self randomObjectWithDepth:depth];
+    }
+
+    return dictionary;
+}
+
+- (id)randomObjectWithDepth:(NSUInteger)depth {
+    switch (random() % (depth > 0 ? 5 : 3)) {
+        case 0:
+            return @(random() % 1000);
+        case 3:
+            return [self randomDictionaryWithDepth:depth - 1];
+        case 4: {
+            NSUInteger count = (NSUInteger)(random() % 4);
+            NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:count];
+
+            for (NSUInteger i = 0; i < count; i++) {
+                [array addObject:[self randomObjectWithDepth:depth - 1]];
+            }
+
+            return array;
+        }
+        default:
+            return [self randomString];
+    }
+}
+
+// Mostly ASCII, with the characters that sort around letters once case is ignored, and some that aren't ASCII
+- (NSString *)randomString {
+    static NSString * const characters = @"aAbBzZ09_-.~ %+&=[]@^`{|}éÉßк☕";
+
+    NSUInteger length = (NSUInteger)(random() % 6);
+    NSMutableString *string = [[NSMutableString alloc] initWithCapacity:length];
+
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar character = [characters characterAtIndex:(NSUInteger)(random() % (long)characters.length)];
+        [string appendString:[NSString stringWithCharacters:&character length:1]];
+    }
+
+    return string;
+}
+
+@end
@@ -0,0 +1,416 @@
+//
+//  TMAPIClientLoadTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TMAPIClient.h"
+#import "TMBenchmark.h"
+#import "TMStandInServer.h"
+
+static NSUInteger const TMAPIClientLoadTestsRequestCount = 2000;
+static NSUInteger const TMAPIClientLoadTestsPostCount = 20;
+static NSUInteger const TMAPIClientLoadTestsBlogCount = 50;
+static NSTimeInterval const TMAPIClientLoadTestsTimeout = 300;
+static NSUInteger const TMAPIClientLoadTestsCompressionRequestCount = 20;
+static NSUInteger const TMAPIClientLoadTestsCompressionBytesPerSecond = 256 * 1024;
+static NSTimeInterval const TMAPIClientLoadTestsCoalescingLatency = 0.5;
+
+@interface TMAPIClientLoadTests : XCTestCase
+
+@property (nonatomic, strong) TMStandInServer *server;
+@property (nonatomic, strong) TMAPIClient *client;
+
+@end
+
+@implementation TMAPIClientLoadTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.server = [[TMStandInServer alloc] init];
+    [self.server replayAPIResponseWithStatusCode:200 response:@{ @"posts" : [self posts] } forMethod:@"GET"
+                                     pathPattern:@"user/dashboard"];
+    [self.server replayAPIResponseWithStatusCode:200 response:@{ @"blog" : [self blog] } forMethod:@"GET"
+                                     pathPattern:@"blog/*/info"];
+    [self.server replayAPIResponseWithStatusCode:200 response:@{ @"blog" : [self blog], @"posts" : [self posts],
+                                                                 @"total_posts" : @1000 }
+                                       forMethod:@"GET" pathPattern:@"blog/*/posts*"];
+    [self.server replayAPIResponseWithStatusCode:201 response:@{ @"id" : @46000000000 } forMethod:@"POST"
+                                     pathPattern:@"blog/*/post"];
+    [self.server start];
+
+    // A client of its own, so that callbacks don't need the main run loop and nothing is answered from a cache
+    self.client = [[TMAPIClient alloc] init];
+    self.client.baseURL = self.server.baseURL;
+    self.client.defaultCallbackQueue = [[NSOperationQueue alloc] init];
+    self.client.responseCache = nil;
+    self.client.OAuthConsumerKey = @"consumer key";
+    self.client.OAuthConsumerSecret = @"consumer secret";
+    self.client.OAuthToken = @"token";
+    self.client.OAuthTokenSecret = @"token secret";
+}
+
+- (void)tearDown {
+    [self.client.queue cancelAllOperations];
+    [self.server stop];
+
+    [super tearDown];
+}
+
+#pragma mark - Stand-in server
+
+- (void)testReplaysRecordedResponses {
+    __block id dashboard = nil;
+    __block id info = nil;
+    __block NSError *missingError = nil;
+
+    [self waitForRequests:^(dispatch_group_t group) {
+        dispatch_group_enter(group);
+        [self.client dashboard:nil callback:^(id response, NSError *error) {
+            dashboard = response;
+            dispatch_group_leave(group);
+        }];
+
+        dispatch_group_enter(group);
+        [self.client blogInfo:@"blog1" callback:^(id response, NSError *error) {
+            info = response;
+            dispatch_group_leave(group);
+        }];
+
+        dispatch_group_enter(group);
+        [self.client likes:@{} callback:^(id response, NSError *error) {
+            missingError = error;
+            dispatch_group_leave(group);
+        }];
+    }];
+
+    XCTAssertEqual([dashboard[@"posts"] count], TMAPIClientLoadTestsPostCount);
+    XCTAssertEqualObjects(info[@"blog"][@"name"], [self blog][@"name"]);
+    XCTAssertEqual(missingError.code, (NSInteger)404);
+}
+
+- (void)testInjectsLatency {
+    self.server.latency = 0.25;
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    [self waitForRequests:^(dispatch_group_t group) {
+        dispatch_group_enter(group);
+        [self.client blogInfo:@"blog1" callback:^(id response, NSError *error) {
+            dispatch_group_leave(group);
+        }];
+    }];
+
+    XCTAssertGreaterThanOrEqual(CFAbsoluteTimeGetCurrent() - start, 0.25);
+}
+
+- (void)testLimitsBandwidth {
+    self.server.bytesPerSecond = 20000;
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    __block id dashboard = nil;
+
+    [self waitForRequests:^(dispatch_group_t group) {
+        dispatch_group_enter(group);
+        [self.client dashboard:nil callback:^(id response, NSError *error) {
+            dashboard = response;
+            dispatch_group_leave(group);
+        }];
+    }];
+
+    NSData *body = [NSJSONSerialization dataWithJSONObject:@{ @"posts" : [self posts] } options:0 error:nil];
+
+    XCTAssertEqual([dashboard[@"posts"] count], TMAPIClientLoadTestsPostCount);
+    XCTAssertGreaterThanOrEqual(CFAbsoluteTimeGetCurrent() - start, (body.length - 20000 * 0.05) / 20000.0);
+}
+
+- (void)testInjectsErrors {
+    self.client.maximumRetryCount = 0;
+    self.client.hedgesRequests = NO;
+
+    self.server.errorRate = 1;
+    self.server.errorStatusCode = 503;
+
+    __block NSError *statusError = nil;
+    __block NSError *connectionError = nil;
+
+    [self waitForRequests:^(dispatch_group_t group) {
+        dispatch_group_enter(group);
+        [self.client blogInfo:@"blog1" callback:^(id response, NSError *error) {
+            statusError = error;
+            dispatch_group_leave(group);
+        }];
+    }];
+
+    self.server.errorStatusCode = 0;
+
+    [self waitForRequests:^(dispatch_group_t group) {
+        dispatch_group_enter(group);
+        [self.client blogInfo:@"blog2" callback:^(id response, NSError *error) {
+            connectionError = error;
+            dispatch_group_leave(group);
+        }];
+    }];
+
+    XCTAssertEqual(statusError.code, (NSInteger)503);
+    XCTAssertEqualObjects(connectionError.domain, NSURLErrorDomain);
+    XCTAssertEqual(self.server.injectedErrorCount, self.server.requestCount);
+}
+
+#pragma mark - Coalescing
+
+- (void)testCancellingOneCoalescedCallbackKeepsTheSharedRequest {
+    self.server.latency = TMAPIClientLoadTestsCoalescingLatency;
+    self.client.hedgesRequests = NO;
+
+    TMCancellationToken *cancelledToken = [[TMCancellationToken alloc] initWithDeadline:nil];
+    JXHTTPOperation *sentRequest = [self.client blogInfoRequest:@"blog1"];
+    __block id cancelledResponse = nil;
+    __block id response = nil;
+
+    [self waitForRequests:^(dispatch_group_t group) {
+        [self.client sendRequest:sentRequest queue:self.client.defaultCallbackQueue token:cancelledToken
+                        callback:^(id blockResponse, NSError *error) {
+                            cancelledResponse = blockResponse;
+                        }];
+
+        dispatch_group_enter(group);
+        [self.client sendRequest:[self.client blogInfoRequest:@"blog1"] queue:self.client.defaultCallbackQueue
+                           token:[[TMCancellationToken alloc] initWithDeadline:nil]
+                        callback:^(id blockResponse, NSError *error) {
+                            response = blockResponse;
+                            dispatch_group_leave(group);
+                        }];
+
+        [cancelledToken cancel];
+    }];
+
+    XCTAssertEqual(self.client.coalescedRequestCount, (NSUInteger)1);
+    XCTAssertFalse(sentRequest.isCancelled);
+    XCTAssertEqualObjects(response[@"blog"][@"name"], [self blog][@"name"]);
+    XCTAssertNil(cancelledResponse);
+    XCTAssertEqual(self.server.requestCount, (NSUInteger)1);
+}
+
+- (void)testCancellingEveryCoalescedCallbackCancelsTheSharedRequest {
+    self.server.latency = TMAPIClientLoadTestsCoalescingLatency;
+    self.client.hedgesRequests = NO;
+
+    NSArray *tokens = @[ [[TMCancellationToken alloc] initWithDeadline:nil],
+                         [[TMCancellationToken alloc] initWithDeadline:nil] ];
+    NSMutableArray *requests = [[NSMutableArray alloc] initWithCapacity:tokens.count];
+    __block NSUInteger callbackCount = 0;
+
+    for (TMCancellationToken *token in tokens) {
+        JXHTTPOperation *request = [self.client blogInfoRequest:@"blog1"];
+        [requests addObject:request];
+
+        [self.client sendRequest:request queue:self.client.defaultCallbackQueue token:token
+                        callback:^(id response, NSError *error) {
+                            @synchronized (requests) {
+                                callbackCount++;
+                            }
+                        }];
+    }
+
+    XCTAssertEqual(self.client.coalescedRequestCount, (NSUInteger)1);
+
+    [tokens[0] cancel];
+    XCTAssertFalse([requests[0] isCancelled]);
+
+    [tokens[1] cancel];
+
+    // The attached request is finished along with the one that was sent
+    for (JXHTTPOperation *request in requests) {
+        [request waitUntilFinished];
+    }
+
+    XCTAssertTrue([requests[0] isCancelled]);
+
+    // Long enough for a response that was still on its way to have arrived
+    [NSThread sleepForTimeInterval:TMAPIClientLoadTestsCoalescingLatency * 2];
+
+    XCTAssertEqual(self.server.requestCount, (NSUInteger)1);
+    XCTAssertEqual(self.server.bytesSent, 0ULL);
+    XCTAssertEqual(callbackCount, (NSUInteger)0);
+}
+
+#pragma mark - Compression
+
+/**
+ Sends the same dashboard reads and posts with compression off and then on, over a link with mobile bandwidth. Bytes on
+ the wire are asserted to shrink; they and the wall time are logged.
+ */
+- (void)testCompressesResponsesAndBodies {
+    self.server.bytesPerSecond = TMAPIClientLoadTestsCompressionBytesPerSecond;
+
+    NSArray *plainResponses = nil;
+    NSTimeInterval plainDuration = [self sendCompressionRequestsWithResponses:&plainResponses];
+    unsigned long long plainSent = self.server.bytesSent;
+    unsigned long long plainReceived = self.server.bytesReceived;
+
+    self.server.compressesResponses = YES;
+    self.client.requestBodyCompressionThreshold = 1;
+    [self.server start];
+
+    NSArray *compressedResponses = nil;
+    NSTimeInterval compressedDuration = [self sendCompressionRequestsWithResponses:&compressedResponses];
+    unsigned long long compressedSent = self.server.bytesSent;
+    unsigned long long compressedReceived = self.server.bytesReceived;
+
+    // Decoded by the time the client sees them, so nothing else about the responses changes
+    XCTAssertEqualObjects(compressedResponses, plainResponses);
+    XCTAssertLessThan(compressedSent, plainSent);
+    XCTAssertLessThan(compressedReceived, plainReceived);
+
+    NSLog(@"Uncompressed: %llu bytes down, %llu bytes up in %.2f s", plainSent, plainReceived, plainDuration);
+    NSLog(@"Compressed: %llu bytes down (%.0f%%), %llu bytes up (%.0f%%) in %.2f s (%.0f%%)", compressedSent,
+          compressedSent * 100.0 / plainSent, compressedReceived, compressedReceived * 100.0 / plainReceived,
+          compressedDuration, compressedDuration * 100 / plainDuration);
+}
+
+#pragma mark - Load
+
+/**
+ Sends thousands of requests at once through the whole client stack, mostly dashboard and blog reads with some posts,
+ against a server with realistic latency and occasional failures. Throughput and latency percentiles are logged rather
+ than asserted on, since they depend on the device.
+ */
+- (void)testLoad {
+    self.server.latency = 0.02;
+    self.server.latencyJitter = 0.08;
+    self.server.errorRate = 0.01;
+    self.server.errorStatusCode = 503;
+
+    NSMutableArray *samples = [[NSMutableArray alloc] initWithCapacity:TMAPIClientLoadTestsRequestCount];
+    __block NSUInteger errorCount = 0;
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    [self waitForRequests:^(dispatch_group_t group) {
+        for (NSUInteger i = 0; i < TMAPIClientLoadTestsRequestCount; i++) {
+            CFAbsoluteTime requestStart = CFAbsoluteTimeGetCurrent();
+
+            TMAPICallback callback = ^(id response, NSError *error) {
+                @synchronized (samples) {
+                    [samples addObject:@(CFAbsoluteTimeGetCurrent() - requestStart)];
+
+                    if (error) {
+                        errorCount++;
+                    }
+                }
+
+                dispatch_group_leave(group);
+            };
+
+            NSString *blogName = [NSString stringWithFormat:@"blog%lu", (unsigned long)(i % TMAPIClientLoadTestsBlogCount)];
+
+            dispatch_group_enter(group);
+
+            switch (i % 10) {
+                case 0: case 1: case 2: case 3: case 4:
+                    [self.client dashboard:@{ @"offset" : @(i) } callback:callback];
+                    break;
+                case 5: case 6:
+                    [self.client blogInfo:blogName callback:callback];
+                    break;
+                case 7: case 8:
+                    [self.client posts:blogName type:nil parameters:@{ @"offset" : @(i) } callback:callback];
+                    break;
+                default:
+                    [self.client post:blogName type:@"text" parameters:@{ @"body" : [self postBody] } callback:callback];
+                    break;
+            }
+        }
+    }];
+
+    NSTimeInterval duration = CFAbsoluteTimeGetCurrent() - start;
+
+    XCTAssertEqual(samples.count, TMAPIClientLoadTestsRequestCount);
+
+    NSLog(@"%lu requests in %.2f s (%.0f requests/s), %lu failed, %lu sent to the server with %lu errors injected",
+          (unsigned long)samples.count, duration, samples.count / duration, (unsigned long)errorCount,
+          (unsigned long)self.server.requestCount, (unsigned long)self.server.injectedErrorCount);
+    NSLog(@"Latency: p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms", TMBenchmarkPercentile(samples, 0.5) * 1000,
+          TMBenchmarkPercentile(samples, 0.9) * 1000, TMBenchmarkPercentile(samples, 0.99) * 1000,
+          TMBenchmarkPercentile(samples, 1) * 1000);
+    NSLog(@"Retried %lu, hedged %lu, coalesced %lu", (unsigned long)self.client.retriedRequestCount,
+          (unsigned long)self.client.hedgedRequestCount, (unsigned long)self.client.coalescedRequestCount);
+}
+
+#pragma mark - Private
+
+// Alternates dashboard reads with posts, one at a time so that each has the bandwidth to itself
+- (NSTimeInterval)sendCompressionRequestsWithResponses:(NSArray **)responses {
+    NSMutableArray *receivedResponses = [[NSMutableArray alloc] initWithCapacity:TMAPIClientLoadTestsCompressionRequestCount];
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    for (NSUInteger i = 0; i < TMAPIClientLoadTestsCompressionRequestCount; i++) {
+        [self waitForRequests:^(dispatch_group_t group) {
+            TMAPICallback callback = ^(id response, NSError *error) {
+                [receivedResponses addObject:response ?: [NSNull null]];
+                dispatch_group_leave(group);
+            };
+
+            dispatch_group_enter(group);
+
+            if (i % 2) {
+                [self.client post:@"blog" type:@"text" parameters:@{ @"body" : [self postBody] } callback:callback];
+            } else {
+                [self.client dashboard:@{ @"offset" : @(i) } callback:callback];
+            }
+        }];
+    }
+
+    *responses = receivedResponses;
+
+    return CFAbsoluteTimeGetCurrent() - start;
+}
+
+
+// Every request entered into the group has to leave it before the timeout
+- (void)waitForRequests:(void (^)(dispatch_group_t group))block {
+    dispatch_group_t group = dispatch_group_create();
+
+    block(group);
+
+    long result = dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW,
+                                                           (int64_t)(TMAPIClientLoadTestsTimeout * NSEC_PER_SEC)));
+    XCTAssertEqual(result, 0L, @"Requests timed out");
+}
+
+- (NSDictionary *)blog {
+    return @{ @"name" : @"blog", @"title" : @"A blog", @"posts" : @1000, @"updated" : @1402000000,
+              @"description" : @"Recorded from blog/blog.tumblr.com/info", @"ask" : @NO, @"likes" : @12 };
+}
+
+- (NSArray *)posts {
+    NSMutableArray *posts = [[NSMutableArray alloc] initWithCapacity:TMAPIClientLoadTestsPostCount];
+
+    for (NSUInteger i = 0; i < TMAPIClientLoadTestsPostCount; i++) {
+        [posts addObject:@{
+                           @"id" : @(46000000000 + i),
+                           @"blog_name" : [NSString stringWithFormat:@"blog%lu", (unsigned long)i],
+                           @"type" : @"text",
+                           @"timestamp" : @(1402000000 + i),
+                           @"note_count" : @(i * 7),
+                           @"tags" : @[@"one", @"two", @"three"],
+                           @"body" : [self postBody],
+                           @"reblog_key" : @"aBcDeFgH",
+                           @"liked" : @NO,
+                           }];
+    }
+
+    return posts;
+}
+
+- (NSString *)postBody {
+    return [@"" stringByPaddingToLength:1000 withString:@"<p>Lorem ipsum dolor sit amet, “quoted” ☃</p>" startingAtIndex:0];
+}
+
+@end
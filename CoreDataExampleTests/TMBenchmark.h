@@ -0,0 +1,27 @@
+//
+//  TMBenchmark.h
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Run a block repeatedly and return the median duration of one run, in seconds. The block is run once beforehand so that
+ caches and lazily loaded code don't count against the first sample.
+ */
+NSTimeInterval TMBenchmarkMedianDuration(NSUInteger runCount, void (^block)(void));
+
+/**
+ Log a before and after comparison of two medians, e.g. `TMBenchmarkLog(@"decode", old, new)`.
+ */
+void TMBenchmarkLog(NSString *name, NSTimeInterval baselineDuration, NSTimeInterval duration);
+
+/**
+ The value below which the given fraction of the samples fall, e.g. 0.99 for the 99th percentile.
+
+ @param samples `NSNumber` durations, in any order
+ */
+NSTimeInterval TMBenchmarkPercentile(NSArray *samples, double fraction);
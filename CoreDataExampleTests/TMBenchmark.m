@@ -0,0 +1,41 @@
+//
+//  TMBenchmark.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMBenchmark.h"
+
+NSTimeInterval TMBenchmarkMedianDuration(NSUInteger runCount, void (^block)(void)) {
+    block();
+
+    NSMutableArray *samples = [[NSMutableArray alloc] initWithCapacity:runCount];
+
+    for (NSUInteger i = 0; i < runCount; i++) {
+        @autoreleasepool {
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            block();
+            [samples addObject:@(CFAbsoluteTimeGetCurrent() - start)];
+        }
+    }
+
+    return TMBenchmarkPercentile(samples, 0.5);
+}
+
+void TMBenchmarkLog(NSString *name, NSTimeInterval baselineDuration, NSTimeInterval duration) {
+    NSLog(@"%@: %.3f ms before, %.3f ms after (%.2fx)", name, baselineDuration * 1000, duration * 1000,
+          duration > 0 ? baselineDuration / duration : 0);
+}
+
+NSTimeInterval TMBenchmarkPercentile(NSArray *samples, double fraction) {
+    if (samples.count == 0) {
+        return 0;
+    }
+
+    NSArray *sortedSamples = [samples sortedArrayUsingSelector:@selector(compare:)];
+    NSUInteger index = MIN((NSUInteger)(fraction * sortedSamples.count), sortedSamples.count - 1);
+
+    return [sortedSamples[index] doubleValue];
+}
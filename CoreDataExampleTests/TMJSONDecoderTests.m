@@ -0,0 +1,161 @@
+//
+//  TMJSONDecoderTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TMBenchmark.h"
+#import "TMJSONDecoder.h"
+
+static NSUInteger const TMJSONDecoderTestsPostCount = 200;
+static NSUInteger const TMJSONDecoderTestsRunCount = 50;
+
+@interface TMJSONDecoderTests : XCTestCase
+
+@end
+
+@implementation TMJSONDecoderTests
+
+#pragma mark - Parity with NSJSONSerialization
+
+- (void)testDecodesWellFormedDocumentsLikeFoundation {
+    NSArray *documents = @[@"{}", @"[]", @"0", @"12", @"-1.5e3", @"1E+2", @"0.25", @"9223372036854775807",
+                           @"true", @"false", @"null", @"\"\"",
+                           @"\"caf\\u00e9 \\ud83d\\ude00 \\\" \\\\ \\/ \\b\\f\\n\\r\\t\"", @"\"café ☃ 😀\"",
+                           @"{\"a\":1,\"b\":[true,false,null],\"c\":{\"d\":\"e\"}}", @" [ 1 , { \"x\" : [ ] } ] ",
+                           @"{\"\\u0061\":\"escaped key\"}"];
+
+    for (NSString *document in documents) {
+        NSData *data = [document dataUsingEncoding:NSUTF8StringEncoding];
+        id expected = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:nil];
+
+        NSError *error = nil;
+        id decoded = [TMJSONDecoder JSONObjectWithData:data error:&error];
+
+        XCTAssertNil(error, @"%@", document);
+        XCTAssertEqualObjects(decoded, expected, @"%@", document);
+    }
+}
+
+- (void)testRejectsMalformedDocumentsLikeFoundation {
+    NSArray *documents = @[@"01", @"-", @"1.", @".5", @"+1", @"1e", @"1e+", @"0x10", @"1.5.2", @"--1",
+                           @"[1,]", @"{\"a\"}", @"{\"a\":1,}", @"[1 2]", @"tru", @"nul", @"\"\\x\"", @"\"\\u12\"",
+                           @"\"\\ud83d\"", @"\"\\ude00\"", @"\"\\ud83d\\u0041\"", @"\"a\tb\"", @"\"a\nb\"", @"\"abc",
+                           @"[1]]", @"{} {}"];
+
+    for (NSString *document in documents) {
+        NSData *data = [document dataUsingEncoding:NSUTF8StringEncoding];
+        [self assertData:data isRejectedWithDescription:document];
+    }
+}
+
+- (void)testRejectsInvalidUTF8 {
+    // A stray continuation byte, overlong slash, truncated sequence, overlong NUL, surrogate, code point past U+10FFFF,
+    // five byte form, and a byte that never appears in UTF-8
+    const char *sequences[] = {"\x80", "\xC0\xAF", "\xC3", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+                               "\xF8\x88\x80\x80\x80", "\xFF"};
+
+    for (NSUInteger i = 0; i < sizeof(sequences) / sizeof(sequences[0]); i++) {
+        NSMutableData *data = [[NSMutableData alloc] initWithBytes:"[\"ok " length:5];
+        [data appendBytes:sequences[i] length:strlen(sequences[i])];
+        [data appendBytes:"\"]" length:2];
+
+        [self assertData:data isRejectedWithDescription:[data description]];
+    }
+}
+
+- (void)testLooksUpKeysOfEveryLength {
+    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] init];
+
+    for (NSUInteger length = 1; length <= 40; length++) {
+        dictionary[[@"" stringByPaddingToLength:length withString:@"k" startingAtIndex:0]] = @(length);
+    }
+
+    dictionary[@"ünïcödé"] = @"value";
+
+    NSData *data = [NSJSONSerialization dataWithJSONObject:dictionary options:0 error:nil];
+    NSDictionary *decoded = [TMJSONDecoder JSONObjectWithData:data error:nil];
+
+    for (NSString *key in dictionary) {
+        XCTAssertEqualObjects(decoded[key], dictionary[key], @"%@", key);
+    }
+
+    XCTAssertNil(decoded[@"kk "]);
+    XCTAssertNil(decoded[@"missing"]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ Decodes a dashboard-sized payload and reads the fields the example app stores for each post, with both decoders.
+ Durations are logged rather than asserted on, since they depend on the device.
+ */
+- (void)testDashboardDecodingThroughput {
+    NSData *data = [self dashboardPayload];
+
+    __block NSUInteger checksum = 0;
+
+    void (^readPosts)(NSDictionary *) = ^(NSDictionary *JSON) {
+        for (NSDictionary *post in JSON[@"response"][@"posts"]) {
+            checksum += [post[@"id"] unsignedIntegerValue] + [post[@"blog_name"] length] + [post[@"type"] length];
+        }
+    };
+
+    NSTimeInterval foundationDuration = TMBenchmarkMedianDuration(TMJSONDecoderTestsRunCount, ^{
+        readPosts([NSJSONSerialization JSONObjectWithData:data options:0 error:nil]);
+    });
+
+    NSUInteger foundationChecksum = checksum;
+    checksum = 0;
+
+    NSTimeInterval decoderDuration = TMBenchmarkMedianDuration(TMJSONDecoderTestsRunCount, ^{
+        readPosts([TMJSONDecoder JSONObjectWithData:data error:nil]);
+    });
+
+    XCTAssertEqual(checksum, foundationChecksum);
+
+    TMBenchmarkLog([NSString stringWithFormat:@"Dashboard, %lu bytes: NSJSONSerialization vs. TMJSONDecoder",
+                    (unsigned long)data.length], foundationDuration, decoderDuration);
+}
+
+#pragma mark - Private
+
+- (void)assertData:(NSData *)data isRejectedWithDescription:(NSString *)description {
+    XCTAssertNil([NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:nil],
+                 @"Foundation accepts %@", description);
+
+    NSError *error = nil;
+    XCTAssertNil([TMJSONDecoder JSONObjectWithData:data error:&error], @"%@", description);
+    XCTAssertNotNil(error, @"%@", description);
+}
+
+- (NSData *)dashboardPayload {
+    NSMutableArray *posts = [[NSMutableArray alloc] initWithCapacity:TMJSONDecoderTestsPostCount];
+
+    for (NSUInteger i = 0; i < TMJSONDecoderTestsPostCount; i++) {
+        NSString *body = [@"" stringByPaddingToLength:2000 withString:@"<p>Lorem ipsum dolor sit amet, “quoted” ☃</p>"
+                                     startingAtIndex:0];
+
+        [posts addObject:@{
+                           @"id" : @(46000000000 + i),
+                           @"blog_name" : [NSString stringWithFormat:@"blog%lu", (unsigned long)i],
+                           @"type" : @"text",
+                           @"timestamp" : @(1402000000 + i),
+                           @"note_count" : @(i * 7),
+                           @"tags" : @[@"one", @"two", @"three"],
+                           @"body" : body,
+                           @"reblog_key" : @"aBcDeFgH",
+                           @"liked" : @NO,
+                           @"trail" : @[@{ @"blog" : @{ @"name" : @"someone" }, @"content" : body }],
+                           }];
+    }
+
+    NSDictionary *JSON = @{ @"meta" : @{ @"status" : @200, @"msg" : @"OK" }, @"response" : @{ @"posts" : posts } };
+
+    return [NSJSONSerialization dataWithJSONObject:JSON options:0 error:nil];
+}
+
+@end
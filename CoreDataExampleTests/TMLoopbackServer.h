@@ -0,0 +1,47 @@
+//
+//  TMLoopbackServer.h
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ A minimal HTTP/1.1 server listening on a real socket on 127.0.0.1, for tests that need connections to go through the
+ system's networking stack rather than a URL protocol.
+
+ Every request, whatever its method or path, is answered with `responseBody` after `responseDelay`. Connections are
+ kept alive, and each one is served on a thread of its own.
+
+ Configure the server before starting it, not while requests are in flight.
+ */
+@interface TMLoopbackServer : NSObject
+
+/// `http://127.0.0.1:<port>/`, or `nil` until the server has been started
+@property (nonatomic, copy, readonly) NSURL *baseURL;
+
+/// Body every request is answered with, empty by default
+@property (nonatomic, copy) NSData *responseBody;
+
+/// Seconds every response is held back for
+@property (nonatomic) NSTimeInterval responseDelay;
+
+/// Number of TCP connections the server has accepted since it was started
+@property (readonly) NSUInteger acceptedConnectionCount;
+
+/// Number of requests the server has answered since it was started
+@property (readonly) NSUInteger requestCount;
+
+/**
+ Start listening on a port chosen by the system.
+
+ @return `NO` if no socket could be opened
+ */
+- (BOOL)start;
+
+/// Stop listening and close every open connection
+- (void)stop;
+
+@end
@@ -0,0 +1,222 @@
+//
+//  TMLoopbackServer.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMLoopbackServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static NSUInteger const TMLoopbackServerReadLength = 16 * 1024;
+
+@interface TMLoopbackServer()
+
+@property (nonatomic, copy) NSURL *baseURL;
+@property (nonatomic, strong) dispatch_source_t acceptSource;
+@property (nonatomic, strong) NSMutableSet *clientSockets;
+@property NSUInteger acceptedConnectionCount;
+@property NSUInteger requestCount;
+
+@end
+
+@implementation TMLoopbackServer
+
+- (id)init {
+    if (self = [super init]) {
+        self.responseBody = [NSData data];
+        self.clientSockets = [[NSMutableSet alloc] init];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [self stop];
+}
+
+- (BOOL)start {
+    int listeningSocket = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (listeningSocket < 0) {
+        return NO;
+    }
+
+    int on = 1;
+    setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_len = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    socklen_t addressLength = sizeof(address);
+
+    if (bind(listeningSocket, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(listeningSocket, SOMAXCONN) != 0
+        || getsockname(listeningSocket, (struct sockaddr *)&address, &addressLength) != 0) {
+        close(listeningSocket);
+        return NO;
+    }
+
+    self.acceptedConnectionCount = 0;
+    self.requestCount = 0;
+    self.baseURL = [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%u/", ntohs(address.sin_port)]];
+
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    self.acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)listeningSocket, 0, queue);
+
+    __weak TMLoopbackServer *weakSelf = self;
+
+    dispatch_source_set_event_handler(self.acceptSource, ^{
+        int clientSocket = accept(listeningSocket, NULL, NULL);
+        TMLoopbackServer *server = weakSelf;
+
+        if (clientSocket < 0) {
+            return;
+        }
+
+        if (!server) {
+            close(clientSocket);
+            return;
+        }
+
+        setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+
+        @synchronized (server) {
+            server.acceptedConnectionCount++;
+            [server.clientSockets addObject:@(clientSocket)];
+        }
+
+        // Each connection blocks on its own thread, which is plenty for the handful a client keeps open per host
+        [NSThread detachNewThreadSelector:@selector(serveSocket:) toTarget:server withObject:@(clientSocket)];
+    });
+
+    dispatch_source_set_cancel_handler(self.acceptSource, ^{
+        close(listeningSocket);
+    });
+
+    dispatch_resume(self.acceptSource);
+
+    return YES;
+}
+
+- (void)stop {
+    if (self.acceptSource) {
+        dispatch_source_cancel(self.acceptSource);
+        self.acceptSource = nil;
+    }
+
+    @synchronized (self) {
+        for (NSNumber *clientSocket in self.clientSockets) {
+            shutdown([clientSocket intValue], SHUT_RDWR);
+        }
+    }
+}
+
+#pragma mark - Private
+
+- (void)serveSocket:(NSNumber *)socketNumber {
+    int clientSocket = [socketNumber intValue];
+    NSMutableData *received = [[NSMutableData alloc] init];
+    uint8_t buffer[TMLoopbackServerReadLength];
+
+    while (YES) {
+        @autoreleasepool {
+            NSRange headerEnd = [received rangeOfData:[NSData dataWithBytes:"\r\n\r\n" length:4] options:0
+                                                range:NSMakeRange(0, received.length)];
+
+            if (headerEnd.location == NSNotFound) {
+                ssize_t readLength = read(clientSocket, buffer, sizeof(buffer));
+
+                if (readLength <= 0) {
+                    break;
+                }
+
+                [received appendBytes:buffer length:(NSUInteger)readLength];
+                continue;
+            }
+
+            NSUInteger bodyLength = [self contentLengthOfHeader:[received subdataWithRange:
+                                                                 NSMakeRange(0, headerEnd.location)]];
+            NSUInteger requestLength = NSMaxRange(headerEnd) + bodyLength;
+
+            if (received.length < requestLength) {
+                ssize_t readLength = read(clientSocket, buffer, sizeof(buffer));
+
+                if (readLength <= 0) {
+                    break;
+                }
+
+                [received appendBytes:buffer length:(NSUInteger)readLength];
+                continue;
+            }
+
+            [received replaceBytesInRange:NSMakeRange(0, requestLength) withBytes:NULL length:0];
+
+            if (self.responseDelay > 0) {
+                [NSThread sleepForTimeInterval:self.responseDelay];
+            }
+
+            if (![self writeResponseToSocket:clientSocket]) {
+                break;
+            }
+
+            @synchronized (self) {
+                self.requestCount++;
+            }
+        }
+    }
+
+    @synchronized (self) {
+        [self.clientSockets removeObject:socketNumber];
+    }
+
+    close(clientSocket);
+}
+
+- (NSUInteger)contentLengthOfHeader:(NSData *)header {
+    NSString *headerString = [[NSString alloc] initWithData:header encoding:NSISOLatin1StringEncoding];
+
+    for (NSString *line in [headerString componentsSeparatedByString:@"\r\n"]) {
+        if ([[line lowercaseString] hasPrefix:@"content-length:"]) {
+            return (NSUInteger)[[line substringFromIndex:@"content-length:".length] integerValue];
+        }
+    }
+
+    return 0;
+}
+
+- (BOOL)writeResponseToSocket:(int)clientSocket {
+    NSData *body = self.responseBody;
+    NSString *header = [NSString stringWithFormat:@"HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                                                  @"Content-Length: %lu\r\nConnection: keep-alive\r\n\r\n",
+                        (unsigned long)body.length];
+
+    NSMutableData *response = [[NSMutableData alloc] initWithData:[header dataUsingEncoding:NSASCIIStringEncoding]];
+    [response appendData:body];
+
+    const uint8_t *bytes = response.bytes;
+    NSUInteger offset = 0;
+
+    while (offset < response.length) {
+        ssize_t writtenLength = write(clientSocket, bytes + offset, response.length - offset);
+
+        if (writtenLength <= 0) {
+            return NO;
+        }
+
+        offset += (NSUInteger)writtenLength;
+    }
+
+    return YES;
+}
+
+@end
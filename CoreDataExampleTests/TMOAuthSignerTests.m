@@ -0,0 +1,173 @@
+//
+//  TMOAuthSignerTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TMBenchmark.h"
+#import "TMOAuth.h"
+#import "TMOAuthSigner.h"
+
+static NSString * const TMOAuthSignerTestsConsumerKey = @"consumer key";
+static NSString * const TMOAuthSignerTestsConsumerSecret = @"consumer secret";
+static NSString * const TMOAuthSignerTestsToken = @"token";
+static NSString * const TMOAuthSignerTestsTokenSecret = @"token secret ☃";
+
+static NSUInteger const TMOAuthSignerTestsBatchSize = 20;
+static NSUInteger const TMOAuthSignerTestsRunCount = 50;
+
+@interface TMOAuthSignerTests : XCTestCase
+
+@end
+
+@implementation TMOAuthSignerTests
+
+#pragma mark - Parity with TMOAuth
+
+- (void)testSignsLikeTMOAuth {
+    TMOAuthSigner *signer = [self signer];
+
+    for (NSDictionary *request in [self requests]) {
+        NSDictionary *expected = nil;
+        NSDictionary *parameters = nil;
+
+        // Both read the clock, so try again if a second boundary fell between them
+        for (NSUInteger attempt = 0; attempt < 3; attempt++) {
+            expected = [self parametersOfHeader:[self TMOAuthHeaderForRequest:request]];
+            parameters = [self parametersOfHeader:[signer headerForURL:request[TMOAuthSignerURLKey]
+                                                                method:request[TMOAuthSignerMethodKey]
+                                                        postParameters:request[TMOAuthSignerPostParametersKey]
+                                                                 nonce:request[TMOAuthSignerNonceKey]]];
+
+            if ([expected[@"oauth_timestamp"] isEqualToString:parameters[@"oauth_timestamp"]]) {
+                break;
+            }
+        }
+
+        XCTAssertEqualObjects(parameters, expected, @"%@", request);
+    }
+}
+
+- (void)testSignsBatchesLikeSingleRequests {
+    TMOAuthSigner *signer = [self signer];
+    NSArray *requests = [self requests];
+    NSArray *headers = [signer headersForRequests:requests];
+
+    XCTAssertEqual(headers.count, requests.count);
+
+    for (NSUInteger i = 0; i < requests.count; i++) {
+        NSDictionary *request = requests[i];
+        NSString *header = [signer headerForURL:request[TMOAuthSignerURLKey] method:request[TMOAuthSignerMethodKey]
+                                 postParameters:request[TMOAuthSignerPostParametersKey]
+                                          nonce:request[TMOAuthSignerNonceKey]];
+
+        NSDictionary *parameters = [self parametersOfHeader:headers[i]];
+        NSDictionary *expected = [self parametersOfHeader:header];
+
+        if ([parameters[@"oauth_timestamp"] isEqualToString:expected[@"oauth_timestamp"]]) {
+            XCTAssertEqualObjects(parameters, expected, @"%@", request);
+        }
+    }
+}
+
+- (void)testRecognizesItsCredentials {
+    TMOAuthSigner *signer = [self signer];
+
+    XCTAssertTrue([signer isSignerForConsumerKey:TMOAuthSignerTestsConsumerKey
+                                  consumerSecret:TMOAuthSignerTestsConsumerSecret token:TMOAuthSignerTestsToken
+                                     tokenSecret:TMOAuthSignerTestsTokenSecret]);
+    XCTAssertFalse([signer isSignerForConsumerKey:TMOAuthSignerTestsConsumerKey
+                                   consumerSecret:TMOAuthSignerTestsConsumerSecret token:TMOAuthSignerTestsToken
+                                      tokenSecret:@"other secret"]);
+}
+
+#pragma mark - Benchmarks
+
+/**
+ Signs a batch of API requests with `TMOAuth`, with `TMOAuthSigner` one request at a time, and with
+ `-[TMOAuthSigner headersForRequests:]`. Durations are logged rather than asserted on, since they depend on the device.
+ */
+- (void)testSigningThroughput {
+    NSArray *requests = [self requests];
+    TMOAuthSigner *signer = [self signer];
+
+    NSTimeInterval oauthDuration = TMBenchmarkMedianDuration(TMOAuthSignerTestsRunCount, ^{
+        for (NSDictionary *request in requests) {
+            [self TMOAuthHeaderForRequest:request];
+        }
+    });
+
+    NSTimeInterval signerDuration = TMBenchmarkMedianDuration(TMOAuthSignerTestsRunCount, ^{
+        for (NSDictionary *request in requests) {
+            [signer headerForURL:request[TMOAuthSignerURLKey] method:request[TMOAuthSignerMethodKey]
+                  postParameters:request[TMOAuthSignerPostParametersKey] nonce:request[TMOAuthSignerNonceKey]];
+        }
+    });
+
+    NSTimeInterval batchDuration = TMBenchmarkMedianDuration(TMOAuthSignerTestsRunCount, ^{
+        [signer headersForRequests:requests];
+    });
+
+    TMBenchmarkLog([NSString stringWithFormat:@"%lu requests: TMOAuth vs. TMOAuthSigner",
+                    (unsigned long)requests.count], oauthDuration, signerDuration);
+    TMBenchmarkLog([NSString stringWithFormat:@"%lu requests: TMOAuth vs. batched TMOAuthSigner",
+                    (unsigned long)requests.count], oauthDuration, batchDuration);
+}
+
+#pragma mark - Private
+
+- (TMOAuthSigner *)signer {
+    return [[TMOAuthSigner alloc] initWithConsumerKey:TMOAuthSignerTestsConsumerKey
+                                       consumerSecret:TMOAuthSignerTestsConsumerSecret token:TMOAuthSignerTestsToken
+                                          tokenSecret:TMOAuthSignerTestsTokenSecret];
+}
+
+- (NSString *)TMOAuthHeaderForRequest:(NSDictionary *)request {
+    return [TMOAuth headerForURL:request[TMOAuthSignerURLKey] method:request[TMOAuthSignerMethodKey]
+                  postParameters:request[TMOAuthSignerPostParametersKey] nonce:request[TMOAuthSignerNonceKey]
+                     consumerKey:TMOAuthSignerTestsConsumerKey consumerSecret:TMOAuthSignerTestsConsumerSecret
+                           token:TMOAuthSignerTestsToken tokenSecret:TMOAuthSignerTestsTokenSecret];
+}
+
+// The two list their parameters in different orders, so headers are compared as dictionaries
+- (NSDictionary *)parametersOfHeader:(NSString *)header {
+    NSMutableDictionary *parameters = [[NSMutableDictionary alloc] init];
+
+    for (NSString *component in [[header substringFromIndex:@"OAuth ".length] componentsSeparatedByString:@","]) {
+        NSRange separator = [component rangeOfString:@"="];
+        parameters[[component substringToIndex:separator.location]] = [component substringFromIndex:NSMaxRange(separator)];
+    }
+
+    return parameters;
+}
+
+- (NSArray *)requests {
+    NSMutableArray *requests = [[NSMutableArray alloc] initWithCapacity:TMOAuthSignerTestsBatchSize];
+
+    for (NSUInteger i = 0; i < TMOAuthSignerTestsBatchSize; i++) {
+        NSString *URLString = [NSString stringWithFormat:
+                               @"https://api.tumblr.com/v2/blog/blog%lu.tumblr.com/posts?offset=%lu&tag=caf%%C3%%A9",
+                               (unsigned long)i, (unsigned long)i * 20];
+
+        NSMutableDictionary *request = [[NSMutableDictionary alloc] initWithDictionary:@{
+                                        TMOAuthSignerURLKey : [NSURL URLWithString:URLString],
+                                        TMOAuthSignerMethodKey : i % 2 ? @"POST" : @"GET",
+                                        TMOAuthSignerNonceKey : [NSString stringWithFormat:@"nonce%lu", (unsigned long)i],
+                                        }];
+
+        if (i % 2) {
+            request[TMOAuthSignerPostParametersKey] = @{ @"type" : @"text", @"title" : @"Title ☃",
+                                                         @"body" : @"Hello, world! !*'();:@&=+$,/?%#[]",
+                                                         @"tags" : @"one,two" };
+        }
+
+        [requests addObject:request];
+    }
+
+    return requests;
+}
+
+@end
@@ -0,0 +1,250 @@
+//
+//  TMResumableUploadTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TMResumableUpload.h"
+#import "TMStandInServer.h"
+
+static NSUInteger const TMResumableUploadTestsFileLength = 100 * 1024;
+static NSUInteger const TMResumableUploadTestsChunkLength = 16 * 1024;
+static NSUInteger const TMResumableUploadTestsChunkCount = 7;
+static NSUInteger const TMResumableUploadTestsInterruptedChunkIndex = 3;
+static NSTimeInterval const TMResumableUploadTestsRetryBackoffInterval = 0.2;
+static NSTimeInterval const TMResumableUploadTestsTimeout = 30;
+
+@interface TMResumableUploadTests : XCTestCase
+
+@property (nonatomic, strong) TMStandInServer *server;
+@property (nonatomic, strong) JXHTTPOperationQueue *queue;
+@property (nonatomic, copy) NSString *directory;
+@property (nonatomic, copy) NSString *filePath;
+
+@end
+
+@implementation TMResumableUploadTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.server = [[TMStandInServer alloc] init];
+    [self.server replayAPIResponseWithStatusCode:200 response:@{ @"id" : @46000000000 } forMethod:@"POST"
+                                     pathPattern:@"upload"];
+    [self.server start];
+
+    self.queue = [[JXHTTPOperationQueue alloc] init];
+
+    NSString *directoryName = [NSString stringWithFormat:@"TMResumableUploadTests-%@", [[NSUUID UUID] UUIDString]];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:directoryName];
+    self.filePath = [self.directory stringByAppendingPathComponent:@"video.mp4"];
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil
+                                                    error:nil];
+    [[self randomDataWithLength:TMResumableUploadTestsFileLength] writeToFile:self.filePath atomically:YES];
+}
+
+- (void)tearDown {
+    [self.queue cancelAllOperations];
+    [self.server stop];
+
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+
+    [super tearDown];
+}
+
+#pragma mark - Resuming
+
+- (void)testResumesFromSavedProgressAfterADroppedConnection {
+    TMResumableUpload *upload = [self upload];
+    upload.maximumRetryCount = 0;
+
+    [self dropConnectionAfterChunkCount:TMResumableUploadTestsInterruptedChunkIndex ofUpload:upload];
+
+    NSError *error = [self runUpload:upload];
+
+    XCTAssertEqual(upload.chunkCount, TMResumableUploadTestsChunkCount);
+    XCTAssertEqual(error.code, (NSInteger)TMResumableUploadErrorChunkRejected);
+    XCTAssertEqual([error.userInfo[NSUnderlyingErrorKey] code], (NSInteger)NSURLErrorNetworkConnectionLost);
+    XCTAssertEqual(self.server.requestCount, TMResumableUploadTestsInterruptedChunkIndex + 1);
+
+    // As after a relaunch, with nothing carried over but the progress file
+    NSArray *pendingUploads = [TMResumableUpload pendingUploadsInDirectory:self.directory];
+    XCTAssertEqual(pendingUploads.count, (NSUInteger)1);
+
+    TMResumableUpload *resumedUpload = [pendingUploads firstObject];
+    XCTAssertEqualObjects(resumedUpload.identifier, upload.identifier);
+    XCTAssertEqual(resumedUpload.acknowledgedChunkCount, TMResumableUploadTestsInterruptedChunkIndex);
+
+    [self.server start];
+    [self configureUpload:resumedUpload];
+
+    error = [self runUpload:resumedUpload];
+
+    XCTAssertNil(error);
+    XCTAssertEqual(resumedUpload.acknowledgedChunkCount, TMResumableUploadTestsChunkCount);
+    XCTAssertEqual(self.server.requestCount, TMResumableUploadTestsChunkCount - TMResumableUploadTestsInterruptedChunkIndex);
+    XCTAssertEqual([TMResumableUpload pendingUploadsInDirectory:self.directory].count, (NSUInteger)0);
+}
+
+- (void)testRefusesToResumeAChangedFile {
+    TMResumableUpload *upload = [self upload];
+    upload.maximumRetryCount = 0;
+
+    [self dropConnectionAfterChunkCount:TMResumableUploadTestsInterruptedChunkIndex ofUpload:upload];
+
+    XCTAssertEqual([self runUpload:upload].code, (NSInteger)TMResumableUploadErrorChunkRejected);
+
+    // Same length, different bytes. The date is moved on too, since a filesystem with one second timestamps could miss
+    // a rewrite this quick.
+    [[self randomDataWithLength:TMResumableUploadTestsFileLength] writeToFile:self.filePath atomically:YES];
+    [[NSFileManager defaultManager] setAttributes:@{ NSFileModificationDate : [NSDate dateWithTimeIntervalSinceNow:60] }
+                                     ofItemAtPath:self.filePath error:nil];
+
+    TMResumableUpload *resumedUpload = [[TMResumableUpload pendingUploadsInDirectory:self.directory] firstObject];
+    [self configureUpload:resumedUpload];
+
+    [self.server start];
+
+    NSError *error = [self runUpload:resumedUpload];
+
+    XCTAssertEqualObjects(error.domain, TMResumableUploadErrorDomain);
+    XCTAssertEqual(error.code, (NSInteger)TMResumableUploadErrorFileChanged);
+    XCTAssertEqual(resumedUpload.acknowledgedChunkCount, TMResumableUploadTestsInterruptedChunkIndex);
+    XCTAssertEqual(self.server.requestCount, (NSUInteger)0);
+}
+
+#pragma mark - Retrying
+
+- (void)testRetriesServerErrorsWithBackoff {
+    self.server.errorStatusCode = 503;
+
+    TMResumableUpload *upload = [self upload];
+    upload.maximumRetryCount = 3;
+    upload.retryBackoffInterval = TMResumableUploadTestsRetryBackoffInterval;
+
+    __weak TMStandInServer *server = self.server;
+
+    upload.progressBlock = ^(TMResumableUpload *upload) {
+        if (upload.acknowledgedChunkCount == TMResumableUploadTestsInterruptedChunkIndex) {
+            [server failNextRequests:2];
+        }
+    };
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    NSError *error = [self runUpload:upload];
+
+    XCTAssertNil(error);
+    XCTAssertEqual(upload.acknowledgedChunkCount, TMResumableUploadTestsChunkCount);
+    XCTAssertEqual(self.server.injectedErrorCount, (NSUInteger)2);
+    XCTAssertEqual(self.server.requestCount, TMResumableUploadTestsChunkCount + 2);
+
+    // The backoff is randomized, anywhere up to its ceiling, so it's logged rather than asserted on
+    NSLog(@"Uploaded %lu chunks with 2 retries in %.2f s", (unsigned long)upload.chunkCount,
+          CFAbsoluteTimeGetCurrent() - start);
+}
+
+- (void)testStopsOnceRetriesRunOut {
+    self.server.errorStatusCode = 503;
+    [self.server failNextRequests:3];
+
+    TMResumableUpload *upload = [self upload];
+    upload.maximumRetryCount = 2;
+    upload.retryBackoffInterval = TMResumableUploadTestsRetryBackoffInterval;
+
+    NSError *error = [self runUpload:upload];
+
+    XCTAssertEqual(error.code, (NSInteger)TMResumableUploadErrorChunkRejected);
+    XCTAssertEqual(upload.acknowledgedChunkCount, (NSUInteger)0);
+    XCTAssertEqual(self.server.requestCount, (NSUInteger)3);
+    XCTAssertEqual([TMResumableUpload pendingUploadsInDirectory:self.directory].count, (NSUInteger)1);
+}
+
+#pragma mark - Requests
+
+- (void)testStopsWhenTheRequestHasNoMultipartBody {
+    TMResumableUpload *upload = [self upload];
+
+    upload.requestBlock = ^JXHTTPOperation *(NSURL *URL, NSDictionary *parameters) {
+        JXHTTPOperation *request = [[JXHTTPOperation alloc] initWithURL:URL];
+        request.requestMethod = @"POST";
+        request.requestBody = [JXHTTPFormEncodedBody withDictionary:parameters];
+
+        return request;
+    };
+
+    NSError *error = [self runUpload:upload];
+
+    XCTAssertEqual(error.code, (NSInteger)TMResumableUploadErrorInvalidRequest);
+    XCTAssertEqual(self.server.requestCount, (NSUInteger)0);
+}
+
+#pragma mark - Private
+
+- (TMResumableUpload *)upload {
+    TMResumableUpload *upload = [[TMResumableUpload alloc] initWithFilePath:self.filePath
+                                                                        URL:[self.server.baseURL URLByAppendingPathComponent:@"upload"]
+                                                                 parameters:@{ @"type" : @"video" }
+                                                                contentType:@"video/mp4" fileName:nil
+                                                                chunkLength:TMResumableUploadTestsChunkLength
+                                                                  directory:self.directory];
+    [self configureUpload:upload];
+
+    return upload;
+}
+
+// Unsigned requests, which the stand-in server doesn't check
+- (void)configureUpload:(TMResumableUpload *)upload {
+    upload.requestBlock = ^JXHTTPOperation *(NSURL *URL, NSDictionary *parameters) {
+        JXHTTPOperation *request = [[JXHTTPOperation alloc] initWithURL:URL];
+        request.requestMethod = @"POST";
+        request.requestBody = [JXHTTPMultipartBody withDictionary:parameters];
+
+        return request;
+    };
+}
+
+// Progress is saved before the block is called, so the dropped chunk is the first one left to send
+- (void)dropConnectionAfterChunkCount:(NSUInteger)chunkCount ofUpload:(TMResumableUpload *)upload {
+    __weak TMStandInServer *server = self.server;
+
+    server.errorStatusCode = 0;
+
+    upload.progressBlock = ^(TMResumableUpload *upload) {
+        if (upload.acknowledgedChunkCount == chunkCount) {
+            [server failNextRequests:1];
+        }
+    };
+}
+
+// Starts the upload and waits for it to succeed or stop
+- (NSError *)runUpload:(TMResumableUpload *)upload {
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block NSError *uploadError = nil;
+
+    upload.completionBlock = ^(TMResumableUpload *upload, JXHTTPOperation *request, NSError *error) {
+        uploadError = error;
+        dispatch_semaphore_signal(semaphore);
+    };
+
+    [upload startOnQueue:self.queue];
+
+    long result = dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW,
+                                                                   (int64_t)(TMResumableUploadTestsTimeout * NSEC_PER_SEC)));
+    XCTAssertEqual(result, 0L, @"The upload timed out");
+
+    return uploadError;
+}
+
+- (NSData *)randomDataWithLength:(NSUInteger)length {
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:length];
+    arc4random_buf(data.mutableBytes, data.length);
+
+    return data;
+}
+
+@end
@@ -0,0 +1,175 @@
+//
+//  TMSDKFunctionsTests.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "TMSDKFunctions.h"
+
+/*
+ The CoreFoundation based implementations the byte-level functions replaced, kept here as the reference they have to
+ match exactly.
+ */
+
+static NSString *TMReferenceURLDecode(NSString *string) {
+    return (NSString *)CFBridgingRelease(CFURLCreateStringByReplacingPercentEscapes(NULL, (CFStringRef)string,
+                                                                                    CFSTR("")));
+}
+
+static NSString *TMReferenceURLEncode(id value) {
+    NSString *string = [value isKindOfClass:[NSString class]] ? value : [value stringValue];
+
+    return (NSString *)CFBridgingRelease(CFURLCreateStringByAddingPercentEscapes(NULL, (CFStringRef)string, NULL,
+                                                                                 CFSTR("!*'();:@&=+$,/?%#[]%"), kCFStringEncodingUTF8));
+}
+
+static NSDictionary *TMReferenceQueryStringToDictionary(NSString *query) {
+    NSMutableDictionary *mutableParameterDictionary = [[NSMutableDictionary alloc] init];
+
+    for (NSString *parameter in [query componentsSeparatedByString:@"&"]) {
+        NSArray *keyValuePair = [parameter componentsSeparatedByString:@"="];
+
+        if (keyValuePair.count == 2) {
+            NSString *key = TMReferenceURLDecode(keyValuePair[0]);
+            NSString *value = TMReferenceURLDecode(keyValuePair[1]);
+
+            id existingValueForKey = mutableParameterDictionary[key];
+
+            if (existingValueForKey) {
+                if ([existingValueForKey isKindOfClass:[NSMutableArray class]])
+                    [(NSMutableArray *)existingValueForKey addObject:value];
+                else
+                    [mutableParameterDictionary setObject:[NSMutableArray arrayWithObjects:existingValueForKey, value, nil]
+                                                   forKey:key];
+            } else
+                [mutableParameterDictionary setObject:value forKey:key];
+        }
+    }
+
+    return [NSDictionary dictionaryWithDictionary:mutableParameterDictionary];
+}
+
+static NSString *TMReferenceDictionaryToQueryString(NSDictionary *dictionary) {
+    NSMutableArray *parameters = [NSMutableArray array];
+
+    void (^addParameter)(NSString *key, NSString *value) = ^(NSString *key, NSString *value) {
+        [parameters addObject:[NSString stringWithFormat:@"%@=%@", TMReferenceURLEncode(key), TMReferenceURLEncode(value)]];
+    };
+
+    for (NSString *key in [[dictionary allKeys] sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)]) {
+        id value = dictionary[key];
+
+        if ([value isKindOfClass:[NSArray class]]) {
+            for (NSString *arrayValue in (NSArray *)value)
+                addParameter(key, arrayValue);
+        } else
+            addParameter(key, value);
+    }
+
+    return [parameters componentsJoinedByString:@"&"];
+}
+
+@interface TMSDKFunctionsTests : XCTestCase
+
+@end
+
+@implementation TMSDKFunctionsTests
+
+#pragma mark - Encoding
+
+- (void)testEncodesValuesLikeCoreFoundation {
+    for (id value in [self values]) {
+        XCTAssertEqualObjects(TMURLEncode(value), TMReferenceURLEncode(value), @"%@", value);
+
+        NSMutableData *data = [[NSMutableData alloc] initWithBytes:"prefix&" length:7];
+        TMAppendURLEncoded(data, value);
+
+        // Values used to be formatted into the header, which prints a failed encoding as `(null)`
+        NSMutableData *expectedData = [[NSMutableData alloc] initWithBytes:"prefix&" length:7];
+        [expectedData appendData:[[NSString stringWithFormat:@"%@", TMReferenceURLEncode(value)]
+                                  dataUsingEncoding:NSUTF8StringEncoding]];
+
+        XCTAssertEqualObjects(data, expectedData, @"%@", value);
+    }
+}
+
+- (void)testEncodesDictionariesLikeCoreFoundation {
+    for (NSDictionary *dictionary in [self dictionaries]) {
+        NSString *expected = TMReferenceDictionaryToQueryString(dictionary);
+
+        XCTAssertEqualObjects(TMDictionaryToQueryString(dictionary), expected, @"%@", dictionary);
+
+        NSMutableData *data = [[NSMutableData alloc] init];
+        TMAppendURLEncodedQueryString(data, dictionary);
+
+        NSString *expectedTwice = TMReferenceURLEncode(expected);
+
+        XCTAssertEqualObjects([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding], expectedTwice,
+                              @"%@", dictionary);
+    }
+}
+
+- (void)testEncodingRoundTripsThroughDecoding {
+    for (NSDictionary *dictionary in [self dictionaries]) {
+        NSString *query = TMDictionaryToQueryString(dictionary);
+
+        XCTAssertEqualObjects(TMQueryStringToDictionary(query), TMReferenceQueryStringToDictionary(query), @"%@", query);
+    }
+}
+
+#pragma mark - Decoding
+
+- (void)testDecodesStringsLikeCoreFoundation {
+    NSArray *strings = @[@"", @"plain", @"a+b", @"%20", @"%2520", @"%E2%98%83", @"%e2%98%83", @"caf%C3%A9", @"café",
+                         @"%", @"%2", @"%zz", @"100%", @"%C3", @"%FF", @"%EF%BB%BFbom", @"%2F%3F%23%5B%5D",
+                         @"☃%20snow"];
+
+    for (NSString *string in strings) {
+        XCTAssertEqualObjects(TMURLDecode(string), TMReferenceURLDecode(string), @"%@", string);
+    }
+}
+
+- (void)testParsesQueryStringsLikeCoreFoundation {
+    NSArray *queries = @[@"", @"a=1", @"a=1&b=2", @"a=", @"=1", @"=", @"a", @"a=1=2", @"&&", @"a=1&", @"&a=1",
+                         @"a=1&a=2", @"a=1&a=2&a=3", @"a=&a=", @"A=1&a=2", @"%61=1&a=2", @"k%20ey=v%2Bal",
+                         @"snow=%E2%98%83&caf%C3%A9=1", @"raw=café&☃=snow", @"bom=%EF%BB%BFx",
+                         @"reserved=%21%2A%27%28%29%3B%3A%40%26%3D%2B%24%2C%2F%3F%25%23%5B%5D"];
+
+    for (NSString *query in queries) {
+        XCTAssertEqualObjects(TMQueryStringToDictionary(query), TMReferenceQueryStringToDictionary(query), @"%@", query);
+    }
+
+    XCTAssertEqualObjects(TMQueryStringToDictionary(nil), TMReferenceQueryStringToDictionary(nil));
+}
+
+#pragma mark - Private
+
+- (NSArray *)values {
+    // A lone surrogate can't be converted to UTF-8
+    unichar surrogate = 0xD83D;
+
+    return @[@"", @"plain", @"-._~", @"a b", @"!*'();:@&=+$,/?%#[]", @"\"<>\\^`{|}", @"café", @"☃", @"😀",
+             @"\t\n", @"100%", @"%20", @"é", @42, @(-1.5), @YES,
+             [[NSString alloc] initWithCharacters:&surrogate length:1]];
+}
+
+- (NSArray *)dictionaries {
+    return @[@{},
+             @{ @"a" : @"1" },
+             @{ @"b" : @"2", @"a" : @"1", @"c" : @"3" },
+             @{ @"empty" : @"", @"" : @"empty key" },
+             @{ @"tag" : @[@"one", @"two", @"one"] },
+             @{ @"tag" : @[] },
+             @{ @"Beta" : @"1", @"alpha" : @"2", @"ALPHA2" : @"3", @"_under" : @"4", @"9" : @"5", @"a-b" : @"6" },
+             @{ @"Key" : @"1", @"key" : @"2", @"KEY" : @"3" },
+             @{ @"café" : @"1", @"cafe" : @"2", @"☃" : @"snow", @"zebra" : @"3" },
+             @{ @"reserved !*'();:@&=+$,/?%#[]" : @"!*'();:@&=+$,/?%#[]" },
+             @{ @"number" : @42, @"float" : @(1.5), @"bool" : @NO },
+             @{ @"oauth_token" : @"abc", @"oauth_nonce" : @"n0nce", @"type" : @"text", @"body" : @"Hello, world! ☃" },
+             ];
+}
+
+@end
@@ -0,0 +1,118 @@
+//
+//  TMStandInServer.h
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Stands in for the Tumblr API inside the test process, so that `TMAPIClient` and the JXHTTP stack under it can be
+ exercised and load tested without network access.
+
+ While started, the server answers every request to its `baseURL` through a URL protocol, which the client's
+ connections go through like any other. Requests are answered with recorded responses, registered with
+ `replayResponseWithStatusCode:headers:body:forMethod:pathPattern:`, after the configured latency, at the configured
+ bandwidth, with a configurable share of them failing instead. Requests without a recording get a 404.
+
+ `GET` requests with a single `Range` get a 206 with that range of a 200 recording's body, unless their `If-Range`
+ matches neither the recording's `ETag` nor its `Last-Modified` header, in which case they get the whole body as a
+ server would once the entity has changed. `HEAD` requests get a recording's headers without its body.
+
+ Only one server can be started at a time. Configure it before starting it or between runs, not while requests are
+ in flight.
+ */
+@interface TMStandInServer : NSObject
+
+/// URL to point `-[TMAPIClient baseURL]` at. On a reserved domain, so nothing ever resolves it.
+@property (nonatomic, copy, readonly) NSURL *baseURL;
+
+/// Seconds before every response starts
+@property (nonatomic) NSTimeInterval latency;
+
+/// Up to this many more seconds are added to `latency`, at random, for every response
+@property (nonatomic) NSTimeInterval latencyJitter;
+
+/// Bytes per second that request and response bodies are transferred at. 0 (the default) for no limit.
+@property (nonatomic) NSUInteger bytesPerSecond;
+
+/// Share of requests, from 0 to 1, that fail instead of getting their recorded response
+@property (nonatomic) double errorRate;
+
+/**
+ Status code that failing requests are answered with, along with an API error body. 0 (the default) drops the
+ connection instead.
+ */
+@property (nonatomic) NSInteger errorStatusCode;
+
+/**
+ Whether recorded bodies are sent gzip encoded to requests that accept it, as a server with compression turned on would
+ send them. The client still receives decoded bytes, as it does from the system's own HTTP loading, but
+ `bytesPerSecond` and `bytesSent` apply to the encoded body.
+ */
+@property (nonatomic) BOOL compressesResponses;
+
+/// Number of response body bytes sent since the server was started, counted as they'd go over the wire
+@property (readonly) unsigned long long bytesSent;
+
+/// Number of request body bytes received since the server was started, counted as they'd come over the wire
+@property (readonly) unsigned long long bytesReceived;
+
+/// Number of requests the server has received since it was started
+@property (readonly) NSUInteger requestCount;
+
+/// Number of requests the server has failed on purpose since it was started
+@property (readonly) NSUInteger injectedErrorCount;
+
+/**
+ Replay a recorded response for requests matching a method and path.
+
+ @param statusCode HTTP status code
+ @param headers HTTP header fields, `Content-Length` is added
+ @param body Response body
+ @param method HTTP method, or `nil` for any
+ @param pathPattern Path relative to `baseURL`, where `*` matches any characters, e.g. `user/*`. The first recording
+ that matches a request answers it.
+ */
+- (void)replayResponseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary *)headers body:(NSData *)body
+                           forMethod:(NSString *)method pathPattern:(NSString *)pathPattern;
+
+/**
+ Replay an API response, wrapped in the API's `meta` envelope, for requests matching a method and path.
+
+ @param statusCode HTTP status code, also reported in `meta`
+ @param response Object to serialize as the `response` field
+ @param method HTTP method, or `nil` for any
+ @param pathPattern Path relative to `baseURL`, as for `replayResponseWithStatusCode:headers:body:forMethod:pathPattern:`
+ */
+- (void)replayAPIResponseWithStatusCode:(NSInteger)statusCode response:(id)response forMethod:(NSString *)method
+                            pathPattern:(NSString *)pathPattern;
+
+/**
+ Fail the next few requests as `errorRate` fails them, with `errorStatusCode` or by dropping the connection, whatever
+ the error rate. Unlike the other settings, this can be changed while requests are in flight.
+
+ @param count Number of requests to fail, in addition to any still waiting to be failed
+ */
+- (void)failNextRequests:(NSUInteger)count;
+
+/**
+ Drop the connection of the next response that has a body, once part of the body has been sent. Like
+ `failNextRequests:`, this can be changed while requests are in flight.
+
+ @param length Number of body bytes sent before the connection is dropped, counted as they go over the wire
+ */
+- (void)dropNextResponseAfterLength:(NSUInteger)length;
+
+/// Stop replaying every recorded response, so that others can be registered in their place
+- (void)removeAllRecordings;
+
+/// Start answering requests to `baseURL`, and reset `requestCount`, `injectedErrorCount`, `bytesSent` and `bytesReceived`
+- (void)start;
+
+/// Stop answering requests. Requests already being answered still complete.
+- (void)stop;
+
+@end
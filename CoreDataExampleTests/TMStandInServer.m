@@ -0,0 +1,485 @@
+//
+//  TMStandInServer.m
+//  CoreDataExample
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMStandInServer.h"
+#import "JXHTTPCompression.h"
+
+static NSString * const TMStandInServerBaseURLString = @"http://api.tumblr.invalid/v2/";
+
+// How often bandwidth limited bodies are handed over, in seconds
+static NSTimeInterval const TMStandInServerChunkInterval = 0.05;
+
+static TMStandInServer *TMStandInServerActiveServer;
+
+@interface TMStandInRecording : NSObject
+
+@property (nonatomic, copy) NSString *method;
+@property (nonatomic, strong) NSPredicate *pathPredicate;
+@property (nonatomic) NSInteger statusCode;
+@property (nonatomic, copy) NSDictionary *headers;
+@property (nonatomic, copy) NSData *body;
+
+/// `body` gzip encoded, once a request has needed it
+@property (nonatomic, copy) NSData *compressedBody;
+
+@end
+
+@implementation TMStandInRecording
+
+@end
+
+@interface TMStandInServer()
+
+@property (nonatomic, copy) NSURL *baseURL;
+@property (nonatomic, strong) NSMutableArray *recordings;
+@property NSUInteger requestCount;
+@property NSUInteger injectedErrorCount;
+@property unsigned long long bytesSent;
+@property unsigned long long bytesReceived;
+@property (nonatomic) NSUInteger pendingFailureCount;
+@property (nonatomic) NSUInteger pendingDropLength;
+
++ (instancetype)activeServer;
+
+/// The recording to answer a request with, or `nil` to drop the connection. Counts the request and its body.
+- (TMStandInRecording *)recordingForRequest:(NSURLRequest *)request;
+
+/// A 206 with the requested range of a recording's body, or the recording itself if it doesn't apply
+- (TMStandInRecording *)rangeRecordingForRecording:(TMStandInRecording *)recording request:(NSURLRequest *)request;
+
+/// The gzip encoded body to send a recording with, or `nil` to send it as is
+- (NSData *)compressedBodyForRecording:(TMStandInRecording *)recording request:(NSURLRequest *)request;
+
+/// Bytes of a body sent before its connection is dropped, or `NSNotFound` to send all of them
+- (NSUInteger)dropLengthForBodyLength:(NSUInteger)bodyLength;
+
+- (void)didSendBodyLength:(NSUInteger)length;
+
+/// Seconds before the response to a request starts, including the time its body takes to upload
+- (NSTimeInterval)delayForRequest:(NSURLRequest *)request;
+
+@end
+
+/**
+ Answers requests to the active server's host, on the thread the loading system starts it on.
+ */
+@interface TMStandInURLProtocol : NSURLProtocol
+
+@property (nonatomic, weak) TMStandInServer *server;
+@property (nonatomic, strong) TMStandInRecording *recording;
+@property (nonatomic, getter = isCompressed) BOOL compressed;
+@property (nonatomic) NSUInteger chunkLength;
+
+/// Length of the body, encoded if it's compressed, as given by `Content-Length`
+@property (nonatomic) NSUInteger contentLength;
+
+/// Length of the body as sent, which is none of it for a `HEAD` request
+@property (nonatomic) NSUInteger wireLength;
+
+/// Bytes of the body sent before the connection is dropped, `wireLength` unless it's dropped partway through
+@property (nonatomic) NSUInteger sendableLength;
+
+/// Bytes of the body sent so far, encoded if it's compressed
+@property (nonatomic) NSUInteger sentLength;
+
+/// Decoded bytes handed to the client so far
+@property (nonatomic) NSUInteger deliveredLength;
+@property (nonatomic, strong) NSTimer *timer;
+
+@end
+
+@implementation TMStandInURLProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+    NSURL *baseURL = [TMStandInServer activeServer].baseURL;
+
+    return baseURL && [request.URL.host isEqualToString:baseURL.host];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+    return request;
+}
+
+- (void)startLoading {
+    TMStandInServer *server = [TMStandInServer activeServer];
+
+    if (!server) {
+        [self.client URLProtocol:self didFailWithError:[NSError errorWithDomain:NSURLErrorDomain
+                                                                           code:NSURLErrorCannotConnectToHost
+                                                                       userInfo:nil]];
+        return;
+    }
+
+    self.server = server;
+    self.recording = [server recordingForRequest:self.request];
+
+    NSData *compressedBody = [server compressedBodyForRecording:self.recording request:self.request];
+    self.compressed = compressedBody != nil;
+    self.contentLength = compressedBody ? compressedBody.length : self.recording.body.length;
+    self.wireLength = [self.request.HTTPMethod isEqualToString:@"HEAD"] ? 0 : self.contentLength;
+    self.sendableLength = MIN([server dropLengthForBodyLength:self.wireLength], self.wireLength);
+
+    NSUInteger bytesPerSecond = server.bytesPerSecond;
+    self.chunkLength = bytesPerSecond > 0 ? MAX((NSUInteger)(bytesPerSecond * TMStandInServerChunkInterval), 1) : 0;
+
+    // Timers fire on this thread's run loop, which is where the client expects to hear back
+    self.timer = [NSTimer timerWithTimeInterval:[server delayForRequest:self.request] target:self
+                                       selector:@selector(sendResponse) userInfo:nil repeats:NO];
+    [[NSRunLoop currentRunLoop] addTimer:self.timer forMode:NSRunLoopCommonModes];
+}
+
+- (void)stopLoading {
+    [self.timer invalidate];
+    self.timer = nil;
+}
+
+#pragma mark - Private
+
+- (void)sendResponse {
+    if (!self.recording) {
+        self.timer = nil;
+        [self.client URLProtocol:self didFailWithError:[NSError errorWithDomain:NSURLErrorDomain
+                                                                           code:NSURLErrorNetworkConnectionLost
+                                                                       userInfo:nil]];
+        return;
+    }
+
+    NSMutableDictionary *headers = [[NSMutableDictionary alloc] initWithDictionary:self.recording.headers];
+    headers[@"Content-Length"] = [NSString stringWithFormat:@"%lu", (unsigned long)self.contentLength];
+
+    if (self.isCompressed) {
+        headers[@"Content-Encoding"] = @"gzip";
+    }
+
+    if (self.recording.statusCode == 200 || self.recording.statusCode == 206) {
+        headers[@"Accept-Ranges"] = @"bytes";
+    }
+
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                              statusCode:self.recording.statusCode
+                                                             HTTPVersion:@"HTTP/1.1" headerFields:headers];
+
+    [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+
+    if (self.chunkLength == 0 || self.sendableLength <= self.chunkLength) {
+        self.timer = nil;
+        [self sendBodyLength:self.sendableLength];
+        return;
+    }
+
+    self.timer = [NSTimer timerWithTimeInterval:TMStandInServerChunkInterval target:self selector:@selector(sendChunk)
+                                       userInfo:nil repeats:YES];
+    [[NSRunLoop currentRunLoop] addTimer:self.timer forMode:NSRunLoopCommonModes];
+
+    [self sendChunk];
+}
+
+- (void)sendChunk {
+    NSUInteger length = MIN(self.chunkLength, self.sendableLength - self.sentLength);
+
+    if (self.sentLength + length == self.sendableLength) {
+        [self.timer invalidate];
+        self.timer = nil;
+    }
+
+    [self sendBodyLength:length];
+}
+
+// Sends a length of the body as it goes over the wire, and finishes once all of it has been sent or fails once the
+// connection is due to drop
+- (void)sendBodyLength:(NSUInteger)length {
+    if (length > 0) {
+        self.sentLength += length;
+        [self.server didSendBodyLength:length];
+
+        // Decoded bytes are handed over in step with the encoded ones, as the system inflates them while they arrive
+        NSUInteger bodyLength = self.recording.body.length;
+        NSUInteger deliverableLength = self.sentLength == self.wireLength ? bodyLength
+            : (NSUInteger)((unsigned long long)bodyLength * self.sentLength / self.wireLength);
+
+        if (deliverableLength > self.deliveredLength) {
+            NSRange range = NSMakeRange(self.deliveredLength, deliverableLength - self.deliveredLength);
+            self.deliveredLength = deliverableLength;
+
+            [self.client URLProtocol:self didLoadData:[self.recording.body subdataWithRange:range]];
+        }
+    }
+
+    if (self.sentLength == self.wireLength) {
+        [self.client URLProtocolDidFinishLoading:self];
+    } else if (self.sentLength == self.sendableLength) {
+        [self.client URLProtocol:self didFailWithError:[NSError errorWithDomain:NSURLErrorDomain
+                                                                           code:NSURLErrorNetworkConnectionLost
+                                                                       userInfo:nil]];
+    }
+}
+
+@end
+
+@implementation TMStandInServer
+
+- (id)init {
+    if (self = [super init]) {
+        self.baseURL = [NSURL URLWithString:TMStandInServerBaseURLString];
+        self.recordings = [[NSMutableArray alloc] init];
+        self.pendingDropLength = NSNotFound;
+    }
+
+    return self;
+}
+
+- (void)replayResponseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary *)headers body:(NSData *)body
+                           forMethod:(NSString *)method pathPattern:(NSString *)pathPattern {
+    TMStandInRecording *recording = [[TMStandInRecording alloc] init];
+    recording.method = [method uppercaseString];
+    recording.pathPredicate = [NSPredicate predicateWithFormat:@"SELF LIKE %@", pathPattern];
+    recording.statusCode = statusCode;
+    recording.headers = headers;
+    recording.body = body ?: [NSData data];
+
+    @synchronized (self) {
+        [self.recordings addObject:recording];
+    }
+}
+
+- (void)replayAPIResponseWithStatusCode:(NSInteger)statusCode response:(id)response forMethod:(NSString *)method
+                            pathPattern:(NSString *)pathPattern {
+    [self replayResponseWithStatusCode:statusCode headers:@{ @"Content-Type" : @"application/json" }
+                                  body:[self APIBodyWithStatusCode:statusCode response:response]
+                             forMethod:method pathPattern:pathPattern];
+}
+
+- (void)failNextRequests:(NSUInteger)count {
+    @synchronized (self) {
+        self.pendingFailureCount += count;
+    }
+}
+
+- (void)dropNextResponseAfterLength:(NSUInteger)length {
+    @synchronized (self) {
+        self.pendingDropLength = length;
+    }
+}
+
+- (void)removeAllRecordings {
+    @synchronized (self) {
+        [self.recordings removeAllObjects];
+    }
+}
+
+- (void)start {
+    self.requestCount = 0;
+    self.injectedErrorCount = 0;
+    self.bytesSent = 0;
+    self.bytesReceived = 0;
+
+    @synchronized ([TMStandInServer class]) {
+        NSAssert(!TMStandInServerActiveServer || TMStandInServerActiveServer == self, @"Another server is started");
+
+        TMStandInServerActiveServer = self;
+    }
+
+    [NSURLProtocol registerClass:[TMStandInURLProtocol class]];
+}
+
+- (void)stop {
+    [NSURLProtocol unregisterClass:[TMStandInURLProtocol class]];
+
+    @synchronized ([TMStandInServer class]) {
+        if (TMStandInServerActiveServer == self) {
+            TMStandInServerActiveServer = nil;
+        }
+    }
+}
+
+#pragma mark - Private
+
++ (instancetype)activeServer {
+    @synchronized (self) {
+        return TMStandInServerActiveServer;
+    }
+}
+
+- (TMStandInRecording *)recordingForRequest:(NSURLRequest *)request {
+    NSString *basePath = self.baseURL.path;
+    NSString *path = request.URL.path;
+
+    // NSURL drops the trailing slash of the base path
+    if ([path hasPrefix:basePath]) {
+        path = [[path substringFromIndex:basePath.length] stringByTrimmingCharactersInSet:
+                [NSCharacterSet characterSetWithCharactersInString:@"/"]];
+    }
+
+    NSString *method = [request.HTTPMethod uppercaseString] ?: @"GET";
+    BOOL injectsError = self.errorRate > 0 && arc4random_uniform(1000000) < self.errorRate * 1000000;
+
+    @synchronized (self) {
+        self.requestCount++;
+        self.bytesReceived += [self bodyLengthOfRequest:request];
+
+        if (self.pendingFailureCount > 0) {
+            self.pendingFailureCount--;
+            injectsError = YES;
+        }
+
+        if (injectsError) {
+            self.injectedErrorCount++;
+
+            if (self.errorStatusCode == 0) {
+                return nil;
+            }
+
+            TMStandInRecording *recording = [[TMStandInRecording alloc] init];
+            recording.statusCode = self.errorStatusCode;
+            recording.headers = @{ @"Content-Type" : @"application/json" };
+            recording.body = [self APIBodyWithStatusCode:self.errorStatusCode response:@[]];
+
+            return recording;
+        }
+
+        for (TMStandInRecording *recording in self.recordings) {
+            if ((!recording.method || [recording.method isEqualToString:method])
+                && [recording.pathPredicate evaluateWithObject:path]) {
+                return [self rangeRecordingForRecording:recording request:request];
+            }
+        }
+    }
+
+    TMStandInRecording *recording = [[TMStandInRecording alloc] init];
+    recording.statusCode = 404;
+    recording.headers = @{ @"Content-Type" : @"application/json" };
+    recording.body = [self APIBodyWithStatusCode:404 response:@[]];
+
+    return recording;
+}
+
+- (TMStandInRecording *)rangeRecordingForRecording:(TMStandInRecording *)recording request:(NSURLRequest *)request {
+    NSString *range = [request valueForHTTPHeaderField:@"Range"];
+    NSString *method = [request.HTTPMethod uppercaseString] ?: @"GET";
+
+    if (recording.statusCode != 200 || !range || ![method isEqualToString:@"GET"]) {
+        return recording;
+    }
+
+    // An entity that changed since the client's validator was taken is sent whole
+    NSString *ifRange = [request valueForHTTPHeaderField:@"If-Range"];
+
+    if (ifRange && ![ifRange isEqualToString:recording.headers[@"ETag"]]
+        && ![ifRange isEqualToString:recording.headers[@"Last-Modified"]]) {
+        return recording;
+    }
+
+    // Only a single range, bytes=start- or bytes=start-end. Anything else is ignored, as a server may ignore it.
+    long long length = (long long)recording.body.length;
+    long long start = -1;
+    long long end = length - 1;
+    NSScanner *scanner = [NSScanner scannerWithString:range];
+
+    if (![scanner scanString:@"bytes=" intoString:NULL] || ![scanner scanLongLong:&start]
+        || ![scanner scanString:@"-" intoString:NULL] || start < 0) {
+        return recording;
+    }
+
+    if (!scanner.isAtEnd && (![scanner scanLongLong:&end] || !scanner.isAtEnd || end < start)) {
+        return recording;
+    }
+
+    TMStandInRecording *rangeRecording = [[TMStandInRecording alloc] init];
+    NSMutableDictionary *headers = [[NSMutableDictionary alloc] initWithDictionary:recording.headers];
+
+    if (start >= length) {
+        headers[@"Content-Range"] = [NSString stringWithFormat:@"bytes */%lld", length];
+        rangeRecording.statusCode = 416;
+        rangeRecording.body = [NSData data];
+    } else {
+        end = MIN(end, length - 1);
+        headers[@"Content-Range"] = [NSString stringWithFormat:@"bytes %lld-%lld/%lld", start, end, length];
+        rangeRecording.statusCode = 206;
+        rangeRecording.body = [recording.body subdataWithRange:NSMakeRange((NSUInteger)start,
+                                                                           (NSUInteger)(end - start + 1))];
+    }
+
+    rangeRecording.headers = headers;
+
+    return rangeRecording;
+}
+
+// Ranges are of the body as is, so they're never encoded
+- (NSData *)compressedBodyForRecording:(TMStandInRecording *)recording request:(NSURLRequest *)request {
+    if (!self.compressesResponses || recording.body.length == 0 || recording.statusCode == 206) {
+        return nil;
+    }
+
+    NSString *acceptEncoding = [[request valueForHTTPHeaderField:@"Accept-Encoding"] lowercaseString];
+
+    if ([acceptEncoding rangeOfString:@"gzip"].location == NSNotFound) {
+        return nil;
+    }
+
+    @synchronized (recording) {
+        if (!recording.compressedBody) {
+            recording.compressedBody = [JXHTTPCompression gzippedData:recording.body];
+        }
+
+        return recording.compressedBody;
+    }
+}
+
+- (NSUInteger)dropLengthForBodyLength:(NSUInteger)bodyLength {
+    @synchronized (self) {
+        NSUInteger dropLength = self.pendingDropLength;
+
+        // Only a response with a body can be cut off partway through it
+        if (bodyLength == 0 || dropLength == NSNotFound) {
+            return NSNotFound;
+        }
+
+        self.pendingDropLength = NSNotFound;
+
+        return dropLength;
+    }
+}
+
+- (void)didSendBodyLength:(NSUInteger)length {
+    @synchronized (self) {
+        self.bytesSent += length;
+    }
+}
+
+- (NSTimeInterval)delayForRequest:(NSURLRequest *)request {
+    NSTimeInterval delay = self.latency;
+
+    if (self.latencyJitter > 0) {
+        delay += self.latencyJitter * arc4random_uniform(1000001) / 1000000.0;
+    }
+
+    if (self.bytesPerSecond > 0) {
+        delay += [self bodyLengthOfRequest:request] / (double)self.bytesPerSecond;
+    }
+
+    return delay;
+}
+
+// As sent, so the compressed length for a compressed body
+- (long long)bodyLengthOfRequest:(NSURLRequest *)request {
+    long long bodyLength = [[request valueForHTTPHeaderField:@"Content-Length"] longLongValue];
+
+    return bodyLength > 0 ? bodyLength : (long long)request.HTTPBody.length;
+}
+
+- (NSData *)APIBodyWithStatusCode:(NSInteger)statusCode response:(id)response {
+    NSDictionary *JSON = @{
+                           @"meta" : @{ @"status" : @(statusCode),
+                                        @"msg" : [NSHTTPURLResponse localizedStringForStatusCode:statusCode] },
+                           @"response" : response ?: @[],
+                           };
+
+    return [NSJSONSerialization dataWithJSONObject:JSON options:0 error:nil];
+}
+
+@end
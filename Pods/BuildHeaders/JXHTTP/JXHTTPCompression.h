@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXHTTPCompression.h
\ No newline at end of file
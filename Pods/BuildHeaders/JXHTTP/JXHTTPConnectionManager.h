@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXHTTPConnectionManager.h
\ No newline at end of file
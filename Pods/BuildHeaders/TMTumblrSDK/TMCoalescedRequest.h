@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/APIClient/TMCoalescedRequest.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/Core/TMJSONDecoder.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/Authentication/TMOAuthSigner.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/APIClient/TMResumableUpload.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/APIClient/TMRetryingRequest.h
\ No newline at end of file
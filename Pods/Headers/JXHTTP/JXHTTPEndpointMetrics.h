@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXHTTPEndpointMetrics.h
\ No newline at end of file
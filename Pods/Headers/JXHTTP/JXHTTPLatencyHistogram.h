@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXHTTPLatencyHistogram.h
\ No newline at end of file
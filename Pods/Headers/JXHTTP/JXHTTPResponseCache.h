@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXHTTPResponseCache.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXHTTPSegmentedDownload.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXNetworkThreadPool.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../JXHTTP/JXHTTP/JXResponseBuffer.h
\ No newline at end of file
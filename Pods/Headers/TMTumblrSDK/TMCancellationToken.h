@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/APIClient/TMCancellationToken.h
\ No newline at end of file
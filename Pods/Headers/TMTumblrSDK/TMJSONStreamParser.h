@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/Core/TMJSONStreamParser.h
\ No newline at end of file
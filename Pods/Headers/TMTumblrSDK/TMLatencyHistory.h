@@ -0,0 +1 @@
+../../TMTumblrSDK/TMTumblrSDK/APIClient/TMLatencyHistory.h
\ No newline at end of file
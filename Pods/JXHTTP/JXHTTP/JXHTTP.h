@@ -2,9 +2,17 @@
 
 // Core
 #import "JXOperation.h"
+#import "JXNetworkThreadPool.h"
+#import "JXResponseBuffer.h"
 #import "JXURLConnectionOperation.h"
 #import "JXHTTPOperation.h"
 #import "JXHTTPOperationQueue.h"
+#import "JXHTTPResponseCache.h"
+#import "JXHTTPConnectionManager.h"
+#import "JXHTTPCompression.h"
+#import "JXHTTPSegmentedDownload.h"
+#import "JXHTTPLatencyHistogram.h"
+#import "JXHTTPEndpointMetrics.h"
 
 // Protocol
 #import "JXHTTPRequestBody.h"
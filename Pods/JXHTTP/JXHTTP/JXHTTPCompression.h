@@ -0,0 +1,30 @@
+/**
+ `JXHTTPCompression` is an abstract class providing the gzip encoding used for compressed
+ request bodies.
+
+ Responses need no counterpart: `NSURLConnection` decodes `gzip` and `deflate` content
+ encodings itself, chunk by chunk, before data reaches <JXURLConnectionOperation>. Bytes
+ written to the `responseBuffer` or `outputStream`, and counted by `bytesDownloaded`, are
+ decoded bytes, while a response's `expectedContentLength` is the encoded length.
+ */
+
+@interface JXHTTPCompression : NSObject
+
+/**
+ Compresses data in the gzip format (RFC 1952) at the default compression level.
+
+ @param data The data to compress.
+ @returns The compressed data, or `nil` if it could not be compressed.
+ */
++ (NSData *)gzippedData:(NSData *)data;
+
+/**
+ Whether a response's body is sent with a content encoding, so that its
+ `expectedContentLength` doesn't describe the bytes that will be received.
+
+ @param response A response.
+ @returns `YES` if the response has a `Content-Encoding` other than `identity`.
+ */
++ (BOOL)isEncodedResponse:(NSURLResponse *)response;
+
+@end
@@ -0,0 +1,52 @@
+#import "JXHTTPCompression.h"
+#import <zlib.h>
+
+static int JXHTTPCompressionGzipWindowBits = 15 + 16; // 32K window, gzip wrapper
+static int JXHTTPCompressionMemoryLevel = 8;
+
+@implementation JXHTTPCompression
+
++ (NSData *)gzippedData:(NSData *)data
+{
+    if (!data || [data length] > UINT_MAX)
+        return nil;
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, JXHTTPCompressionGzipWindowBits, JXHTTPCompressionMemoryLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+        return nil;
+
+    // the bound covers the gzip header and trailer, so a single pass always finishes
+    uLong bound = deflateBound(&stream, (uLong)[data length]);
+    NSMutableData *output = [[NSMutableData alloc] initWithLength:bound];
+
+    stream.next_in = (Bytef *)[data bytes];
+    stream.avail_in = (uInt)[data length];
+    stream.next_out = (Bytef *)[output mutableBytes];
+    stream.avail_out = (uInt)bound;
+
+    int status = deflate(&stream, Z_FINISH);
+    uLong length = stream.total_out;
+
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END)
+        return nil;
+
+    [output setLength:length];
+    return output;
+}
+
++ (BOOL)isEncodedResponse:(NSURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]])
+        return NO;
+
+    NSString *encoding = [[[(NSHTTPURLResponse *)response allHeaderFields] objectForKey:@"Content-Encoding"] lowercaseString];
+    encoding = [encoding stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+
+    return [encoding length] && ![encoding isEqualToString:@"identity"];
+}
+
+@end
@@ -0,0 +1,167 @@
+/**
+ `JXHTTPConnectionManager` treats the connections to each host as a shared, limited
+ resource for the operations that use it.
+
+ `NSURLConnection` keeps its own pool of persistent connections and gives no direct
+ control over it, so the manager works around the edges of that pool instead:
+
+ - A <JXHTTPOperationQueue> holds back operations whose host already has
+   <maximumConnectionsPerHost> requests in flight, rather than leaving the system to
+   queue them behind each other where priority classes no longer apply.
+ - `GET` requests without a body are sent with HTTP pipelining enabled to hosts that
+   have opted in with <setPipelinesSafeRequests:forURL:>. Many servers and proxies
+   mishandle pipelined requests, so no host is opted in by default.
+ - <prewarmConnectionsToURL:count:> opens connections ahead of time with `HEAD` requests,
+   so the DNS lookup and TCP handshake are out of the way before the first real request.
+   Requests the app never asked for are just as unwelcome to some servers, so only hosts
+   opted in the same way are prewarmed.
+
+ Since the system doesn't report which connection a request used, the manager keeps a
+ model of each host's pool: a request that finishes cleanly leaves its connection idle,
+ and an idle connection is assumed to stay open for <keepAliveInterval> seconds. A request
+ that starts while its host has an idle connection counts as reused, otherwise as opened.
+ <estimatedReusedConnectionCount> and <estimatedOpenedConnectionCount> come from that model,
+ not from the system, and are only estimates of the handshakes avoided and made. Nothing
+checks them against the connections actually opened at the socket level, so they can be
+off in either direction, for instance when the server closes idle connections early.
+
+ When a connection is released, `JXHTTPConnectionManagerDidReleaseConnectionNotification`
+ is posted with the manager as its object.
+
+ Safe to access from any thread at any time.
+
+ ## Example ##
+
+     JXHTTPConnectionManager *manager = [JXHTTPConnectionManager sharedManager];
+     [manager prewarmConnectionsToURL:[NSURL URLWithString:@"http://jxhttp.com/"] count:2];
+
+     JXHTTPOperation *op = [JXHTTPOperation withURLString:@"http://jxhttp.com/"];
+     op.connectionManager = manager;
+ */
+
+extern NSString * const JXHTTPConnectionManagerDidReleaseConnectionNotification;
+
+@class JXHTTPOperation;
+
+@interface JXHTTPConnectionManager : NSObject
+
+/**
+ The maximum number of requests to a single host (scheme, host and port) that a
+ <JXHTTPOperationQueue> lets run at once. Defaults to `4`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) NSUInteger maximumConnectionsPerHost;
+
+/**
+ The number of seconds an idle connection is assumed to stay open. Defaults to `15.0`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) NSTimeInterval keepAliveInterval;
+
+/**
+ The number of requests that started without a modeled idle connection to their host.
+ An estimate, since the system doesn't report when it opens a connection.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) NSUInteger estimatedOpenedConnectionCount;
+
+/**
+ The number of requests that started while their host had a modeled idle connection.
+ An estimate, since the system doesn't report which connection a request used.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) NSUInteger estimatedReusedConnectionCount;
+
+/**
+ A manager shared by all operations that use one.
+
+ @returns The shared connection manager.
+ */
++ (instancetype)sharedManager;
+
+/**
+ Opens connections to a host ahead of time by sending `HEAD` requests to a URL, unless
+ the host already has that many connections in use or idle. Does nothing unless the host
+ has been opted in with <setPipelinesSafeRequests:forURL:>.
+
+ @param url A URL on the host, ideally one with a small response.
+ @param count The number of connections to open.
+ */
+- (void)prewarmConnectionsToURL:(NSURL *)url count:(NSUInteger)count;
+
+/**
+ The number of requests in flight to the host of a URL, including those reserved by a
+ <JXHTTPOperationQueue> that haven't started yet.
+
+ @param url A URL on the host.
+ @returns The number of connections in use.
+ */
+- (NSUInteger)activeConnectionCountForURL:(NSURL *)url;
+
+/**
+ The number of connections to the host of a URL assumed to be open and idle.
+
+ @param url A URL on the host.
+ @returns The number of idle connections.
+ */
+- (NSUInteger)idleConnectionCountForURL:(NSURL *)url;
+
+/**
+ Resets <estimatedOpenedConnectionCount> and <estimatedReusedConnectionCount> to `0`.
+ */
+- (void)resetStatistics;
+
+/// @name Pipelining
+
+/**
+ Opts the host of a URL in or out of HTTP pipelining for `GET` requests without a body,
+ and of being sent `HEAD` requests by <prewarmConnectionsToURL:count:>. Only opt in hosts
+ known to handle pipelined requests correctly, all the way through any proxies in front
+ of them.
+
+ @param pipelines `YES` to pipeline requests to the host.
+ @param url A URL on the host.
+ */
+- (void)setPipelinesSafeRequests:(BOOL)pipelines forURL:(NSURL *)url;
+
+/**
+ Whether `GET` requests without a body to the host of a URL are sent with HTTP pipelining.
+ `NO` unless the host was opted in.
+
+ @param url A URL on the host.
+ @returns `YES` if the host was opted in.
+ */
+- (BOOL)pipelinesSafeRequestsForURL:(NSURL *)url;
+
+/// @name Operation Hooks
+
+/**
+ Reserves a connection for an operation that hasn't started, if its host has fewer than
+ <maximumConnectionsPerHost> requests in flight. Called by <JXHTTPOperationQueue>.
+
+ @param operation The operation.
+ @returns `YES` if the operation holds a connection.
+ */
+- (BOOL)reserveConnectionForOperation:(JXHTTPOperation *)operation;
+
+/**
+ Takes a connection for a starting operation even if its host is at the limit, unless it
+ already holds one, and turns on pipelining if appropriate. Called by <JXHTTPOperation>.
+
+ @param operation The operation.
+ */
+- (void)operationWillStart:(JXHTTPOperation *)operation;
+
+/**
+ Releases an operation's connection, leaving it idle if the request finished cleanly.
+ Does nothing if the operation doesn't hold one. Called by <JXHTTPOperation>.
+
+ @param operation The operation.
+ */
+- (void)operationDidFinish:(JXHTTPOperation *)operation;
+
+@end
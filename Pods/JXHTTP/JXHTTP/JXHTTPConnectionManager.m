@@ -0,0 +1,314 @@
+#import "JXHTTPConnectionManager.h"
+#import "JXHTTPOperation.h"
+#import "JXHTTPOperation+Convenience.h"
+#import "JXHTTPOperationQueue.h"
+
+NSString * const JXHTTPConnectionManagerDidReleaseConnectionNotification = @"JXHTTPConnectionManagerDidReleaseConnectionNotification";
+
+static NSUInteger JXHTTPConnectionManagerDefaultMaxConnectionsPerHost = 4;
+static NSTimeInterval JXHTTPConnectionManagerDefaultKeepAliveInterval = 15.0;
+
+@interface JXHTTPConnectionManager ()
+@property (assign) NSUInteger estimatedOpenedConnectionCount;
+@property (assign) NSUInteger estimatedReusedConnectionCount;
+@property (strong) NSMutableSet *pipeliningKeySet;
+@property (strong) NSMutableDictionary *activeCounts;
+@property (strong) NSMutableDictionary *idleTimes;
+@property (strong) NSMutableSet *connectedOperationSet;
+@property (strong) NSMutableSet *startedOperationSet;
+@property (strong) JXHTTPOperationQueue *prewarmQueue;
+#if OS_OBJECT_USE_OBJC
+@property (strong) dispatch_queue_t stateQueue;
+#else
+@property (assign) dispatch_queue_t stateQueue;
+#endif
+@end
+
+static NSString * JXHTTPConnectionKey(NSURL *url)
+{
+    NSString *scheme = [[url scheme] lowercaseString];
+    NSString *host = [[url host] lowercaseString];
+
+    if (!scheme || !host)
+        return nil;
+
+    NSNumber *port = [url port];
+    if (!port)
+        port = [scheme isEqualToString:@"https"] ? @443 : @80;
+
+    return [[NSString alloc] initWithFormat:@"%@://%@:%@", scheme, host, port];
+}
+
+@implementation JXHTTPConnectionManager
+
+#pragma mark - Initialization
+
+- (void)dealloc
+{
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_stateQueue);
+    _stateQueue = NULL;
+    #endif
+}
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        self.maximumConnectionsPerHost = JXHTTPConnectionManagerDefaultMaxConnectionsPerHost;
+        self.keepAliveInterval = JXHTTPConnectionManagerDefaultKeepAliveInterval;
+        self.estimatedOpenedConnectionCount = 0;
+        self.estimatedReusedConnectionCount = 0;
+        self.pipeliningKeySet = [[NSMutableSet alloc] init];
+        self.activeCounts = [[NSMutableDictionary alloc] init];
+        self.idleTimes = [[NSMutableDictionary alloc] init];
+        self.connectedOperationSet = [[NSMutableSet alloc] init];
+        self.startedOperationSet = [[NSMutableSet alloc] init];
+
+        self.prewarmQueue = [[JXHTTPOperationQueue alloc] init];
+        self.prewarmQueue.maxConcurrentOperationCount = NSOperationQueueDefaultMaxConcurrentOperationCount;
+
+        NSString *queueName = [[NSString alloc] initWithFormat:@"%@.%p.state", NSStringFromClass([self class]), self];
+        self.stateQueue = dispatch_queue_create([queueName UTF8String], DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
++ (instancetype)sharedManager
+{
+    static id sharedManager = nil;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^{
+        sharedManager = [[self alloc] init];
+    });
+
+    return sharedManager;
+}
+
+#pragma mark - Public Methods
+
+- (void)prewarmConnectionsToURL:(NSURL *)url count:(NSUInteger)count
+{
+    NSString *key = JXHTTPConnectionKey(url);
+    if (!key)
+        return;
+
+    __block NSUInteger openCount = 0;
+    __block BOOL optedIn = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        optedIn = [self.pipeliningKeySet containsObject:key];
+        openCount = [self activeCountForKey:key] + [[self unexpiredIdleTimesForKey:key] count];
+    });
+
+    // hosts that haven't opted in to pipelining aren't sent requests nobody asked for either
+    if (!optedIn)
+        return;
+
+    NSUInteger limit = MIN(count, self.maximumConnectionsPerHost);
+
+    for (NSUInteger i = openCount; i < limit; i++) {
+        JXHTTPOperation *op = [[JXHTTPOperation alloc] initWithURL:url];
+        op.requestMethod = @"HEAD";
+        op.priorityClass = JXHTTPOperationPriorityClassPrefetch;
+        op.requestNetworkServiceType = NSURLNetworkServiceTypeBackground;
+        op.updatesNetworkActivityIndicator = NO;
+        op.connectionManager = self;
+
+        [self.prewarmQueue addOperation:op];
+    }
+}
+
+- (NSUInteger)activeConnectionCountForURL:(NSURL *)url
+{
+    NSString *key = JXHTTPConnectionKey(url);
+    __block NSUInteger count = 0;
+
+    if (key) {
+        dispatch_sync(self.stateQueue, ^{
+            count = [self activeCountForKey:key];
+        });
+    }
+
+    return count;
+}
+
+- (NSUInteger)idleConnectionCountForURL:(NSURL *)url
+{
+    NSString *key = JXHTTPConnectionKey(url);
+    __block NSUInteger count = 0;
+
+    if (key) {
+        dispatch_sync(self.stateQueue, ^{
+            count = [[self unexpiredIdleTimesForKey:key] count];
+        });
+    }
+
+    return count;
+}
+
+- (void)resetStatistics
+{
+    dispatch_sync(self.stateQueue, ^{
+        self.estimatedOpenedConnectionCount = 0;
+        self.estimatedReusedConnectionCount = 0;
+    });
+}
+
+- (void)setPipelinesSafeRequests:(BOOL)pipelines forURL:(NSURL *)url
+{
+    NSString *key = JXHTTPConnectionKey(url);
+    if (!key)
+        return;
+
+    dispatch_sync(self.stateQueue, ^{
+        if (pipelines) {
+            [self.pipeliningKeySet addObject:key];
+        } else {
+            [self.pipeliningKeySet removeObject:key];
+        }
+    });
+}
+
+- (BOOL)pipelinesSafeRequestsForURL:(NSURL *)url
+{
+    NSString *key = JXHTTPConnectionKey(url);
+    __block BOOL pipelines = NO;
+
+    if (key) {
+        dispatch_sync(self.stateQueue, ^{
+            pipelines = [self.pipeliningKeySet containsObject:key];
+        });
+    }
+
+    return pipelines;
+}
+
+#pragma mark - Operation Hooks
+
+- (BOOL)reserveConnectionForOperation:(JXHTTPOperation *)operation
+{
+    NSString *key = JXHTTPConnectionKey(operation.requestURL);
+    if (!key)
+        return YES;
+
+    __block BOOL reserved = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        if ([self.connectedOperationSet containsObject:operation]) {
+            reserved = YES;
+            return;
+        }
+
+        NSUInteger activeCount = [self activeCountForKey:key];
+        if (activeCount >= MAX(self.maximumConnectionsPerHost, 1))
+            return;
+
+        [self.activeCounts setObject:@(activeCount + 1) forKey:key];
+        [self.connectedOperationSet addObject:operation];
+        reserved = YES;
+    });
+
+    return reserved;
+}
+
+- (void)operationWillStart:(JXHTTPOperation *)operation
+{
+    NSString *key = JXHTTPConnectionKey(operation.requestURL);
+    if (!key)
+        return;
+
+    NSString *method = [operation.requestMethod uppercaseString];
+    BOOL safe = (![method length] || [method isEqualToString:@"GET"]) && !operation.requestBody;
+
+    dispatch_sync(self.stateQueue, ^{
+        if (safe && [self.pipeliningKeySet containsObject:key])
+            operation.requestShouldUsePipelining = YES;
+
+        if (![self.connectedOperationSet containsObject:operation]) {
+            [self.activeCounts setObject:@([self activeCountForKey:key] + 1) forKey:key];
+            [self.connectedOperationSet addObject:operation];
+        }
+
+        NSMutableArray *idleTimes = [self unexpiredIdleTimesForKey:key];
+
+        if ([idleTimes count]) {
+            [idleTimes removeLastObject];
+            self.estimatedReusedConnectionCount++;
+        } else {
+            self.estimatedOpenedConnectionCount++;
+        }
+
+        [self.startedOperationSet addObject:operation];
+    });
+}
+
+- (void)operationDidFinish:(JXHTTPOperation *)operation
+{
+    NSString *key = JXHTTPConnectionKey(operation.requestURL);
+    if (!key)
+        return;
+
+    // a connection that errored, was cancelled mid-request or asked to close can't be reused
+    NSString *connectionHeader = [[[operation responseHeaders] objectForKey:@"Connection"] lowercaseString];
+    BOOL reusable = ![operation isCancelled] && !operation.error && ![connectionHeader isEqualToString:@"close"];
+
+    __block BOOL released = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        if (![self.connectedOperationSet containsObject:operation])
+            return;
+
+        [self.connectedOperationSet removeObject:operation];
+        released = YES;
+
+        NSUInteger activeCount = [self activeCountForKey:key];
+        if (activeCount > 1) {
+            [self.activeCounts setObject:@(activeCount - 1) forKey:key];
+        } else {
+            [self.activeCounts removeObjectForKey:key];
+        }
+
+        if (![self.startedOperationSet containsObject:operation])
+            return;
+
+        [self.startedOperationSet removeObject:operation];
+
+        if (!reusable)
+            return;
+
+        NSMutableArray *idleTimes = [self unexpiredIdleTimesForKey:key];
+        if (!idleTimes) {
+            idleTimes = [[NSMutableArray alloc] init];
+            [self.idleTimes setObject:idleTimes forKey:key];
+        }
+
+        if ([idleTimes count] < MAX(self.maximumConnectionsPerHost, 1))
+            [idleTimes addObject:@(CFAbsoluteTimeGetCurrent())];
+    });
+
+    if (released)
+        [[NSNotificationCenter defaultCenter] postNotificationName:JXHTTPConnectionManagerDidReleaseConnectionNotification object:self];
+}
+
+#pragma mark - Private Methods
+
+// must be called on the state queue
+- (NSUInteger)activeCountForKey:(NSString *)key
+{
+    return [[self.activeCounts objectForKey:key] unsignedIntegerValue];
+}
+
+// must be called on the state queue, oldest first
+- (NSMutableArray *)unexpiredIdleTimesForKey:(NSString *)key
+{
+    NSMutableArray *idleTimes = [self.idleTimes objectForKey:key];
+    CFAbsoluteTime cutoff = CFAbsoluteTimeGetCurrent() - self.keepAliveInterval;
+
+    while ([idleTimes count] && [[idleTimes objectAtIndex:0] doubleValue] < cutoff)
+        [idleTimes removeObjectAtIndex:0];
+
+    return idleTimes;
+}
+
+@end
@@ -0,0 +1,72 @@
+/**
+ `JXHTTPEndpointMetrics` aggregates the timing and byte counts of every finished
+ <JXHTTPOperation> that shares a `metricsKey`, splitting each request's life into phases:
+
+ - <queueingHistogram>: from `enqueueDate` to `startDate`, waiting for a slot.
+ - <responseHistogram>: from `startDate` to `responseDate`, the time to the response headers.
+ - <transferHistogram>: from `responseDate` to `finishDate`, receiving the body.
+ - <callbackHistogram>: from `finishDate` to `callbackDate`, waiting for the final block or
+   delegate method to be performed.
+ - <totalHistogram>: from `enqueueDate` (or `startDate`) to `callbackDate`.
+
+ A phase whose dates are missing, e.g. the transfer of a request that failed before it got a
+ response, isn't recorded. Cancelled operations aren't recorded at all.
+
+ Instances returned by <JXHTTPOperationQueue> are snapshots and are safe to access from any
+ thread; instances being recorded to are not.
+ */
+
+@class JXHTTPOperation;
+@class JXHTTPLatencyHistogram;
+
+@interface JXHTTPEndpointMetrics : NSObject <NSCopying>
+
+/**
+ The `metricsKey` shared by the operations.
+ */
+@property (copy, readonly) NSString *key;
+
+/**
+ The number of operations recorded.
+ */
+@property (assign, readonly) unsigned long long requestCount;
+
+/**
+ The number of operations recorded that failed.
+ */
+@property (assign, readonly) unsigned long long failureCount;
+
+/**
+ The total number of bytes downloaded by the operations.
+ */
+@property (assign, readonly) long long bytesDownloaded;
+
+/**
+ The total number of bytes uploaded by the operations.
+ */
+@property (assign, readonly) long long bytesUploaded;
+
+/// @name Histograms
+
+@property (strong, readonly) JXHTTPLatencyHistogram *queueingHistogram;
+@property (strong, readonly) JXHTTPLatencyHistogram *responseHistogram;
+@property (strong, readonly) JXHTTPLatencyHistogram *transferHistogram;
+@property (strong, readonly) JXHTTPLatencyHistogram *callbackHistogram;
+@property (strong, readonly) JXHTTPLatencyHistogram *totalHistogram;
+
+/**
+ Creates empty metrics.
+
+ @param key The `metricsKey` of the operations to be recorded.
+ @returns Metrics.
+ */
+- (instancetype)initWithKey:(NSString *)key;
+
+/**
+ Adds an operation's phases and byte counts. Called by <JXHTTPOperationQueue>.
+
+ @param operation A finished operation.
+ */
+- (void)recordOperation:(JXHTTPOperation *)operation;
+
+@end
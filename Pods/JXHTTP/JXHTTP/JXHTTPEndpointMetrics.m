@@ -0,0 +1,88 @@
+#import "JXHTTPEndpointMetrics.h"
+#import "JXHTTPLatencyHistogram.h"
+#import "JXHTTPOperation.h"
+
+static void JXHTTPRecordInterval(JXHTTPLatencyHistogram *histogram, NSDate *fromDate, NSDate *toDate)
+{
+    if (fromDate && toDate)
+        [histogram recordValue:[toDate timeIntervalSinceDate:fromDate]];
+}
+
+@interface JXHTTPEndpointMetrics ()
+@property (copy) NSString *key;
+@property (assign) unsigned long long requestCount;
+@property (assign) unsigned long long failureCount;
+@property (assign) long long bytesDownloaded;
+@property (assign) long long bytesUploaded;
+@property (strong) JXHTTPLatencyHistogram *queueingHistogram;
+@property (strong) JXHTTPLatencyHistogram *responseHistogram;
+@property (strong) JXHTTPLatencyHistogram *transferHistogram;
+@property (strong) JXHTTPLatencyHistogram *callbackHistogram;
+@property (strong) JXHTTPLatencyHistogram *totalHistogram;
+@end
+
+@implementation JXHTTPEndpointMetrics
+
+#pragma mark - Initialization
+
+- (instancetype)initWithKey:(NSString *)key
+{
+    if (self = [super init]) {
+        self.key = key;
+        self.requestCount = 0ULL;
+        self.failureCount = 0ULL;
+        self.bytesDownloaded = 0LL;
+        self.bytesUploaded = 0LL;
+        self.queueingHistogram = [[JXHTTPLatencyHistogram alloc] init];
+        self.responseHistogram = [[JXHTTPLatencyHistogram alloc] init];
+        self.transferHistogram = [[JXHTTPLatencyHistogram alloc] init];
+        self.callbackHistogram = [[JXHTTPLatencyHistogram alloc] init];
+        self.totalHistogram = [[JXHTTPLatencyHistogram alloc] init];
+    }
+    return self;
+}
+
+- (instancetype)init
+{
+    return [self initWithKey:nil];
+}
+
+#pragma mark - Public Methods
+
+- (void)recordOperation:(JXHTTPOperation *)operation
+{
+    self.requestCount++;
+
+    if (operation.error)
+        self.failureCount++;
+
+    self.bytesDownloaded += operation.bytesDownloaded;
+    self.bytesUploaded += operation.bytesUploaded;
+
+    NSDate *callbackDate = operation.callbackDate ?: operation.finishDate;
+
+    JXHTTPRecordInterval(self.queueingHistogram, operation.enqueueDate, operation.startDate);
+    JXHTTPRecordInterval(self.responseHistogram, operation.startDate, operation.responseDate);
+    JXHTTPRecordInterval(self.transferHistogram, operation.responseDate, operation.finishDate);
+    JXHTTPRecordInterval(self.callbackHistogram, operation.finishDate, operation.callbackDate);
+    JXHTTPRecordInterval(self.totalHistogram, operation.enqueueDate ?: operation.startDate, callbackDate);
+}
+
+#pragma mark - <NSCopying>
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    JXHTTPEndpointMetrics *copy = [[[self class] allocWithZone:zone] initWithKey:self.key];
+    copy.requestCount = self.requestCount;
+    copy.failureCount = self.failureCount;
+    copy.bytesDownloaded = self.bytesDownloaded;
+    copy.bytesUploaded = self.bytesUploaded;
+    copy.queueingHistogram = [self.queueingHistogram copy];
+    copy.responseHistogram = [self.responseHistogram copy];
+    copy.transferHistogram = [self.transferHistogram copy];
+    copy.callbackHistogram = [self.callbackHistogram copy];
+    copy.totalHistogram = [self.totalHistogram copy];
+    return copy;
+}
+
+@end
@@ -14,6 +14,13 @@
  */
 @property (strong, readonly, nonatomic) NSMutableDictionary *dictionary;
 
+/**
+ Bodies of at least this many bytes are sent gzipped, with a `Content-Encoding: gzip`
+ header, if that makes them smaller. The server must accept compressed request bodies.
+ Defaults to `0`, which disables compression.
+ */
+@property (assign, nonatomic) long long compressionThreshold;
+
 /**
  Creates a new `JXHTTPFormEncodedBody`.
  
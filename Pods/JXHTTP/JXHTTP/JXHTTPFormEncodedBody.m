@@ -1,8 +1,11 @@
 #import "JXHTTPFormEncodedBody.h"
 #import "JXURLEncoding.h"
+#import "JXHTTPCompression.h"
 
 @interface JXHTTPFormEncodedBody ()
 @property (strong, nonatomic) NSMutableDictionary *dictionary;
+@property (strong, nonatomic) NSData *encodedData;
+@property (strong, nonatomic) NSData *compressedData;
 @end
 
 @implementation JXHTTPFormEncodedBody
@@ -13,6 +16,7 @@
 {
     if (self = [super init]) {
         self.dictionary = [[NSMutableDictionary alloc] init];
+        self.compressionThreshold = 0LL;
     }
     return self;
 }
@@ -37,11 +41,28 @@
     return [[JXURLEncoding formEncodedDictionary:self.dictionary] dataUsingEncoding:NSUTF8StringEncoding];
 }
 
+- (NSData *)bodyData
+{
+    NSData *data = [self requestData];
+
+    if (self.compressionThreshold <= 0LL || (long long)[data length] < self.compressionThreshold)
+        return data;
+
+    // the dictionary is mutable, so the compressed copy is only reused while the encoding is unchanged
+    if (![self.encodedData isEqualToData:data]) {
+        NSData *compressedData = [JXHTTPCompression gzippedData:data];
+        self.encodedData = data;
+        self.compressedData = [compressedData length] < [data length] ? compressedData : nil;
+    }
+
+    return self.compressedData ?: data;
+}
+
 #pragma mark - <JXHTTPRequestBody>
 
 - (NSInputStream *)httpInputStream
 {
-    return [[NSInputStream alloc] initWithData:[self requestData]];
+    return [[NSInputStream alloc] initWithData:[self bodyData]];
 }
 
 - (NSString *)httpContentType
@@ -51,7 +72,12 @@
 
 - (long long)httpContentLength
 {
-    return [[self requestData] length];
+    return [[self bodyData] length];
+}
+
+- (NSString *)httpContentEncoding
+{
+    return [self bodyData] == self.compressedData ? @"gzip" : nil;
 }
 
 @end
@@ -3,6 +3,8 @@
 
 @interface JXHTTPJSONBody ()
 @property (strong, nonatomic) NSData *requestData;
+@property (strong, nonatomic) NSData *compressedData;
+@property (assign, nonatomic) BOOL didCompress;
 @end
 
 @implementation JXHTTPJSONBody
@@ -13,6 +15,7 @@
 {
     if (self = [super init]) {
         self.requestData = data;
+        self.compressionThreshold = 0LL;
     }
     return self;
 }
@@ -36,11 +39,27 @@
     return [self withData:data];
 }
 
+#pragma mark - Private Methods
+
+- (NSData *)bodyData
+{
+    if (self.compressionThreshold <= 0LL || (long long)[self.requestData length] < self.compressionThreshold)
+        return self.requestData;
+
+    if (!self.didCompress) {
+        NSData *compressedData = [JXHTTPCompression gzippedData:self.requestData];
+        self.compressedData = [compressedData length] < [self.requestData length] ? compressedData : nil;
+        self.didCompress = YES;
+    }
+
+    return self.compressedData ?: self.requestData;
+}
+
 #pragma mark - <JXHTTPRequestBody>
 
 - (NSInputStream *)httpInputStream
 {
-    return [[NSInputStream alloc] initWithData:self.requestData];
+    return [[NSInputStream alloc] initWithData:[self bodyData]];
 }
 
 - (NSString *)httpContentType
@@ -50,7 +69,12 @@
 
 - (long long)httpContentLength
 {
-    return [self.requestData length];
+    return [[self bodyData] length];
+}
+
+- (NSString *)httpContentEncoding
+{
+    return self.compressedData && [self bodyData] == self.compressedData ? @"gzip" : nil;
 }
 
 #pragma mark - <JXHTTPOperationDelegate>
@@ -58,6 +82,7 @@
 - (void)httpOperationDidFinishLoading:(JXHTTPOperation *)operation
 {
     self.requestData = nil;
+    self.compressedData = nil;
 }
 
 @end
@@ -0,0 +1,63 @@
+/**
+ `JXHTTPLatencyHistogram` counts durations in log-linear buckets, in the style of an HDR
+ histogram: each power-of-two range of microseconds is split into 32 equal buckets, so any
+ recorded value can be read back within about 2% while the whole range from a microsecond to
+ several hours fits in a fixed 4KB of counts. Recording is a few integer operations, and two
+ histograms can be merged by adding their counts.
+
+ Durations are recorded in seconds. Values beyond the last bucket are counted in it.
+
+ Not thread safe; <JXHTTPOperationQueue> only hands out copies of the histograms it records to.
+ */
+
+@interface JXHTTPLatencyHistogram : NSObject <NSCopying>
+
+/**
+ The number of values recorded.
+ */
+@property (assign, readonly) unsigned long long count;
+
+/**
+ The smallest value recorded, `0.0` if there are none.
+ */
+@property (assign, readonly) NSTimeInterval minimum;
+
+/**
+ The largest value recorded, `0.0` if there are none.
+ */
+@property (assign, readonly) NSTimeInterval maximum;
+
+/**
+ The mean of the values recorded, `0.0` if there are none.
+ */
+@property (readonly) NSTimeInterval mean;
+
+/**
+ Records a duration. Negative durations are ignored.
+
+ @param seconds The duration in seconds.
+ */
+- (void)recordValue:(NSTimeInterval)seconds;
+
+/**
+ The value at or below which a fraction of the recorded values fall, e.g. `0.99` for the
+ 99th percentile.
+
+ @param percentile A number between 0 and 1.
+ @returns The value, or `0.0` if there are none.
+ */
+- (NSTimeInterval)valueAtPercentile:(double)percentile;
+
+/**
+ Adds every value recorded by another histogram to this one.
+
+ @param histogram The histogram to add.
+ */
+- (void)addHistogram:(JXHTTPLatencyHistogram *)histogram;
+
+/**
+ Removes every recorded value.
+ */
+- (void)reset;
+
+@end
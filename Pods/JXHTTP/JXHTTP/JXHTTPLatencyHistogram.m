@@ -0,0 +1,147 @@
+#import "JXHTTPLatencyHistogram.h"
+
+// 2^5 sub-buckets per power of two bounds the error of a bucket's midpoint to 1/64
+#define JXHTTPLatencyHistogramSubBucketBits 5
+#define JXHTTPLatencyHistogramSubBucketCount (1 << JXHTTPLatencyHistogramSubBucketBits)
+#define JXHTTPLatencyHistogramMaxExponent 36 // 2^36 microseconds is about 19 hours
+#define JXHTTPLatencyHistogramBucketCount (JXHTTPLatencyHistogramSubBucketCount * (JXHTTPLatencyHistogramMaxExponent - JXHTTPLatencyHistogramSubBucketBits + 1))
+
+static NSUInteger JXHTTPLatencyHistogramBucketIndex(uint64_t micros)
+{
+    if (micros < JXHTTPLatencyHistogramSubBucketCount)
+        return (NSUInteger)micros;
+
+    NSUInteger exponent = 63 - __builtin_clzll(micros);
+    if (exponent >= JXHTTPLatencyHistogramMaxExponent)
+        return JXHTTPLatencyHistogramBucketCount - 1;
+
+    NSUInteger shift = exponent - JXHTTPLatencyHistogramSubBucketBits;
+    NSUInteger subBucket = (NSUInteger)(micros >> shift) - JXHTTPLatencyHistogramSubBucketCount;
+
+    return JXHTTPLatencyHistogramSubBucketCount * (shift + 1) + subBucket;
+}
+
+static double JXHTTPLatencyHistogramBucketMidpoint(NSUInteger index)
+{
+    if (index < JXHTTPLatencyHistogramSubBucketCount)
+        return (double)index;
+
+    NSUInteger shift = index / JXHTTPLatencyHistogramSubBucketCount - 1;
+    uint64_t lower = (uint64_t)(JXHTTPLatencyHistogramSubBucketCount + index % JXHTTPLatencyHistogramSubBucketCount) << shift;
+
+    return lower + ((uint64_t)1 << shift) / 2.0;
+}
+
+@interface JXHTTPLatencyHistogram ()
+@property (assign) unsigned long long count;
+@property (assign) NSTimeInterval minimum;
+@property (assign) NSTimeInterval maximum;
+@property (assign) NSTimeInterval sum;
+@end
+
+@implementation JXHTTPLatencyHistogram
+{
+    uint32_t _counts[JXHTTPLatencyHistogramBucketCount];
+}
+
+#pragma mark - Initialization
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        [self reset];
+    }
+    return self;
+}
+
+#pragma mark - Accessors
+
+- (NSTimeInterval)mean
+{
+    return self.count ? self.sum / self.count : 0.0;
+}
+
+#pragma mark - Public Methods
+
+- (void)recordValue:(NSTimeInterval)seconds
+{
+    if (seconds < 0.0 || isnan(seconds))
+        return;
+
+    uint64_t micros = (uint64_t)MIN(seconds * 1000000.0, (double)UINT64_MAX / 2.0);
+    NSUInteger index = JXHTTPLatencyHistogramBucketIndex(micros);
+
+    if (_counts[index] < UINT32_MAX)
+        _counts[index]++;
+
+    if (!self.count || seconds < self.minimum)
+        self.minimum = seconds;
+    if (!self.count || seconds > self.maximum)
+        self.maximum = seconds;
+
+    self.count++;
+    self.sum += seconds;
+}
+
+- (NSTimeInterval)valueAtPercentile:(double)percentile
+{
+    if (!self.count)
+        return 0.0;
+
+    unsigned long long target = (unsigned long long)ceil(MIN(MAX(percentile, 0.0), 1.0) * self.count);
+    if (target < 1ULL)
+        target = 1ULL;
+
+    unsigned long long seen = 0ULL;
+
+    for (NSUInteger i = 0; i < JXHTTPLatencyHistogramBucketCount; i++) {
+        seen += _counts[i];
+
+        if (seen >= target) {
+            NSTimeInterval value = JXHTTPLatencyHistogramBucketMidpoint(i) / 1000000.0;
+            return MIN(MAX(value, self.minimum), self.maximum);
+        }
+    }
+
+    return self.maximum;
+}
+
+- (void)addHistogram:(JXHTTPLatencyHistogram *)histogram
+{
+    if (!histogram.count)
+        return;
+
+    for (NSUInteger i = 0; i < JXHTTPLatencyHistogramBucketCount; i++) {
+        uint64_t total = (uint64_t)_counts[i] + histogram->_counts[i];
+        _counts[i] = (uint32_t)MIN(total, (uint64_t)UINT32_MAX);
+    }
+
+    if (!self.count || histogram.minimum < self.minimum)
+        self.minimum = histogram.minimum;
+    if (!self.count || histogram.maximum > self.maximum)
+        self.maximum = histogram.maximum;
+
+    self.count += histogram.count;
+    self.sum += histogram.sum;
+}
+
+- (void)reset
+{
+    memset(_counts, 0, sizeof(_counts));
+
+    self.count = 0ULL;
+    self.minimum = 0.0;
+    self.maximum = 0.0;
+    self.sum = 0.0;
+}
+
+#pragma mark - <NSCopying>
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    JXHTTPLatencyHistogram *copy = [[[self class] allocWithZone:zone] init];
+    [copy addHistogram:self];
+    return copy;
+}
+
+@end
@@ -3,7 +3,9 @@
  mulitpart MIME request bodies (with potentially multiple content types).
  
  File parts are streamed from disk using an `NSInputStream` and therefore memory
- efficient even in the case of very large files.
+ efficient even in the case of very large files. Each file is memory-mapped (or, failing
+ that, held open) once when the connection begins and closed when it finishes, so files
+ shouldn't be modified while they're being uploaded.
  */
 
 #import "JXHTTPRequestBody.h"
@@ -13,6 +13,10 @@ typedef enum {
 @property (strong, nonatomic) NSData *preData;
 @property (strong, nonatomic) NSData *contentData;
 @property (strong, nonatomic) NSData *postData;
+@property (strong, nonatomic) NSData *fileData;
+@property (strong, nonatomic) NSFileHandle *fileHandle;
+@property (assign, nonatomic) long long fileLength;
+@property (assign, nonatomic) long long fileOffset;
 @end
 
 @implementation JXHTTPMultipartPart
@@ -72,6 +76,10 @@ typedef enum {
     
     if (self.multipartType == JXHTTPMultipartData) {
         length += [self.contentData length];
+    } else if (self.fileData) {
+        length += [self.fileData length];
+    } else if (self.fileHandle) {
+        length += self.fileLength;
     } else if (self.multipartType == JXHTTPMultipartFile) {
         NSError *error = nil;
         NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[self filePath] error:&error];
@@ -85,45 +93,109 @@ typedef enum {
     return length;
 }
 
+- (void)openFile
+{
+    if (self.multipartType != JXHTTPMultipartFile || self.fileData || self.fileHandle)
+        return;
+    
+    NSString *filePath = [self filePath];
+    NSError *error = nil;
+    
+    self.fileData = [[NSData alloc] initWithContentsOfFile:filePath options:NSDataReadingMappedAlways error:&error];
+    if (self.fileData)
+        return;
+    
+    // mapping can fail for very large files when address space is short, so fall back to reading
+    self.fileHandle = [NSFileHandle fileHandleForReadingAtPath:filePath];
+    if (!self.fileHandle) {
+        JXError(error);
+        return;
+    }
+    
+    self.fileLength = (long long)[self.fileHandle seekToEndOfFile];
+    self.fileOffset = self.fileLength;
+}
+
+- (void)closeFile
+{
+    [self.fileHandle closeFile];
+    
+    self.fileHandle = nil;
+    self.fileData = nil;
+    self.fileLength = 0LL;
+    self.fileOffset = 0LL;
+}
+
 - (NSUInteger)loadMutableData:(NSMutableData *)mutableData withDataInRange:(NSRange)searchRange
 {
-    NSUInteger dataOffset = 0;
+    NSUInteger preLength = [self.preData length];
+    NSUInteger contentLength = (NSUInteger)[self contentLength];
+    NSUInteger postLength = [self.postData length];
+    
     NSUInteger bytesAppended = 0;
+    NSRange intersection;
+    
+    intersection = NSIntersectionRange(NSMakeRange(0, preLength), searchRange);
+    if (intersection.length > 0) {
+        [mutableData appendBytes:(const char *)[self.preData bytes] + intersection.location length:intersection.length];
+        bytesAppended += intersection.length;
+    }
     
-    for (NSData *data in @[self.preData, self.contentData, self.postData]) {
-        NSUInteger dataLength = data == self.contentData ? [self contentLength] : [data length];
-        NSRange dataRange = NSMakeRange(dataOffset, dataLength);
-        NSRange intersection = NSIntersectionRange(dataRange, searchRange);
+    intersection = NSIntersectionRange(NSMakeRange(preLength, contentLength), searchRange);
+    if (intersection.length > 0) {
+        NSRange rangeInContent = NSMakeRange(intersection.location - preLength, intersection.length);
+        NSUInteger contentBytes = [self loadMutableData:mutableData withContentInRange:rangeInContent];
+        bytesAppended += contentBytes;
         
-        if (intersection.length > 0) {
-            NSRange rangeInPart = NSMakeRange(intersection.location - dataOffset, intersection.length);
-            NSData *dataToAppend = nil;
-            
-            if (data == self.preData || data == self.postData) {
-                dataToAppend = [data subdataWithRange:rangeInPart];
-            } else if (data == self.contentData) {
-                if (self.multipartType == JXHTTPMultipartData) {
-                    dataToAppend = [data subdataWithRange:rangeInPart];
-                } else if (self.multipartType == JXHTTPMultipartFile) {
-                    NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:[self filePath]];
-                    if (!fileHandle)
-                        return bytesAppended;
-                    
-                    [fileHandle seekToFileOffset:rangeInPart.location];
-                    dataToAppend = [fileHandle readDataOfLength:rangeInPart.length];
-                    [fileHandle closeFile];
-                }
-            }
-            
-            if (dataToAppend) {
-                [mutableData appendData:dataToAppend];
-                bytesAppended += [dataToAppend length];
-            }
-        }
+        if (contentBytes < rangeInContent.length)
+            return bytesAppended;
+    }
+    
+    intersection = NSIntersectionRange(NSMakeRange(preLength + contentLength, postLength), searchRange);
+    if (intersection.length > 0) {
+        [mutableData appendBytes:(const char *)[self.postData bytes] + (intersection.location - preLength - contentLength) length:intersection.length];
+        bytesAppended += intersection.length;
+    }
+    
+    return bytesAppended;
+}
+
+- (NSUInteger)loadMutableData:(NSMutableData *)mutableData withContentInRange:(NSRange)range
+{
+    NSData *data = self.multipartType == JXHTTPMultipartData ? self.contentData : self.fileData;
+    
+    if (data) {
+        [mutableData appendBytes:(const char *)[data bytes] + range.location length:range.length];
+        return range.length;
+    }
+    
+    if (self.multipartType != JXHTTPMultipartFile)
+        return 0;
+    
+    // a file opened outside of an upload is read once and closed again
+    BOOL temporary = !self.fileHandle;
+    if (temporary)
+        [self openFile];
+    
+    NSUInteger bytesAppended = 0;
+    
+    if (self.fileData) {
+        bytesAppended = [self loadMutableData:mutableData withContentInRange:range];
+    } else if (self.fileHandle) {
+        // chunks are requested in order, so the seek is usually skipped
+        if (self.fileOffset != (long long)range.location)
+            [self.fileHandle seekToFileOffset:range.location];
         
-        dataOffset += dataLength;
+        NSData *fileChunk = [self.fileHandle readDataOfLength:range.length];
+        [mutableData appendData:fileChunk];
+        
+        bytesAppended = [fileChunk length];
+        self.fileOffset = (long long)(range.location + bytesAppended);
     }
     
+    if (temporary)
+        [self closeFile];
+    
     return bytesAppended;
 }
 
@@ -139,6 +211,7 @@ typedef enum {
 @property (strong, nonatomic) NSInputStream *httpInputStream;
 @property (strong, nonatomic) NSOutputStream *httpOutputStream;
 @property (strong, nonatomic) NSMutableData *bodyDataBuffer;
+@property (strong, nonatomic) NSMutableData *partOffsetTable;
 @property (assign, nonatomic) long long httpContentLength;
 @property (assign, nonatomic) long long bytesWritten;
 @end
@@ -151,6 +224,8 @@ typedef enum {
 {
     self.httpOutputStream.delegate = nil;
     [self.httpOutputStream close];
+    
+    [self closeFiles];
 }
 
 - (instancetype)init
@@ -190,12 +265,20 @@ typedef enum {
     if (_httpContentLength != NSURLResponseUnknownLength)
         return _httpContentLength;
     
+    // each part's offset is recorded along with the length, one past the end of the last part
+    NSUInteger partCount = [self.partsArray count];
+    self.partOffsetTable = [[NSMutableData alloc] initWithLength:(partCount + 1) * sizeof(long long)];
+    long long *offsets = [self.partOffsetTable mutableBytes];
+    
     long long newLength = 0LL;
     
-    for (JXHTTPMultipartPart *part in self.partsArray) {
-        newLength += [part dataLength];
+    for (NSUInteger i = 0; i < partCount; i++) {
+        offsets[i] = newLength;
+        newLength += [[self.partsArray objectAtIndex:i] dataLength];
     }
     
+    offsets[partCount] = newLength;
+    
     if (newLength > 0LL)
         newLength += [self.finalBoundaryData length];
     
@@ -208,28 +291,36 @@ typedef enum {
 
 - (void)httpOperationWillNeedNewBodyStream:(JXHTTPOperation *)operation
 {
-    [self recreateStreams];
+    [self recreateStreamsOnThread:operation.connectionThread];
 }
 
 - (void)httpOperationWillStart:(JXHTTPOperation *)operation
 {
-    [self recreateStreams];
+    [self recreateStreamsOnThread:operation.connectionThread];
 }
 
 - (void)httpOperationDidFinishLoading:(JXHTTPOperation *)operation
 {
     [self.httpOutputStream close];
+    [self closeFiles];
 }
 
 - (void)httpOperationDidFail:(JXHTTPOperation *)operation
 {
     [self.httpOutputStream close];
+    [self closeFiles];
 }
 
 #pragma mark - Private Methods
 
-- (void)recreateStreams
+- (void)recreateStreamsOnThread:(NSThread *)thread
 {
+    // files stay open for the whole upload, and their lengths are taken from the open files
+    for (JXHTTPMultipartPart *part in self.partsArray) {
+        [part closeFile];
+        [part openFile];
+    }
+    
     self.bodyDataBuffer = [[NSMutableData alloc] initWithCapacity:self.streamBufferLength];
     self.httpContentLength = NSURLResponseUnknownLength;
     self.bytesWritten = 0LL;
@@ -249,8 +340,7 @@ typedef enum {
         self.httpOutputStream = (__bridge_transfer NSOutputStream *)writeStream;
         
         self.httpOutputStream.delegate = self;
-        [self scheduleOutputStreamOnThread:[JXHTTPOperation sharedThread]];
-        [self.httpOutputStream open];
+        [self scheduleOutputStream:self.httpOutputStream onThread:thread];
 
         readStream = NULL;
         writeStream = NULL;
@@ -262,19 +352,15 @@ typedef enum {
         CFRelease(writeStream);
 }
 
-- (void)scheduleOutputStreamOnThread:(NSThread *)thread
+- (void)scheduleOutputStream:(NSOutputStream *)outputStream onThread:(NSThread *)thread
 {
-    if (thread && thread != [NSThread currentThread]) {
-        [self performSelector:@selector(scheduleOutputStreamOnThread:) onThread:thread withObject:nil waitUntilDone:YES];
-        return;
-    }
-
-    self.httpOutputStream.delegate = self;
-    [self.httpOutputStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
-    [self.httpOutputStream open];
+    // the connection is started on the same thread after this, so there's no need to wait
+    [JXNetworkThreadPool performBlock:^{
+        [outputStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
+        [outputStream open];
+    } onThread:thread waitUntilDone:NO];
 }
 
-
 - (void)setPartWithType:(JXHTTPMultipartPartType)type forKey:(NSString *)key contentType:(NSString *)contentTypeOrNil fileName:(NSString *)fileNameOrNil data:(NSData *)data
 {
     NSMutableArray *removal = [[NSMutableArray alloc] initWithCapacity:[self.partsArray count]];
@@ -285,6 +371,10 @@ typedef enum {
     
     [self.partsArray removeObjectsInArray:removal];
     
+    for (JXHTTPMultipartPart *part in removal) {
+        [part closeFile];
+    }
+    
     [self addPartWithType:type forKey:key contentType:contentTypeOrNil fileName:fileNameOrNil data:data];
 }
 
@@ -296,6 +386,33 @@ typedef enum {
     self.httpContentLength = NSURLResponseUnknownLength;
 }
 
+- (void)closeFiles
+{
+    for (JXHTTPMultipartPart *part in self.partsArray) {
+        [part closeFile];
+    }
+}
+
+// index of the last part starting at or before the offset, which may be past the last part
+- (NSUInteger)indexOfPartAtOffset:(long long)offset
+{
+    const long long *offsets = [self.partOffsetTable bytes];
+    NSUInteger low = 0;
+    NSUInteger high = [self.partsArray count];
+    
+    while (low < high) {
+        NSUInteger middle = low + (high - low + 1) / 2;
+        
+        if (offsets[middle] <= offset) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    
+    return low;
+}
+
 #pragma mark - <NSStreamDelegate>
 
 - (void)stream:(NSStream *)stream handleEvent:(NSStreamEvent)eventCode
@@ -334,33 +451,39 @@ typedef enum {
 {
     [data setLength:0];
     
-    NSUInteger partOffset = 0;
+    if ([self httpContentLength] <= 0LL)
+        return 0;
+    
+    const long long *offsets = [self.partOffsetTable bytes];
+    NSUInteger partCount = [self.partsArray count];
     NSUInteger bytesLoaded = 0;
     
-    for (JXHTTPMultipartPart *part in self.partsArray) {
-        NSUInteger partLength = [part dataLength];
-        NSRange partRange = NSMakeRange(partOffset, partLength);
+    for (NSUInteger i = [self indexOfPartAtOffset:searchRange.location]; i < partCount; i++) {
+        NSUInteger partOffset = (NSUInteger)offsets[i];
+        NSRange partRange = NSMakeRange(partOffset, (NSUInteger)(offsets[i + 1] - offsets[i]));
+        
+        if (partOffset >= NSMaxRange(searchRange))
+            break;
         
         NSRange intersection = NSIntersectionRange(partRange, searchRange);
         if (intersection.length > 0) {
             NSRange rangeInPart = NSMakeRange(intersection.location - partOffset, intersection.length);
-            bytesLoaded += [part loadMutableData:data withDataInRange:rangeInPart];
+            NSUInteger partBytes = [[self.partsArray objectAtIndex:i] loadMutableData:data withDataInRange:rangeInPart];
+            bytesLoaded += partBytes;
+            
+            // a short read leaves a gap, so stop and let the stream write what's contiguous
+            if (partBytes < rangeInPart.length)
+                return bytesLoaded;
         }
-        
-        partOffset += partLength;
     }
     
-    NSRange finalRange = NSMakeRange(partOffset, [self.finalBoundaryData length]);
+    NSUInteger partsLength = (NSUInteger)offsets[partCount];
+    NSRange finalRange = NSMakeRange(partsLength, [self.finalBoundaryData length]);
     NSRange intersection = NSIntersectionRange(finalRange, searchRange);
     
     if (intersection.length > 0) {
-        NSRange range = NSMakeRange(intersection.location - partOffset, intersection.length);
-        NSData *dataToAppend = [self.finalBoundaryData subdataWithRange:range];
-        
-        if (dataToAppend) {
-            [data appendData:dataToAppend];
-            bytesLoaded += [dataToAppend length];
-        }
+        [data appendBytes:(const char *)[self.finalBoundaryData bytes] + (intersection.location - partsLength) length:intersection.length];
+        bytesLoaded += intersection.length;
     }
     
     return bytesLoaded;
@@ -109,6 +109,9 @@
 
 - (NSData *)responseData
 {
+    if (self.responseBuffer)
+        return [self.responseBuffer data];
+
     NSData *data = [self.outputStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
     if (data)
         return data;
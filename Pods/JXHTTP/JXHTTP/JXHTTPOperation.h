@@ -39,19 +39,31 @@
 #import "JXURLConnectionOperation.h"
 #import "JXHTTPOperationDelegate.h"
 #import "JXHTTPRequestBody.h"
+#import "JXHTTPResponseCache.h"
+#import "JXHTTPConnectionManager.h"
+
+@class JXHTTPOperationQueue;
 
 typedef void (^JXHTTPBlock)(JXHTTPOperation *operation);
 typedef NSCachedURLResponse * (^JXHTTPCacheBlock)(JXHTTPOperation *operation, NSCachedURLResponse *response);
 typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLRequest *request, NSURLResponse *response);
 
+typedef NS_ENUM(NSInteger, JXHTTPOperationPriorityClass) {
+    JXHTTPOperationPriorityClassInteractive,
+    JXHTTPOperationPriorityClassUserInitiated,
+    JXHTTPOperationPriorityClassPrefetch,
+    JXHTTPOperationPriorityClassBulkUpload
+};
+
 @interface JXHTTPOperation : JXURLConnectionOperation
 
 /// @name Core
 
 /**
  An optional, non-retained object conforming to the <JXHTTPOperationDelegate> protocol.
+ The methods it implements are looked up once, when the operation starts.
  
- Safe to access from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
  @warning Delegate methods will be called on a background thread. No other
  guarantees are made about thread continuity.
@@ -68,12 +80,22 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
 
 /**
  A string guaranteed to be unique for the lifetime of the application process, useful
- for keying operations stored in a collection.
+ for keying operations stored in a collection. Built from <operationID> the first time
+ it's accessed.
  
  Safe to access from any thread at any time.
  */
 @property (strong, readonly) NSString *uniqueString;
 
+/**
+ A number unique for the lifetime of the application process, increasing in the order
+ operations are created. A cheaper key than <uniqueString> for operations stored in a
+ collection.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) unsigned long long operationID;
+
 /**
  A convenience property for creating an `NSOutputStream` that streams response data to disk.
  If this property is nil when the operation starts the `outputStream` property is used instead,
@@ -84,6 +106,93 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
  */
 @property (copy, nonatomic) NSString *responseDataFilePath;
 
+/**
+ If `YES`, a download to <responseDataFilePath> that is interrupted keeps what it has
+ written so far, and the next operation with the same URL and path picks up where it
+ left off with a `Range` request. An `If-Range` header carrying the response's `ETag` or
+ `Last-Modified` date makes the server send the whole entity instead if it has changed,
+ in which case the file is started over. Any other status than `200` or `206` fails the
+ operation and leaves the partial file alone. The validator is kept in a file next to the
+ download, ending in `.jxresume`, which is deleted when the download finishes.
+
+ Responses are requested without a content encoding, since byte ranges of an encoded
+ response don't line up with the decoded bytes written to the file. Defaults to `NO`.
+
+ Safe to access from any thread at any time, should only be changed before operation start.
+ */
+@property (assign) BOOL resumesDownload;
+
+/**
+ The number of bytes that were already in <responseDataFilePath> when a resumed download
+ started, otherwise `0`. Not counted by `bytesDownloaded`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) long long resumedLength;
+
+/**
+ The number of response bytes held in memory before the response buffer spills to a
+ temporary file, after which <responseData> and <responseJSON> read from a memory mapping
+ of that file. A response whose expected length already exceeds it is written straight
+ to disk. The file is deleted when the operation is deallocated. Has no effect when
+ <responseDataFilePath> or `outputStream` is set. Set to `0` to never spill.
+ Defaults to `1MB`.
+
+ Safe to access from any thread at any time, should only be changed before operation start.
+ */
+@property (assign) long long responseDataSpillThreshold;
+
+/// @name Caching
+
+/**
+ A cache used to revalidate and store the response of a `GET` request that has no
+ `outputStream`. See <JXHTTPResponseCache>. Defaults to `nil`.
+
+ If the server answers `304 Not Modified` but the entry was evicted after its validators
+ were sent, the request is sent once more without them to get the full response.
+
+ Safe to access from any thread at any time, should only be changed before operation start.
+ */
+@property (strong) JXHTTPResponseCache *responseCache;
+
+/**
+ The key the response is cached under. Requests whose responses differ for reasons not
+ reflected in the URL (such as credentials) should set distinct keys. Defaults to the
+ absolute string of the request URL when `nil`.
+
+ Safe to access from any thread at any time, should only be changed before operation start.
+ */
+@property (copy) NSString *responseCacheKey;
+
+/**
+ `YES` if the server answered `304 Not Modified` and the response and body are those of
+ the <responseCache> entry.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) BOOL didUseCachedResponse;
+
+/// @name Scheduling
+
+/**
+ The class of work the request belongs to. A <JXHTTPOperationQueue> starts waiting
+ operations in order of class, `Interactive` first, and keeps one slot free of `Prefetch`
+ and `BulkUpload` operations so they can't hold up anything the user is waiting on.
+ Other queues ignore it. Defaults to `JXHTTPOperationPriorityClassUserInitiated`.
+
+ Must not be changed once the operation has been added to a queue.
+ */
+@property (assign) JXHTTPOperationPriorityClass priorityClass;
+
+/**
+ An optional connection manager that accounts for the connection the request uses, limits
+ how many requests to the same host a <JXHTTPOperationQueue> runs at once, and turns on
+ pipelining for safe requests. Defaults to `nil`.
+
+ Must not be changed once the operation has been added to a queue.
+ */
+@property (strong) JXHTTPConnectionManager *connectionManager;
+
 /**
  A user-supplied object retained for the lifetime of the operation.
 
@@ -129,6 +238,14 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
 
 /// @name Timing
 
+/**
+ The date the operation was added to a <JXHTTPOperationQueue>, or `nil`. Set by the queue;
+ operations added to other queues can set it themselves so that queueing time is measured.
+ 
+ Safe to access from any thread at any time.
+ */
+@property (strong) NSDate *enqueueDate;
+
 /**
  The start date of the operation or `nil` if the operation has not started.
  
@@ -136,6 +253,20 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
  */
 @property (strong, readonly) NSDate *startDate;
 
+/**
+ The date the response headers were received, or `nil`.
+ 
+ Safe to access from any thread at any time.
+ */
+@property (strong, readonly) NSDate *responseDate;
+
+/**
+ The date the first byte of the response body was received, or `nil`.
+ 
+ Safe to access from any thread at any time.
+ */
+@property (strong, readonly) NSDate *firstByteDate;
+
 /**
  The finish date of the operation or `nil` if the operation has not finished.
  
@@ -143,6 +274,32 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
  */
 @property (strong, readonly) NSDate *finishDate;
 
+/**
+ The date the final delegate method and block (`didFinishLoadingBlock` or `didFailBlock`)
+ had been performed, or `nil`. The gap after <finishDate> is the time the block spent
+ waiting on its queue.
+ 
+ Safe to access from any thread at any time.
+ */
+@property (strong, readonly) NSDate *callbackDate;
+
+/**
+ The key the operation's timing is aggregated under by its <operationQueue>, typically the
+ endpoint it calls. Defaults to `nil`, which aggregates it under its method, host and path.
+ 
+ Safe to access from any thread at any time.
+ */
+@property (copy) NSString *metricsKey;
+
+/**
+ The queue the operation reports its progress and finishing to as they happen, and that
+ records its timing once <callbackDate> is set. Set by <JXHTTPOperationQueue> when the
+ operation is added.
+ 
+ Safe to access from any thread at any time.
+ */
+@property (weak) JXHTTPOperationQueue *operationQueue;
+
 /**
  The number of seconds elapsed since the operation started, 0.0 if it has not.
  
@@ -150,6 +307,25 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
  */
 @property (readonly) NSTimeInterval elapsedSeconds;
 
+/// @name Resuming
+
+/**
+ The validator of a response that can be sent in an `If-Range` header: its `ETag` if
+ that is a strong one, or else its `Last-Modified` date.
+
+ @param response A response.
+ @returns The validator, or `nil` if the response has none.
+ */
++ (NSString *)rangeValidatorForResponse:(NSURLResponse *)response;
+
+/**
+ The offset of the first byte in a `206 Partial Content` response.
+
+ @param response A response.
+ @returns The offset from the response's `Content-Range`, or `-1` if it isn't a partial response.
+ */
++ (long long)rangeStartOfResponse:(NSURLResponse *)response;
+
 /// @name Blocks
 
 /**
@@ -164,7 +340,7 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
 /**
  Performed at the very start of the operation, before the connection object is created.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
   @see <JXHTTPOperationDelegate>
  */
@@ -174,7 +350,7 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
  Performed when the underlying `NSURLConnection` requires a new, unopened stream
  for the <requestBody> when a retransmission is necessary.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
  @warning For notification purposes only, do not use this block to supply the stream.
  
@@ -185,7 +361,7 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
 /**
  Performed when the underlying `NSURLConnection` receives a request for authentication.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
  @warning For notification purposes only, do not use this block to supply the credential.
  @see <JXHTTPOperationDelegate>
@@ -195,7 +371,7 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
 /**
  Performed immediately after the underlying `NSURLConnection` begins.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
   @see <JXHTTPOperationDelegate>
  */
@@ -204,25 +380,27 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
 /**
  Performed immediately after the underlying `NSURLConnection` receives a response.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
   @see <JXHTTPOperationDelegate>
  */
 @property (copy) JXHTTPBlock didReceiveResponseBlock;
 
 /**
- Performed every time the underlying `NSURLConnection` receives response data.
+ Performed after the underlying `NSURLConnection` receives response data, at most once per
+ turn of the connection's run loop however many chunks arrived in it.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
   @see <JXHTTPOperationDelegate>
  */
 @property (copy) JXHTTPBlock didReceiveDataBlock;
 
 /**
- Performed every time the underlying `NSURLConnection` sends request data.
+ Performed after the underlying `NSURLConnection` sends request data, at most once per
+ turn of the connection's run loop.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
   @see <JXHTTPOperationDelegate>
  */
@@ -231,7 +409,7 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
 /**
  Performed when the underlying `NSURLConnection` finishes loading successfully.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
   @see <JXHTTPOperationDelegate>
  */
@@ -241,7 +419,7 @@ typedef NSURLRequest * (^JXHTTPRedirectBlock)(JXHTTPOperation *operation, NSURLR
  Performed when the underlying `NSURLConnection` fails to load. The `error` property
  is available for inspection.
  
- Safe to access and change from any thread at any time.
+ Safe to access from any thread at any time, should only be changed before operation start.
  
   @see <JXHTTPOperationDelegate>
  */
@@ -1,28 +1,97 @@
 #import "JXHTTPOperation.h"
 #import "JXURLEncoding.h"
+#import "JXHTTPCompression.h"
+#import "JXHTTPOperationQueue.h"
+#import <libkern/OSAtomic.h>
 
 static NSUInteger JXHTTPOperationCount = 0;
+static volatile int64_t JXHTTPOperationLastID = 0LL;
 static NSTimer * JXHTTPActivityTimer = nil;
 static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
+static long long JXHTTPOperationDefaultSpillThreshold = 0x100000; // 1MB
+
+typedef NS_ENUM(uint32_t, JXHTTPOperationEvent) {
+    JXHTTPOperationEventWillStart,
+    JXHTTPOperationEventWillNeedNewBodyStream,
+    JXHTTPOperationEventWillSendRequestForAuthenticationChallenge,
+    JXHTTPOperationEventDidStart,
+    JXHTTPOperationEventDidReceiveResponse,
+    JXHTTPOperationEventDidReceiveData,
+    JXHTTPOperationEventDidSendData,
+    JXHTTPOperationEventDidFinishLoading,
+    JXHTTPOperationEventDidFail,
+    JXHTTPOperationEventCount
+};
+
+static SEL JXHTTPOperationEventSelector(JXHTTPOperationEvent event)
+{
+    switch (event) {
+        case JXHTTPOperationEventWillStart: return @selector(httpOperationWillStart:);
+        case JXHTTPOperationEventWillNeedNewBodyStream: return @selector(httpOperationWillNeedNewBodyStream:);
+        case JXHTTPOperationEventWillSendRequestForAuthenticationChallenge: return @selector(httpOperationWillSendRequestForAuthenticationChallenge:);
+        case JXHTTPOperationEventDidStart: return @selector(httpOperationDidStart:);
+        case JXHTTPOperationEventDidReceiveResponse: return @selector(httpOperationDidReceiveResponse:);
+        case JXHTTPOperationEventDidReceiveData: return @selector(httpOperationDidReceiveData:);
+        case JXHTTPOperationEventDidSendData: return @selector(httpOperationDidSendData:);
+        case JXHTTPOperationEventDidFinishLoading: return @selector(httpOperationDidFinishLoading:);
+        case JXHTTPOperationEventDidFail: return @selector(httpOperationDidFail:);
+        default: return NULL;
+    }
+}
+
+static void JXHTTPOperationSendEvent(id <JXHTTPOperationDelegate> listener, JXHTTPOperationEvent event, JXHTTPOperation *operation)
+{
+    switch (event) {
+        case JXHTTPOperationEventWillStart: [listener httpOperationWillStart:operation]; break;
+        case JXHTTPOperationEventWillNeedNewBodyStream: [listener httpOperationWillNeedNewBodyStream:operation]; break;
+        case JXHTTPOperationEventWillSendRequestForAuthenticationChallenge: [listener httpOperationWillSendRequestForAuthenticationChallenge:operation]; break;
+        case JXHTTPOperationEventDidStart: [listener httpOperationDidStart:operation]; break;
+        case JXHTTPOperationEventDidReceiveResponse: [listener httpOperationDidReceiveResponse:operation]; break;
+        case JXHTTPOperationEventDidReceiveData: [listener httpOperationDidReceiveData:operation]; break;
+        case JXHTTPOperationEventDidSendData: [listener httpOperationDidSendData:operation]; break;
+        case JXHTTPOperationEventDidFinishLoading: [listener httpOperationDidFinishLoading:operation]; break;
+        case JXHTTPOperationEventDidFail: [listener httpOperationDidFail:operation]; break;
+        default: break;
+    }
+}
+
+// high frequency events are coalesced into one call per run loop turn
+static uint32_t JXHTTPOperationBatchedEvents = (1U << JXHTTPOperationEventDidReceiveData) | (1U << JXHTTPOperationEventDidSendData);
 
 @interface JXHTTPOperation ()
 @property (assign) BOOL didIncrementCount;
 @property (strong) NSURLAuthenticationChallenge *authenticationChallenge;
 @property (strong) NSNumber *downloadProgress;
 @property (strong) NSNumber *uploadProgress;
-@property (strong) NSString *uniqueString;
+@property (assign) unsigned long long operationID;
 @property (strong) NSDate *startDate;
+@property (strong) NSDate *responseDate;
+@property (strong) NSDate *firstByteDate;
 @property (strong) NSDate *finishDate;
+@property (strong) NSDate *callbackDate;
+@property (copy) NSString *activeResponseCacheKey;
+@property (assign) BOOL didUseCachedResponse;
+@property (assign) BOOL didAddCacheValidators;
+@property (assign) BOOL isRevalidatingWithoutValidators;
+@property (assign) long long resumedLength;
+@property (assign) long long reportedBytesDownloaded;
+@property (assign) long long reportedBytesUploaded;
+@property (assign) long long reportedExpectedBytes;
 @property (assign) dispatch_once_t incrementCountOnce;
 @property (assign) dispatch_once_t decrementCountOnce;
-#if OS_OBJECT_USE_OBJC
-@property (strong) dispatch_queue_t blockQueue;
-#else
-@property (assign) dispatch_queue_t blockQueue;
-#endif
+@property (assign) dispatch_once_t uniqueStringOnce;
+@property (assign) dispatch_once_t blockQueueOnce;
+@property (assign) uint32_t delegateEvents;
+@property (assign) uint32_t requestBodyEvents;
+@property (assign) uint32_t blockEvents;
 @end
 
 @implementation JXHTTPOperation
+{
+    NSString *_uniqueString;
+    dispatch_queue_t _blockQueue;
+    volatile uint32_t _pendingEvents;
+}
 
 #pragma mark - Initialization
 
@@ -31,7 +100,8 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
     [self decrementOperationCount];
 
     #if !OS_OBJECT_USE_OBJC
-    dispatch_release(_blockQueue);
+    if (_blockQueue)
+        dispatch_release(_blockQueue);
     _blockQueue = NULL;
     #endif
 }
@@ -39,16 +109,14 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
 - (instancetype)init
 {
     if (self = [super init]) {
-        NSString *queueName = [[NSString alloc] initWithFormat:@"%@.%p.blocks", NSStringFromClass([self class]), self];
-        self.blockQueue = dispatch_queue_create([queueName UTF8String], DISPATCH_QUEUE_SERIAL);
-
-        self.uniqueString = [[NSProcessInfo processInfo] globallyUniqueString];
+        self.operationID = (unsigned long long)OSAtomicIncrement64Barrier(&JXHTTPOperationLastID);
         self.downloadProgress = @0.0f;
         self.uploadProgress = @0.0f;
         self.performsBlocksOnMainQueue = NO;
         self.updatesNetworkActivityIndicator = YES;
         self.authenticationChallenge = nil;
         self.responseDataFilePath = nil;
+        self.responseDataSpillThreshold = JXHTTPOperationDefaultSpillThreshold;
         self.credential = nil;
         self.userObject = nil;
         self.didIncrementCount = NO;
@@ -57,8 +125,25 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
         self.trustAllHosts = NO;
         self.username = nil;
         self.password = nil;
+        self.enqueueDate = nil;
         self.startDate = nil;
+        self.responseDate = nil;
+        self.firstByteDate = nil;
         self.finishDate = nil;
+        self.callbackDate = nil;
+        self.metricsKey = nil;
+        self.operationQueue = nil;
+        self.responseCache = nil;
+        self.responseCacheKey = nil;
+        self.activeResponseCacheKey = nil;
+        self.didUseCachedResponse = NO;
+        self.priorityClass = JXHTTPOperationPriorityClassUserInitiated;
+        self.connectionManager = nil;
+        self.resumesDownload = NO;
+        self.resumedLength = 0LL;
+        self.reportedBytesDownloaded = 0LL;
+        self.reportedBytesUploaded = 0LL;
+        self.reportedExpectedBytes = 0LL;
 
         self.willStartBlock = nil;
         self.willNeedNewBodyStreamBlock = nil;
@@ -92,49 +177,169 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
 
 #pragma mark - Private Methods
 
-- (void)performDelegateMethod:(SEL)selector
+// resolves who listens to which events once, so events nobody listens to cost nothing
+- (void)resolveListeners
+{
+    NSObject <JXHTTPOperationDelegate> *delegate = self.delegate;
+    NSObject <JXHTTPRequestBody> *requestBody = self.requestBody;
+
+    uint32_t delegateEvents = 0;
+    uint32_t requestBodyEvents = 0;
+    uint32_t blockEvents = 0;
+
+    for (JXHTTPOperationEvent event = 0; event < JXHTTPOperationEventCount; event++) {
+        SEL selector = JXHTTPOperationEventSelector(event);
+
+        if ([delegate respondsToSelector:selector])
+            delegateEvents |= 1U << event;
+        if ([requestBody respondsToSelector:selector])
+            requestBodyEvents |= 1U << event;
+        if ([self blockForEvent:event])
+            blockEvents |= 1U << event;
+    }
+
+    self.delegateEvents = delegateEvents;
+    self.requestBodyEvents = requestBodyEvents;
+    self.blockEvents = blockEvents;
+}
+
+- (void)performEvent:(JXHTTPOperationEvent)event
 {
     if ([self isCancelled])
         return;
-    
-    if ([self.delegate respondsToSelector:selector])
-        [self.delegate performSelector:selector onThread:[NSThread currentThread] withObject:self waitUntilDone:YES];
 
-    if ([self.requestBody respondsToSelector:selector])
-        [self.requestBody performSelector:selector onThread:[NSThread currentThread] withObject:self waitUntilDone:YES];
+    uint32_t eventBit = 1U << event;
+
+    if (!((self.delegateEvents | self.requestBodyEvents | self.blockEvents) & eventBit)) {
+        if (event == JXHTTPOperationEventDidFinishLoading || event == JXHTTPOperationEventDidFail)
+            [self didDeliverCallback];
+        return;
+    }
+
+    if (eventBit & JXHTTPOperationBatchedEvents) {
+        // only the first event since the last flush schedules one, later events ride along with it
+        if (!OSAtomicOr32OrigBarrier(eventBit, &_pendingEvents)) {
+            CFRunLoopPerformBlock(CFRunLoopGetCurrent(), kCFRunLoopCommonModes, ^{
+                [self flushPendingEvents];
+            });
+        }
+
+        return;
+    }
+
+    // batched events that happened first are delivered first
+    [self flushPendingEvents];
+
+    [self deliverEvent:event];
+}
+
+- (void)flushPendingEvents
+{
+    uint32_t pendingEvents = OSAtomicAnd32OrigBarrier(0, &_pendingEvents);
+
+    if (pendingEvents & (1U << JXHTTPOperationEventDidSendData))
+        [self deliverEvent:JXHTTPOperationEventDidSendData];
+
+    if (pendingEvents & (1U << JXHTTPOperationEventDidReceiveData))
+        [self deliverEvent:JXHTTPOperationEventDidReceiveData];
+}
+
+- (void)deliverEvent:(JXHTTPOperationEvent)event
+{
+    if ([self isCancelled])
+        return;
+
+    uint32_t eventBit = 1U << event;
+
+    if (self.delegateEvents & eventBit)
+        JXHTTPOperationSendEvent(self.delegate, event, self);
+
+    if (self.requestBodyEvents & eventBit)
+        JXHTTPOperationSendEvent(self.requestBody, event, self);
+
+    JXHTTPBlock block = self.blockEvents & eventBit ? [self blockForEvent:event] : nil;
+    BOOL final = event == JXHTTPOperationEventDidFinishLoading || event == JXHTTPOperationEventDidFail;
 
-    JXHTTPBlock block = [self blockForSelector:selector];
+    if ([self isCancelled])
+        return;
 
-    if ([self isCancelled] || !block)
+    if (!block) {
+        if (final)
+            [self didDeliverCallback];
         return;
+    }
 
     dispatch_async(self.performsBlocksOnMainQueue ? dispatch_get_main_queue() : self.blockQueue, ^{
-        if (![self isCancelled])
-            block(self);
+        if ([self isCancelled])
+            return;
+
+        block(self);
+
+        if (final)
+            [self didDeliverCallback];
     });
 }
 
-- (JXHTTPBlock)blockForSelector:(SEL)selector
-{
-    if (selector == @selector(httpOperationWillStart:))
-        return self.willStartBlock;
-    if (selector == @selector(httpOperationWillNeedNewBodyStream:))
-        return self.willNeedNewBodyStreamBlock;
-    if (selector == @selector(httpOperationWillSendRequestForAuthenticationChallenge:))
-        return self.willSendRequestForAuthenticationChallengeBlock;
-    if (selector == @selector(httpOperationDidStart:))
-        return self.didStartBlock;
-    if (selector == @selector(httpOperationDidReceiveResponse:))
-        return self.didReceiveResponseBlock;
-    if (selector == @selector(httpOperationDidReceiveData:))
-        return self.didReceiveDataBlock;
-    if (selector == @selector(httpOperationDidSendData:))
-        return self.didSendDataBlock;
-    if (selector == @selector(httpOperationDidFinishLoading:))
-        return self.didFinishLoadingBlock;
-    if (selector == @selector(httpOperationDidFail:))
-        return self.didFailBlock;
-    return nil;
+- (void)didDeliverCallback
+{
+    self.callbackDate = [[NSDate alloc] init];
+
+    [self.operationQueue recordMetricsForOperation:self];
+}
+
+- (void)reportProgressToQueue
+{
+    JXHTTPOperationQueue *queue = self.operationQueue;
+    if (!queue)
+        return;
+
+    long long expected = [self.response expectedContentLength];
+    if (expected < 0LL)
+        expected = 0LL;
+
+    // only the change since the last report is passed on, so the queue's totals never need re-summing
+    long long downloaded = self.bytesDownloaded;
+    long long uploaded = self.bytesUploaded;
+
+    long long downloadedDelta = downloaded - self.reportedBytesDownloaded;
+    long long uploadedDelta = uploaded - self.reportedBytesUploaded;
+    long long expectedDelta = expected - self.reportedExpectedBytes;
+
+    self.reportedBytesDownloaded = downloaded;
+    self.reportedBytesUploaded = uploaded;
+    self.reportedExpectedBytes = expected;
+
+    if (downloadedDelta || expectedDelta)
+        [queue operation:self didDownloadBytes:downloadedDelta expectedBytes:expectedDelta];
+
+    if (uploadedDelta)
+        [queue operation:self didUploadBytes:uploadedDelta];
+}
+
+- (dispatch_queue_t)blockQueue
+{
+    // created on first use, most operations never need their own
+    dispatch_once(&_blockQueueOnce, ^{
+        _blockQueue = dispatch_queue_create("JXHTTPOperation.blocks", DISPATCH_QUEUE_SERIAL);
+    });
+
+    return _blockQueue;
+}
+
+- (JXHTTPBlock)blockForEvent:(JXHTTPOperationEvent)event
+{
+    switch (event) {
+        case JXHTTPOperationEventWillStart: return self.willStartBlock;
+        case JXHTTPOperationEventWillNeedNewBodyStream: return self.willNeedNewBodyStreamBlock;
+        case JXHTTPOperationEventWillSendRequestForAuthenticationChallenge: return self.willSendRequestForAuthenticationChallengeBlock;
+        case JXHTTPOperationEventDidStart: return self.didStartBlock;
+        case JXHTTPOperationEventDidReceiveResponse: return self.didReceiveResponseBlock;
+        case JXHTTPOperationEventDidReceiveData: return self.didReceiveDataBlock;
+        case JXHTTPOperationEventDidSendData: return self.didSendDataBlock;
+        case JXHTTPOperationEventDidFinishLoading: return self.didFinishLoadingBlock;
+        case JXHTTPOperationEventDidFail: return self.didFailBlock;
+        default: return nil;
+    }
 }
 
 #pragma mark - Operation Count
@@ -205,6 +410,23 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
 
 #pragma mark - Accessors
 
+- (NSString *)uniqueString
+{
+    static NSString *processString = nil;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^{
+        processString = [[NSProcessInfo processInfo] globallyUniqueString];
+    });
+
+    // one globally unique string per process, told apart by the operation ID
+    dispatch_once(&_uniqueStringOnce, ^{
+        _uniqueString = [[NSString alloc] initWithFormat:@"%@-%llx", processString, self.operationID];
+    });
+
+    return _uniqueString;
+}
+
 - (void)setResponseDataFilePath:(NSString *)filePath
 {
     if ([self isCancelled] || self.isExecuting || self.isFinished)
@@ -229,6 +451,109 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
     }
 }
 
+#pragma mark - Resuming
+
++ (NSString *)rangeValidatorForResponse:(NSURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]])
+        return nil;
+
+    NSDictionary *headers = [(NSHTTPURLResponse *)response allHeaderFields];
+
+    // weak entity tags can't be used for ranges
+    NSString *entityTag = [headers objectForKey:@"ETag"];
+    if ([entityTag length] && ![entityTag hasPrefix:@"W/"])
+        return entityTag;
+
+    NSString *lastModified = [headers objectForKey:@"Last-Modified"];
+    if ([lastModified length])
+        return lastModified;
+
+    return nil;
+}
+
++ (long long)rangeStartOfResponse:(NSURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]] || [(NSHTTPURLResponse *)response statusCode] != 206)
+        return -1LL;
+
+    NSString *contentRange = [[(NSHTTPURLResponse *)response allHeaderFields] objectForKey:@"Content-Range"];
+    NSScanner *scanner = [[NSScanner alloc] initWithString:contentRange ?: @""];
+    long long start = -1LL;
+
+    if (![scanner scanString:@"bytes" intoString:NULL] || ![scanner scanLongLong:&start])
+        return -1LL;
+
+    return start;
+}
+
+- (NSString *)resumeFilePath
+{
+    return [self.responseDataFilePath stringByAppendingString:@".jxresume"];
+}
+
+- (void)addResumeHeaders
+{
+    // the file's bytes have to match the entity's, which they wouldn't after decoding
+    if (![self.request valueForHTTPHeaderField:@"Accept-Encoding"])
+        [self.request setValue:@"identity" forHTTPHeaderField:@"Accept-Encoding"];
+
+    NSDictionary *resumeInfo = [[NSDictionary alloc] initWithContentsOfFile:[self resumeFilePath]];
+    NSString *validator = [resumeInfo objectForKey:@"validator"];
+
+    if (![validator length] || ![[resumeInfo objectForKey:@"url"] isEqualToString:[[self.request URL] absoluteString]])
+        return;
+
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.responseDataFilePath error:nil];
+    long long length = [[attributes objectForKey:NSFileSize] longLongValue];
+
+    if (length <= 0LL)
+        return;
+
+    self.resumedLength = length;
+
+    [self.request setValue:[[NSString alloc] initWithFormat:@"bytes=%lld-", length] forHTTPHeaderField:@"Range"];
+    [self.request setValue:validator forHTTPHeaderField:@"If-Range"];
+}
+
+// called on the connection thread before the output stream is opened, NO if the response can't be written
+- (BOOL)prepareOutputStreamForResponse:(NSURLResponse *)urlResponse
+{
+    NSInteger statusCode = [urlResponse isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse *)urlResponse statusCode] : 0;
+
+    // a range other than the one asked for can't be appended, and is no use as a whole file either
+    if (statusCode == 206 && [[self class] rangeStartOfResponse:urlResponse] != self.resumedLength) {
+        [[NSFileManager defaultManager] removeItemAtPath:[self resumeFilePath] error:nil];
+        return NO;
+    }
+
+    if (self.resumedLength > 0LL) {
+        if (statusCode == 206) {
+            NSOutputStream *appendStream = [[NSOutputStream alloc] initToFileAtPath:self.responseDataFilePath append:YES];
+            [self.outputStream removeFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
+            [appendStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
+            self.outputStream = appendStream;
+        } else if (statusCode == 200) {
+            // the entity changed or the server ignored the range, the unopened stream starts the file over
+            self.resumedLength = 0LL;
+        } else {
+            // an error or a redirect isn't the entity, keep the partial file and its validator for another try
+            return NO;
+        }
+    }
+
+    NSString *validator = [[self class] rangeValidatorForResponse:urlResponse];
+
+    if (statusCode / 100 == 2 && validator) {
+        NSDictionary *resumeInfo = @{ @"url": [[self.request URL] absoluteString], @"validator": validator };
+        [resumeInfo writeToFile:[self resumeFilePath] atomically:YES];
+    } else if (statusCode != 206) {
+        [[NSFileManager defaultManager] removeItemAtPath:[self resumeFilePath] error:nil];
+    }
+
+    return YES;
+}
+
 #pragma mark - JXOperation
 
 - (void)main
@@ -236,7 +561,9 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
     if ([self isCancelled])
         return;
 
-    [self performDelegateMethod:@selector(httpOperationWillStart:)];
+    [self resolveListeners];
+
+    [self performEvent:JXHTTPOperationEventWillStart];
 
     [self incrementOperationCount];
 
@@ -255,6 +582,13 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
         if (![self.request valueForHTTPHeaderField:@"Content-Type"])
             [self.request setValue:contentType forHTTPHeaderField:@"Content-Type"];
 
+        NSString *contentEncoding = nil;
+        if ([self.requestBody respondsToSelector:@selector(httpContentEncoding)])
+            contentEncoding = [self.requestBody httpContentEncoding];
+
+        if ([contentEncoding length] && ![self.request valueForHTTPHeaderField:@"Content-Encoding"])
+            [self.request setValue:contentEncoding forHTTPHeaderField:@"Content-Encoding"];
+
         if (![self.request valueForHTTPHeaderField:@"User-Agent"])
             [self.request setValue:@"JXHTTP" forHTTPHeaderField:@"User-Agent"];
 
@@ -263,11 +597,40 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
             [self.request setValue:[[NSString alloc] initWithFormat:@"%lld", expectedLength] forHTTPHeaderField:@"Content-Length"];
     }
 
+    if (self.resumesDownload && [self.responseDataFilePath length])
+        [self addResumeHeaders];
+
+    // the system decodes these as they arrive, asking explicitly keeps it from depending on the platform default
+    if (![self.request valueForHTTPHeaderField:@"Accept-Encoding"])
+        [self.request setValue:@"gzip, deflate" forHTTPHeaderField:@"Accept-Encoding"];
+
+    NSString *method = [[self.request HTTPMethod] uppercaseString];
+
+    if (self.responseCache && (![method length] || [method isEqualToString:@"GET"]) && !self.outputStream) {
+        self.activeResponseCacheKey = self.responseCacheKey ?: [[self.request URL] absoluteString];
+
+        // keep NSURLCache from answering a 304 on our behalf
+        self.request.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+
+        self.didAddCacheValidators = [self.responseCache addValidatorsToRequest:self.request forKey:self.activeResponseCacheKey];
+    }
+
+    [self.connectionManager operationWillStart:self];
+
     self.startDate = [[NSDate alloc] init];
 
     [super main];
-    
-    [self performDelegateMethod:@selector(httpOperationDidStart:)];
+}
+
+- (void)didStartConnection
+{
+    [super didStartConnection];
+
+    // a connection restarted without validators is still the same start as far as observers are concerned
+    if (self.isRevalidatingWithoutValidators)
+        return;
+
+    [self performEvent:JXHTTPOperationEventDidStart];
 }
 
 - (void)willFinish
@@ -275,20 +638,37 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
     [super willFinish];
 
     [self decrementOperationCount];
+
+    [self.connectionManager operationDidFinish:self];
+
+    [self.operationQueue operationWillFinish:self];
+}
+
+#pragma mark - JXURLConnectionOperation
+
+- (JXResponseBuffer *)responseBufferForResponse:(NSURLResponse *)urlResponse
+{
+    // an encoded response's expected length is the encoded size, which would undersize the buffer
+    long long expectedLength = [JXHTTPCompression isEncodedResponse:urlResponse] ? NSURLResponseUnknownLength : [urlResponse expectedContentLength];
+
+    return [[JXResponseBuffer alloc] initWithExpectedLength:expectedLength
+                                             spillThreshold:self.responseDataSpillThreshold];
 }
 
 #pragma mark - <NSURLConnectionDelegate>
 
 - (void)connection:(NSURLConnection *)connection didFailWithError:(NSError *)error
 {
+    // super finishes the operation, so the date has to be set before the completion block can read it
+    if (![self isCancelled])
+        self.finishDate = [[NSDate alloc] init];
+
     [super connection:connection didFailWithError:error];
 
     if ([self isCancelled])
         return;
 
-    self.finishDate = [[NSDate alloc] init];
-
-    [self performDelegateMethod:@selector(httpOperationDidFail:)];
+    [self performEvent:JXHTTPOperationEventDidFail];
 }
 
 - (BOOL)connectionShouldUseCredentialStorage:(NSURLConnection *)connection
@@ -305,7 +685,7 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
 
     self.authenticationChallenge = challenge;
 
-    [self performDelegateMethod:@selector(httpOperationWillSendRequestForAuthenticationChallenge:)];
+    [self performEvent:JXHTTPOperationEventWillSendRequestForAuthenticationChallenge];
 
     if (!self.credential && self.authenticationChallenge.protectionSpace.authenticationMethod == NSURLAuthenticationMethodServerTrust) {
         BOOL trusted = NO;
@@ -340,57 +720,111 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
 
 - (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)urlResponse
 {
+    NSData *cachedData = nil;
+
+    if (self.activeResponseCacheKey && [urlResponse isKindOfClass:[NSHTTPURLResponse class]] && [(NSHTTPURLResponse *)urlResponse statusCode] == 304) {
+        NSHTTPURLResponse *cachedResponse = [self.responseCache cachedResponseForNotModifiedResponse:(NSHTTPURLResponse *)urlResponse
+                                                                                               forKey:self.activeResponseCacheKey];
+        if (cachedResponse)
+            cachedData = [self.responseCache cachedDataForKey:self.activeResponseCacheKey];
+
+        if (cachedData) {
+            urlResponse = cachedResponse;
+            self.didUseCachedResponse = YES;
+        } else if (self.didAddCacheValidators && !self.isRevalidatingWithoutValidators && ![self isCancelled]) {
+            // the entry was evicted after its validators went out, so ask again for the full response
+            [connection cancel];
+
+            self.isRevalidatingWithoutValidators = YES;
+            [self.request setValue:nil forHTTPHeaderField:@"If-None-Match"];
+            [self.request setValue:nil forHTTPHeaderField:@"If-Modified-Since"];
+
+            [self startConnection];
+            return;
+        }
+    }
+
+    if (self.resumesDownload && [self.responseDataFilePath length] && ![self isCancelled] && ![self prepareOutputStreamForResponse:urlResponse]) {
+        [connection cancel];
+        [self connection:connection didFailWithError:[[NSError alloc] initWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil]];
+        return;
+    }
+
     [super connection:connection didReceiveResponse:urlResponse];
 
+    [self reportProgressToQueue];
+
     if ([self isCancelled])
         return;
 
-    [self performDelegateMethod:@selector(httpOperationDidReceiveResponse:)];
+    self.responseDate = [[NSDate alloc] init];
+
+    [self performEvent:JXHTTPOperationEventDidReceiveResponse];
+
+    // the 304 has no body of its own, so deliver the cached one as if it had been downloaded
+    if (cachedData)
+        [self connection:connection didReceiveData:cachedData];
 }
 
 - (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data
 {
     [super connection:connection didReceiveData:data];
 
+    [self reportProgressToQueue];
+
     if ([self isCancelled])
         return;
 
+    if (!self.firstByteDate)
+        self.firstByteDate = [[NSDate alloc] init];
+
+    // decoded bytes can outnumber an encoded response's expected length
     long long bytesExpected = [self.response expectedContentLength];
     if (bytesExpected > 0LL && bytesExpected != NSURLResponseUnknownLength)
-        self.downloadProgress = @(self.bytesDownloaded / (float)bytesExpected);
+        self.downloadProgress = @(MIN((self.resumedLength + self.bytesDownloaded) / (float)(self.resumedLength + bytesExpected), 1.0f));
 
-    [self performDelegateMethod:@selector(httpOperationDidReceiveData:)];
+    [self performEvent:JXHTTPOperationEventDidReceiveData];
 }
 
 - (void)connectionDidFinishLoading:(NSURLConnection *)connection
 {
+    // super finishes the operation, so the date has to be set before the completion block can read it
+    if (![self isCancelled])
+        self.finishDate = [[NSDate alloc] init];
+
     [super connectionDidFinishLoading:connection];
     
     if ([self isCancelled])
         return;
 
+    if (self.activeResponseCacheKey && !self.didUseCachedResponse && self.responseBuffer && [self.response isKindOfClass:[NSHTTPURLResponse class]])
+        [self.responseCache storeResponse:(NSHTTPURLResponse *)self.response data:[self.responseBuffer data] forKey:self.activeResponseCacheKey];
+
+    if (self.resumesDownload && [self.responseDataFilePath length])
+        [[NSFileManager defaultManager] removeItemAtPath:[self resumeFilePath] error:nil];
+
     if ([self.downloadProgress floatValue] != 1.0f)
         self.downloadProgress = @1.0f;
 
     if ([self.uploadProgress floatValue] != 1.0f)
         self.uploadProgress = @1.0f;
 
-    self.finishDate = [[NSDate alloc] init];
-
-    [self performDelegateMethod:@selector(httpOperationDidFinishLoading:)];
+    [self performEvent:JXHTTPOperationEventDidFinishLoading];
 }
 
 - (void)connection:(NSURLConnection *)connection didSendBodyData:(NSInteger)bytes totalBytesWritten:(NSInteger)bytesSent totalBytesExpectedToWrite:(NSInteger)bytesExpected
 {
     [super connection:connection didSendBodyData:bytes totalBytesWritten:bytesSent totalBytesExpectedToWrite:bytesExpected];
 
+    [self reportProgressToQueue];
+
     if ([self isCancelled])
         return;
 
     if (bytesExpected > 0LL && bytesExpected != NSURLResponseUnknownLength)
         self.uploadProgress = @(bytesSent / (float)bytesExpected);
 
-    [self performDelegateMethod:@selector(httpOperationDidSendData:)];
+    [self performEvent:JXHTTPOperationEventDidSendData];
 }
 
 - (NSInputStream *)connection:(NSURLConnection *)connection needNewBodyStream:(NSURLRequest *)request
@@ -398,7 +832,7 @@ static NSTimeInterval JXHTTPActivityTimerInterval = 0.25;
     if ([self isCancelled])
         return nil;
 
-    [self performDelegateMethod:@selector(httpOperationWillNeedNewBodyStream:)];
+    [self performEvent:JXHTTPOperationEventWillNeedNewBodyStream];
 
     return [self.requestBody httpInputStream];
 }
@@ -60,14 +60,16 @@
 - (void)httpOperationDidReceiveResponse:(JXHTTPOperation *)operation;
 
 /**
- Called periodically as the connection receives data.
+ Called periodically as the connection receives data, at most once per turn of the
+ connection's run loop.
 
  @param operation The operation.
  */
 - (void)httpOperationDidReceiveData:(JXHTTPOperation *)operation;
 
 /**
- Called periodically as the connection sends data.
+ Called periodically as the connection sends data, at most once per turn of the
+ connection's run loop.
 
  @param operation The operation.
  */
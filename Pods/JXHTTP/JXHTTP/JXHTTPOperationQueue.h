@@ -7,7 +7,19 @@
  <JXHTTPOperation> receive no special treatment.
  
  Progress and byte count properties are reset every time a new operation is added when
- the queue is empty.
+ the queue is empty. Totals are kept with atomic counters that each operation's progress
+ is added to as it happens; the properties, blocks and delegate methods are updated at most
+ once per <progressInterval>, and once more before the queue finishes.
+
+ Operations without dependencies wait in the queue itself until there is room for them
+ under `maxConcurrentOperationCount`, and are started in order of their `priorityClass`,
+ first-in first-out within a class. One slot is always left for `Interactive` and
+ `UserInitiated` operations, so a long `Prefetch` or `BulkUpload` backlog can't hold up
+ a request the user is waiting on. Operations with a `connectionManager` also wait while
+ their host is at the manager's `maximumConnectionsPerHost`. Waiting operations are counted by
+ <waitingOperationCount> rather than `operationCount`, and don't appear in `operations`. They
+ still keep the queue from finishing: it starts and finishes, and resets its progress,
+ only when it goes from or to having no operations running or waiting.
  
  ## Example ##
  
@@ -31,6 +43,8 @@
 
 #import "JXHTTPOperationQueueDelegate.h"
 
+@class JXHTTPOperation;
+
 typedef void (^JXHTTPQueueBlock)(JXHTTPOperationQueue *queue);
 
 @interface JXHTTPOperationQueue : NSOperationQueue
@@ -51,6 +65,49 @@ typedef void (^JXHTTPQueueBlock)(JXHTTPOperationQueue *queue);
  */
 @property (strong, readonly) NSString *uniqueString;
 
+/// @name Scheduling
+
+/**
+ The number of operations waiting for a free slot.
+
+ Safe to access from any thread at any time.
+ */
+@property (readonly) NSUInteger waitingOperationCount;
+
+/**
+ Whether `maxConcurrentOperationCount` is tuned to the network the queue is running on.
+
+ While operations are waiting, the queue compares throughput and mean request latency once
+ per <concurrencyAdjustmentInterval>. It probes with one more slot, keeps it only if
+ throughput improves by at least 10% without latency growing by more than half, and gives
+ slots back when throughput holds up without them. The limit stays between
+ <minimumAdaptiveOperationCount> and <maximumAdaptiveOperationCount>. Defaults to `NO`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) BOOL adjustsConcurrencyAutomatically;
+
+/**
+ The lowest limit automatic adjustment will choose. Defaults to `2`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) NSInteger minimumAdaptiveOperationCount;
+
+/**
+ The highest limit automatic adjustment will choose. Defaults to `8`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) NSInteger maximumAdaptiveOperationCount;
+
+/**
+ The minimum number of seconds between automatic adjustments. Defaults to `2.0`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) NSTimeInterval concurrencyAdjustmentInterval;
+
 /// @name Progress
 
 /**
@@ -95,6 +152,14 @@ typedef void (^JXHTTPQueueBlock)(JXHTTPOperationQueue *queue);
  */
 @property (strong, readonly) NSNumber *expectedUploadBytes;
 
+/**
+ The minimum number of seconds between progress updates. Changes that happen in between
+ are coalesced into the next update. Defaults to `0.1`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) NSTimeInterval progressInterval;
+
 /// @name Timing
 
 /**
@@ -119,6 +184,72 @@ typedef void (^JXHTTPQueueBlock)(JXHTTPOperationQueue *queue);
  */
 @property (readonly) NSTimeInterval elapsedSeconds;
 
+/// @name Metrics
+
+/**
+ Whether the timing and byte counts of each <JXHTTPOperation> added to the queue are
+ recorded, once its final callback has been delivered, into the <JXHTTPEndpointMetrics>
+ for its `metricsKey`. Up to 256 keys are kept; operations with any further key are recorded
+ under `*`. Defaults to `YES`.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) BOOL recordsMetrics;
+
+/**
+ A copy of the metrics recorded since the queue was created or <resetMetrics> was last
+ called, for exporting or for watching tail latency while the app runs.
+
+ @returns A dictionary of <JXHTTPEndpointMetrics> keyed by `metricsKey`.
+ */
+- (NSDictionary *)metricsSnapshot;
+
+/**
+ Discards the metrics recorded so far.
+ */
+- (void)resetMetrics;
+
+/**
+ Records a finished operation's timing and byte counts, unless it was cancelled or
+ <recordsMetrics> is `NO`. Called by <JXHTTPOperation> once its final callback has been
+ delivered.
+
+ @param operation The operation.
+ */
+- (void)recordMetricsForOperation:(JXHTTPOperation *)operation;
+
+/// @name Operation Reporting
+
+/**
+ Adds to the queue's download progress. Called by <JXHTTPOperation> as it receives its
+ response and data, in place of observing each operation.
+
+ The queue keeps what each operation has reported until it leaves the queue. If it was
+ cancelled, all of it is then taken back out of the totals, and anything it reports later
+ is ignored.
+
+ @param operation The operation.
+ @param bytes The number of bytes downloaded since the operation last reported.
+ @param expected The change in the number of bytes the operation expects to download.
+ */
+- (void)operation:(JXHTTPOperation *)operation didDownloadBytes:(long long)bytes expectedBytes:(long long)expected;
+
+/**
+ Adds to the queue's upload progress. Called by <JXHTTPOperation> as it sends its body.
+
+ @param operation The operation.
+ @param bytes The number of bytes uploaded since the operation last reported.
+ */
+- (void)operation:(JXHTTPOperation *)operation didUploadBytes:(long long)bytes;
+
+/**
+ Frees the operation's slot and admits the next waiting operation. Called by
+ <JXHTTPOperation> just before it finishes, including when it's cancelled while waiting.
+
+ @param operation The operation.
+ */
+- (void)operationWillFinish:(JXHTTPOperation *)operation;
+
 /// @name Blocks
 
 @property (assign) BOOL performsBlocksOnMainQueue;
@@ -1,14 +1,42 @@
 #import "JXHTTPOperationQueue.h"
 #import "JXHTTPOperation.h"
+#import "JXHTTPEndpointMetrics.h"
+#import <libkern/OSAtomic.h>
+#import <pthread.h>
 
 static void * JXHTTPOperationQueueContext = &JXHTTPOperationQueueContext;
 static NSInteger JXHTTPOperationQueueDefaultMaxOps = 4;
+static NSTimeInterval JXHTTPOperationQueueDefaultProgressInterval = 0.1;
+static NSInteger JXHTTPOperationQueueDefaultMinAdaptiveOps = 2;
+static NSInteger JXHTTPOperationQueueDefaultMaxAdaptiveOps = 8;
+static NSTimeInterval JXHTTPOperationQueueDefaultAdjustmentInterval = 2.0;
+static NSInteger JXHTTPOperationQueueReservedOps = 1;
+static NSUInteger JXHTTPOperationQueuePriorityClassCount = JXHTTPOperationPriorityClassBulkUpload + 1;
+static NSUInteger JXHTTPOperationQueueMaxMetricsKeys = 256;
+static NSString * const JXHTTPOperationQueueOverflowMetricsKey = @"*";
+
+typedef NS_OPTIONS(uint32_t, JXHTTPOperationQueueProgress) {
+    JXHTTPOperationQueueProgressDownload = 1 << 0,
+    JXHTTPOperationQueueProgressUpload = 1 << 1
+};
+
+#pragma mark - JXHTTPOperationQueueTransfer
+
+// what one operation has added to the queue's progress totals, so exactly that can be taken back out
+@interface JXHTTPOperationQueueTransfer : NSObject
+@property (assign) int64_t reportedDownloaded;
+@property (assign) int64_t reportedExpectedDownload;
+@property (assign) int64_t reportedUploaded;
+@property (assign) int64_t reportedExpectedUpload;
+@end
+
+@implementation JXHTTPOperationQueueTransfer
+@end
+
+#pragma mark - JXHTTPOperationQueue
 
 @interface JXHTTPOperationQueue ()
-@property (strong) NSMutableDictionary *bytesDownloadedPerOperation;
-@property (strong) NSMutableDictionary *bytesUploadedPerOperation;
-@property (strong) NSMutableDictionary *expectedDownloadBytesPerOperation;
-@property (strong) NSMutableDictionary *expectedUploadBytesPerOperation;
+@property (assign) CFAbsoluteTime lastProgressTime;
 @property (strong) NSDate *startDate;
 @property (strong) NSDate *finishDate;
 @property (strong) NSString *uniqueString;
@@ -18,47 +46,104 @@ static NSInteger JXHTTPOperationQueueDefaultMaxOps = 4;
 @property (strong) NSNumber *bytesUploaded;
 @property (strong) NSNumber *expectedDownloadBytes;
 @property (strong) NSNumber *expectedUploadBytes;
-@property (strong) NSMutableSet *observedOperationSet;
+@property (strong) NSArray *waitingOperationArrays;
+@property (strong) NSMutableSet *admittedOperationSet;
+@property (assign) BOOL hasOperations;
+@property (assign) CFAbsoluteTime lastAdjustmentTime;
+@property (assign) int64_t lastAdjustmentByteCount;
+@property (assign) double lastThroughput;
+@property (assign) NSTimeInterval lastLatency;
+@property (assign) NSInteger adjustmentStep;
+@property (assign) NSTimeInterval latencySum;
+@property (assign) NSUInteger latencyCount;
+@property (strong) NSMutableDictionary *metricsDictionary;
+@property (strong) NSMapTable *transferMapTable;
 #if OS_OBJECT_USE_OBJC
-@property (strong) dispatch_queue_t observationQueue;
 @property (strong) dispatch_queue_t progressQueue;
+@property (strong) dispatch_queue_t schedulingQueue;
 @property (strong) dispatch_queue_t blockQueue;
+@property (strong) dispatch_queue_t recordingQueue;
+@property (strong) dispatch_group_t waitingGroup;
 #else
-@property (assign) dispatch_queue_t observationQueue;
 @property (assign) dispatch_queue_t progressQueue;
+@property (assign) dispatch_queue_t schedulingQueue;
 @property (assign) dispatch_queue_t blockQueue;
+@property (assign) dispatch_queue_t recordingQueue;
+@property (assign) dispatch_group_t waitingGroup;
 #endif
 @end
 
 @implementation JXHTTPOperationQueue
+{
+    volatile int64_t _downloadedByteCount;
+    volatile int64_t _uploadedByteCount;
+    volatile int64_t _expectedDownloadByteCount;
+    volatile int64_t _expectedUploadByteCount;
+    volatile int64_t _transferredByteCount;
+    volatile uint32_t _pendingProgress;
+    pthread_mutex_t _transferMutex;
+}
 
 #pragma mark - Initialization
 
 - (void)dealloc
 {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
     [self removeObserver:self forKeyPath:@"operations" context:JXHTTPOperationQueueContext];
 
+    pthread_mutex_destroy(&_transferMutex);
+
     #if !OS_OBJECT_USE_OBJC
-    dispatch_release(_observationQueue);
     dispatch_release(_progressQueue);
+    dispatch_release(_schedulingQueue);
     dispatch_release(_blockQueue);
-    _observationQueue = NULL;
+    dispatch_release(_recordingQueue);
+    dispatch_release(_waitingGroup);
     _progressQueue = NULL;
+    _schedulingQueue = NULL;
     _blockQueue = NULL;
+    _recordingQueue = NULL;
+    _waitingGroup = NULL;
     #endif
 }
 
 - (instancetype)init
 {
     if (self = [super init]) {
-        self.maxConcurrentOperationCount = JXHTTPOperationQueueDefaultMaxOps;
+        pthread_mutex_init(&_transferMutex, NULL);
+
+        [super setMaxConcurrentOperationCount:JXHTTPOperationQueueDefaultMaxOps];
         self.uniqueString = [[NSProcessInfo processInfo] globallyUniqueString];
-        self.observedOperationSet = [[NSMutableSet alloc] init];
+        self.progressInterval = JXHTTPOperationQueueDefaultProgressInterval;
+        self.lastProgressTime = 0.0;
+        self.adjustsConcurrencyAutomatically = NO;
+        self.minimumAdaptiveOperationCount = JXHTTPOperationQueueDefaultMinAdaptiveOps;
+        self.maximumAdaptiveOperationCount = JXHTTPOperationQueueDefaultMaxAdaptiveOps;
+        self.concurrencyAdjustmentInterval = JXHTTPOperationQueueDefaultAdjustmentInterval;
+        self.admittedOperationSet = [[NSMutableSet alloc] init];
+        self.hasOperations = NO;
+        self.lastAdjustmentTime = CFAbsoluteTimeGetCurrent();
+        self.lastAdjustmentByteCount = 0LL;
+        self.lastThroughput = 0.0;
+        self.lastLatency = 0.0;
+        self.adjustmentStep = 0;
+        self.latencySum = 0.0;
+        self.latencyCount = 0;
+        self.recordsMetrics = YES;
+        self.metricsDictionary = [[NSMutableDictionary alloc] init];
+        self.transferMapTable = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                          valueOptions:NSPointerFunctionsStrongMemory
+                                                              capacity:0];
         self.performsBlocksOnMainQueue = NO;
         self.delegate = nil;
         self.startDate = nil;
         self.finishDate = nil;
 
+        NSMutableArray *waitingOperationArrays = [[NSMutableArray alloc] initWithCapacity:JXHTTPOperationQueuePriorityClassCount];
+        for (NSUInteger i = 0; i < JXHTTPOperationQueuePriorityClassCount; i++)
+            [waitingOperationArrays addObject:[[NSMutableArray alloc] init]];
+        self.waitingOperationArrays = waitingOperationArrays;
+
         self.willStartBlock = nil;
         self.willFinishBlock = nil;
         self.didStartBlock = nil;
@@ -68,14 +153,21 @@ static NSInteger JXHTTPOperationQueueDefaultMaxOps = 4;
         self.didFinishBlock = nil;
 
         NSString *prefix = [[NSString alloc] initWithFormat:@"%@.%p.", NSStringFromClass([self class]), self];
-        self.observationQueue = dispatch_queue_create([[prefix stringByAppendingString:@"observation"] UTF8String], DISPATCH_QUEUE_SERIAL);
-        self.progressQueue = dispatch_queue_create([[prefix stringByAppendingString:@"progress"] UTF8String], DISPATCH_QUEUE_CONCURRENT);
+        self.progressQueue = dispatch_queue_create([[prefix stringByAppendingString:@"progress"] UTF8String], DISPATCH_QUEUE_SERIAL);
+        self.schedulingQueue = dispatch_queue_create([[prefix stringByAppendingString:@"scheduling"] UTF8String], DISPATCH_QUEUE_SERIAL);
         self.blockQueue = dispatch_queue_create([[prefix stringByAppendingString:@"blocks"] UTF8String], DISPATCH_QUEUE_SERIAL);
+        self.recordingQueue = dispatch_queue_create([[prefix stringByAppendingString:@"recording"] UTF8String], DISPATCH_QUEUE_SERIAL);
+        self.waitingGroup = dispatch_group_create();
 
         [self addObserver:self
                forKeyPath:@"operations"
                   options:NSKeyValueObservingOptionNew | NSKeyValueObservingOptionOld
                   context:JXHTTPOperationQueueContext];
+
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(connectionManagerDidReleaseConnection:)
+                                                     name:JXHTTPConnectionManagerDidReleaseConnectionNotification
+                                                   object:nil];
     }
     return self;
 }
@@ -104,6 +196,202 @@ static NSInteger JXHTTPOperationQueueDefaultMaxOps = 4;
     }
 }
 
+- (NSUInteger)waitingOperationCount
+{
+    __block NSUInteger count = 0;
+
+    dispatch_sync(self.schedulingQueue, ^{
+        count = [self countOfWaitingOperations];
+    });
+
+    return count;
+}
+
+#pragma mark - NSOperationQueue
+
+- (void)addOperation:(NSOperation *)operation
+{
+    if ([operation isKindOfClass:[JXHTTPOperation class]]) {
+        JXHTTPOperation *httpOperation = (JXHTTPOperation *)operation;
+
+        if (!httpOperation.enqueueDate)
+            httpOperation.enqueueDate = [[NSDate alloc] init];
+
+        httpOperation.operationQueue = self;
+
+        // tracked from here rather than once it's inserted, since it may report before the insertion is observed
+        if (![httpOperation isFinished])
+            [self beginTransferForOperation:httpOperation];
+    }
+
+    // operations with dependencies are left to NSOperationQueue, holding them here could starve what they depend on
+    if (![operation isKindOfClass:[JXHTTPOperation class]] || [[operation dependencies] count] || [operation isFinished]) {
+        [super addOperation:operation];
+        return;
+    }
+
+    dispatch_sync(self.schedulingQueue, ^{
+        NSUInteger priorityClass = MIN((NSUInteger)MAX([(JXHTTPOperation *)operation priorityClass], 0), JXHTTPOperationQueuePriorityClassCount - 1);
+        [[self.waitingOperationArrays objectAtIndex:priorityClass] addObject:operation];
+
+        // left once the operation is handed over, so waiting on the group waits for the backlog to drain
+        dispatch_group_enter(self.waitingGroup);
+    });
+
+    [self admitWaitingOperations];
+}
+
+- (void)addOperations:(NSArray *)operations waitUntilFinished:(BOOL)wait
+{
+    for (NSOperation *operation in operations)
+        [self addOperation:operation];
+
+    if (!wait)
+        return;
+
+    for (NSOperation *operation in operations)
+        [operation waitUntilFinished];
+}
+
+- (void)setMaxConcurrentOperationCount:(NSInteger)count
+{
+    [super setMaxConcurrentOperationCount:count];
+
+    [self admitWaitingOperations];
+}
+
+- (void)setSuspended:(BOOL)suspended
+{
+    [super setSuspended:suspended];
+
+    if (!suspended)
+        [self admitWaitingOperations];
+}
+
+- (void)cancelAllOperations
+{
+    __block NSArray *waitingOperations = nil;
+
+    dispatch_sync(self.schedulingQueue, ^{
+        waitingOperations = [self.waitingOperationArrays valueForKeyPath:@"@unionOfArrays.self"];
+    });
+
+    for (NSOperation *operation in waitingOperations)
+        [operation cancel];
+
+    [super cancelAllOperations];
+
+    [self admitWaitingOperations];
+}
+
+- (void)waitUntilAllOperationsAreFinished
+{
+    // waiting operations are admitted before the last running one leaves, so each pass blocks rather than polls
+    do {
+        dispatch_group_wait(self.waitingGroup, DISPATCH_TIME_FOREVER);
+        [super waitUntilAllOperationsAreFinished];
+    } while (self.waitingOperationCount);
+}
+
+#pragma mark - Metrics
+
+- (NSDictionary *)metricsSnapshot
+{
+    __block NSDictionary *snapshot = nil;
+
+    dispatch_sync(self.recordingQueue, ^{
+        // deep copies, so the snapshot doesn't change as later operations are recorded
+        snapshot = [[NSDictionary alloc] initWithDictionary:self.metricsDictionary copyItems:YES];
+    });
+
+    return snapshot;
+}
+
+- (void)resetMetrics
+{
+    dispatch_async(self.recordingQueue, ^{
+        [self.metricsDictionary removeAllObjects];
+    });
+}
+
+- (void)recordMetricsForOperation:(JXHTTPOperation *)operation
+{
+    if (!self.recordsMetrics || [operation isCancelled])
+        return;
+
+    NSString *key = operation.metricsKey;
+
+    if (!key) {
+        NSURL *url = [operation.request URL];
+        NSString *method = [[operation.request HTTPMethod] length] ? [[operation.request HTTPMethod] uppercaseString] : @"GET";
+        key = [[NSString alloc] initWithFormat:@"%@ %@%@", method, [url host] ?: @"", [url path] ?: @""];
+    }
+
+    dispatch_async(self.recordingQueue, ^{
+        JXHTTPEndpointMetrics *metrics = [self.metricsDictionary objectForKey:key];
+
+        if (!metrics && [self.metricsDictionary count] >= JXHTTPOperationQueueMaxMetricsKeys) {
+            metrics = [self.metricsDictionary objectForKey:JXHTTPOperationQueueOverflowMetricsKey];
+
+            if (!metrics) {
+                metrics = [[JXHTTPEndpointMetrics alloc] initWithKey:JXHTTPOperationQueueOverflowMetricsKey];
+                [self.metricsDictionary setObject:metrics forKey:JXHTTPOperationQueueOverflowMetricsKey];
+            }
+        } else if (!metrics) {
+            metrics = [[JXHTTPEndpointMetrics alloc] initWithKey:key];
+            [self.metricsDictionary setObject:metrics forKey:key];
+        }
+
+        [metrics recordOperation:operation];
+    });
+}
+
+#pragma mark - Operation Reporting
+
+- (void)operation:(JXHTTPOperation *)operation didDownloadBytes:(long long)bytes expectedBytes:(long long)expected
+{
+    pthread_mutex_lock(&_transferMutex);
+
+    // reports that arrive after the operation has left the queue are dropped
+    JXHTTPOperationQueueTransfer *transfer = [self.transferMapTable objectForKey:operation];
+    if (transfer) {
+        transfer.reportedDownloaded += bytes;
+        transfer.reportedExpectedDownload += expected;
+        [self addDownloadedBytes:bytes expectedBytes:expected];
+    }
+
+    pthread_mutex_unlock(&_transferMutex);
+}
+
+- (void)operation:(JXHTTPOperation *)operation didUploadBytes:(long long)bytes
+{
+    pthread_mutex_lock(&_transferMutex);
+
+    JXHTTPOperationQueueTransfer *transfer = [self.transferMapTable objectForKey:operation];
+    if (transfer) {
+        transfer.reportedUploaded += bytes;
+        [self addUploadedBytes:bytes expectedBytes:0LL];
+    }
+
+    pthread_mutex_unlock(&_transferMutex);
+}
+
+- (void)operationWillFinish:(JXHTTPOperation *)operation
+{
+    // admitting the next operation before this one leaves keeps the queue from looking empty in between
+    [self operationDidFinish:operation];
+
+    if (![operation isCancelled])
+        return;
+
+    __weak __typeof(self) weakSelf = self;
+
+    // let the cancellation finish a waiting operation before handing it over
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [weakSelf admitWaitingOperations];
+    });
+}
+
 #pragma mark - Private Methods
 
 - (void)performDelegateMethod:(SEL)selector
@@ -140,6 +428,310 @@ static NSInteger JXHTTPOperationQueueDefaultMaxOps = 4;
     return nil;
 }
 
+#pragma mark - Scheduling
+
+// must be called on the scheduling queue
+- (NSUInteger)countOfWaitingOperations
+{
+    NSUInteger count = 0;
+
+    for (NSArray *waitingArray in self.waitingOperationArrays)
+        count += [waitingArray count];
+
+    return count;
+}
+
+- (void)admitWaitingOperations
+{
+    NSMutableArray *admittedArray = [[NSMutableArray alloc] init];
+
+    dispatch_sync(self.schedulingQueue, ^{
+        // cancelled operations are handed over right away so they finish and leave the queue
+        for (NSMutableArray *waitingArray in self.waitingOperationArrays) {
+            NSIndexSet *cancelledIndexes = [waitingArray indexesOfObjectsPassingTest:^BOOL(NSOperation *operation, NSUInteger index, BOOL *stop) {
+                return [operation isCancelled];
+            }];
+
+            [admittedArray addObjectsFromArray:[waitingArray objectsAtIndexes:cancelledIndexes]];
+            [waitingArray removeObjectsAtIndexes:cancelledIndexes];
+        }
+
+        for (NSUInteger i = 0; i < [admittedArray count]; i++)
+            dispatch_group_leave(self.waitingGroup);
+
+        if ([self isSuspended])
+            return;
+
+        NSInteger limit = [self maxConcurrentOperationCount];
+        BOOL unlimited = limit == NSOperationQueueDefaultMaxConcurrentOperationCount;
+
+        for (NSUInteger priorityClass = 0; priorityClass < JXHTTPOperationQueuePriorityClassCount; priorityClass++) {
+            NSMutableArray *waitingArray = [self.waitingOperationArrays objectAtIndex:priorityClass];
+
+            NSInteger slots = limit;
+            if (priorityClass >= JXHTTPOperationPriorityClassPrefetch && limit > JXHTTPOperationQueueReservedOps)
+                slots = limit - JXHTTPOperationQueueReservedOps;
+
+            NSMutableIndexSet *admittedIndexes = [[NSMutableIndexSet alloc] init];
+
+            for (NSUInteger i = 0; i < [waitingArray count]; i++) {
+                if (!unlimited && (NSInteger)[self.admittedOperationSet count] >= slots)
+                    break;
+
+                // an operation whose host is busy lets the ones behind it go first
+                JXHTTPOperation *operation = [waitingArray objectAtIndex:i];
+                if (operation.connectionManager && ![operation.connectionManager reserveConnectionForOperation:operation])
+                    continue;
+
+                [self.admittedOperationSet addObject:operation];
+                [admittedArray addObject:operation];
+                [admittedIndexes addIndex:i];
+
+                dispatch_group_leave(self.waitingGroup);
+            }
+
+            [waitingArray removeObjectsAtIndexes:admittedIndexes];
+        }
+    });
+
+    for (NSOperation *operation in admittedArray)
+        [super addOperation:operation];
+}
+
+- (void)operationDidFinish:(JXHTTPOperation *)operation
+{
+    __block BOOL released = NO;
+
+    dispatch_sync(self.schedulingQueue, ^{
+        if (![self.admittedOperationSet containsObject:operation])
+            return;
+
+        [self.admittedOperationSet removeObject:operation];
+        released = YES;
+
+        if (operation.startDate && ![operation isCancelled]) {
+            self.latencySum += operation.elapsedSeconds;
+            self.latencyCount++;
+        }
+
+        if (self.adjustsConcurrencyAutomatically)
+            [self adjustConcurrency];
+    });
+
+    if (released)
+        [self admitWaitingOperations];
+}
+
+// must be called on the scheduling queue
+- (void)adjustConcurrency
+{
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    NSTimeInterval interval = now - self.lastAdjustmentTime;
+
+    if (interval < self.concurrencyAdjustmentInterval)
+        return;
+
+    int64_t byteCount = OSAtomicAdd64Barrier(0LL, &_transferredByteCount);
+    double throughput = (byteCount - self.lastAdjustmentByteCount) / interval;
+    NSTimeInterval latency = self.latencyCount ? self.latencySum / self.latencyCount : 0.0;
+
+    self.lastAdjustmentTime = now;
+    self.lastAdjustmentByteCount = byteCount;
+    self.latencySum = 0.0;
+    self.latencyCount = 0;
+
+    // a period without a backlog says nothing about whether more slots would help
+    if (![self countOfWaitingOperations]) {
+        self.lastThroughput = 0.0;
+        self.lastLatency = 0.0;
+        self.adjustmentStep = 0;
+        return;
+    }
+
+    NSInteger limit = [self maxConcurrentOperationCount];
+    if (limit == NSOperationQueueDefaultMaxConcurrentOperationCount)
+        limit = self.maximumAdaptiveOperationCount;
+
+    BOOL faster = throughput >= self.lastThroughput * 1.1;
+    BOOL slower = throughput < self.lastThroughput * 0.9;
+    BOOL laggier = self.lastLatency > 0.0 && latency > self.lastLatency * 1.5;
+
+    NSInteger step = 0;
+
+    if (self.lastThroughput <= 0.0) {
+        step = 1;
+    } else if (self.adjustmentStep > 0) {
+        // keep the extra slot only if it paid for itself
+        step = faster && !laggier ? 1 : -1;
+    } else if (self.adjustmentStep < 0) {
+        // keep giving slots back while throughput holds up without them
+        step = slower ? 1 : -1;
+    } else {
+        step = laggier && !faster ? -1 : 1;
+    }
+
+    NSInteger newLimit = MIN(MAX(limit + step, self.minimumAdaptiveOperationCount), self.maximumAdaptiveOperationCount);
+
+    self.adjustmentStep = newLimit - limit;
+    self.lastThroughput = throughput;
+    self.lastLatency = latency;
+
+    if (newLimit != [self maxConcurrentOperationCount])
+        [super setMaxConcurrentOperationCount:newLimit];
+}
+
+- (void)connectionManagerDidReleaseConnection:(NSNotification *)notification
+{
+    [self admitWaitingOperations];
+}
+
+#pragma mark - Progress
+
+- (void)beginTransferForOperation:(JXHTTPOperation *)operation
+{
+    pthread_mutex_lock(&_transferMutex);
+
+    if (![self.transferMapTable objectForKey:operation]) {
+        JXHTTPOperationQueueTransfer *transfer = [[JXHTTPOperationQueueTransfer alloc] init];
+        [self.transferMapTable setObject:transfer forKey:operation];
+
+        long long expectedUp = operation.requestBody.httpContentLength;
+        if (expectedUp > 0LL) {
+            transfer.reportedExpectedUpload = expectedUp;
+            [self addUploadedBytes:0LL expectedBytes:expectedUp];
+        }
+    }
+
+    pthread_mutex_unlock(&_transferMutex);
+}
+
+- (void)endTransferForOperation:(JXHTTPOperation *)operation
+{
+    pthread_mutex_lock(&_transferMutex);
+
+    JXHTTPOperationQueueTransfer *transfer = [self.transferMapTable objectForKey:operation];
+    [self.transferMapTable removeObjectForKey:operation];
+
+    // a cancelled operation takes back everything it reported, not just what it had transferred by now
+    if (transfer && [operation isCancelled]) {
+        [self addDownloadedBytes:-transfer.reportedDownloaded expectedBytes:-transfer.reportedExpectedDownload];
+        [self addUploadedBytes:-transfer.reportedUploaded expectedBytes:-transfer.reportedExpectedUpload];
+    }
+
+    pthread_mutex_unlock(&_transferMutex);
+}
+
+- (void)resetProgress
+{
+    pthread_mutex_lock(&_transferMutex);
+
+    OSAtomicAnd32Barrier(0, &_pendingProgress);
+
+    // operations that have already been added keep what they've reported so far
+    int64_t downloaded = 0LL;
+    int64_t uploaded = 0LL;
+    int64_t expectedDownload = 0LL;
+    int64_t expectedUpload = 0LL;
+
+    for (JXHTTPOperationQueueTransfer *transfer in [self.transferMapTable objectEnumerator]) {
+        downloaded += transfer.reportedDownloaded;
+        uploaded += transfer.reportedUploaded;
+        expectedDownload += transfer.reportedExpectedDownload;
+        expectedUpload += transfer.reportedExpectedUpload;
+    }
+
+    _downloadedByteCount = downloaded;
+    _uploadedByteCount = uploaded;
+    _expectedDownloadByteCount = expectedDownload;
+    _expectedUploadByteCount = expectedUpload;
+
+    OSMemoryBarrier();
+
+    pthread_mutex_unlock(&_transferMutex);
+}
+
+- (void)addDownloadedBytes:(int64_t)downloaded expectedBytes:(int64_t)expected
+{
+    if (downloaded)
+        OSAtomicAdd64Barrier(downloaded, &_downloadedByteCount);
+    if (downloaded > 0LL)
+        OSAtomicAdd64Barrier(downloaded, &_transferredByteCount);
+    if (expected)
+        OSAtomicAdd64Barrier(expected, &_expectedDownloadByteCount);
+
+    [self setNeedsProgress:JXHTTPOperationQueueProgressDownload];
+}
+
+- (void)addUploadedBytes:(int64_t)uploaded expectedBytes:(int64_t)expected
+{
+    if (uploaded)
+        OSAtomicAdd64Barrier(uploaded, &_uploadedByteCount);
+    if (uploaded > 0LL)
+        OSAtomicAdd64Barrier(uploaded, &_transferredByteCount);
+    if (expected)
+        OSAtomicAdd64Barrier(expected, &_expectedUploadByteCount);
+
+    [self setNeedsProgress:JXHTTPOperationQueueProgressUpload];
+}
+
+- (void)setNeedsProgress:(JXHTTPOperationQueueProgress)progress
+{
+    // only the first change since the last publish schedules one, later changes ride along with it
+    if (OSAtomicOr32OrigBarrier(progress, &_pendingProgress))
+        return;
+
+    __weak __typeof(self) weakSelf = self;
+
+    dispatch_async(self.progressQueue, ^{
+        __typeof(self) strongSelf = weakSelf;
+        if (!strongSelf)
+            return;
+
+        NSTimeInterval delay = strongSelf.lastProgressTime + strongSelf.progressInterval - CFAbsoluteTimeGetCurrent();
+
+        if (delay <= 0.0) {
+            [strongSelf publishProgress];
+            return;
+        }
+
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), strongSelf.progressQueue, ^{
+            [weakSelf publishProgress];
+        });
+    });
+}
+
+// must be called on the progress queue
+- (void)publishProgress
+{
+    JXHTTPOperationQueueProgress progress = OSAtomicAnd32OrigBarrier(0, &_pendingProgress);
+    if (!progress)
+        return;
+
+    self.lastProgressTime = CFAbsoluteTimeGetCurrent();
+
+    if (progress & JXHTTPOperationQueueProgressDownload) {
+        int64_t downloaded = OSAtomicAdd64Barrier(0LL, &_downloadedByteCount);
+        int64_t expected = OSAtomicAdd64Barrier(0LL, &_expectedDownloadByteCount);
+
+        self.bytesDownloaded = @(downloaded);
+        self.expectedDownloadBytes = @(expected);
+        self.downloadProgress = expected ? @(MIN(downloaded / (float)expected, 1.0f)) : @0.0f;
+        [self performDelegateMethod:@selector(httpOperationQueueDidDownload:)];
+    }
+
+    if (progress & JXHTTPOperationQueueProgressUpload) {
+        int64_t uploaded = OSAtomicAdd64Barrier(0LL, &_uploadedByteCount);
+        int64_t expected = OSAtomicAdd64Barrier(0LL, &_expectedUploadByteCount);
+
+        self.bytesUploaded = @(uploaded);
+        self.expectedUploadBytes = @(expected);
+        self.uploadProgress = expected ? @(uploaded / (float)expected) : @0.0f;
+        [self performDelegateMethod:@selector(httpOperationQueueDidUpload:)];
+    }
+
+    [self performDelegateMethod:@selector(httpOperationQueueDidMakeProgress:)];
+}
+
 #pragma mark - <NSKeyValueObserving>
 
 - (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
@@ -160,24 +752,27 @@ static NSInteger JXHTTPOperationQueueDefaultMaxOps = 4;
         NSArray *newOperationsArray = [change objectForKey:NSKeyValueChangeNewKey];
         NSArray *oldOperationsArray = [change objectForKey:NSKeyValueChangeOldKey];
         
-        NSMutableArray *insertedArray = [[NSMutableArray alloc] initWithArray:newOperationsArray];
         NSMutableArray *removedArray = [[NSMutableArray alloc] initWithArray:oldOperationsArray];
-        
-        [insertedArray removeObjectsInArray:oldOperationsArray];
         [removedArray removeObjectsInArray:newOperationsArray];
 
         NSUInteger newCount = [newOperationsArray count];
-        NSUInteger oldCount = [oldOperationsArray count];
-        
-        BOOL starting = oldCount < 1 && newCount > 0;
-        BOOL finishing = oldCount > 0 && newCount < 1;
+
+        // the queue isn't done while operations are still waiting to be admitted, even with none running
+        __block BOOL starting = NO;
+        __block BOOL finishing = NO;
+
+        dispatch_sync(self.schedulingQueue, ^{
+            BOOL hasOperations = newCount > 0 || [self countOfWaitingOperations] > 0;
+
+            starting = hasOperations && !self.hasOperations;
+            finishing = !hasOperations && self.hasOperations;
+            self.hasOperations = hasOperations;
+        });
 
         if (starting) {
-            dispatch_barrier_async(self.progressQueue, ^{
-                weakSelf.bytesDownloadedPerOperation = [[NSMutableDictionary alloc] init];
-                weakSelf.bytesUploadedPerOperation = [[NSMutableDictionary alloc] init];
-                weakSelf.expectedDownloadBytesPerOperation = [[NSMutableDictionary alloc] init];
-                weakSelf.expectedUploadBytesPerOperation = [[NSMutableDictionary alloc] init];
+            [self resetProgress];
+
+            dispatch_async(self.progressQueue, ^{
                 weakSelf.downloadProgress = @0.0f;
                 weakSelf.uploadProgress = @0.0f;
                 weakSelf.bytesDownloaded = @0LL;
@@ -189,150 +784,32 @@ static NSInteger JXHTTPOperationQueueDefaultMaxOps = 4;
                 [weakSelf performDelegateMethod:@selector(httpOperationQueueWillStart:)];
             });
         } else if (finishing) {
-            dispatch_barrier_async(self.progressQueue, ^{
+            dispatch_async(self.progressQueue, ^{
                 [weakSelf performDelegateMethod:@selector(httpOperationQueueWillFinish:)];
             });
         }
 
-        for (JXHTTPOperation *operation in insertedArray) {
-            if (![operation isKindOfClass:[JXHTTPOperation class]])
-                continue;
-
-            NSNumber *expectedUp = @(operation.requestBody.httpContentLength);
-            NSString *uniqueString = [operation.uniqueString copy];
-
-            dispatch_barrier_async(self.progressQueue, ^{
-                [weakSelf.expectedUploadBytesPerOperation setObject:expectedUp forKey:uniqueString];
-            });
-            
-            dispatch_sync(self.observationQueue, ^{
-                if (![self.observedOperationSet containsObject:operation]) {
-                    [operation addObserver:self forKeyPath:@"bytesDownloaded" options:0 context:JXHTTPOperationQueueContext];
-                    [operation addObserver:self forKeyPath:@"bytesUploaded" options:0 context:JXHTTPOperationQueueContext];
-                    [operation addObserver:self forKeyPath:@"response" options:0 context:JXHTTPOperationQueueContext];
-
-                    [self.observedOperationSet addObject:operation];
-                }
-            });
-        }
-
         for (JXHTTPOperation *operation in removedArray) {
             if (![operation isKindOfClass:[JXHTTPOperation class]])
                 continue;
-            
-            dispatch_sync(self.observationQueue, ^{
-                if ([self.observedOperationSet containsObject:operation]) {
-                    [operation removeObserver:self forKeyPath:@"bytesDownloaded" context:JXHTTPOperationQueueContext];
-                    [operation removeObserver:self forKeyPath:@"bytesUploaded" context:JXHTTPOperationQueueContext];
-                    [operation removeObserver:self forKeyPath:@"response" context:JXHTTPOperationQueueContext];
-
-                    [self.observedOperationSet removeObject:operation];
-                }
-            });
 
-            if ([operation isCancelled]) {
-                NSString *uniqueString = [operation.uniqueString copy];
+            [self endTransferForOperation:operation];
 
-                dispatch_barrier_async(self.progressQueue, ^{
-                    [weakSelf.bytesDownloadedPerOperation removeObjectForKey:uniqueString];
-                    [weakSelf.bytesUploadedPerOperation removeObjectForKey:uniqueString];
-                });
-            }
+            // operations cancelled before they start finish without notifying observers
+            [self operationDidFinish:operation];
         }
 
         if (starting) {
-            dispatch_barrier_async(self.progressQueue, ^{
+            dispatch_async(self.progressQueue, ^{
                 [weakSelf performDelegateMethod:@selector(httpOperationQueueDidStart:)];
             });
         } else if (finishing) {
-            dispatch_barrier_async(self.progressQueue, ^{
+            dispatch_async(self.progressQueue, ^{
+                [weakSelf publishProgress];
                 weakSelf.finishDate = now;
                 [weakSelf performDelegateMethod:@selector(httpOperationQueueDidFinish:)];
             });
         }
-
-        return;
-    }
-
-    if ([keyPath isEqualToString:@"response"]) {
-        JXHTTPOperation *operation = object;
-        long long expectedDown = [operation.response expectedContentLength];
-        NSString *uniqueString = [operation.uniqueString copy];
-
-        if (expectedDown && expectedDown != NSURLResponseUnknownLength) {
-            dispatch_barrier_async(self.progressQueue, ^{
-                [weakSelf.expectedDownloadBytesPerOperation setObject:@(expectedDown) forKey:uniqueString];
-            });
-        }
-
-        return;
-    }
-
-    if ([keyPath isEqualToString:@"bytesDownloaded"]) {
-        JXHTTPOperation *operation = (JXHTTPOperation *)object;
-        long long bytesDownloaded = operation.bytesDownloaded;
-        NSString *uniqueString = [operation.uniqueString copy];
-
-        dispatch_barrier_async(self.progressQueue, ^{
-            [weakSelf.bytesDownloadedPerOperation setObject:@(bytesDownloaded) forKey:uniqueString];
-        });
-
-        dispatch_sync(self.progressQueue, ^{
-            long long bytesDownloaded = 0LL;
-            long long expectedDownloadBytes = 0LL;
-
-            for (NSString *opString in [self.bytesDownloadedPerOperation allKeys]) {
-                bytesDownloaded += [[self.bytesDownloadedPerOperation objectForKey:opString] longLongValue];
-            }
-
-            for (NSString *opString in [self.expectedDownloadBytesPerOperation allKeys]) {
-                expectedDownloadBytes += [[self.expectedDownloadBytesPerOperation objectForKey:opString] longLongValue];
-            }
-
-            dispatch_barrier_async(self.progressQueue, ^{
-                weakSelf.bytesDownloaded = @(bytesDownloaded);
-                weakSelf.expectedDownloadBytes = @(expectedDownloadBytes);
-                weakSelf.downloadProgress = expectedDownloadBytes ? @(bytesDownloaded / (float)expectedDownloadBytes) : @0.0f;
-                [weakSelf performDelegateMethod:@selector(httpOperationQueueDidUpload:)];
-                [weakSelf performDelegateMethod:@selector(httpOperationQueueDidMakeProgress:)];
-            });
-        });
-
-        return;
-    }
-
-    if ([keyPath isEqualToString:@"bytesUploaded"]) {
-        JXHTTPOperation *operation = (JXHTTPOperation *)object;
-
-        long long bytesUploaded = operation.bytesUploaded;
-        NSString *uniqueString = [operation.uniqueString copy];
-
-        dispatch_barrier_async(self.progressQueue, ^{
-            [weakSelf.bytesUploadedPerOperation setObject:@(bytesUploaded) forKey:uniqueString];
-        });
-
-        dispatch_sync(self.progressQueue, ^{
-            long long bytesUploaded = 0LL;
-            long long expectedUploadBytes = 0LL;
-
-            for (NSString *opString in [self.bytesUploadedPerOperation allKeys]) {
-                bytesUploaded += [[self.bytesUploadedPerOperation objectForKey:opString] longLongValue];
-            }
-
-            for (NSString *opString in [self.expectedUploadBytesPerOperation allKeys]) {
-                expectedUploadBytes += [[self.expectedUploadBytesPerOperation objectForKey:opString] longLongValue];
-            }
-
-            dispatch_barrier_async(self.progressQueue, ^{
-                weakSelf.bytesUploaded = @(bytesUploaded);
-                weakSelf.expectedUploadBytes = @(expectedUploadBytes);
-                weakSelf.uploadProgress = expectedUploadBytes ? @(bytesUploaded / (float)expectedUploadBytes) : @0.0f;
-                [weakSelf performDelegateMethod:@selector(httpOperationQueueDidDownload:)];
-                [weakSelf performDelegateMethod:@selector(httpOperationQueueDidMakeProgress:)];
-            });
-        });
-
-        return;
     }
 }
 
@@ -36,4 +36,14 @@
  @returns An integer.
  */
 - (long long)httpContentLength;
+
+@optional
+
+/**
+ The content coding applied to the request data (e.g. `gzip`), sent as the
+ `Content-Encoding` header. If nil or not implemented, the data is sent as is.
+
+ @returns A string.
+ */
+- (NSString *)httpContentEncoding;
 @end
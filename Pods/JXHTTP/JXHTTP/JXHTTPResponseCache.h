@@ -0,0 +1,112 @@
+/**
+ `JXHTTPResponseCache` is a size-bounded, on-disk store of `GET` response bodies along with
+ the validators (`ETag` and `Last-Modified`) needed to revalidate them.
+
+ A <JXHTTPOperation> with a `responseCache` adds `If-None-Match` and `If-Modified-Since`
+ headers to its request when the cache holds an entry for it. If the server answers
+ `304 Not Modified`, the operation presents the cached body as an ordinary `200` response,
+ through the same delegate methods, blocks and `responseData` as a full download. Successful
+ responses carrying a validator are stored when they finish loading.
+
+ Cached entries are always revalidated before use, as if every response said `no-cache`.
+ Responses marked `Cache-Control: no-store`, responses without a validator, and responses
+ that vary on anything but `Accept-Encoding` are not stored. When the total size of the
+ stored bodies exceeds <maximumSize>, the least recently used entries are evicted.
+
+ Safe to access from any thread at any time. Disk access happens on a private serial queue.
+
+ ## Example ##
+
+     JXHTTPOperation *op = [JXHTTPOperation withURLString:@"http://jxhttp.com/"];
+     op.responseCache = [JXHTTPResponseCache sharedCache];
+ */
+
+@interface JXHTTPResponseCache : NSObject
+
+/**
+ The directory entries are stored in.
+
+ Safe to access from any thread at any time.
+ */
+@property (copy, readonly) NSString *directoryPath;
+
+/**
+ The maximum total size of cached bodies in bytes. Lowering it evicts entries immediately.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign) unsigned long long maximumSize;
+
+/**
+ The total size of cached bodies in bytes.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) unsigned long long currentSize;
+
+/**
+ A cache in the application's caches directory with a <maximumSize> of `10MB`.
+
+ @returns The shared response cache.
+ */
++ (instancetype)sharedCache;
+
+/**
+ Creates a new cache, loading any entries already stored in the directory.
+
+ @param directoryPath The directory to store entries in, created if necessary.
+ @param maximumSize The maximum total size of cached bodies in bytes.
+ @returns A response cache.
+ */
+- (instancetype)initWithDirectoryPath:(NSString *)directoryPath maximumSize:(unsigned long long)maximumSize;
+
+/**
+ Adds conditional headers for a cached entry to a request, if there is one.
+
+ @param request The request to modify.
+ @param key The key the entry is stored under.
+ @returns `YES` if the cache holds an entry for the key.
+ */
+- (BOOL)addValidatorsToRequest:(NSMutableURLRequest *)request forKey:(NSString *)key;
+
+/**
+ Builds a `200` response from a cached entry, to stand in for a `304 Not Modified`.
+ Headers sent with the `304` replace the cached ones.
+
+ @param notModifiedResponse The `304` response received from the server.
+ @param key The key the entry is stored under.
+ @returns A response, or `nil` if the entry no longer exists.
+ */
+- (NSHTTPURLResponse *)cachedResponseForNotModifiedResponse:(NSHTTPURLResponse *)notModifiedResponse forKey:(NSString *)key;
+
+/**
+ The body of a cached entry, memory-mapped from disk. Marks the entry as recently used.
+
+ @param key The key the entry is stored under.
+ @returns The body, or `nil` if the entry no longer exists.
+ */
+- (NSData *)cachedDataForKey:(NSString *)key;
+
+/**
+ Stores a response and its body if the response allows it, replacing any existing entry.
+ Returns immediately; the body is written asynchronously and must not be mutated.
+
+ @param response A `200` response.
+ @param data The response body.
+ @param key The key to store the entry under.
+ */
+- (void)storeResponse:(NSHTTPURLResponse *)response data:(NSData *)data forKey:(NSString *)key;
+
+/**
+ Removes the entry stored under a key.
+
+ @param key The key the entry is stored under.
+ */
+- (void)removeEntryForKey:(NSString *)key;
+
+/**
+ Removes every entry.
+ */
+- (void)removeAllEntries;
+
+@end
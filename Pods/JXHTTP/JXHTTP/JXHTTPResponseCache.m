@@ -0,0 +1,366 @@
+#import "JXHTTPResponseCache.h"
+#import <CommonCrypto/CommonDigest.h>
+
+static unsigned long long JXHTTPResponseCacheDefaultMaximumSize = 10 * 1024 * 1024; // 10MB
+static NSString * const JXHTTPResponseCacheURLKey = @"url";
+static NSString * const JXHTTPResponseCacheHeadersKey = @"headers";
+static NSString * const JXHTTPResponseCacheSizeKey = @"size";
+static NSString * const JXHTTPResponseCacheAccessDateKey = @"accessDate";
+
+@interface JXHTTPResponseCache ()
+@property (copy) NSString *directoryPath;
+@property (assign) unsigned long long currentSize;
+@property (strong) NSMutableDictionary *entries;
+#if OS_OBJECT_USE_OBJC
+@property (strong) dispatch_queue_t ioQueue;
+#else
+@property (assign) dispatch_queue_t ioQueue;
+#endif
+@end
+
+@implementation JXHTTPResponseCache
+{
+    unsigned long long _maximumSize;
+}
+
+#pragma mark - Initialization
+
+- (void)dealloc
+{
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_ioQueue);
+    _ioQueue = NULL;
+    #endif
+}
+
+- (instancetype)init
+{
+    NSString *cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    return [self initWithDirectoryPath:[cachesPath stringByAppendingPathComponent:@"JXHTTPResponseCache"]
+                           maximumSize:JXHTTPResponseCacheDefaultMaximumSize];
+}
+
+- (instancetype)initWithDirectoryPath:(NSString *)directoryPath maximumSize:(unsigned long long)maximumSize
+{
+    if (self = [super init]) {
+        NSString *queueName = [[NSString alloc] initWithFormat:@"%@.%p.io", NSStringFromClass([self class]), self];
+        self.ioQueue = dispatch_queue_create([queueName UTF8String], DISPATCH_QUEUE_SERIAL);
+
+        self.directoryPath = directoryPath;
+        self.entries = [[NSMutableDictionary alloc] init];
+        self.currentSize = 0ULL;
+        _maximumSize = maximumSize;
+
+        dispatch_async(self.ioQueue, ^{
+            [self loadEntries];
+        });
+    }
+    return self;
+}
+
++ (instancetype)sharedCache
+{
+    static id sharedCache = nil;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^{
+        sharedCache = [[self alloc] init];
+    });
+
+    return sharedCache;
+}
+
+#pragma mark - Accessors
+
+- (unsigned long long)maximumSize
+{
+    __block unsigned long long maximumSize = 0ULL;
+
+    dispatch_sync(self.ioQueue, ^{
+        maximumSize = _maximumSize;
+    });
+
+    return maximumSize;
+}
+
+- (void)setMaximumSize:(unsigned long long)maximumSize
+{
+    dispatch_async(self.ioQueue, ^{
+        _maximumSize = maximumSize;
+        [self evictEntries];
+    });
+}
+
+#pragma mark - Public Methods
+
+- (BOOL)addValidatorsToRequest:(NSMutableURLRequest *)request forKey:(NSString *)key
+{
+    NSString *hash = [[self class] hashForKey:key];
+    __block NSDictionary *headers = nil;
+
+    dispatch_sync(self.ioQueue, ^{
+        headers = [[self.entries objectForKey:hash] objectForKey:JXHTTPResponseCacheHeadersKey];
+    });
+
+    if (!headers)
+        return NO;
+
+    NSString *entityTag = [[self class] valueForHeaderField:@"ETag" inHeaders:headers];
+    if (entityTag)
+        [request setValue:entityTag forHTTPHeaderField:@"If-None-Match"];
+
+    NSString *lastModified = [[self class] valueForHeaderField:@"Last-Modified" inHeaders:headers];
+    if (lastModified)
+        [request setValue:lastModified forHTTPHeaderField:@"If-Modified-Since"];
+
+    return YES;
+}
+
+- (NSHTTPURLResponse *)cachedResponseForNotModifiedResponse:(NSHTTPURLResponse *)notModifiedResponse forKey:(NSString *)key
+{
+    NSString *hash = [[self class] hashForKey:key];
+    __block NSDictionary *entry = nil;
+
+    dispatch_sync(self.ioQueue, ^{
+        entry = [self.entries objectForKey:hash];
+    });
+
+    if (!entry)
+        return nil;
+
+    NSMutableDictionary *headers = [[NSMutableDictionary alloc] initWithDictionary:[entry objectForKey:JXHTTPResponseCacheHeadersKey]];
+    NSSet *bodyHeaders = [[NSSet alloc] initWithObjects:@"content-length", @"content-encoding", @"transfer-encoding", nil];
+
+    [[notModifiedResponse allHeaderFields] enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+        if ([bodyHeaders containsObject:[field lowercaseString]])
+            return;
+
+        for (NSString *existingField in [headers allKeys]) {
+            if ([existingField caseInsensitiveCompare:field] == NSOrderedSame)
+                [headers removeObjectForKey:existingField];
+        }
+
+        [headers setObject:value forKey:field];
+    }];
+
+    return [[NSHTTPURLResponse alloc] initWithURL:[notModifiedResponse URL] statusCode:200 HTTPVersion:@"HTTP/1.1" headerFields:headers];
+}
+
+- (NSData *)cachedDataForKey:(NSString *)key
+{
+    NSString *hash = [[self class] hashForKey:key];
+    __block NSData *data = nil;
+
+    dispatch_sync(self.ioQueue, ^{
+        NSMutableDictionary *entry = [self.entries objectForKey:hash];
+        if (!entry)
+            return;
+
+        data = [[NSData alloc] initWithContentsOfFile:[self bodyPathForHash:hash] options:NSDataReadingMappedAlways error:nil];
+
+        if (!data) {
+            [self removeEntryForHash:hash];
+            return;
+        }
+
+        NSDate *now = [[NSDate alloc] init];
+        [entry setObject:now forKey:JXHTTPResponseCacheAccessDateKey];
+
+        // the metadata file's modification date doubles as the access date across launches
+        [[NSFileManager defaultManager] setAttributes:@{ NSFileModificationDate: now } ofItemAtPath:[self metadataPathForHash:hash] error:nil];
+    });
+
+    return data;
+}
+
+- (void)storeResponse:(NSHTTPURLResponse *)response data:(NSData *)data forKey:(NSString *)key
+{
+    if (![[self class] canStoreResponse:response] || !data)
+        return;
+
+    NSString *hash = [[self class] hashForKey:key];
+
+    NSMutableDictionary *headers = [[NSMutableDictionary alloc] initWithDictionary:[response allHeaderFields]];
+    for (NSString *field in [headers allKeys]) {
+        NSString *lowercaseField = [field lowercaseString];
+        if ([lowercaseField isEqualToString:@"content-encoding"] || [lowercaseField isEqualToString:@"transfer-encoding"] || [lowercaseField isEqualToString:@"content-length"])
+            [headers removeObjectForKey:field];
+    }
+
+    // the body is stored decoded, so describe it as it is on disk
+    [headers setObject:[[NSString alloc] initWithFormat:@"%lu", (unsigned long)[data length]] forKey:@"Content-Length"];
+
+    NSDictionary *metadata = @{ JXHTTPResponseCacheURLKey: [[response URL] absoluteString] ?: @"",
+                                JXHTTPResponseCacheHeadersKey: headers };
+
+    dispatch_async(self.ioQueue, ^{
+        NSFileManager *fileManager = [[NSFileManager alloc] init];
+        [fileManager createDirectoryAtPath:self.directoryPath withIntermediateDirectories:YES attributes:nil error:nil];
+
+        [self removeEntryForHash:hash];
+
+        if (![data writeToFile:[self bodyPathForHash:hash] options:NSDataWritingAtomic error:nil])
+            return;
+
+        if (![metadata writeToFile:[self metadataPathForHash:hash] atomically:YES]) {
+            [fileManager removeItemAtPath:[self bodyPathForHash:hash] error:nil];
+            return;
+        }
+
+        NSMutableDictionary *entry = [[NSMutableDictionary alloc] initWithDictionary:metadata];
+        [entry setObject:@([data length]) forKey:JXHTTPResponseCacheSizeKey];
+        [entry setObject:[[NSDate alloc] init] forKey:JXHTTPResponseCacheAccessDateKey];
+
+        [self.entries setObject:entry forKey:hash];
+        self.currentSize += [data length];
+
+        [self evictEntries];
+    });
+}
+
+- (void)removeEntryForKey:(NSString *)key
+{
+    NSString *hash = [[self class] hashForKey:key];
+
+    dispatch_async(self.ioQueue, ^{
+        [self removeEntryForHash:hash];
+    });
+}
+
+- (void)removeAllEntries
+{
+    dispatch_async(self.ioQueue, ^{
+        for (NSString *hash in [self.entries allKeys])
+            [self removeEntryForHash:hash];
+    });
+}
+
+#pragma mark - Private Methods
+
++ (NSString *)hashForKey:(NSString *)key
+{
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1([keyData bytes], (CC_LONG)[keyData length], digest);
+
+    NSMutableString *hash = [[NSMutableString alloc] initWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+    for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; i++)
+        [hash appendFormat:@"%02x", digest[i]];
+
+    return hash;
+}
+
++ (NSString *)valueForHeaderField:(NSString *)field inHeaders:(NSDictionary *)headers
+{
+    for (NSString *existingField in headers) {
+        if ([existingField caseInsensitiveCompare:field] == NSOrderedSame)
+            return [headers objectForKey:existingField];
+    }
+
+    return nil;
+}
+
++ (BOOL)canStoreResponse:(NSHTTPURLResponse *)response
+{
+    if (![response isKindOfClass:[NSHTTPURLResponse class]] || [response statusCode] != 200)
+        return NO;
+
+    NSDictionary *headers = [response allHeaderFields];
+
+    NSString *cacheControl = [[self valueForHeaderField:@"Cache-Control" inHeaders:headers] lowercaseString];
+    if ([cacheControl rangeOfString:@"no-store"].location != NSNotFound)
+        return NO;
+
+    NSString *vary = [[self valueForHeaderField:@"Vary" inHeaders:headers] lowercaseString];
+    for (NSString *field in [vary componentsSeparatedByString:@","]) {
+        NSString *trimmedField = [field stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if ([trimmedField length] && ![trimmedField isEqualToString:@"accept-encoding"])
+            return NO;
+    }
+
+    return [self valueForHeaderField:@"ETag" inHeaders:headers] || [self valueForHeaderField:@"Last-Modified" inHeaders:headers];
+}
+
+- (NSString *)bodyPathForHash:(NSString *)hash
+{
+    return [self.directoryPath stringByAppendingPathComponent:[hash stringByAppendingPathExtension:@"body"]];
+}
+
+- (NSString *)metadataPathForHash:(NSString *)hash
+{
+    return [self.directoryPath stringByAppendingPathComponent:[hash stringByAppendingPathExtension:@"plist"]];
+}
+
+// must be called on the io queue
+- (void)loadEntries
+{
+    NSFileManager *fileManager = [[NSFileManager alloc] init];
+
+    for (NSString *fileName in [fileManager contentsOfDirectoryAtPath:self.directoryPath error:nil]) {
+        if (![[fileName pathExtension] isEqualToString:@"plist"])
+            continue;
+
+        NSString *hash = [fileName stringByDeletingPathExtension];
+        NSString *metadataPath = [self metadataPathForHash:hash];
+
+        NSDictionary *metadata = [[NSDictionary alloc] initWithContentsOfFile:metadataPath];
+        NSDictionary *bodyAttributes = [fileManager attributesOfItemAtPath:[self bodyPathForHash:hash] error:nil];
+        NSDictionary *metadataAttributes = [fileManager attributesOfItemAtPath:metadataPath error:nil];
+
+        if (!metadata || !bodyAttributes) {
+            [self removeFilesForHash:hash];
+            continue;
+        }
+
+        NSMutableDictionary *entry = [[NSMutableDictionary alloc] initWithDictionary:metadata];
+        [entry setObject:@([bodyAttributes fileSize]) forKey:JXHTTPResponseCacheSizeKey];
+        [entry setObject:[metadataAttributes fileModificationDate] ?: [NSDate distantPast] forKey:JXHTTPResponseCacheAccessDateKey];
+
+        [self.entries setObject:entry forKey:hash];
+        self.currentSize += [bodyAttributes fileSize];
+    }
+
+    [self evictEntries];
+}
+
+// must be called on the io queue
+- (void)evictEntries
+{
+    if (self.currentSize <= _maximumSize)
+        return;
+
+    NSArray *hashes = [self.entries keysSortedByValueUsingComparator:^NSComparisonResult(NSDictionary *entry1, NSDictionary *entry2) {
+        return [[entry1 objectForKey:JXHTTPResponseCacheAccessDateKey] compare:[entry2 objectForKey:JXHTTPResponseCacheAccessDateKey]];
+    }];
+
+    for (NSString *hash in hashes) {
+        if (self.currentSize <= _maximumSize)
+            break;
+
+        [self removeEntryForHash:hash];
+    }
+}
+
+// must be called on the io queue
+- (void)removeEntryForHash:(NSString *)hash
+{
+    NSDictionary *entry = [self.entries objectForKey:hash];
+
+    if (entry) {
+        unsigned long long size = [[entry objectForKey:JXHTTPResponseCacheSizeKey] unsignedLongLongValue];
+        self.currentSize -= MIN(size, self.currentSize);
+        [self.entries removeObjectForKey:hash];
+    }
+
+    [self removeFilesForHash:hash];
+}
+
+// must be called on the io queue
+- (void)removeFilesForHash:(NSString *)hash
+{
+    NSFileManager *fileManager = [[NSFileManager alloc] init];
+    [fileManager removeItemAtPath:[self metadataPathForHash:hash] error:nil];
+    [fileManager removeItemAtPath:[self bodyPathForHash:hash] error:nil];
+}
+
+@end
@@ -0,0 +1,156 @@
+/**
+ `JXHTTPSegmentedDownload` downloads a large file with several `Range` requests at once,
+ each writing its own segment of a file that is preallocated to the full length, and
+ resumes each segment from where it stopped if the download is interrupted.
+
+ A `HEAD` request first learns the length and validator of the entity. If the server
+ doesn't accept byte ranges, has no validator to check the segments against, or the file
+ is shorter than two <minimumSegmentLength> segments, the file is downloaded with a single
+ <JXHTTPOperation> that has `resumesDownload` set instead.
+
+ Progress is kept in a file next to the download, ending in `.jxsegments`, saved each time
+ a segment stops and after every <minimumSegmentLength> bytes. Starting a download whose
+ progress file matches the URL picks up every segment where the progress file says it
+ stopped, with an `If-Range` header; if the entity has changed since, the download starts
+ over once.
+
+ Safe to access from any thread at any time. The download keeps itself alive until it
+ has finished, failed or been cancelled.
+
+ ## Example ##
+
+     JXHTTPSegmentedDownload *download = [JXHTTPSegmentedDownload withURL:url filePath:path];
+     download.didFinishBlock = ^(JXHTTPSegmentedDownload *download) {
+         NSLog(@"%@", download.error ?: @"done");
+     };
+
+     [download start];
+ */
+
+#import "JXHTTPOperationDelegate.h"
+
+@class JXHTTPSegmentedDownload;
+@class JXHTTPOperation;
+@class JXHTTPOperationQueue;
+
+typedef void (^JXHTTPSegmentedDownloadBlock)(JXHTTPSegmentedDownload *download);
+typedef void (^JXHTTPSegmentedDownloadOperationBlock)(JXHTTPOperation *operation);
+
+@interface JXHTTPSegmentedDownload : NSObject <JXHTTPOperationDelegate>
+
+/**
+ The URL of the file.
+
+ Safe to access from any thread at any time.
+ */
+@property (strong, readonly) NSURL *url;
+
+/**
+ The path the file is written to.
+
+ Safe to access from any thread at any time.
+ */
+@property (copy, readonly) NSString *filePath;
+
+/**
+ The queue that every request is added to. Defaults to the shared <JXHTTPOperationQueue>.
+
+ Should only be changed before the download starts.
+ */
+@property (strong) JXHTTPOperationQueue *queue;
+
+/**
+ The most segments downloaded at once. Defaults to `4`.
+
+ Should only be changed before the download starts.
+ */
+@property (assign) NSUInteger maximumSegmentCount;
+
+/**
+ The shortest segment the file is split into. Defaults to `1MB`.
+
+ Should only be changed before the download starts.
+ */
+@property (assign) long long minimumSegmentLength;
+
+/**
+ Performed with each request before it is added to the queue, e.g. to add headers. Must
+ not set the operation's delegate, `outputStream` or `responseDataFilePath`.
+
+ Should only be changed before the download starts.
+ */
+@property (copy) JXHTTPSegmentedDownloadOperationBlock prepareBlock;
+
+/**
+ Performed once when the download has finished, failed or been cancelled, on a private
+ background queue.
+ */
+@property (copy) JXHTTPSegmentedDownloadBlock didFinishBlock;
+
+/**
+ The length of the file, or `NSURLResponseUnknownLength` if it isn't known yet.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) long long expectedLength;
+
+/**
+ The number of bytes of the file written so far, including those written before the
+ download was resumed.
+
+ Safe to access from any thread at any time.
+ */
+@property (readonly) long long bytesDownloaded;
+
+/**
+ The number of segments the file is downloaded in, `1` if it isn't split.
+
+ Safe to access from any thread at any time.
+ */
+@property (readonly) NSUInteger segmentCount;
+
+/**
+ The error that stopped the download, if any.
+
+ Safe to access from any thread at any time.
+ */
+@property (strong, readonly) NSError *error;
+
+/**
+ `YES` once the download has finished, failed or been cancelled.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly, getter = isFinished) BOOL finished;
+
+/**
+ Creates a new download.
+
+ @param url The URL of the file.
+ @param filePath The path to write the file to.
+ @returns A download.
+ */
++ (instancetype)withURL:(NSURL *)url filePath:(NSString *)filePath;
+
+/**
+ Creates a new download.
+
+ @param url The URL of the file.
+ @param filePath The path to write the file to.
+ @returns A download.
+ */
+- (instancetype)initWithURL:(NSURL *)url filePath:(NSString *)filePath;
+
+/**
+ Starts the download, resuming it if its progress file matches. Does nothing if it has
+ already started.
+ */
+- (void)start;
+
+/**
+ Stops the download, keeping what has been written and saving its progress so a new
+ download with the same URL and path can resume it.
+ */
+- (void)cancel;
+
+@end
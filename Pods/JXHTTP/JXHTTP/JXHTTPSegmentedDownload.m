@@ -0,0 +1,669 @@
+#import "JXHTTPSegmentedDownload.h"
+#import "JXHTTPOperation.h"
+#import "JXHTTPOperation+Convenience.h"
+#import "JXHTTPOperationQueue.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+static NSUInteger JXHTTPSegmentedDownloadDefaultMaxSegments = 4;
+static long long JXHTTPSegmentedDownloadDefaultMinSegmentLength = 0x100000; // 1MB
+
+#pragma mark - JXHTTPFileRangeStream
+
+@interface JXHTTPFileRangeStream : NSOutputStream
+@property (copy, nonatomic) NSString *filePath;
+@property (assign, nonatomic) long long offset;
+@property (assign, nonatomic) long long limit;
+@property (copy, nonatomic) void (^writeBlock)(NSUInteger length);
+@property (assign, nonatomic) int fileDescriptor;
+@property (assign, nonatomic) NSStreamStatus status;
+@property (strong, nonatomic) NSError *error;
+@property (weak, nonatomic) id <NSStreamDelegate> streamDelegate;
+@end
+
+@implementation JXHTTPFileRangeStream
+
+- (void)dealloc
+{
+    if (_fileDescriptor >= 0)
+        close(_fileDescriptor);
+}
+
+- (instancetype)initWithFilePath:(NSString *)filePath offset:(long long)offset limit:(long long)limit
+{
+    if (self = [super init]) {
+        self.filePath = filePath;
+        self.offset = offset;
+        self.limit = limit;
+        self.fileDescriptor = -1;
+        self.status = NSStreamStatusNotOpen;
+    }
+    return self;
+}
+
+- (void)open
+{
+    if (self.status != NSStreamStatusNotOpen)
+        return;
+
+    self.fileDescriptor = open([self.filePath fileSystemRepresentation], O_WRONLY);
+
+    if (self.fileDescriptor < 0) {
+        self.error = [[NSError alloc] initWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        self.status = NSStreamStatusError;
+        return;
+    }
+
+    self.status = NSStreamStatusOpen;
+}
+
+- (void)close
+{
+    if (self.fileDescriptor >= 0) {
+        close(self.fileDescriptor);
+        self.fileDescriptor = -1;
+    }
+
+    if (self.status != NSStreamStatusError)
+        self.status = NSStreamStatusClosed;
+}
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length
+{
+    if (self.status != NSStreamStatusOpen)
+        return -1;
+
+    // bytes past the end of the range would overwrite the next segment
+    if ((long long)length > self.limit - self.offset) {
+        self.error = [[NSError alloc] initWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil];
+        self.status = NSStreamStatusError;
+        return -1;
+    }
+
+    ssize_t bytesWritten = pwrite(self.fileDescriptor, buffer, length, (off_t)self.offset);
+
+    if (bytesWritten < 0) {
+        self.error = [[NSError alloc] initWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        self.status = NSStreamStatusError;
+        return -1;
+    }
+
+    self.offset += bytesWritten;
+
+    if (self.writeBlock)
+        self.writeBlock((NSUInteger)bytesWritten);
+
+    return bytesWritten;
+}
+
+- (BOOL)hasSpaceAvailable
+{
+    return self.status == NSStreamStatusOpen;
+}
+
+- (NSStreamStatus)streamStatus
+{
+    return self.status;
+}
+
+- (NSError *)streamError
+{
+    return self.error;
+}
+
+- (id <NSStreamDelegate>)delegate
+{
+    return self.streamDelegate;
+}
+
+- (void)setDelegate:(id <NSStreamDelegate>)delegate
+{
+    self.streamDelegate = delegate;
+}
+
+// writes to a regular file never wait for space, so there's nothing to schedule
+- (void)scheduleInRunLoop:(NSRunLoop *)runLoop forMode:(NSString *)mode
+{
+}
+
+- (void)removeFromRunLoop:(NSRunLoop *)runLoop forMode:(NSString *)mode
+{
+}
+
+- (id)propertyForKey:(NSString *)key
+{
+    return nil;
+}
+
+- (BOOL)setProperty:(id)property forKey:(NSString *)key
+{
+    return NO;
+}
+
+@end
+
+#pragma mark - JXHTTPDownloadSegment
+
+@interface JXHTTPDownloadSegment : NSObject
+@property (assign, nonatomic) long long start;
+@property (assign, nonatomic) long long end;
+@property (assign, nonatomic) long long bytesWritten;
+@property (assign, nonatomic) long long requestedOffset;
+@end
+
+@implementation JXHTTPDownloadSegment
+
+- (BOOL)isComplete
+{
+    return self.start + self.bytesWritten >= self.end;
+}
+
+@end
+
+#pragma mark - JXHTTPSegmentedDownload
+
+@interface JXHTTPSegmentedDownload ()
+@property (strong) NSURL *url;
+@property (copy) NSString *filePath;
+@property (assign) long long expectedLength;
+@property (strong) NSError *error;
+@property (assign) BOOL finished;
+@property (assign) BOOL started;
+@property (assign) BOOL didRestart;
+@property (copy) NSString *validator;
+@property (strong) NSArray *segments;
+@property (strong) NSMutableSet *operations;
+@property (strong) JXHTTPOperation *singleOperation;
+@property (assign) long long bytesSinceSave;
+@property (strong) JXHTTPSegmentedDownload *retainedSelf;
+#if OS_OBJECT_USE_OBJC
+@property (strong) dispatch_queue_t stateQueue;
+#else
+@property (assign) dispatch_queue_t stateQueue;
+#endif
+@end
+
+@implementation JXHTTPSegmentedDownload
+
+#pragma mark - Initialization
+
+- (void)dealloc
+{
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_stateQueue);
+    _stateQueue = NULL;
+    #endif
+}
+
+- (instancetype)initWithURL:(NSURL *)url filePath:(NSString *)filePath
+{
+    if (self = [super init]) {
+        self.url = url;
+        self.filePath = filePath;
+        self.queue = [JXHTTPOperationQueue sharedQueue];
+        self.maximumSegmentCount = JXHTTPSegmentedDownloadDefaultMaxSegments;
+        self.minimumSegmentLength = JXHTTPSegmentedDownloadDefaultMinSegmentLength;
+        self.expectedLength = NSURLResponseUnknownLength;
+        self.operations = [[NSMutableSet alloc] init];
+
+        NSString *queueName = [[NSString alloc] initWithFormat:@"%@.%p.state", NSStringFromClass([self class]), self];
+        self.stateQueue = dispatch_queue_create([queueName UTF8String], DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
++ (instancetype)withURL:(NSURL *)url filePath:(NSString *)filePath
+{
+    return [[self alloc] initWithURL:url filePath:filePath];
+}
+
+#pragma mark - Accessors
+
+- (long long)bytesDownloaded
+{
+    JXHTTPOperation *singleOperation = self.singleOperation;
+    if (singleOperation)
+        return singleOperation.resumedLength + singleOperation.bytesDownloaded;
+
+    __block long long bytesDownloaded = 0LL;
+
+    dispatch_sync(self.stateQueue, ^{
+        for (JXHTTPDownloadSegment *segment in self.segments) {
+            bytesDownloaded += segment.bytesWritten;
+        }
+    });
+
+    return bytesDownloaded;
+}
+
+- (NSUInteger)segmentCount
+{
+    return MAX([self.segments count], 1);
+}
+
+#pragma mark - Public Methods
+
+- (void)start
+{
+    __block BOOL shouldStart = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        if (self.started)
+            return;
+
+        self.started = YES;
+        self.retainedSelf = self;
+        shouldStart = YES;
+    });
+
+    if (!shouldStart)
+        return;
+
+    if ([self loadProgress]) {
+        [self startSegments];
+    } else {
+        [self startProbe];
+    }
+}
+
+- (void)cancel
+{
+    [self finishWithError:[[NSError alloc] initWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+}
+
+#pragma mark - Private Methods
+
+- (NSString *)progressFilePath
+{
+    return [self.filePath stringByAppendingString:@".jxsegments"];
+}
+
+- (BOOL)loadProgress
+{
+    NSDictionary *progress = [[NSDictionary alloc] initWithContentsOfFile:[self progressFilePath]];
+    if (![[progress objectForKey:@"url"] isEqualToString:[self.url absoluteString]] || ![[progress objectForKey:@"validator"] length])
+        return NO;
+
+    long long expectedLength = [[progress objectForKey:@"expectedLength"] longLongValue];
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.filePath error:nil];
+
+    if (expectedLength <= 0LL || [[attributes objectForKey:NSFileSize] longLongValue] != expectedLength)
+        return NO;
+
+    NSMutableArray *segments = [[NSMutableArray alloc] init];
+
+    for (NSDictionary *segmentInfo in [progress objectForKey:@"segments"]) {
+        JXHTTPDownloadSegment *segment = [[JXHTTPDownloadSegment alloc] init];
+        segment.start = [[segmentInfo objectForKey:@"start"] longLongValue];
+        segment.end = [[segmentInfo objectForKey:@"end"] longLongValue];
+        segment.bytesWritten = [[segmentInfo objectForKey:@"bytesWritten"] longLongValue];
+
+        if (segment.start < 0LL || segment.end > expectedLength || segment.start + segment.bytesWritten > segment.end)
+            return NO;
+
+        [segments addObject:segment];
+    }
+
+    if (![segments count])
+        return NO;
+
+    self.validator = [progress objectForKey:@"validator"];
+    self.expectedLength = expectedLength;
+    self.segments = segments;
+
+    return YES;
+}
+
+// must be called on the state queue
+- (void)saveProgress
+{
+    if (!self.validator || ![self.segments count])
+        return;
+
+    NSMutableArray *segmentInfos = [[NSMutableArray alloc] initWithCapacity:[self.segments count]];
+
+    for (JXHTTPDownloadSegment *segment in self.segments) {
+        [segmentInfos addObject:@{ @"start": @(segment.start), @"end": @(segment.end), @"bytesWritten": @(segment.bytesWritten) }];
+    }
+
+    NSDictionary *progress = @{ @"url": [self.url absoluteString],
+                                @"validator": self.validator,
+                                @"expectedLength": @(self.expectedLength),
+                                @"segments": segmentInfos };
+
+    [progress writeToFile:[self progressFilePath] atomically:YES];
+
+    self.bytesSinceSave = 0LL;
+}
+
+- (void)startProbe
+{
+    JXHTTPOperation *probe = [[JXHTTPOperation alloc] initWithURL:self.url];
+    probe.requestMethod = @"HEAD";
+    [probe setValue:@"identity" forRequestHeader:@"Accept-Encoding"];
+
+    probe.didFinishLoadingBlock = ^(JXHTTPOperation *operation) {
+        [self probeDidFinish:operation];
+    };
+
+    probe.didFailBlock = ^(JXHTTPOperation *operation) {
+        [self finishWithError:operation.error];
+    };
+
+    if (self.prepareBlock)
+        self.prepareBlock(probe);
+
+    [self addOperation:probe];
+}
+
+- (void)probeDidFinish:(JXHTTPOperation *)probe
+{
+    [self removeOperation:probe];
+
+    long long length = [probe responseStatusCode] / 100 == 2 ? [probe responseExpectedContentLength] : NSURLResponseUnknownLength;
+    NSString *validator = [JXHTTPOperation rangeValidatorForResponse:probe.response];
+    NSString *acceptRanges = [[[probe responseHeaders] objectForKey:@"Accept-Ranges"] lowercaseString];
+    long long minimumSegmentLength = MAX(self.minimumSegmentLength, 1LL);
+    NSUInteger segmentCount = length > 0LL ? (NSUInteger)MIN((long long)self.maximumSegmentCount, length / minimumSegmentLength) : 0;
+
+    [[NSFileManager defaultManager] removeItemAtPath:[self progressFilePath] error:nil];
+
+    if (!validator || [acceptRanges rangeOfString:@"bytes"].location == NSNotFound || segmentCount < 2) {
+        self.expectedLength = length > 0LL ? length : NSURLResponseUnknownLength;
+        [self startSingleOperation];
+        return;
+    }
+
+    NSError *error = [self preallocateFileWithLength:length];
+    if (error) {
+        [self finishWithError:error];
+        return;
+    }
+
+    long long segmentLength = length / segmentCount;
+    NSMutableArray *segments = [[NSMutableArray alloc] initWithCapacity:segmentCount];
+
+    for (NSUInteger i = 0; i < segmentCount; i++) {
+        JXHTTPDownloadSegment *segment = [[JXHTTPDownloadSegment alloc] init];
+        segment.start = segmentLength * i;
+        segment.end = i + 1 < segmentCount ? segmentLength * (i + 1) : length;
+        [segments addObject:segment];
+    }
+
+    dispatch_sync(self.stateQueue, ^{
+        self.validator = validator;
+        self.expectedLength = length;
+        self.segments = segments;
+        [self saveProgress];
+    });
+
+    [self startSegments];
+}
+
+- (NSError *)preallocateFileWithLength:(long long)length
+{
+    int fileDescriptor = open([self.filePath fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0)
+        return [[NSError alloc] initWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+
+    #ifdef F_PREALLOCATE
+    // reserving the blocks up front fails now rather than partway through if the disk is full
+    fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, length, 0 };
+    if (fcntl(fileDescriptor, F_PREALLOCATE, &store) == -1 && errno == ENOSPC) {
+        close(fileDescriptor);
+        return [[NSError alloc] initWithDomain:NSPOSIXErrorDomain code:ENOSPC userInfo:nil];
+    }
+    #endif
+
+    int result = ftruncate(fileDescriptor, (off_t)length);
+    int truncateError = errno;
+    close(fileDescriptor);
+
+    if (result != 0)
+        return [[NSError alloc] initWithDomain:NSPOSIXErrorDomain code:truncateError userInfo:nil];
+
+    return nil;
+}
+
+- (void)startSingleOperation
+{
+    JXHTTPOperation *operation = [[JXHTTPOperation alloc] initWithURL:self.url];
+    operation.responseDataFilePath = self.filePath;
+    operation.resumesDownload = YES;
+
+    operation.didFinishLoadingBlock = ^(JXHTTPOperation *op) {
+        NSError *error = nil;
+        if ([op responseStatusCode] / 100 != 2)
+            error = [[NSError alloc] initWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil];
+
+        [self removeOperation:op];
+        [self finishWithError:error];
+    };
+
+    operation.didFailBlock = ^(JXHTTPOperation *op) {
+        [self removeOperation:op];
+        [self finishWithError:op.error];
+    };
+
+    if (self.prepareBlock)
+        self.prepareBlock(operation);
+
+    self.singleOperation = operation;
+
+    [self addOperation:operation];
+}
+
+- (void)startSegments
+{
+    NSMutableArray *operations = [[NSMutableArray alloc] init];
+    __block NSArray *segments = nil;
+    __block NSString *validator = nil;
+
+    dispatch_sync(self.stateQueue, ^{
+        segments = self.segments;
+        validator = self.validator;
+    });
+
+    for (JXHTTPDownloadSegment *segment in segments) {
+        if ([segment isComplete])
+            continue;
+
+        segment.requestedOffset = segment.start + segment.bytesWritten;
+
+        JXHTTPFileRangeStream *stream = [[JXHTTPFileRangeStream alloc] initWithFilePath:self.filePath offset:segment.requestedOffset limit:segment.end];
+        stream.writeBlock = ^(NSUInteger length) {
+            [self segment:segment didWriteLength:length];
+        };
+
+        JXHTTPOperation *operation = [[JXHTTPOperation alloc] initWithURL:self.url];
+        operation.outputStream = stream;
+        operation.userObject = segment;
+        [operation setValue:@"identity" forRequestHeader:@"Accept-Encoding"];
+        [operation setValue:[[NSString alloc] initWithFormat:@"bytes=%lld-%lld", segment.requestedOffset, segment.end - 1] forRequestHeader:@"Range"];
+        [operation setValue:validator forRequestHeader:@"If-Range"];
+
+        if (self.prepareBlock)
+            self.prepareBlock(operation);
+
+        operation.delegate = self;
+
+        [operations addObject:operation];
+    }
+
+    if (![operations count]) {
+        [self finishWithError:nil];
+        return;
+    }
+
+    for (JXHTTPOperation *operation in operations) {
+        [self addOperation:operation];
+    }
+}
+
+- (void)segment:(JXHTTPDownloadSegment *)segment didWriteLength:(NSUInteger)length
+{
+    dispatch_sync(self.stateQueue, ^{
+        segment.bytesWritten += length;
+        self.bytesSinceSave += length;
+
+        if (self.bytesSinceSave >= self.minimumSegmentLength)
+            [self saveProgress];
+    });
+}
+
+- (void)addOperation:(JXHTTPOperation *)operation
+{
+    __block BOOL finished = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        finished = self.finished;
+        if (!finished)
+            [self.operations addObject:operation];
+    });
+
+    if (!finished)
+        [self.queue addOperation:operation];
+}
+
+- (void)removeOperation:(JXHTTPOperation *)operation
+{
+    dispatch_sync(self.stateQueue, ^{
+        [self.operations removeObject:operation];
+    });
+}
+
+- (void)restartForOperation:(JXHTTPOperation *)operation
+{
+    __block NSArray *operations = nil;
+    __block BOOL shouldRestart = NO;
+    __block BOOL superseded = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        // the other segments of a layout often get their 200s at once, only the first one starts over
+        if (![self.operations containsObject:operation]) {
+            superseded = YES;
+            return;
+        }
+
+        if (self.finished || self.didRestart)
+            return;
+
+        self.didRestart = YES;
+        shouldRestart = YES;
+
+        operations = [self.operations allObjects];
+        [self.operations removeAllObjects];
+
+        self.segments = nil;
+        self.validator = nil;
+        self.expectedLength = NSURLResponseUnknownLength;
+    });
+
+    if (superseded)
+        return;
+
+    if (!shouldRestart) {
+        [self finishWithError:[[NSError alloc] initWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil]];
+        return;
+    }
+
+    for (JXHTTPOperation *otherOperation in operations) {
+        [otherOperation cancel];
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:[self progressFilePath] error:nil];
+
+    [self startProbe];
+}
+
+- (void)finishWithError:(NSError *)error
+{
+    __block NSArray *operations = nil;
+    __block BOOL didFinish = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        if (self.finished)
+            return;
+
+        self.finished = YES;
+        self.error = error;
+        didFinish = YES;
+
+        operations = [self.operations allObjects];
+        [self.operations removeAllObjects];
+
+        if (error) {
+            [self saveProgress];
+        } else {
+            [[NSFileManager defaultManager] removeItemAtPath:[self progressFilePath] error:nil];
+        }
+    });
+
+    if (!didFinish)
+        return;
+
+    for (JXHTTPOperation *operation in operations) {
+        [operation cancel];
+    }
+
+    JXHTTPSegmentedDownloadBlock block = self.didFinishBlock;
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        if (block)
+            block(self);
+
+        self.retainedSelf = nil;
+    });
+}
+
+#pragma mark - <JXHTTPOperationDelegate>
+
+- (void)httpOperationDidReceiveResponse:(JXHTTPOperation *)operation
+{
+    JXHTTPDownloadSegment *segment = operation.userObject;
+
+    if ([JXHTTPOperation rangeStartOfResponse:operation.response] == segment.requestedOffset)
+        return;
+
+    // anything but the requested range would land in the wrong place, so nothing gets written
+    [operation cancel];
+
+    if ([operation responseStatusCode] == 200) {
+        // the entity changed since the segments were laid out
+        [self restartForOperation:operation];
+    } else {
+        [self finishWithError:[[NSError alloc] initWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil]];
+    }
+}
+
+- (void)httpOperationDidFinishLoading:(JXHTTPOperation *)operation
+{
+    JXHTTPDownloadSegment *segment = operation.userObject;
+    __block BOOL complete = YES;
+    __block BOOL segmentComplete = NO;
+
+    dispatch_sync(self.stateQueue, ^{
+        [self.operations removeObject:operation];
+
+        segmentComplete = [segment isComplete];
+
+        for (JXHTTPDownloadSegment *otherSegment in self.segments) {
+            if (![otherSegment isComplete])
+                complete = NO;
+        }
+    });
+
+    if (!segmentComplete) {
+        [self finishWithError:[[NSError alloc] initWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+    } else if (complete) {
+        [self finishWithError:nil];
+    }
+}
+
+- (void)httpOperationDidFail:(JXHTTPOperation *)operation
+{
+    [self removeOperation:operation];
+    [self finishWithError:operation.error];
+}
+
+@end
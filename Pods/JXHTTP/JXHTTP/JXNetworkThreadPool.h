@@ -0,0 +1,69 @@
+/**
+ `JXNetworkThreadPool` owns a fixed set of threads that never exit, each running its
+ own runloop. <JXURLConnectionOperation> schedules its connection and output stream on
+ one of these threads, so that network I/O is spread across several runloops instead of
+ being serialized on a single one.
+
+ Threads are handed out round-robin by <nextThread>. Work is submitted to a thread
+ with <performBlock:onThread:waitUntilDone:>, which never blocks the caller unless asked to.
+
+ For the reasons we provide our own threads rather than use GCD's, see
+ <JXURLConnectionOperation>.
+
+ ## Example ##
+
+     JXNetworkThreadPool *pool = [[JXNetworkThreadPool alloc] initWithThreadCount:2 name:@"uploads"];
+
+     JXHTTPOperation *op = [JXHTTPOperation withURLString:@"http://jxhttp.com/"];
+     op.connectionThread = [pool nextThread];
+ */
+
+@interface JXNetworkThreadPool : NSObject
+
+/**
+ The threads owned by the pool, in the order they are handed out.
+
+ Safe to access from any thread at any time.
+ */
+@property (copy, readonly) NSArray *threads;
+
+/**
+ A pool shared by all operations that don't specify their own `connectionThread`. It
+ has one thread per active processor, with a minimum of `2` and a maximum of `4`.
+
+ Safe to access from any thread at any time.
+
+ @returns The shared thread pool.
+ */
++ (instancetype)sharedPool;
+
+/**
+ Creates a new pool and starts its threads.
+
+ @param threadCount The number of threads, at least `1`.
+ @param name A name used for the threads, for debugging purposes.
+ @returns A thread pool.
+ */
+- (instancetype)initWithThreadCount:(NSUInteger)threadCount name:(NSString *)name;
+
+/**
+ The next thread in round-robin order.
+
+ Safe to call from any thread at any time.
+
+ @returns A thread owned by the pool.
+ */
+- (NSThread *)nextThread;
+
+/**
+ Performs a block on the runloop of a thread.
+
+ If `wait` is `YES` and the calling thread is `thread`, the block is performed immediately.
+
+ @param block The block to perform.
+ @param thread The thread to perform it on.
+ @param wait If `YES`, blocks the calling thread until the block has been performed.
+ */
++ (void)performBlock:(void (^)(void))block onThread:(NSThread *)thread waitUntilDone:(BOOL)wait;
+
+@end
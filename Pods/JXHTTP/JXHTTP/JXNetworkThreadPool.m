@@ -0,0 +1,96 @@
+#import "JXNetworkThreadPool.h"
+#import <libkern/OSAtomic.h>
+
+static NSUInteger JXNetworkThreadPoolMinSharedThreads = 2;
+static NSUInteger JXNetworkThreadPoolMaxSharedThreads = 4;
+
+@interface JXNetworkThreadPool ()
+@property (copy) NSArray *threads;
+@property (assign) volatile int32_t threadIndex;
+@end
+
+@implementation JXNetworkThreadPool
+
+#pragma mark - Initialization
+
+- (instancetype)init
+{
+    return [self initWithThreadCount:1 name:nil];
+}
+
+- (instancetype)initWithThreadCount:(NSUInteger)threadCount name:(NSString *)name
+{
+    if (self = [super init]) {
+        NSUInteger count = threadCount ? threadCount : 1;
+        NSMutableArray *threads = [[NSMutableArray alloc] initWithCapacity:count];
+
+        for (NSUInteger i = 0; i < count; i++) {
+            NSThread *thread = [[NSThread alloc] initWithTarget:[self class] selector:@selector(runLoopForever) object:nil];
+            thread.name = count > 1 ? [[NSString alloc] initWithFormat:@"%@.%lu", name ?: @"JXHTTP", (unsigned long)i] : (name ?: @"JXHTTP");
+            [thread start];
+
+            [threads addObject:thread];
+        }
+
+        self.threads = threads;
+        self.threadIndex = -1;
+    }
+    return self;
+}
+
++ (instancetype)sharedPool
+{
+    static id sharedPool = nil;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^{
+        NSUInteger count = [[NSProcessInfo processInfo] activeProcessorCount];
+        count = MIN(MAX(count, JXNetworkThreadPoolMinSharedThreads), JXNetworkThreadPoolMaxSharedThreads);
+
+        sharedPool = [[self alloc] initWithThreadCount:count name:@"JXHTTP"];
+    });
+
+    return sharedPool;
+}
+
+#pragma mark - Public Methods
+
+- (NSThread *)nextThread
+{
+    uint32_t index = (uint32_t)OSAtomicIncrement32Barrier(&_threadIndex);
+    return [self.threads objectAtIndex:index % [self.threads count]];
+}
+
++ (void)performBlock:(void (^)(void))block onThread:(NSThread *)thread waitUntilDone:(BOOL)wait
+{
+    if (!block || !thread)
+        return;
+
+    if (wait && [NSThread currentThread] == thread) {
+        block();
+        return;
+    }
+
+    [self performSelector:@selector(runBlock:) onThread:thread withObject:[block copy] waitUntilDone:wait];
+}
+
+#pragma mark - Private Methods
+
++ (void)runBlock:(void (^)(void))block
+{
+    block();
+}
+
++ (void)runLoopForever
+{
+    // a runloop without input sources returns immediately, so give each thread a port to wait on
+    [[NSRunLoop currentRunLoop] addPort:[NSMachPort port] forMode:NSDefaultRunLoopMode];
+
+    while (YES) {
+        @autoreleasepool {
+            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
+        }
+    }
+}
+
+@end
@@ -1,16 +1,11 @@
 #import "JXOperation.h"
+#import <pthread.h>
 
 @interface JXOperation ()
 
 @property (assign) BOOL isExecuting;
 @property (assign) BOOL isFinished;
 
-#if OS_OBJECT_USE_OBJC
-@property (strong) dispatch_queue_t stateQueue;
-#else
-@property (assign) dispatch_queue_t stateQueue;
-#endif
-
 #if __IPHONE_OS_VERSION_MIN_REQUIRED >= __IPHONE_4_0
 @property (assign) UIBackgroundTaskIdentifier backgroundTaskID;
 #endif
@@ -18,24 +13,24 @@
 @end
 
 @implementation JXOperation
+{
+    // a serial queue per operation is costly to create at high request rates, a mutex does the same job
+    pthread_mutex_t _stateMutex;
+}
 
 #pragma mark - Initialization
 
 - (void)dealloc
 {
     [self endAppBackgroundTask];
-    
-    #if !OS_OBJECT_USE_OBJC
-    dispatch_release(_stateQueue);
-    _stateQueue = NULL;
-    #endif
+
+    pthread_mutex_destroy(&_stateMutex);
 }
 
 - (instancetype)init
 {
     if (self = [super init]) {
-        NSString *queueName = [[NSString alloc] initWithFormat:@"%@.%p.state", NSStringFromClass([self class]), self];
-        self.stateQueue = dispatch_queue_create([queueName UTF8String], DISPATCH_QUEUE_SERIAL);
+        pthread_mutex_init(&_stateMutex, NULL);
 
         self.isExecuting = NO;
         self.isFinished = NO;
@@ -57,21 +52,23 @@
 
 - (void)start
 {
-    __block BOOL shouldStart = YES;
-    
-    dispatch_sync(self.stateQueue, ^{
-        if (![self isReady] || [self isCancelled] || self.isExecuting || self.isFinished) {
-            shouldStart = NO;
-        } else {
-            [self willChangeValueForKey:@"isExecuting"];
-            self.isExecuting = YES;
-            [self didChangeValueForKey:@"isExecuting"];
-            
-            if (self.continuesInAppBackground)
-                [self startAppBackgroundTask];
-        }
-    });
-    
+    BOOL shouldStart = YES;
+
+    pthread_mutex_lock(&_stateMutex);
+
+    if (![self isReady] || [self isCancelled] || self.isExecuting || self.isFinished) {
+        shouldStart = NO;
+    } else {
+        [self willChangeValueForKey:@"isExecuting"];
+        self.isExecuting = YES;
+        [self didChangeValueForKey:@"isExecuting"];
+
+        if (self.continuesInAppBackground)
+            [self startAppBackgroundTask];
+    }
+
+    pthread_mutex_unlock(&_stateMutex);
+
     if (!shouldStart || [self isCancelled])
         return;
 
@@ -106,24 +103,28 @@
 
 - (void)finish
 {
-    dispatch_sync(self.stateQueue, ^{
-        if (self.isFinished)
-            return;
+    pthread_mutex_lock(&_stateMutex);
 
-        [self willFinish];
-
-        if (self.isExecuting) {
-            [self willChangeValueForKey:@"isExecuting"];
-            [self willChangeValueForKey:@"isFinished"];
-            self.isExecuting = NO;
-            self.isFinished = YES;
-            [self didChangeValueForKey:@"isExecuting"];
-            [self didChangeValueForKey:@"isFinished"];
-        } else if (!self.isFinished) {
-            self.isExecuting = NO;
-            self.isFinished = YES;
-        }
-    });
+    if (self.isFinished) {
+        pthread_mutex_unlock(&_stateMutex);
+        return;
+    }
+
+    [self willFinish];
+
+    if (self.isExecuting) {
+        [self willChangeValueForKey:@"isExecuting"];
+        [self willChangeValueForKey:@"isFinished"];
+        self.isExecuting = NO;
+        self.isFinished = YES;
+        [self didChangeValueForKey:@"isExecuting"];
+        [self didChangeValueForKey:@"isFinished"];
+    } else if (!self.isFinished) {
+        self.isExecuting = NO;
+        self.isFinished = YES;
+    }
+
+    pthread_mutex_unlock(&_stateMutex);
 }
 
 - (void)startAndWaitUntilFinished
@@ -0,0 +1,109 @@
+/**
+ `JXResponseBuffer` is an append-only store for response bytes, used by
+ <JXURLConnectionOperation> when no `outputStream` has been supplied.
+
+ When the expected length of the response is known up front, a single region of that
+ size is allocated once and filled in place. Otherwise (or if the response outgrows
+ its expected length) bytes are appended to a chain of fixed-size chunks, which are
+ recycled through a small process-wide pool. Stored bytes are never moved or
+ reallocated.
+
+ A buffer created with a spill threshold moves its contents to a temporary file once
+ its length would exceed the threshold (or immediately, if the expected length already
+ does), and appends to the file from then on. At most the threshold number of bytes is
+ ever held in memory. The file is deleted when the buffer is deallocated. If no file
+ can be created the buffer keeps its contents in memory instead.
+
+ <data> returns an immutable view of the bytes appended so far without copying them.
+ Views retain the storage they refer to and remain valid after the buffer is released.
+ Once spilled, views are memory mappings of the file.
+
+ A view of a single region or chunk is contiguous, so its `bytes` never copy. A view
+ spanning more than one chunk (a response without a usable `Content-Length`) exposes
+ each chunk separately through `enumerateByteRangesUsingBlock:`, but its `bytes`
+ method has to coalesce them into one newly allocated region, once per view. Anything
+ that needs contiguous bytes, including `NSJSONSerialization`, `NSString` and most
+ decoders, calls `bytes`, so for such responses the final flattening copy is not
+ avoided, only deferred until the bytes are first read. Only consumers that enumerate
+ byte ranges read chunked responses without it.
+
+ Safe to access from any thread at any time.
+ */
+
+@interface JXResponseBuffer : NSObject
+
+/**
+ The number of bytes appended so far.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) long long length;
+
+/**
+ The number of bytes after which the buffer spills to a file, or `0` if it never does.
+
+ Safe to access from any thread at any time.
+ */
+@property (assign, readonly) long long spillThreshold;
+
+/**
+ The path of the temporary file holding the buffer's contents once it has spilled,
+ otherwise `nil`.
+
+ Safe to access from any thread at any time.
+ */
+@property (copy, readonly) NSString *filePath;
+
+/**
+ The error that caused an append to fail, otherwise `nil`. Once it is set the buffer
+ has lost bytes, and every later append fails too.
+
+ Safe to access from any thread at any time.
+ */
+@property (strong, readonly) NSError *error;
+
+/**
+ The size of each chunk used when the expected length is unknown, `64K`.
+
+ @returns The chunk length in bytes.
+ */
++ (NSUInteger)chunkLength;
+
+/**
+ Creates a new buffer.
+
+ @param expectedLength The expected number of bytes, or `NSURLResponseUnknownLength`.
+ Storage for lengths above an internal limit is not preallocated.
+ @returns A response buffer.
+ */
+- (instancetype)initWithExpectedLength:(long long)expectedLength;
+
+/**
+ Creates a new buffer that spills to a temporary file past a given length.
+
+ @param expectedLength The expected number of bytes, or `NSURLResponseUnknownLength`.
+ @param spillThreshold The number of bytes to hold in memory before spilling, or `0`
+ to never spill.
+ @returns A response buffer.
+ */
+- (instancetype)initWithExpectedLength:(long long)expectedLength spillThreshold:(long long)spillThreshold;
+
+/**
+ Copies bytes onto the end of the buffer.
+
+ @param bytes The bytes to append.
+ @param length The number of bytes to append.
+ @returns `NO` if the bytes could not all be stored or an earlier append failed, in
+ which case <error> is set.
+ */
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length;
+
+/**
+ An immutable view of the bytes appended so far. Does not copy, though reading `bytes`
+ from a view of more than one chunk does.
+
+ @returns The buffered bytes, or an empty `NSData` if nothing has been appended.
+ */
+- (NSData *)data;
+
+@end
@@ -0,0 +1,356 @@
+#import "JXResponseBuffer.h"
+#import <pthread.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+static NSUInteger const JXResponseBufferChunkLength = 0x10000; // 64K
+static NSUInteger const JXResponseBufferMaxPooledChunks = 32; // 2MB
+static long long const JXResponseBufferMaxPreallocatedLength = 0x1000000; // 16MB
+
+static void * JXResponseBufferChunkPool[JXResponseBufferMaxPooledChunks];
+static NSUInteger JXResponseBufferChunkPoolCount = 0;
+static pthread_mutex_t JXResponseBufferChunkPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+
+#pragma mark - JXResponseBufferSegment
+
+@interface JXResponseBufferSegment : NSObject
+@property (assign, readonly) void *bytes;
+@property (assign, readonly) NSUInteger capacity;
+@property (assign) NSUInteger length;
+@end
+
+@implementation JXResponseBufferSegment
+
+- (void)dealloc
+{
+    if (_capacity != JXResponseBufferChunkLength) {
+        free(_bytes);
+        return;
+    }
+
+    pthread_mutex_lock(&JXResponseBufferChunkPoolMutex);
+
+    if (JXResponseBufferChunkPoolCount < JXResponseBufferMaxPooledChunks) {
+        JXResponseBufferChunkPool[JXResponseBufferChunkPoolCount++] = _bytes;
+        _bytes = NULL;
+    }
+
+    pthread_mutex_unlock(&JXResponseBufferChunkPoolMutex);
+
+    free(_bytes);
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    if (self = [super init]) {
+        void *bytes = NULL;
+
+        if (capacity == JXResponseBufferChunkLength) {
+            pthread_mutex_lock(&JXResponseBufferChunkPoolMutex);
+
+            if (JXResponseBufferChunkPoolCount > 0)
+                bytes = JXResponseBufferChunkPool[--JXResponseBufferChunkPoolCount];
+
+            pthread_mutex_unlock(&JXResponseBufferChunkPoolMutex);
+        }
+
+        if (!bytes)
+            bytes = malloc(capacity);
+
+        if (!bytes)
+            return nil;
+
+        _bytes = bytes;
+        _capacity = capacity;
+        _length = 0;
+    }
+    return self;
+}
+
+@end
+
+#pragma mark - JXResponseBufferData
+
+@interface JXResponseBufferData : NSData
+@end
+
+@implementation JXResponseBufferData
+{
+    NSArray *_segments;
+    NSUInteger _length;
+    NSUInteger _lastSegmentLength;
+    void *_coalescedBytes;
+    dispatch_once_t _coalesceOnce;
+}
+
+- (void)dealloc
+{
+    free(_coalescedBytes);
+}
+
+- (instancetype)initWithSegments:(NSArray *)segments length:(NSUInteger)length lastSegmentLength:(NSUInteger)lastSegmentLength
+{
+    if (self = [super init]) {
+        _segments = [segments copy];
+        _length = length;
+        _lastSegmentLength = lastSegmentLength;
+        _coalescedBytes = NULL;
+    }
+    return self;
+}
+
+- (NSUInteger)length
+{
+    return _length;
+}
+
+- (const void *)bytes
+{
+    if ([_segments count] < 2)
+        return [[_segments lastObject] bytes];
+
+    dispatch_once(&_coalesceOnce, ^{
+        uint8_t *coalescedBytes = malloc(_length);
+
+        [self enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+            memcpy(coalescedBytes + byteRange.location, bytes, byteRange.length);
+        }];
+
+        _coalescedBytes = coalescedBytes;
+    });
+
+    return _coalescedBytes;
+}
+
+- (void)enumerateByteRangesUsingBlock:(void (^)(const void *bytes, NSRange byteRange, BOOL *stop))block
+{
+    NSUInteger offset = 0;
+    NSUInteger count = [_segments count];
+    BOOL stop = NO;
+
+    for (NSUInteger i = 0; i < count && !stop; i++) {
+        JXResponseBufferSegment *segment = [_segments objectAtIndex:i];
+        NSUInteger length = i == count - 1 ? _lastSegmentLength : segment.length;
+
+        if (length)
+            block(segment.bytes, NSMakeRange(offset, length), &stop);
+
+        offset += length;
+    }
+}
+
+@end
+
+#pragma mark - JXResponseBuffer
+
+@interface JXResponseBuffer ()
+@property (assign) long long length;
+@property (assign) long long spillThreshold;
+@property (copy) NSString *filePath;
+@property (strong) NSError *error;
+@property (strong) NSMutableArray *segments;
+@property (strong) NSData *mappedData;
+@end
+
+@implementation JXResponseBuffer
+{
+    pthread_mutex_t _mutex;
+    int _fileDescriptor;
+}
+
+#pragma mark - Initialization
+
+- (void)dealloc
+{
+    if (_fileDescriptor >= 0)
+        close(_fileDescriptor);
+
+    // existing mappings stay valid after the file is unlinked
+    if (_filePath)
+        unlink([_filePath fileSystemRepresentation]);
+
+    pthread_mutex_destroy(&_mutex);
+}
+
+- (instancetype)init
+{
+    return [self initWithExpectedLength:NSURLResponseUnknownLength];
+}
+
+- (instancetype)initWithExpectedLength:(long long)expectedLength
+{
+    return [self initWithExpectedLength:expectedLength spillThreshold:0LL];
+}
+
+- (instancetype)initWithExpectedLength:(long long)expectedLength spillThreshold:(long long)spillThreshold
+{
+    if (self = [super init]) {
+        pthread_mutex_init(&_mutex, NULL);
+        _fileDescriptor = -1;
+
+        self.length = 0LL;
+        self.spillThreshold = MAX(spillThreshold, 0LL);
+        self.segments = [[NSMutableArray alloc] init];
+
+        if (self.spillThreshold && expectedLength > self.spillThreshold) {
+            [self spill];
+        } else if (expectedLength > 0LL && expectedLength <= JXResponseBufferMaxPreallocatedLength) {
+            JXResponseBufferSegment *segment = [[JXResponseBufferSegment alloc] initWithCapacity:(NSUInteger)expectedLength];
+            if (segment)
+                [self.segments addObject:segment];
+        }
+    }
+    return self;
+}
+
++ (NSUInteger)chunkLength
+{
+    return JXResponseBufferChunkLength;
+}
+
+#pragma mark - Public Methods
+
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length
+{
+    pthread_mutex_lock(&_mutex);
+
+    // once bytes have been lost, nothing appended after them can be used
+    if (!self.error && _fileDescriptor < 0 && self.spillThreshold && self.length + length > self.spillThreshold)
+        [self spill];
+
+    if (!self.error) {
+        NSUInteger remaining = _fileDescriptor >= 0 ? [self writeBytes:bytes length:length] : [self copyBytes:bytes length:length];
+        self.length += length - remaining;
+    }
+
+    BOOL appended = !self.error;
+
+    pthread_mutex_unlock(&_mutex);
+
+    return appended;
+}
+
+- (NSData *)data
+{
+    pthread_mutex_lock(&_mutex);
+
+    NSData *data = nil;
+
+    if (self.filePath) {
+        // an empty file can't be mapped
+        if (!self.length) {
+            self.mappedData = [[NSData alloc] init];
+        } else if ((long long)[self.mappedData length] != self.length) {
+            NSError *error = nil;
+            self.mappedData = [[NSData alloc] initWithContentsOfFile:self.filePath options:NSDataReadingMappedAlways error:&error];
+            if (!self.mappedData)
+                self.error = error;
+        }
+
+        data = self.mappedData;
+    } else {
+        NSMutableArray *segments = [[NSMutableArray alloc] initWithCapacity:[self.segments count]];
+
+        for (JXResponseBufferSegment *segment in self.segments) {
+            if (segment.length)
+                [segments addObject:segment];
+        }
+
+        JXResponseBufferSegment *lastSegment = [segments lastObject];
+
+        data = [[JXResponseBufferData alloc] initWithSegments:segments
+                                                       length:(NSUInteger)self.length
+                                            lastSegmentLength:lastSegment.length];
+    }
+
+    pthread_mutex_unlock(&_mutex);
+
+    return data;
+}
+
+#pragma mark - Private Methods
+
+// must be called with the mutex held
+- (NSUInteger)copyBytes:(const uint8_t *)bytes length:(NSUInteger)length
+{
+    NSUInteger remaining = length;
+
+    while (remaining > 0) {
+        JXResponseBufferSegment *segment = [self.segments lastObject];
+
+        if (!segment || segment.length == segment.capacity) {
+            segment = [[JXResponseBufferSegment alloc] initWithCapacity:JXResponseBufferChunkLength];
+            if (!segment) {
+                self.error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM userInfo:nil];
+                break;
+            }
+
+            [self.segments addObject:segment];
+        }
+
+        NSUInteger count = MIN(remaining, segment.capacity - segment.length);
+        memcpy((uint8_t *)segment.bytes + segment.length, bytes, count);
+
+        segment.length += count;
+        bytes += count;
+        remaining -= count;
+    }
+
+    return remaining;
+}
+
+// must be called with the mutex held
+- (NSUInteger)writeBytes:(const uint8_t *)bytes length:(NSUInteger)length
+{
+    NSUInteger remaining = length;
+
+    while (remaining > 0) {
+        ssize_t count = write(_fileDescriptor, bytes, remaining);
+
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count <= 0) {
+            self.error = [NSError errorWithDomain:NSPOSIXErrorDomain code:count < 0 ? errno : ENOSPC userInfo:nil];
+            break;
+        }
+
+        bytes += count;
+        remaining -= (NSUInteger)count;
+    }
+
+    return remaining;
+}
+
+// must be called with the mutex held
+- (void)spill
+{
+    NSString *fileName = [[NSString alloc] initWithFormat:@"JXHTTP-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:fileName];
+
+    int fileDescriptor = open([filePath fileSystemRepresentation], O_WRONLY | O_CREAT | O_EXCL, 0600);
+    // if no file can be created, carry on in memory rather than failing the response
+    if (fileDescriptor < 0) {
+        self.spillThreshold = 0LL;
+        return;
+    }
+
+    _fileDescriptor = fileDescriptor;
+
+    for (JXResponseBufferSegment *segment in self.segments) {
+        if (!segment.length || ![self writeBytes:segment.bytes length:segment.length])
+            continue;
+
+        // the buffered bytes are still intact, so keep them and stay in memory; the error fails later appends
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+        unlink([filePath fileSystemRepresentation]);
+        self.spillThreshold = 0LL;
+        return;
+    }
+
+    self.filePath = filePath;
+    [self.segments removeAllObjects];
+}
+
+@end
@@ -1,19 +1,25 @@
 /**
  `JXURLConnectionOperation` is a <JXOperation> subclass that encapsulates an
  `NSURLConnection`. It implements a basic set of delegate methods for writing
- response data to an `NSOutputStream` and counting the bytes transferred.
+ response data to a <JXResponseBuffer> (or an `NSOutputStream`, if one is supplied)
+ and counting the bytes transferred.
  
- All connections and streams are scheduled on the runloop of a <sharedThread>
- that never exits. This is preferable to using the runloop of a thread provided
- by a queue because GCD manages its threads dynamically and there's no guarantee
- about the lifetime of a GCD thread. There is also evidence that manipulating
- the runloop of a GCD thread confuses the GCD scheduler. For more discussion:
+ Each connection and its stream are scheduled on the runloop of a <connectionThread>,
+ which by default is taken round-robin from the <JXNetworkThreadPool> shared pool so
+ that connections are spread across several threads. These threads never exit. This is
+ preferable to using the runloop of a thread provided by a queue because GCD manages its
+ threads dynamically and there's no guarantee about the lifetime of a GCD thread. There
+ is also evidence that manipulating the runloop of a GCD thread confuses the GCD
+ scheduler. For more discussion:
  
  <http://stackoverflow.com/questions/7213845/>
  
  From the _Concurrency Programming Guide_: "Although you can obtain information
  about the underlying thread running a task, it is better to avoid doing so."
- And so we provide our own thread.
+ And so we provide our own threads.
+ 
+ Starting and stopping the connection are handed off to the <connectionThread> without
+ waiting, so neither `start` nor `cancel` blocks the calling thread on network work.
  
  ## Example ##
  
@@ -24,12 +30,14 @@
      JXURLConnectionOperation *op = [[JXURLConnectionOperation alloc] initWithURL:url];
      [op startAndWaitUntilFinished];
  
-     NSData *responseData = [op.outputStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+     NSData *responseData = [op.responseBuffer data];
      NSString *someHTML = [[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding];
      NSLog(@"%@", someHTML);
  */
 
 #import "JXOperation.h"
+#import "JXNetworkThreadPool.h"
+#import "JXResponseBuffer.h"
 
 @interface JXURLConnectionOperation : JXOperation <NSURLConnectionDelegate, NSURLConnectionDataDelegate>
 
@@ -60,8 +68,11 @@
  The stream to which downloaded bytes will be written.
  
  This can be set to any `NSOutputStream` or subclass thereof, providing that
- it is new and unopened. If this property is `nil` when the operation starts
- an `outputStreamToMemory` is created by default.
+ it is new and unopened. If this property is `nil` when a response is received,
+ downloaded bytes are written to the <responseBuffer> instead.
+ 
+ If the stream fails to accept all of the bytes received the operation fails
+ with the stream's error.
  
  Safe to access from any thread at any time.
  
@@ -69,6 +80,25 @@
  */
 @property (strong) NSOutputStream *outputStream;
 
+/**
+ The buffer to which downloaded bytes are written when no <outputStream> has been
+ supplied, otherwise `nil`. It is created when a response is received and
+ preallocated from the response's expected content length, if known.
+ 
+ Safe to access from any thread at any time.
+ */
+@property (strong, readonly) JXResponseBuffer *responseBuffer;
+
+/**
+ The thread on whose runloop the connection and <outputStream> are scheduled. Defaults to
+ the <nextThread> of the shared <JXNetworkThreadPool>.
+ 
+ Safe to access from any thread at any time.
+ 
+ @warning Do not change this property after the operation has started.
+ */
+@property (strong) NSThread *connectionThread;
+
 /// @name Progress
 
 /**
@@ -88,12 +118,13 @@
 /// @name Initialization
 
 /**
- A shared thread that never exits. All connections and streams are scheduled
- on this thread's runloop.
+ A shared thread that never exits, the first thread of the shared <JXNetworkThreadPool>.
+ Connections are no longer all scheduled on this thread, use <connectionThread> to find
+ the thread of a particular operation.
  
  Safe to access from any thread at any time.
  
- @returns The shared thread used by all connections and streams.
+ @returns The first thread of the shared thread pool.
  */
 + (NSThread *)sharedThread;
 
@@ -105,4 +136,25 @@
  */
 - (instancetype)initWithURL:(NSURL *)url;
 
+/// @name Scheduling
+
+/**
+ Called on the <connectionThread> when a response is received and no <outputStream> has
+ been supplied, to create the <responseBuffer>. Subclasses may override this method to
+ configure the buffer differently.
+ 
+ @param urlResponse The response that was received.
+ @returns A new response buffer.
+ */
+- (JXResponseBuffer *)responseBufferForResponse:(NSURLResponse *)urlResponse;
+
+/**
+ Called on the <connectionThread> immediately after the connection has started. Not
+ called if the operation is cancelled before the connection starts. Subclasses may
+ override this method (and call `super`).
+ 
+ @warning Do not call this method yourself.
+ */
+- (void)didStartConnection;
+
 @end
@@ -5,6 +5,7 @@
 @property (strong) NSMutableURLRequest *request;
 @property (strong) NSURLResponse *response;
 @property (strong) NSError *error;
+@property (strong) JXResponseBuffer *responseBuffer;
 @property (assign) long long bytesDownloaded;
 @property (assign) long long bytesUploaded;
 @end
@@ -15,7 +16,16 @@
 
 - (void)dealloc
 {
-    [self stopConnection];
+    // self can't be retained by a block at this point, so only the connection and stream are captured
+    NSURLConnection *connection = _connection;
+    NSOutputStream *outputStream = _outputStream;
+
+    if (!connection && !outputStream)
+        return;
+
+    [JXNetworkThreadPool performBlock:^{
+        [JXURLConnectionOperation stopConnection:connection outputStream:outputStream];
+    } onThread:_connectionThread waitUntilDone:NO];
 }
 
 - (instancetype)init
@@ -26,6 +36,8 @@
         self.response = nil;
         self.error = nil;
         self.outputStream = nil;
+        self.responseBuffer = nil;
+        self.connectionThread = [[JXNetworkThreadPool sharedPool] nextThread];
 
         self.bytesDownloaded = 0LL;
         self.bytesUploaded = 0LL;
@@ -62,60 +74,47 @@
 
 - (void)startConnection
 {
-    if ([NSThread currentThread] != [[self class] sharedThread]) {
-        [self performSelector:@selector(startConnection) onThread:[[self class] sharedThread] withObject:nil waitUntilDone:YES];
+    if ([NSThread currentThread] != self.connectionThread) {
+        [JXNetworkThreadPool performBlock:^{ [self startConnection]; } onThread:self.connectionThread waitUntilDone:NO];
         return;
     }
     
-    if ([self isCancelled])
+    if ([self isCancelled] || self.isFinished)
         return;
     
-    if (!self.outputStream)
-        self.outputStream = [[NSOutputStream alloc] initToMemory];
-
     [self.outputStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
 
     self.connection = [[NSURLConnection alloc] initWithRequest:self.request delegate:self startImmediately:NO];
     [self.connection scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
     [self.connection start];
+
+    [self didStartConnection];
 }
 
-- (void)stopConnection
+- (void)didStartConnection
 {
-    if ([NSThread currentThread] != [[self class] sharedThread]) {
-        [self performSelector:@selector(stopConnection) onThread:[[self class] sharedThread] withObject:nil waitUntilDone:YES];
-        return;
-    }
-
-    [self.connection unscheduleFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
-    [self.connection cancel];
-
-    [self.outputStream removeFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
-    [self.outputStream close];
 }
 
-+ (NSThread *)sharedThread
+- (void)stopConnection
 {
-    static NSThread *thread = nil;
-    static dispatch_once_t predicate;
-    
-    dispatch_once(&predicate, ^{
-        thread = [[NSThread alloc] initWithTarget:self selector:@selector(runLoopForever) object:nil];
-        [thread start];
-    });
-    
-    return thread;
+    // performed after any pending startConnection, which runs on the same thread
+    [JXNetworkThreadPool performBlock:^{
+        [[self class] stopConnection:self.connection outputStream:self.outputStream];
+    } onThread:self.connectionThread waitUntilDone:NO];
 }
 
-+ (void)runLoopForever
++ (void)stopConnection:(NSURLConnection *)connection outputStream:(NSOutputStream *)outputStream
 {
-    [[NSThread currentThread] setName:@"JXHTTP"];
+    [connection unscheduleFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
+    [connection cancel];
 
-    while (YES) {
-        @autoreleasepool {
-            [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
-        }
-    }
+    [outputStream removeFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
+    [outputStream close];
+}
+
++ (NSThread *)sharedThread
+{
+    return [[[JXNetworkThreadPool sharedPool] threads] objectAtIndex:0];
 }
 
 #pragma mark - <NSURLConnectionDelegate>
@@ -130,6 +129,13 @@
     [self finish];
 }
 
+#pragma mark - Response Buffering
+
+- (JXResponseBuffer *)responseBufferForResponse:(NSURLResponse *)urlResponse
+{
+    return [[JXResponseBuffer alloc] initWithExpectedLength:[urlResponse expectedContentLength]];
+}
+
 #pragma mark - <NSURLConnectionDataDelegate>
 
 - (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)urlResponse
@@ -139,7 +145,11 @@
 
     self.response = urlResponse;
     
-    [self.outputStream open];
+    if (self.outputStream) {
+        [self.outputStream open];
+    } else {
+        self.responseBuffer = [self responseBufferForResponse:urlResponse];
+    }
 }
 
 - (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data
@@ -147,11 +157,45 @@
     if ([self isCancelled])
         return;
     
-    if ([self.outputStream hasSpaceAvailable]) {
-        NSInteger bytesWritten = [self.outputStream write:[data bytes] maxLength:[data length]];
-        
-        if (bytesWritten != -1)
-            self.bytesDownloaded += bytesWritten;
+    if (!self.outputStream) {
+        __block BOOL appended = YES;
+
+        [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+            *stop = !(appended = [self.responseBuffer appendBytes:bytes length:byteRange.length]);
+        }];
+
+        if (appended) {
+            self.bytesDownloaded += [data length];
+        } else {
+            [connection cancel];
+            [self connection:connection didFailWithError:self.responseBuffer.error];
+        }
+
+        return;
+    }
+
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger offset = 0;
+
+    // write blocks until the stream has space, so a short write means there's no more room
+    while (offset < length) {
+        NSInteger bytesWritten = [self.outputStream write:bytes + offset maxLength:length - offset];
+        if (bytesWritten <= 0)
+            break;
+
+        offset += bytesWritten;
+    }
+
+    self.bytesDownloaded += offset;
+
+    if (offset < length) {
+        NSError *error = [self.outputStream streamError];
+        if (!error)
+            error = [[NSError alloc] initWithDomain:NSPOSIXErrorDomain code:ENOSPC userInfo:nil];
+
+        [connection cancel];
+        [self connection:connection didFailWithError:error];
     }
 }
 
@@ -23,8 +23,8 @@
 + (NSString *)formEncodedString:(NSString *)string;
 
 /**
- Encodes a dictionary according to RFC 3986, with keys sorted alphabetically and flattened
- into a query string. Dictionary values must be one of `NSString`, `NSArray`, or `NSDictionary`.
+ Encodes a dictionary according to RFC 3986, with keys sorted alphabetically ignoring case,
+ the same way in every locale, and flattened into a query string. Dictionary values must be one of `NSString`, `NSArray`, or `NSDictionary`.
  
  ### Example ###
  
@@ -35,7 +35,7 @@
     };
  
     NSString *escaped = [JXURLEncoding encodedDictionary:params];
-    // make=Ferrari&model=458%20Italia&options[0]=heated%20seats&options[1]=cup&20holders
+    // make=Ferrari&model=458%20Italia&options%5B%5D=heated%20seats&options%5B%5D=cup%20holders
 
  @param dictionary A dictionary to encode.
  @returns An encoded string.
@@ -43,8 +43,8 @@
 + (NSString *)encodedDictionary:(NSDictionary *)dictionary;
 
 /**
- Encodes a dictionary according to RFC 3986, with keys sorted alphabetically and flattened
- into a query string. Dictionary values must be one of `NSString`, `NSArray`, or `NSDictionary`.
+ Encodes a dictionary according to RFC 3986, with keys sorted alphabetically ignoring case,
+ the same way in every locale, and flattened into a query string. Dictionary values must be one of `NSString`, `NSArray`, or `NSDictionary`.
  
  Identical to <encodedDictionary:> but with `+` replacing spaces instead of `%20`.
 
@@ -57,7 +57,7 @@
      };
 
      NSString *escaped = [JXURLEncoding encodedDictionary:params];
-     // make=Ferrari&model=458+Italia&options[0]=heated+seats&options[1]=cup+holders
+     // make=Ferrari&model=458+Italia&options%5B%5D=heated+seats&options%5B%5D=cup+holders
 
  @param dictionary A dictionary to encode.
  @returns An encoded string.
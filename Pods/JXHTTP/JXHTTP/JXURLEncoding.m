@@ -1,5 +1,307 @@
 #import "JXURLEncoding.h"
 
+// RFC 3986 unreserved, everything else is escaped
+static const bool JXURLEncodingUnreserved[256] = {
+    ['A' ... 'Z'] = true, ['a' ... 'z'] = true, ['0' ... '9'] = true,
+    ['-'] = true, ['.'] = true, ['_'] = true, ['~'] = true
+};
+
+static const char JXURLEncodingHexDigits[] = "0123456789ABCDEF";
+
+typedef struct {
+    uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger capacity;
+} JXURLEncodingBuffer;
+
+typedef struct {
+    __unsafe_unretained NSString *key;
+    const uint8_t *bytes;
+    NSUInteger length;
+} JXURLEncodingSortKey;
+
+#pragma mark - Buffer
+
+static void JXURLEncodingBufferReserve(JXURLEncodingBuffer *buffer, NSUInteger length)
+{
+    if (buffer->length + length <= buffer->capacity)
+        return;
+
+    NSUInteger capacity = MAX(buffer->capacity * 2, buffer->length + length);
+    capacity = MAX(capacity, (NSUInteger)64);
+
+    buffer->bytes = reallocf(buffer->bytes, capacity);
+    buffer->capacity = buffer->bytes ? capacity : 0;
+
+    if (!buffer->bytes)
+        buffer->length = 0;
+}
+
+static void JXURLEncodingBufferAppend(JXURLEncodingBuffer *buffer, const void *bytes, NSUInteger length)
+{
+    JXURLEncodingBufferReserve(buffer, length);
+
+    if (buffer->bytes) {
+        memcpy(buffer->bytes + buffer->length, bytes, length);
+        buffer->length += length;
+    }
+}
+
+static void JXURLEncodingBufferAppendEscaped(JXURLEncodingBuffer *buffer, const uint8_t *bytes, NSUInteger length, BOOL form)
+{
+    JXURLEncodingBufferReserve(buffer, length * 3);
+
+    if (!buffer->bytes)
+        return;
+
+    uint8_t *output = buffer->bytes + buffer->length;
+
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t byte = bytes[i];
+
+        if (JXURLEncodingUnreserved[byte]) {
+            *output++ = byte;
+        } else if (form && byte == ' ') {
+            *output++ = '+';
+        } else {
+            *output++ = '%';
+            *output++ = JXURLEncodingHexDigits[byte >> 4];
+            *output++ = JXURLEncodingHexDigits[byte & 0x0F];
+        }
+    }
+
+    buffer->length = output - buffer->bytes;
+}
+
+// NO if the string isn't valid UTF-16, which can't be converted to UTF-8
+static BOOL JXURLEncodingBufferAppendEscapedString(JXURLEncodingBuffer *buffer, NSString *string, BOOL form)
+{
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(cfString);
+
+    if (!length)
+        return YES;
+
+    // ASCII strings can be read in place
+    const char *cString = CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8);
+    if (cString) {
+        JXURLEncodingBufferAppendEscaped(buffer, (const uint8_t *)cString, (NSUInteger)length, form);
+        return YES;
+    }
+
+    uint8_t stackBytes[256];
+    CFIndex maxLength = length * 3;
+    uint8_t *bytes = maxLength <= (CFIndex)sizeof(stackBytes) ? stackBytes : malloc(maxLength);
+    CFIndex usedLength = 0;
+
+    CFIndex convertedLength = CFStringGetBytes(cfString, CFRangeMake(0, length), kCFStringEncodingUTF8, 0, false, bytes, maxLength, &usedLength);
+
+    if (convertedLength == length)
+        JXURLEncodingBufferAppendEscaped(buffer, bytes, (NSUInteger)usedLength, form);
+
+    if (bytes != stackBytes)
+        free(bytes);
+
+    return convertedLength == length;
+}
+
+static NSString *JXURLEncodingBufferString(JXURLEncodingBuffer *buffer)
+{
+    if (!buffer->length) {
+        free(buffer->bytes);
+        return @"";
+    }
+
+    return [[NSString alloc] initWithBytesNoCopy:buffer->bytes length:buffer->length encoding:NSASCIIStringEncoding freeWhenDone:YES];
+}
+
+#pragma mark - Key Sorting
+
+// keys are ordered ignoring case, then by their UTF-16 code units, which doesn't depend on the user's locale
+static NSComparisonResult JXURLEncodingCompareKeys(NSString *key, NSString *otherKey)
+{
+    NSComparisonResult result = [key compare:otherKey options:NSCaseInsensitiveSearch | NSLiteralSearch];
+    return result != NSOrderedSame ? result : [key compare:otherKey options:NSLiteralSearch];
+}
+
+// the same order as JXURLEncodingCompareKeys, for ASCII keys, whose bytes are their code units
+static int JXURLEncodingCompareSortKeys(const void *a, const void *b)
+{
+    const JXURLEncodingSortKey *keyA = a;
+    const JXURLEncodingSortKey *keyB = b;
+    NSUInteger length = MIN(keyA->length, keyB->length);
+
+    for (NSUInteger i = 0; i < length; i++) {
+        int foldedA = tolower(keyA->bytes[i]);
+        int foldedB = tolower(keyB->bytes[i]);
+
+        if (foldedA != foldedB)
+            return foldedA < foldedB ? -1 : 1;
+    }
+
+    if (keyA->length != keyB->length)
+        return keyA->length < keyB->length ? -1 : 1;
+
+    return memcmp(keyA->bytes, keyB->bytes, length);
+}
+
+// nil unless every key is ASCII
+static NSArray *JXURLEncodingBytewiseSortedKeys(NSArray *keys)
+{
+    NSUInteger count = [keys count];
+    NSUInteger totalLength = 0;
+
+    for (NSString *key in keys) {
+        if (![key isKindOfClass:[NSString class]])
+            return nil;
+
+        totalLength += [key length];
+    }
+
+    JXURLEncodingSortKey *sortKeys = malloc(count * sizeof(JXURLEncodingSortKey));
+    uint8_t *keyBytes = malloc(MAX(totalLength, (NSUInteger)1));
+    NSUInteger offset = 0;
+    NSUInteger index = 0;
+    BOOL sortable = YES;
+
+    for (NSString *key in keys) {
+        CFIndex length = CFStringGetLength((__bridge CFStringRef)key);
+        CFIndex usedLength = 0;
+
+        CFStringGetBytes((__bridge CFStringRef)key, CFRangeMake(0, length), kCFStringEncodingASCII, 0, false, keyBytes + offset, length, &usedLength);
+
+        sortable = usedLength == length;
+        if (!sortable)
+            break;
+
+        sortKeys[index++] = (JXURLEncodingSortKey){ key, keyBytes + offset, (NSUInteger)length };
+        offset += length;
+    }
+
+    NSMutableArray *sortedKeys = nil;
+
+    if (sortable) {
+        qsort(sortKeys, count, sizeof(JXURLEncodingSortKey), JXURLEncodingCompareSortKeys);
+
+        sortedKeys = [[NSMutableArray alloc] initWithCapacity:count];
+
+        for (NSUInteger i = 0; i < count; i++)
+            [sortedKeys addObject:sortKeys[i].key];
+    }
+
+    free(sortKeys);
+    free(keyBytes);
+
+    return sortedKeys;
+}
+
+static NSArray *JXURLEncodingSortedKeys(NSDictionary *dictionary)
+{
+    NSArray *keys = [dictionary allKeys];
+
+    if ([keys count] < 2)
+        return keys;
+
+    return JXURLEncodingBytewiseSortedKeys(keys) ?: [keys sortedArrayUsingComparator:^NSComparisonResult(NSString *key, NSString *otherKey) {
+        return JXURLEncodingCompareKeys(key, otherKey);
+    }];
+}
+
+#pragma mark - Pairs
+
+static void JXURLEncodingBufferAppendKey(JXURLEncodingBuffer *buffer, const uint8_t *key, NSUInteger keyLength, NSString *subKey, BOOL form)
+{
+    JXURLEncodingBufferAppendEscaped(buffer, key, keyLength, form);
+
+    if (!subKey)
+        return;
+
+    JXURLEncodingBufferAppend(buffer, "[", 1);
+
+    if (!JXURLEncodingBufferAppendEscapedString(buffer, subKey, form))
+        JXURLEncodingBufferAppend(buffer, "(null)", 6);
+
+    JXURLEncodingBufferAppend(buffer, "]", 1);
+}
+
+// the key is escaped again at every level of nesting, keys of nested containers have always been encoded that way
+static void JXURLEncodingBufferAppendObject(JXURLEncodingBuffer *buffer, id object, const uint8_t *key, NSUInteger keyLength, NSString *subKey, BOOL form)
+{
+    if (!object || !keyLength)
+        return;
+
+    if ([object isKindOfClass:[NSDictionary class]] || [object isKindOfClass:[NSArray class]]) {
+        // only escapes that make it into the result as they are are subject to form encoding
+        JXURLEncodingBuffer objectKey = { NULL, 0, 0 };
+        JXURLEncodingBufferAppendKey(&objectKey, key, keyLength, subKey, NO);
+
+        if ([object isKindOfClass:[NSDictionary class]]) {
+            for (NSString *insideKey in JXURLEncodingSortedKeys(object))
+                JXURLEncodingBufferAppendObject(buffer, [object objectForKey:insideKey], objectKey.bytes, objectKey.length, insideKey, form);
+        } else {
+            JXURLEncodingBufferAppend(&objectKey, "[]", 2);
+
+            for (id arrayObject in (NSArray *)object)
+                JXURLEncodingBufferAppendObject(buffer, arrayObject, objectKey.bytes, objectKey.length, nil, form);
+        }
+
+        free(objectKey.bytes);
+        return;
+    }
+
+    if (buffer->length)
+        JXURLEncodingBufferAppend(buffer, "&", 1);
+
+    JXURLEncodingBufferAppendKey(buffer, key, keyLength, subKey, form);
+    JXURLEncodingBufferAppend(buffer, "=", 1);
+
+    if ([object isKindOfClass:[NSNumber class]]) {
+        const char *numberString = [[object stringValue] UTF8String];
+        JXURLEncodingBufferAppend(buffer, numberString, strlen(numberString));
+    } else if (!JXURLEncodingBufferAppendEscapedString(buffer, object, form)) {
+        JXURLEncodingBufferAppend(buffer, "(null)", 6);
+    }
+}
+
+static NSString *JXURLEncodingEncodeDictionary(NSDictionary *dictionary, BOOL form)
+{
+    JXURLEncodingBuffer buffer = { NULL, 0, 0 };
+    JXURLEncodingBuffer keyBuffer = { NULL, 0, 0 };
+
+    for (NSString *key in JXURLEncodingSortedKeys(dictionary)) {
+        keyBuffer.length = 0;
+
+        // top level keys are escaped once, like any other string
+        CFIndex length = CFStringGetLength((__bridge CFStringRef)key);
+        CFIndex usedLength = 0;
+
+        JXURLEncodingBufferReserve(&keyBuffer, length * 3 + 1);
+        if (!keyBuffer.bytes)
+            break;
+
+        if (CFStringGetBytes((__bridge CFStringRef)key, CFRangeMake(0, length), kCFStringEncodingUTF8, 0, false, keyBuffer.bytes, length * 3, &usedLength) != length)
+            continue;
+
+        JXURLEncodingBufferAppendObject(&buffer, [dictionary objectForKey:key], keyBuffer.bytes, usedLength, nil, form);
+    }
+
+    free(keyBuffer.bytes);
+
+    return JXURLEncodingBufferString(&buffer);
+}
+
+static NSString *JXURLEncodingEncodeString(NSString *string, BOOL form)
+{
+    JXURLEncodingBuffer buffer = { NULL, 0, 0 };
+
+    if (!JXURLEncodingBufferAppendEscapedString(&buffer, string, form)) {
+        free(buffer.bytes);
+        return nil;
+    }
+
+    return JXURLEncodingBufferString(&buffer);
+}
+
 @implementation JXURLEncoding
 
 #pragma mark - NSString Encoding
@@ -8,15 +310,8 @@
 {
     if (![string length])
         return @"";
-    
-    CFStringRef static const charsToLeave = CFSTR("-._~"); // RFC 3986 unreserved
-    CFStringRef static const charsToEscape = CFSTR(":/?#[]@!$&'()*+,;="); // RFC 3986 reserved
-    CFStringRef escapedString = CFURLCreateStringByAddingPercentEscapes(kCFAllocatorDefault,
-                                                                        (__bridge CFStringRef)string,
-                                                                        charsToLeave,
-                                                                        charsToEscape,
-                                                                        kCFStringEncodingUTF8);
-    return (__bridge_transfer NSString *)escapedString;
+
+    return JXURLEncodingEncodeString(string, NO);
 }
 
 + (NSString *)formEncodedString:(NSString *)string
@@ -24,7 +319,7 @@
     if (![string length])
         return @"";
 
-    return [[self encodedString:string] stringByReplacingOccurrencesOfString:@"%20" withString:@"+"];
+    return JXURLEncodingEncodeString(string, YES);
 }
 
 #pragma mark - NSDictionary Encoding
@@ -33,56 +328,16 @@
 {
     if (![dictionary count])
         return @"";
-    
-    NSMutableArray *arguments = [[NSMutableArray alloc] initWithCapacity:[dictionary count]];
-    NSArray *sortedKeys = [[dictionary allKeys] sortedArrayUsingSelector:@selector(localizedCaseInsensitiveCompare:)];
 
-    for (NSString *key in sortedKeys) {
-        [self encodeObject:[dictionary objectForKey:key] withKey:key andSubKey:nil intoArray:arguments];
-    }
-    
-    return [arguments componentsJoinedByString:@"&"];
+    return JXURLEncodingEncodeDictionary(dictionary, NO);
 }
 
 + (NSString *)formEncodedDictionary:(NSDictionary *)dictionary
 {
     if (![dictionary count])
         return @"";
-    
-    return [[self encodedDictionary:dictionary] stringByReplacingOccurrencesOfString:@"%20" withString:@"+"];
-}
 
-#pragma mark - Private Methods
-
-+ (void)encodeObject:(id)object withKey:(NSString *)key andSubKey:(NSString *)subKey intoArray:(NSMutableArray *)array
-{
-    if (!object || ![key length])
-        return;
-
-    NSString *objectKey = nil;
-    
-    if (subKey) {
-        objectKey = [[NSString alloc] initWithFormat:@"%@[%@]", [self encodedString:key], [self encodedString:subKey]];
-    } else {
-        objectKey = [self encodedString:key];
-    }
-    
-    if ([object isKindOfClass:[NSDictionary class]]) {
-        NSArray *sortedKeys = [[object allKeys] sortedArrayUsingSelector:@selector(localizedCaseInsensitiveCompare:)];
-        for (NSString *insideKey in sortedKeys) {
-            [self encodeObject:[object objectForKey:insideKey] withKey:objectKey andSubKey:insideKey intoArray:array];
-        }
-    } else if ([object isKindOfClass:[NSArray class]]) {
-        for (NSString *arrayObject in (NSArray *)object) {
-            NSString *arrayKey = [[NSString alloc] initWithFormat:@"%@[]", objectKey];
-            [self encodeObject:arrayObject withKey:arrayKey andSubKey:nil intoArray:array];
-        }
-    } else if ([object isKindOfClass:[NSNumber class]]) {
-        [array addObject:[[NSString alloc] initWithFormat:@"%@=%@", objectKey, [object stringValue]]];
-    } else {
-        NSString *encodedString = [self encodedString:object];
-        [array addObject:[[NSString alloc] initWithFormat:@"%@=%@", objectKey, encodedString]];
-    }
+    return JXURLEncodingEncodeDictionary(dictionary, YES);
 }
 
 @end
@@ -7,9 +7,15 @@
 //
 
 #import "JXHTTP.h"
+#import "TMCancellationToken.h"
+#import "TMJSONStreamParser.h"
+#import "TMLatencyHistory.h"
+#import "TMResumableUpload.h"
 
 typedef void (^TMAPICallback)(id, NSError *error);
 
+typedef void (^TMAPIUploadCallback)(TMResumableUpload *upload, id response, NSError *error);
+
 /**
  Full wrapper around the [Tumblr API](http://www.tumblr.com/docs/en/api/). Please see API documentation for a listing 
  of each route's parameters.
@@ -44,11 +50,28 @@ typedef void (^TMAPICallback)(id, NSError *error);
  */
 @property (nonatomic, copy) NSDictionary *customHeaders;
 
+/**
+ URL that API paths are appended to. Pointing it at a local stand-in server lets the client and its queue be exercised 
+ or load tested without reaching the real API. Must end with a slash, and should end with `/v2/` so that requests are 
+ keyed by endpoint the same way as they are against the real API.
+ 
+ Default: `http://api.tumblr.com/v2/`
+ */
+@property (nonatomic, copy) NSURL *baseURL;
+
 /**
  Default: 60 seconds
  */
 @property (nonatomic) NSTimeInterval timeoutInterval;
 
+/**
+ Form-encoded POST bodies of at least this many bytes are sent gzipped, if that makes them smaller. Only enable this 
+ against a server that accepts `Content-Encoding: gzip` request bodies.
+ 
+ Default: 0 (never compress)
+ */
+@property (nonatomic) long long requestBodyCompressionThreshold;
+
 /**
  Queue that requests sent through `sendRequest:callback:` or `sendRequest:queue:callback:` (and as such, any of the 
  `void` API methods) will be added to.
@@ -63,10 +86,140 @@ typedef void (^TMAPICallback)(id, NSError *error);
  */
 @property (nonatomic, strong) NSOperationQueue *defaultCallbackQueue;
 
+/**
+ Cache that GET responses are revalidated against and stored in, keyed per OAuth token. Set to `nil` to disable.
+ 
+ Default: `[JXHTTPResponseCache sharedCache]`
+ */
+@property (nonatomic, strong) JXHTTPResponseCache *responseCache;
+
+/**
+ Connection manager that requests are accounted against. It limits how many requests to the API host `queue` runs at 
+ once, pipelines GET requests to and prewarms connections to hosts opted in with `-setPipelinesSafeRequests:forURL:`, 
+ and estimates opened versus reused connection counts. Set to `nil` to leave connection handling to the system.
+ 
+ Default: `[JXHTTPConnectionManager sharedManager]`
+ */
+@property (nonatomic, strong) JXHTTPConnectionManager *connectionManager;
+
+/**
+ Whether a GET request sent through `sendRequest:callback:` or `sendRequest:queue:callback:` while an identical one is 
+ still in flight is attached to the in-flight request instead of being sent again. Requests are identical if they have 
+ the same method, path, and parameters (in any order) and are sent with the same OAuth token. Every attached callback 
+ receives the same parsed response.
+ 
+ A request that is attached to another one is never started itself, but it tracks the in-flight request: cancelling it 
+ detaches its callback without affecting the others, and it is marked finished once the in-flight request is done. Its 
+ own response properties stay empty, so callers that need to read them should exclude its endpoint using 
+ `uncoalescedPathPatterns`. Cancelling the in-flight request fails every attached callback with an 
+ `NSURLErrorCancelled` error, and the in-flight request is cancelled once every callback has been detached from it.
+ 
+ Default: `YES`
+ */
+@property (nonatomic) BOOL coalescesRequests;
+
+/**
+ Endpoints that are never coalesced, as `LIKE` patterns matched against the API path (e.g. `user/dashboard` or 
+ `blog/*.tumblr.com/followers`).
+ */
+@property (nonatomic, copy) NSArray *uncoalescedPathPatterns;
+
+/// Number of requests that were attached to an identical in-flight request instead of being sent
+@property (readonly) NSUInteger coalescedRequestCount;
+
+/// Number of requests that were eligible for coalescing but had no identical request in flight, and so were sent
+@property (readonly) NSUInteger uncoalescedRequestCount;
+
+/**
+ Maximum number of times a request sent through one of the `sendRequest:` methods is sent again after a transient 
+ failure: a connection that couldn't be established, or for GET requests, a timeout, a dropped connection, or a `408`, 
+ `429` or `5xx` response. Retries are re-signed copies of the original request, sent after a randomized exponential 
+ backoff. Cancelling the original request cancels its retries.
+ 
+ Requests with multipart bodies are never retried.
+ 
+ Default: 2
+ */
+@property (nonatomic) NSUInteger maximumRetryCount;
+
+/**
+ Retry `n` waits a random interval of up to `retryBackoffInterval * 2^(n-1)` seconds.
+ 
+ Default: 0.5 seconds
+ */
+@property (nonatomic) NSTimeInterval retryBackoffInterval;
+
+/**
+ Whether a GET request that hasn't received a response within its endpoint's 95th percentile response time is raced 
+ against a second copy. Whichever receives a response first is used and the other is cancelled.
+ 
+ Default: `YES`
+ */
+@property (nonatomic) BOOL hedgesRequests;
+
+/**
+ Whether requests whose timeout is `timeoutInterval` instead time out after four times their endpoint's 99th percentile 
+ response time, but no sooner than 10 seconds.
+ 
+ Default: `YES`
+ */
+@property (nonatomic) BOOL adaptsTimeoutIntervals;
+
+/**
+ Time from start to the response headers (the operation's `responseDate`) of successful requests, and from start to 
+ failure of requests that failed before any response arrived, keyed by method and API path with the blog name replaced 
+ by a placeholder (e.g. `GET user/dashboard` or `GET blog/{blog}/posts`). Hedging and adaptive timeouts only kick in 
+ for an endpoint once it has 20 samples.
+ */
+@property (nonatomic, strong, readonly) TMLatencyHistory *latencyHistory;
+
+/// Number of retries sent
+@property (readonly) NSUInteger retriedRequestCount;
+
+/// Number of hedged copies sent
+@property (readonly) NSUInteger hedgedRequestCount;
+
+/**
+ Length of the chunks that resumable uploads split files into. Smaller chunks lose less progress when a connection 
+ drops, at the cost of one request per chunk.
+ 
+ Default: 1 MB
+ */
+@property (nonatomic) NSUInteger resumableUploadChunkLength;
+
+/**
+ Directory that the progress of resumable uploads is saved in.
+ 
+ Default: `Library/Caches/TMResumableUploads`
+ */
+@property (nonatomic, copy) NSString *resumableUploadDirectory;
+
+/**
+ How long likes, unlikes, follows and unfollows sent with the `queue` methods are held before being sent. An action 
+ queued while the opposite action on the same post or blog is being held cancels it out, so that neither is sent, and 
+ repeating an action that is being held attaches to it. Whatever is left is then sent at once, as concurrent requests.
+ 
+ Default: 0.5 seconds
+ */
+@property (nonatomic) NSTimeInterval actionBatchingInterval;
+
+/// Number of queued actions that were never sent because they cancelled out or were attached to an identical action
+@property (readonly) NSUInteger unsentActionCount;
+
 /** @name Singleton instance */
 
 + (instancetype)sharedInstance;
 
+/**
+ Open connections to the API host ahead of the first request, so that the DNS lookup and TCP handshake are already done 
+ by the time it is sent. Call this at launch, or when the app returns to the foreground after long enough for idle 
+ connections to have closed.
+ 
+ Like pipelining, this only happens once the API host has been opted in on `connectionManager` with 
+ `-setPipelinesSafeRequests:forURL:`, since it sends `HEAD` requests to `baseURL`.
+ */
+- (void)prewarmConnections;
+
 /** @name Sending raw requests */
 
 /**
@@ -90,6 +243,69 @@ typedef void (^TMAPICallback)(id, NSError *error);
  */
 - (void)sendRequest:(JXHTTPOperation *)request queue:(NSOperationQueue *)queue callback:(TMAPICallback)callback;
 
+/**
+ Send an API request and receive the elements of one array in the response as soon as each has been downloaded, 
+ instead of after the whole response has been downloaded and parsed.
+ 
+ Elements are passed to `elementBlock` serially and in order, on a private background queue. The callback block is 
+ executed on `queue` once the request has finished and every element has been passed to `elementBlock`. Its response 
+ argument is always `nil`.
+ 
+ Responses with a non-2xx status code are not streamed; the callback block receives an error, as with 
+ `sendRequest:queue:callback:`. It also receives an error if the body isn't JSON, doesn't contain the array, or has a 
+ non-2xx `meta.status`. Elements may already have been passed to `elementBlock` by then, so nothing they feed should be 
+ treated as final until the callback succeeds.
+ 
+ @param keyPath Dot-separated keys leading to the array to stream, relative to the top level of the response body (e.g. 
+ `response.posts`)
+ @param queue Queue to execute the callback block on.
+ @param elementBlock Block called with each element of the array.
+ */
+- (void)sendRequest:(JXHTTPOperation *)request elementsAtKeyPath:(NSString *)keyPath queue:(NSOperationQueue *)queue
+       elementBlock:(TMJSONStreamParserElementBlock)elementBlock callback:(TMAPICallback)callback;
+
+/**
+ Send an API request whose callback is tied to a cancellation token.
+ 
+ Cancelling the token cancels the request along with any retry or hedged copy of it, skips parsing its response, and 
+ drops its callback even if it has already been added to `queue`. If the token expires first, the request is cancelled 
+ the same way and the callback is executed straight away with the token's `NSURLErrorTimedOut` error.
+ 
+ A request that is coalesced with an identical one in flight keeps that shared request going while other callbacks are 
+ still waiting on it, only its own callback is dropped or timed out. The shared request is cancelled once no callback is 
+ left.
+ 
+ @param queue Queue to execute the callback block on.
+ @param token Token to tie the request to, or `nil` to send it as `sendRequest:queue:callback:` does.
+ */
+- (void)sendRequest:(JXHTTPOperation *)request queue:(NSOperationQueue *)queue token:(TMCancellationToken *)token
+           callback:(TMAPICallback)callback;
+
+/**
+ Streaming counterpart of `sendRequest:queue:token:callback:`. No element is passed to `elementBlock` once the token has 
+ been cancelled or has expired.
+ */
+- (void)sendRequest:(JXHTTPOperation *)request elementsAtKeyPath:(NSString *)keyPath queue:(NSOperationQueue *)queue
+              token:(TMCancellationToken *)token elementBlock:(TMJSONStreamParserElementBlock)elementBlock
+           callback:(TMAPICallback)callback;
+
+/** @name Cancellation groups */
+
+/**
+ The token shared by every request sent on behalf of an owner (e.g. a view controller), to pass to the `token:` methods 
+ directly or to derive a child token with a deadline from. Work downstream of the requests, such as importing their 
+ results, can check it too.
+ 
+ The same token is returned until `cancelRequestsForOwner:` is called. The owner isn't retained.
+ */
+- (TMCancellationToken *)cancellationTokenForOwner:(id)owner;
+
+/**
+ Cancel the owner's token, stopping all pending network, parsing and import work tied to it. Requests sent on the 
+ owner's behalf afterwards get a new token.
+ */
+- (void)cancelRequestsForOwner:(id)owner;
+
 /** @name Authentication */
 
 /**
@@ -135,6 +351,12 @@ typedef void (^TMAPICallback)(id, NSError *error);
 - (JXHTTPOperation *)dashboardRequest:(NSDictionary *)parameters;
 - (void)dashboard:(NSDictionary *)parameters callback:(TMAPICallback)callback;
 
+/// Get posts for the authenticated user's dashboard, receiving each post as soon as it has been downloaded
+- (void)dashboard:(NSDictionary *)parameters postBlock:(TMJSONStreamParserElementBlock)postBlock
+         callback:(TMAPICallback)callback;
+- (void)dashboard:(NSDictionary *)parameters token:(TMCancellationToken *)token
+        postBlock:(TMJSONStreamParserElementBlock)postBlock callback:(TMAPICallback)callback;
+
 /// Get posts that the authenticated user has "liked"
 - (JXHTTPOperation *)likesRequest:(NSDictionary *)parameters;
 - (void)likes:(NSDictionary *)parameters callback:(TMAPICallback)callback;
@@ -159,9 +381,31 @@ typedef void (^TMAPICallback)(id, NSError *error);
 - (JXHTTPOperation *)unlikeRequest:(NSString *)postID reblogKey:(NSString *)reblogKey;
 - (void)unlike:(NSString *)postID reblogKey:(NSString *)reblogKey callback:(TMAPICallback)callback;
 
+/** @name Queued actions */
+
+/**
+ Like a post once `actionBatchingInterval` has passed, unless it is unliked with `queueUnlike:reblogKey:callback:` 
+ before then. The callback block is executed on the `defaultCallbackQueue` with the response to the request, or with a 
+ `nil` response and no error if the like was cancelled out.
+ */
+- (void)queueLike:(NSString *)postID reblogKey:(NSString *)reblogKey callback:(TMAPICallback)callback;
+
+/// Unlike a post once `actionBatchingInterval` has passed, unless it is liked again before then
+- (void)queueUnlike:(NSString *)postID reblogKey:(NSString *)reblogKey callback:(TMAPICallback)callback;
+
+/// Follow a blog once `actionBatchingInterval` has passed, unless it is unfollowed before then
+- (void)queueFollow:(NSString *)blogName callback:(TMAPICallback)callback;
+
+/// Unfollow a blog once `actionBatchingInterval` has passed, unless it is followed again before then
+- (void)queueUnfollow:(NSString *)blogName callback:(TMAPICallback)callback;
+
+/// Send every action that is being held straight away, e.g. when the app is about to move to the background
+- (void)sendQueuedActions;
+
 /** @name Blog */
 
 /// Get the avatar for a blog
+- (JXHTTPOperation *)avatarRequest:(NSString *)blogName size:(NSUInteger)size;
 - (void)avatar:(NSString *)blogName size:(NSUInteger)size callback:(TMAPICallback)callback;
 
 /**
@@ -256,6 +500,32 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
 - (void)audio:(NSString *)blogName filePath:(NSString *)filePathOrNil contentType:(NSString *)contentTypeOrNil
      fileName:(NSString *)fileNameOrNil parameters:(NSDictionary *)parameters callback:(TMAPICallback)callback;
 
+/** @name Resumable uploads */
+
+/**
+ Upload a file in chunks to an upload endpoint that understands the chunk fields described in `TMResumableUpload`, 
+ saving its progress after every chunk. If the upload fails, calling `startOnQueue:` on it again with `queue` carries 
+ on from the first chunk the server didn't acknowledge; if the app is terminated, `resumePendingUploads:` does the same 
+ on the next launch.
+ 
+ The callback block is executed on the `defaultCallbackQueue` each time the upload succeeds or stops, with the parsed 
+ response to the last chunk.
+ 
+ @param parameters Fields sent with every chunk, which must only contain property list objects.
+ @return The upload, already started.
+ */
+- (TMResumableUpload *)resumableUpload:(NSURL *)URL filePath:(NSString *)filePath contentType:(NSString *)contentTypeOrNil
+                              fileName:(NSString *)fileNameOrNil parameters:(NSDictionary *)parameters
+                              callback:(TMAPIUploadCallback)callback;
+
+/**
+ Carry on with the uploads saved in `resumableUploadDirectory` that hadn't finished when the app was last terminated. 
+ Call this once at launch, after the OAuth token has been set.
+ 
+ @return The uploads, already started.
+ */
+- (NSArray *)resumePendingUploads:(TMAPIUploadCallback)callback;
+
 /** @name Tagging */
 
 /// Get posts with a given tag
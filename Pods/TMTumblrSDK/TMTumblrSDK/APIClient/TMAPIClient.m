@@ -8,20 +8,67 @@
 
 #import "TMAPIClient.h"
 
-#import "TMOAuth.h"
+#import "TMCoalescedRequest.h"
+#import "TMJSONDecoder.h"
+#import "TMOAuthSigner.h"
+#import "TMRetryingRequest.h"
 #import "TMTumblrAuthenticator.h"
 
 static NSTimeInterval const TMAPIClientDefaultRequestTimeoutInterval = 60;
 
+static NSUInteger const TMAPIClientDefaultMaximumRetryCount = 2;
+
+static NSTimeInterval const TMAPIClientDefaultRetryBackoffInterval = 0.5;
+
+static NSTimeInterval const TMAPIClientMinimumAdaptiveTimeoutInterval = 10;
+
+static NSUInteger const TMAPIClientMinimumLatencySampleCount = 20;
+
+static NSUInteger const TMAPIClientPrewarmedConnectionCount = 2;
+
+static NSUInteger const TMAPIClientDefaultResumableUploadChunkLength = 1024 * 1024;
+
+static NSString * const TMAPIClientDefaultBaseURLString = @"http://api.tumblr.com/v2/";
+
+static NSTimeInterval const TMAPIClientDefaultActionBatchingInterval = 0.5;
+
 @interface TMAPIClient()
 
 @property (nonatomic, strong) JXHTTPOperationQueue *queue;
 
+@property (nonatomic, strong) NSMutableDictionary *inFlightCallbacks;
+
+@property (nonatomic, strong) NSMutableDictionary *inFlightRequests;
+
+@property (nonatomic, strong) NSPredicate *uncoalescedPathPredicate;
+
+@property NSUInteger coalescedRequestCount;
+
+@property NSUInteger uncoalescedRequestCount;
+
+@property (nonatomic, strong) TMLatencyHistory *latencyHistory;
+
+@property NSUInteger retriedRequestCount;
+
+@property NSUInteger hedgedRequestCount;
+
+@property (nonatomic, strong) NSMapTable *ownerTokens;
+
+@property (strong) TMOAuthSigner *OAuthSigner;
+
+@property (nonatomic, strong) NSMutableDictionary *queuedActions;
+
+@property (nonatomic) NSUInteger queuedActionBatch;
+
+@property (nonatomic) BOOL queuedActionsScheduled;
+
+@property NSUInteger unsentActionCount;
+
 NSString *blogPath(NSString *ext, NSString *blogName);
 
 NSString *fullBlogName(NSString *blogName);
 
-NSString *URLWithPath(NSString *path);
+NSString *endpointKey(JXHTTPOperation *request);
 
 @end
 
@@ -88,13 +135,27 @@ NSString *URLWithPath(NSString *path);
 }
 
 - (JXHTTPOperation *)dashboardRequest:(NSDictionary *)parameters {
-    return [self getRequestWithPath:@"user/dashboard" parameters:parameters];
+    JXHTTPOperation *request = [self getRequestWithPath:@"user/dashboard" parameters:parameters];
+    request.priorityClass = JXHTTPOperationPriorityClassInteractive;
+    
+    return request;
 }
 
 - (void)dashboard:(NSDictionary *)parameters callback:(TMAPICallback)callback {
     [self sendRequest:[self dashboardRequest:parameters] callback:callback];
 }
 
+- (void)dashboard:(NSDictionary *)parameters postBlock:(TMJSONStreamParserElementBlock)postBlock
+         callback:(TMAPICallback)callback {
+    [self dashboard:parameters token:nil postBlock:postBlock callback:callback];
+}
+
+- (void)dashboard:(NSDictionary *)parameters token:(TMCancellationToken *)token
+        postBlock:(TMJSONStreamParserElementBlock)postBlock callback:(TMAPICallback)callback {
+    [self sendRequest:[self dashboardRequest:parameters] elementsAtKeyPath:@"response.posts"
+                queue:self.defaultCallbackQueue token:token elementBlock:postBlock callback:callback];
+}
+
 - (JXHTTPOperation *)likesRequest:(NSDictionary *)parameters {
     return [self getRequestWithPath:@"user/likes" parameters:parameters];
 }
@@ -143,15 +204,145 @@ NSString *URLWithPath(NSString *path);
     [self sendRequest:[self unlikeRequest:postID reblogKey:reblogKey] callback:callback];
 }
 
+#pragma mark - Queued actions
+
+- (void)queueLike:(NSString *)postID reblogKey:(NSString *)reblogKey callback:(TMAPICallback)callback {
+    [self queueActionWithPath:@"user/like" target:[@"post " stringByAppendingString:postID]
+                   parameters:@{ @"id" : postID, @"reblog_key" : reblogKey } callback:callback];
+}
+
+- (void)queueUnlike:(NSString *)postID reblogKey:(NSString *)reblogKey callback:(TMAPICallback)callback {
+    [self queueActionWithPath:@"user/unlike" target:[@"post " stringByAppendingString:postID]
+                   parameters:@{ @"id" : postID, @"reblog_key" : reblogKey } callback:callback];
+}
+
+- (void)queueFollow:(NSString *)blogName callback:(TMAPICallback)callback {
+    [self queueActionWithPath:@"user/follow" target:[@"blog " stringByAppendingString:fullBlogName(blogName)]
+                   parameters:@{ @"url" : fullBlogName(blogName) } callback:callback];
+}
+
+- (void)queueUnfollow:(NSString *)blogName callback:(TMAPICallback)callback {
+    [self queueActionWithPath:@"user/unfollow" target:[@"blog " stringByAppendingString:fullBlogName(blogName)]
+                   parameters:@{ @"url" : fullBlogName(blogName) } callback:callback];
+}
+
+- (void)sendQueuedActions {
+    NSDictionary *actions = nil;
+    
+    @synchronized (self.queuedActions) {
+        actions = [self removeQueuedActions];
+    }
+    
+    [self sendActions:actions];
+}
+
+/**
+ Hold an action until the current batch is sent. Actions are held per target (a post or a blog), so there is at most 
+ one per target: a repeated action attaches its callback to the held one, and an opposite action removes it.
+ */
+- (void)queueActionWithPath:(NSString *)path target:(NSString *)target parameters:(NSDictionary *)parameters
+                   callback:(TMAPICallback)callback {
+    id queuedCallback = callback ? [callback copy] : [NSNull null];
+    NSArray *cancelledCallbacks = nil;
+    BOOL schedulesBatch = NO;
+    NSUInteger batch = 0;
+    
+    @synchronized (self.queuedActions) {
+        NSDictionary *action = self.queuedActions[target];
+        
+        if ([action[@"path"] isEqualToString:path]) {
+            [action[@"callbacks"] addObject:queuedCallback];
+            self.unsentActionCount++;
+        } else if (action) {
+            cancelledCallbacks = [action[@"callbacks"] arrayByAddingObject:queuedCallback];
+            [self.queuedActions removeObjectForKey:target];
+            self.unsentActionCount += [cancelledCallbacks count];
+        } else {
+            self.queuedActions[target] = @{ @"path" : path, @"parameters" : parameters,
+                                            @"callbacks" : [NSMutableArray arrayWithObject:queuedCallback] };
+            
+            if (!self.queuedActionsScheduled) {
+                self.queuedActionsScheduled = YES;
+                schedulesBatch = YES;
+                batch = self.queuedActionBatch;
+            }
+        }
+    }
+    
+    if (cancelledCallbacks) {
+        [self.defaultCallbackQueue addOperationWithBlock:^{
+            for (id cancelledCallback in cancelledCallbacks) {
+                if (cancelledCallback != [NSNull null]) {
+                    ((TMAPICallback)cancelledCallback)(nil, nil);
+                }
+            }
+        }];
+    }
+    
+    if (!schedulesBatch) {
+        return;
+    }
+    
+    dispatch_time_t sendTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.actionBatchingInterval * NSEC_PER_SEC));
+    
+    dispatch_after(sendTime, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSDictionary *actions = nil;
+        
+        // `sendQueuedActions` may have sent this batch already
+        
+        @synchronized (self.queuedActions) {
+            if (self.queuedActionBatch == batch) {
+                actions = [self removeQueuedActions];
+            }
+        }
+        
+        [self sendActions:actions];
+    });
+}
+
+/**
+ Must be called while synchronized on `queuedActions`.
+ */
+- (NSDictionary *)removeQueuedActions {
+    NSDictionary *actions = [self.queuedActions copy];
+    
+    [self.queuedActions removeAllObjects];
+    self.queuedActionBatch++;
+    self.queuedActionsScheduled = NO;
+    
+    return actions;
+}
+
+- (void)sendActions:(NSDictionary *)actions {
+    for (NSString *target in actions) {
+        NSDictionary *action = actions[target];
+        NSArray *callbacks = action[@"callbacks"];
+        
+        JXHTTPOperation *request = [self postRequestWithPath:action[@"path"] parameters:action[@"parameters"]];
+        
+        [self sendRequest:request callback:^(id response, NSError *error) {
+            for (id callback in callbacks) {
+                if (callback != [NSNull null]) {
+                    ((TMAPICallback)callback)(response, error);
+                }
+            }
+        }];
+    }
+}
+
 #pragma mark - Blog
 
 - (void)avatar:(NSString *)blogName size:(NSUInteger)size callback:(TMAPICallback)callback {
     [self avatar:blogName size:size queue:self.defaultCallbackQueue callback:callback];
 }
 
+- (JXHTTPOperation *)avatarRequest:(NSString *)blogName size:(NSUInteger)size {
+    return [self getRequestWithPath:[blogPath(@"avatar", blogName) stringByAppendingFormat:@"/%ld", (long)size]
+                         parameters:nil];
+}
+
 - (void)avatar:(NSString *)blogName size:(NSUInteger)size queue:(NSOperationQueue *)queue callback:(TMAPICallback)callback {
-    JXHTTPOperation *request = [self getRequestWithPath:[blogPath(@"avatar", blogName) stringByAppendingFormat:@"/%ld", (long)size]
-                                             parameters:nil];
+    JXHTTPOperation *request = [self avatarRequest:blogName size:size];
     
     if (callback) {
         __block typeof(callback) blockCallback = callback;
@@ -360,6 +551,50 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
                               parameters:parameters] callback:(TMAPICallback)callback];
 }
 
+#pragma mark - Resumable uploads
+
+- (TMResumableUpload *)resumableUpload:(NSURL *)URL filePath:(NSString *)filePath contentType:(NSString *)contentTypeOrNil
+                              fileName:(NSString *)fileNameOrNil parameters:(NSDictionary *)parameters
+                              callback:(TMAPIUploadCallback)callback {
+    TMResumableUpload *upload = [[TMResumableUpload alloc] initWithFilePath:filePath URL:URL parameters:parameters
+                                                                contentType:contentTypeOrNil fileName:fileNameOrNil
+                                                                chunkLength:self.resumableUploadChunkLength
+                                                                  directory:self.resumableUploadDirectory];
+    [self startUpload:upload callback:callback];
+    
+    return upload;
+}
+
+- (NSArray *)resumePendingUploads:(TMAPIUploadCallback)callback {
+    NSArray *uploads = [TMResumableUpload pendingUploadsInDirectory:self.resumableUploadDirectory];
+    
+    for (TMResumableUpload *upload in uploads) {
+        [self startUpload:upload callback:callback];
+    }
+    
+    return uploads;
+}
+
+- (void)startUpload:(TMResumableUpload *)upload callback:(TMAPIUploadCallback)callback {
+    NSOperationQueue *queue = self.defaultCallbackQueue;
+    
+    upload.requestBlock = ^JXHTTPOperation *(NSURL *URL, NSDictionary *parameters) {
+        return [self multipartPostRequestWithURL:URL parameters:parameters];
+    };
+    
+    upload.completionBlock = ^(TMResumableUpload *finishedUpload, JXHTTPOperation *request, NSError *error) {
+        id response = request ? [self responseForRequest:request error:&error] : nil;
+        
+        if (callback) {
+            [queue addOperationWithBlock:^{
+                callback(finishedUpload, response, error);
+            }];
+        }
+    };
+    
+    [upload startOnQueue:self.queue];
+}
+
 #pragma mark - Tagging
 
 - (JXHTTPOperation *)taggedRequest:(NSString *)tag parameters:(NSDictionary *)parameters {
@@ -373,15 +608,52 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
     [self sendRequest:[self taggedRequest:tag parameters:parameters] callback:callback];
 }
 
+#pragma mark - Cancellation groups
+
+- (TMCancellationToken *)cancellationTokenForOwner:(id)owner {
+    @synchronized (self.ownerTokens) {
+        TMCancellationToken *token = [self.ownerTokens objectForKey:owner];
+        
+        if (!token) {
+            token = [[TMCancellationToken alloc] init];
+            [self.ownerTokens setObject:token forKey:owner];
+        }
+        
+        return token;
+    }
+}
+
+- (void)cancelRequestsForOwner:(id)owner {
+    TMCancellationToken *token = nil;
+    
+    @synchronized (self.ownerTokens) {
+        token = [self.ownerTokens objectForKey:owner];
+        [self.ownerTokens removeObjectForKey:owner];
+    }
+    
+    [token cancel];
+}
+
+#pragma mark - Connections
+
+- (void)prewarmConnections {
+    [self.connectionManager prewarmConnectionsToURL:self.baseURL
+                                              count:TMAPIClientPrewarmedConnectionCount];
+}
+
 #pragma mark - Private
 
 - (JXHTTPOperation *)getRequestWithPath:(NSString *)path parameters:(NSDictionary *)parameters {
     NSMutableDictionary *mutableParameters = [NSMutableDictionary dictionaryWithDictionary:parameters];
     mutableParameters[@"api_key"] = self.OAuthConsumerKey;
     
-    JXHTTPOperation *request = [JXHTTPOperation withURLString:URLWithPath(path) queryParameters:mutableParameters];
+    JXHTTPOperation *request = [JXHTTPOperation withURLString:[self URLStringWithPath:path] queryParameters:mutableParameters];
     request.continuesInAppBackground = YES;
     request.requestTimeoutInterval = self.timeoutInterval;
+    request.connectionManager = self.connectionManager;
+    request.responseCache = self.responseCache;
+    request.responseCacheKey = [NSString stringWithFormat:@"%@ %@", [request.requestURL absoluteString],
+                                self.OAuthToken ?: @""];
     
     [self signRequest:request withParameters:nil];
     
@@ -392,11 +664,15 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
     NSMutableDictionary *mutableParameters = [NSMutableDictionary dictionaryWithDictionary:parameters];
     mutableParameters[@"api_key"] = self.OAuthConsumerKey;
     
-    JXHTTPOperation *request = [JXHTTPOperation withURLString:URLWithPath(path)];
+    JXHTTPOperation *request = [JXHTTPOperation withURLString:[self URLStringWithPath:path]];
     request.requestMethod = @"POST";
     request.continuesInAppBackground = YES;
-    request.requestBody = [JXHTTPFormEncodedBody withDictionary:mutableParameters];
+    JXHTTPFormEncodedBody *body = [JXHTTPFormEncodedBody withDictionary:mutableParameters];
+    body.compressionThreshold = self.requestBodyCompressionThreshold;
+    
+    request.requestBody = body;
     request.requestTimeoutInterval = self.timeoutInterval;
+    request.connectionManager = self.connectionManager;
     
     [self signRequest:request withParameters:mutableParameters];
     
@@ -407,27 +683,12 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
                             filePathArray:(NSArray *)filePathArray contentTypeArray:(NSArray *)contentTypeArray
                             fileNameArray:(NSArray *)fileNameArray {
     NSMutableDictionary *mutableParameters = [NSMutableDictionary dictionaryWithDictionary:parameters];
-    mutableParameters[@"api_key"] = self.OAuthConsumerKey;
     mutableParameters[@"type"] = type;
-
-    JXHTTPOperation *request = [JXHTTPOperation withURLString:URLWithPath(blogPath(@"post", blogName))];
-    request.requestMethod = @"POST";
-    request.continuesInAppBackground = YES;
-    request.requestBody = [self multipartBodyForParameters:mutableParameters filePathArray:filePathArray
-                                          contentTypeArray:contentTypeArray fileNameArray:fileNameArray];
-    request.requestTimeoutInterval = self.timeoutInterval;
     
-    [self signRequest:request withParameters:mutableParameters];
+    JXHTTPOperation *request = [self multipartPostRequestWithURL:[NSURL URLWithString:[self URLStringWithPath:blogPath(@"post", blogName)]]
+                                                      parameters:mutableParameters];
     
-    return request;
-}
-
-- (JXHTTPMultipartBody *)multipartBodyForParameters:(NSDictionary *)parameters filePathArray:(NSArray *)filePathArray
-                                   contentTypeArray:(NSArray *)contentTypeArray fileNameArray:(NSArray *)fileNameArray {
-    NSMutableDictionary *mutableParameters = [NSMutableDictionary dictionaryWithDictionary:parameters];
-    mutableParameters[@"api_key"] = self.OAuthConsumerKey;
-    
-    JXHTTPMultipartBody *multipartBody = [JXHTTPMultipartBody withDictionary:mutableParameters];
+    JXHTTPMultipartBody *multipartBody = (JXHTTPMultipartBody *)request.requestBody;
     
     BOOL multiple = [filePathArray count] > 1;
     
@@ -436,7 +697,24 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
                    contentType:contentTypeArray[index] fileName:fileNameArray[index]];
     }];
     
-    return multipartBody;
+    return request;
+}
+
+- (JXHTTPOperation *)multipartPostRequestWithURL:(NSURL *)URL parameters:(NSDictionary *)parameters {
+    NSMutableDictionary *mutableParameters = [NSMutableDictionary dictionaryWithDictionary:parameters];
+    mutableParameters[@"api_key"] = self.OAuthConsumerKey;
+    
+    JXHTTPOperation *request = [[JXHTTPOperation alloc] initWithURL:URL];
+    request.requestMethod = @"POST";
+    request.continuesInAppBackground = YES;
+    request.priorityClass = JXHTTPOperationPriorityClassBulkUpload;
+    request.requestBody = [JXHTTPMultipartBody withDictionary:mutableParameters];
+    request.requestTimeoutInterval = self.timeoutInterval;
+    request.connectionManager = self.connectionManager;
+    
+    [self signRequest:request withParameters:mutableParameters];
+    
+    return request;
 }
 
 - (void)signRequest:(JXHTTPOperation *)request withParameters:(NSDictionary *)parameters {
@@ -445,10 +723,27 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
     for (NSString *header in self.customHeaders)
         [request setValue:self.customHeaders[header] forRequestHeader:header];
     
-    [request setValue:[TMOAuth headerForURL:request.requestURL method:request.requestMethod postParameters:parameters
-                                      nonce:request.uniqueString consumerKey:self.OAuthConsumerKey
-                             consumerSecret:self.OAuthConsumerSecret token:self.OAuthToken
-                                tokenSecret:self.OAuthTokenSecret] forRequestHeader:@"Authorization"];
+    [request setValue:[[self currentOAuthSigner] headerForURL:request.requestURL method:request.requestMethod
+                                               postParameters:parameters nonce:request.uniqueString]
+     forRequestHeader:@"Authorization"];
+}
+
+// The signer hashes its key once, so it's kept until any of the credentials change
+- (TMOAuthSigner *)currentOAuthSigner {
+    NSString *consumerKey = self.OAuthConsumerKey;
+    NSString *consumerSecret = self.OAuthConsumerSecret;
+    NSString *token = self.OAuthToken;
+    NSString *tokenSecret = self.OAuthTokenSecret;
+    
+    TMOAuthSigner *signer = self.OAuthSigner;
+    
+    if (![signer isSignerForConsumerKey:consumerKey consumerSecret:consumerSecret token:token tokenSecret:tokenSecret]) {
+        signer = [[TMOAuthSigner alloc] initWithConsumerKey:consumerKey consumerSecret:consumerSecret token:token
+                                                tokenSecret:tokenSecret];
+        self.OAuthSigner = signer;
+    }
+    
+    return signer;
 }
 
 - (void)sendRequest:(JXHTTPOperation *)request callback:(TMAPICallback)callback {
@@ -456,33 +751,477 @@ fileNameArray:(NSArray *)fileNameArrayOrNil parameters:(NSDictionary *)parameter
 }
 
 - (void)sendRequest:(JXHTTPOperation *)request queue:(NSOperationQueue *)queue callback:(TMAPICallback)callback {
-    if (callback) {
-        __block typeof(callback) blockCallback = callback;
+    [self sendRequest:request queue:queue token:nil callback:callback];
+}
+
+- (void)sendRequest:(JXHTTPOperation *)request queue:(NSOperationQueue *)queue token:(TMCancellationToken *)token
+           callback:(TMAPICallback)callback {
+    NSString *coalescingKey = [self coalescingKeyForRequest:request];
+    
+    // Attempts keep the retrying request alive, the token only needs to reach it while they're running. A coalesced 
+    // callback is kept alive by the in-flight callbacks until the shared request is done.
+    
+    __block __weak TMRetryingRequest *weakRetryingRequest = nil;
+    __block __weak TMAPICallback weakDeliver = nil;
+    __weak TMAPIClient *weakSelf = self;
+    
+    TMAPICallback deliver = [self callback:callback queue:queue token:token cancellation:^{
+        if (coalescingKey) {
+            [weakSelf detachCoalescedRequest:nil callback:weakDeliver key:coalescingKey];
+        } else {
+            [weakRetryingRequest cancel];
+        }
+    }];
+    
+    weakDeliver = deliver;
+    
+    if (token.error) {
+        return;
+    }
+    
+    if (coalescingKey) {
+        [self sendCoalescedRequest:request key:coalescingKey callback:deliver];
+        return;
+    }
+    
+    TMRetryingRequest *retryingRequest = [self retryingRequestForRequest:request completion:^(JXHTTPOperation *attempt) {
+        NSError *error = attempt.error ?: token.error;
+        id response = error ? nil : [self responseForRequest:attempt error:&error];
         
-        request.didFinishLoadingBlock = ^(JXHTTPOperation *operation) {
-            NSDictionary *response = operation.responseJSON;
-            int statusCode = response[@"meta"] ? [response[@"meta"][@"status"] intValue] : 0;
+        deliver(response, error);
+    }];
+    
+    weakRetryingRequest = retryingRequest;
+    
+    [retryingRequest start];
+}
+
+- (id)responseForRequest:(JXHTTPOperation *)request error:(NSError **)error {
+    NSDictionary *response = [TMJSONDecoder JSONObjectWithData:request.responseData error:nil];
+    int statusCode = response[@"meta"] ? [response[@"meta"][@"status"] intValue] : 0;
+    
+    if (statusCode/100 != 2 && error)
+        *error = [NSError errorWithDomain:@"Request failed" code:statusCode userInfo:nil];
+    
+    return response[@"response"];
+}
+
+/**
+ Wrap a callback so that it is executed at most once, on `queue`, and not at all once the token has been cancelled. If 
+ the token expires first, the callback is executed straight away with the token's error. `cancellation` is performed 
+ when the token is cancelled or expires before the returned block is called, which must happen when the request is done.
+ */
+- (TMAPICallback)callback:(TMAPICallback)callback queue:(NSOperationQueue *)queue token:(TMCancellationToken *)token
+             cancellation:(dispatch_block_t)cancellation {
+    __block TMAPICallback pendingCallback = callback;
+    __block BOOL done = NO;
+    __block id registration = nil;
+    NSObject *lock = [[NSObject alloc] init];
+    
+    TMAPICallback deliver = ^(id response, NSError *error) {
+        TMAPICallback blockCallback = nil;
+        id blockRegistration = nil;
+        
+        @synchronized (lock) {
+            if (done) {
+                return;
+            }
             
-            NSError *error = nil;
+            done = YES;
+            blockCallback = pendingCallback;
+            blockRegistration = registration;
+            pendingCallback = nil;
+            registration = nil;
+        }
+        
+        [token removeCancellationHandler:blockRegistration];
+        
+        if (!blockCallback) {
+            return;
+        }
+        
+        [queue addOperationWithBlock:^{
+            // Cancelling the token while the callback waits on the queue still drops it
             
-            if (statusCode/100 != 2)
-                error = [NSError errorWithDomain:@"Request failed" code:statusCode userInfo:nil];
+            if (![token isCancelled]) {
+                blockCallback(response, error);
+            }
+        }];
+    };
+    
+    if (!token) {
+        return deliver;
+    }
+    
+    __weak TMCancellationToken *weakToken = token;
+    
+    id tokenRegistration = [token addCancellationHandler:^{
+        TMCancellationToken *strongToken = weakToken;
+        
+        if ([strongToken isCancelled]) {
+            @synchronized (lock) {
+                pendingCallback = nil;
+            }
+        }
+        
+        deliver(nil, strongToken.error);
+        
+        if (cancellation) {
+            cancellation();
+        }
+    }];
+    
+    @synchronized (lock) {
+        if (done) {
+            [token removeCancellationHandler:tokenRegistration];
+        } else {
+            registration = tokenRegistration;
+        }
+    }
+    
+    return deliver;
+}
+
+#pragma mark - Coalescing
+
+- (NSString *)coalescingKeyForRequest:(JXHTTPOperation *)request {
+    if (!self.coalescesRequests || !([request.requestMethod length] == 0 || [request.requestMethod isEqualToString:@"GET"])) {
+        return nil;
+    }
+    
+    NSString *path = [request.requestURL path];
+    NSRange versionRange = [path rangeOfString:@"/v2/" options:NSAnchoredSearch];
+    
+    if (versionRange.location != NSNotFound) {
+        path = [path substringFromIndex:NSMaxRange(versionRange)];
+    }
+    
+    if ([self.uncoalescedPathPredicate evaluateWithObject:path]) {
+        return nil;
+    }
+    
+    // Query parameters are always encoded in sorted order, so the URL is already normalized
+    
+    return [NSString stringWithFormat:@"GET %@ %@", [request.requestURL absoluteString], self.OAuthToken ?: @""];
+}
+
+// Patterns are compiled once here rather than for every request that is checked against them
+- (void)setUncoalescedPathPatterns:(NSArray *)uncoalescedPathPatterns {
+    _uncoalescedPathPatterns = [uncoalescedPathPatterns copy];
+    
+    NSMutableArray *predicates = [NSMutableArray arrayWithCapacity:_uncoalescedPathPatterns.count];
+    
+    for (NSString *pattern in _uncoalescedPathPatterns) {
+        [predicates addObject:[NSPredicate predicateWithFormat:@"SELF LIKE %@", pattern]];
+    }
+    
+    self.uncoalescedPathPredicate = predicates.count > 0 ? [NSCompoundPredicate orPredicateWithSubpredicates:predicates] : nil;
+}
+
+- (void)sendCoalescedRequest:(JXHTTPOperation *)request key:(NSString *)key callback:(TMAPICallback)deliver {
+    if ([request isCancelled]) {
+        return;
+    }
+    
+    TMAPICallback callback = [deliver copy];
+    TMRetryingRequest *retryingRequest = nil;
+    
+    __weak TMAPIClient *weakSelf = self;
+    __block __weak TMCoalescedRequest *weakAttachedRequest = nil;
+    TMCoalescedRequest *attachedRequest = nil;
+    
+    @synchronized (self.inFlightCallbacks) {
+        NSMutableArray *callbacks = self.inFlightCallbacks[key];
+        
+        if (callbacks) {
+            self.coalescedRequestCount++;
             
-            [queue addOperationWithBlock:^{
-                blockCallback(response[@"response"], error);
-                blockCallback = nil;
+            // The attached request is never sent, but cancelling it still detaches its callback
+            
+            attachedRequest = [[TMCoalescedRequest alloc] initWithRequest:request cancellationBlock:^{
+                [weakSelf detachCoalescedRequest:weakAttachedRequest callback:callback key:key];
             }];
+        } else {
+            self.uncoalescedRequestCount++;
+            
+            callbacks = [NSMutableArray array];
+            self.inFlightCallbacks[key] = callbacks;
+            self.inFlightRequests[key] = [NSMutableArray array];
+            
+            retryingRequest = [self retryingRequestForRequest:request completion:^(JXHTTPOperation *attempt) {
+                NSError *error = attempt.error;
+                id response = error ? nil : [weakSelf responseForRequest:attempt error:&error];
+                
+                [weakSelf completeCoalescedRequestsForKey:key response:response error:error];
+            }];
+            
+            // Cancelling the request that was sent fails everything attached to it, since no response will arrive
+            
+            __weak TMRetryingRequest *weakRetryingRequest = retryingRequest;
+            
+            attachedRequest = [[TMCoalescedRequest alloc] initWithRequest:request cancellationBlock:^{
+                TMRetryingRequest *strongRetryingRequest = weakRetryingRequest;
+                
+                if ([strongRetryingRequest isCancelled]) {
+                    [strongRetryingRequest cancel];
+                    [weakSelf completeCoalescedRequestsForKey:key response:nil
+                                                        error:[NSError errorWithDomain:NSURLErrorDomain
+                                                                                  code:NSURLErrorCancelled userInfo:nil]];
+                }
+            }];
+        }
+        
+        weakAttachedRequest = attachedRequest;
+        
+        if (callback) {
+            [callbacks addObject:callback];
+        }
+        
+        [self.inFlightRequests[key] addObject:attachedRequest];
+    }
+    
+    [retryingRequest start];
+    [attachedRequest start];
+}
+
+- (void)completeCoalescedRequestsForKey:(NSString *)key response:(id)response error:(NSError *)error {
+    NSArray *callbacks = nil;
+    NSArray *attachedRequests = nil;
+    
+    @synchronized (self.inFlightCallbacks) {
+        callbacks = self.inFlightCallbacks[key];
+        attachedRequests = self.inFlightRequests[key];
+        
+        [self.inFlightCallbacks removeObjectForKey:key];
+        [self.inFlightRequests removeObjectForKey:key];
+    }
+    
+    for (TMAPICallback callback in callbacks) {
+        callback(response, error);
+    }
+    
+    [attachedRequests makeObjectsPerformSelector:@selector(finish)];
+}
+
+- (void)detachCoalescedRequest:(TMCoalescedRequest *)attachedRequest callback:(TMAPICallback)callback key:(NSString *)key {
+    TMCoalescedRequest *sentRequest = nil;
+    
+    @synchronized (self.inFlightCallbacks) {
+        NSMutableArray *callbacks = self.inFlightCallbacks[key];
+        NSUInteger callbackCount = callbacks.count;
+        
+        if (callback) {
+            [callbacks removeObjectIdenticalTo:callback];
+        }
+        
+        if (attachedRequest) {
+            [self.inFlightRequests[key] removeObjectIdenticalTo:attachedRequest];
+        }
+        
+        // The request that was sent is always the first one, and is never detached
+        
+        if (callbackCount > 0 && callbacks.count == 0) {
+            sentRequest = [self.inFlightRequests[key] firstObject];
+        }
+    }
+    
+    // Nothing is waiting on the response any more. Cancelling the sent request fails and finishes whatever is still 
+    // attached to it.
+    
+    [sentRequest.request cancel];
+}
+
+/**
+ Feed the parser whatever part of the response body it hasn't seen yet.
+ */
+static BOOL appendUnparsedData(TMJSONStreamParser *parser, NSData *data) {
+    __block BOOL succeeded = YES;
+    
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        unsigned long long parsedLength = parser.byteCount;
+        
+        if (NSMaxRange(byteRange) > parsedLength) {
+            NSUInteger offset = parsedLength > byteRange.location ? (NSUInteger)(parsedLength - byteRange.location) : 0;
+            
+            *stop = !(succeeded = [parser appendBytes:(const uint8_t *)bytes + offset length:byteRange.length - offset]);
+        }
+    }];
+    
+    return succeeded;
+}
+
+- (void)sendRequest:(JXHTTPOperation *)request elementsAtKeyPath:(NSString *)keyPath queue:(NSOperationQueue *)queue
+       elementBlock:(TMJSONStreamParserElementBlock)elementBlock callback:(TMAPICallback)callback {
+    [self sendRequest:request elementsAtKeyPath:keyPath queue:queue token:nil elementBlock:elementBlock callback:callback];
+}
+
+- (void)sendRequest:(JXHTTPOperation *)request elementsAtKeyPath:(NSString *)keyPath queue:(NSOperationQueue *)queue
+              token:(TMCancellationToken *)token elementBlock:(TMJSONStreamParserElementBlock)elementBlock
+           callback:(TMAPICallback)callback {
+    TMJSONStreamParserElementBlock guardedElementBlock = elementBlock;
+    
+    if (token && elementBlock) {
+        guardedElementBlock = ^(id element) {
+            if (!token.error) {
+                elementBlock(element);
+            }
         };
+    }
+    
+    TMJSONStreamParser *parser = [[TMJSONStreamParser alloc] initWithKeyPath:keyPath elementBlock:guardedElementBlock];
+    
+    __block __weak TMRetryingRequest *weakRetryingRequest = nil;
+    
+    TMAPICallback deliver = [self callback:callback queue:queue token:token cancellation:^{
+        [weakRetryingRequest cancel];
+    }];
+    
+    if (token.error) {
+        return;
+    }
+    
+    TMRetryingRequest *retryingRequest = [self retryingRequestForRequest:request completion:^(JXHTTPOperation *operation) {
+        if (operation.error || token.error) {
+            deliver(nil, operation.error ?: token.error);
+            return;
+        }
         
-        request.didFailBlock = ^(JXHTTPOperation *operation) {
-            [queue addOperationWithBlock:^{
-                blockCallback(nil, operation.error);
-                blockCallback = nil;
-            }];
+        NSError *error = nil;
+        
+        if (operation.responseStatusCode/100 == 2) {
+            if (!appendUnparsedData(parser, operation.responseData) || ![parser finish]) {
+                error = parser.error;
+            } else {
+                // The body's own status has the final say, as it does for responses that aren't streamed
+                
+                [self responseForRequest:operation error:&error];
+            }
+        } else {
+            NSDictionary *response = [TMJSONDecoder JSONObjectWithData:operation.responseData error:nil];
+            int statusCode = response[@"meta"] ? [response[@"meta"][@"status"] intValue] : (int)operation.responseStatusCode;
+            
+            error = [NSError errorWithDomain:@"Request failed" code:statusCode userInfo:nil];
+        }
+        
+        deliver(nil, error);
+    }];
+    
+    weakRetryingRequest = retryingRequest;
+    
+    // Elements that have been handed out can't be taken back, so only the attempt that won the race for a response
+    // feeds the parser, and it isn't retried once it has received part of the body. Data and finish blocks are
+    // performed serially on the operation's block queue, so the parser is never used concurrently.
+    
+    retryingRequest.retriesPartialResponses = NO;
+    retryingRequest.prepareBlock = ^(JXHTTPOperation *attempt) {
+        attempt.didReceiveDataBlock = ^(JXHTTPOperation *operation) {
+            if (operation.responseStatusCode/100 == 2 && operation.responseBuffer && !token.error
+                && [weakRetryingRequest isWinningAttempt:operation]) {
+                appendUnparsedData(parser, [operation.responseBuffer data]);
+            }
         };
+    };
+    
+    [retryingRequest start];
+}
+
+#pragma mark - Retries
+
+- (TMRetryingRequest *)retryingRequestForRequest:(JXHTTPOperation *)request
+                                      completion:(TMRetryingRequestAttemptBlock)completion {
+    NSString *endpoint = endpointKey(request);
+    
+    // The queue's per-endpoint metrics use the same key as the latency history
+    
+    request.metricsKey = endpoint;
+    
+    TMRetryingRequest *retryingRequest = [[TMRetryingRequest alloc] initWithRequest:request queue:self.queue];
+    retryingRequest.maximumRetryCount = self.maximumRetryCount;
+    retryingRequest.retryBackoffInterval = self.retryBackoffInterval;
+    retryingRequest.copyBlock = ^JXHTTPOperation *(JXHTTPOperation *original) {
+        return [self copyOfRequest:original];
+    };
+    
+    // Too few samples make for a noisy percentile, so history is only used once there are enough of them
+    
+    if ([self.latencyHistory sampleCountForKey:endpoint] >= TMAPIClientMinimumLatencySampleCount) {
+        if (self.hedgesRequests) {
+            retryingRequest.hedgeInterval = [self.latencyHistory latencyAtPercentile:0.95 forKey:endpoint];
+        }
+        
+        if (self.adaptsTimeoutIntervals && request.requestTimeoutInterval == self.timeoutInterval) {
+            NSTimeInterval timeoutInterval = [self.latencyHistory latencyAtPercentile:0.99 forKey:endpoint] * 4;
+            request.requestTimeoutInterval = MIN(MAX(timeoutInterval, TMAPIClientMinimumAdaptiveTimeoutInterval),
+                                                 self.timeoutInterval);
+        }
     }
     
-    [self.queue addOperation:request];
+    __weak TMRetryingRequest *weakRetryingRequest = retryingRequest;
+    
+    retryingRequest.completionBlock = ^(JXHTTPOperation *attempt) {
+        TMRetryingRequest *strongRetryingRequest = weakRetryingRequest;
+        
+        // Time to the response headers is what a hedge or timeout waits on, and doesn't grow with the body's length.
+        // The operation's own dates are used, so time spent waiting on the callback queue isn't counted.
+        
+        if (attempt.responseDate && attempt.startDate) {
+            if (attempt.responseStatusCode/100 == 2) {
+                [self.latencyHistory addLatency:[attempt.responseDate timeIntervalSinceDate:attempt.startDate]
+                                         forKey:endpoint];
+            }
+        } else if (attempt.error && attempt.finishDate && ![attempt isCancelled]) {
+            [self.latencyHistory addLatency:attempt.elapsedSeconds forKey:endpoint];
+        }
+        
+        @synchronized (self) {
+            self.retriedRequestCount += strongRetryingRequest.retryCount;
+            self.hedgedRequestCount += strongRetryingRequest.didHedge ? 1 : 0;
+        }
+        
+        completion(attempt);
+    };
+    
+    return retryingRequest;
+}
+
+- (JXHTTPOperation *)copyOfRequest:(JXHTTPOperation *)request {
+    NSDictionary *postParameters = nil;
+    JXHTTPFormEncodedBody *body = nil;
+    
+    // Each attempt gets its own body, since a body's contents and compressed data can change between attempts
+    
+    if ([request.requestBody isKindOfClass:[JXHTTPFormEncodedBody class]]) {
+        JXHTTPFormEncodedBody *originalBody = (JXHTTPFormEncodedBody *)request.requestBody;
+        postParameters = [originalBody.dictionary copy];
+        
+        body = [JXHTTPFormEncodedBody withDictionary:postParameters];
+        body.compressionThreshold = originalBody.compressionThreshold;
+    } else if (request.requestBody) {
+        // Other bodies are signed over parameters that can't be recovered from the body
+        return nil;
+    }
+    
+    NSMutableDictionary *headers = [NSMutableDictionary dictionaryWithDictionary:request.requestHeaders];
+    [headers removeObjectsForKeys:@[ @"If-None-Match", @"If-Modified-Since" ]];
+    
+    JXHTTPOperation *copy = [[JXHTTPOperation alloc] initWithURL:request.requestURL];
+    copy.requestMethod = request.requestMethod;
+    copy.requestBody = body;
+    copy.requestHeaders = headers;
+    copy.requestTimeoutInterval = request.requestTimeoutInterval;
+    copy.continuesInAppBackground = request.continuesInAppBackground;
+    copy.performsBlocksOnMainQueue = request.performsBlocksOnMainQueue;
+    copy.priorityClass = request.priorityClass;
+    copy.connectionManager = request.connectionManager;
+    copy.responseCache = request.responseCache;
+    copy.responseCacheKey = request.responseCacheKey;
+    copy.metricsKey = request.metricsKey;
+    
+    // A fresh nonce and timestamp, so the copy isn't rejected as a replay
+    
+    [self signRequest:copy withParameters:postParameters];
+    
+    return copy;
 }
 
 NSString *blogPath(NSString *ext, NSString *blogName) {
@@ -497,8 +1236,29 @@ NSString *fullBlogName(NSString *blogName) {
     return blogName;
 }
 
-NSString *URLWithPath(NSString *path) {
-    return [@"http://api.tumblr.com/v2/" stringByAppendingString:path];
+- (NSString *)URLStringWithPath:(NSString *)path {
+    return [[self.baseURL absoluteString] stringByAppendingString:path];
+}
+
+NSString *endpointKey(JXHTTPOperation *request) {
+    NSString *path = [request.requestURL path];
+    NSRange versionRange = [path rangeOfString:@"/v2/" options:NSAnchoredSearch];
+    
+    if (versionRange.location != NSNotFound) {
+        path = [path substringFromIndex:NSMaxRange(versionRange)];
+    }
+    
+    // Every blog's copy of an endpoint shares one history
+    
+    NSMutableArray *components = [[path componentsSeparatedByString:@"/"] mutableCopy];
+    
+    if ([components count] > 1 && [components[0] isEqualToString:@"blog"]) {
+        components[1] = @"{blog}";
+    }
+    
+    NSString *method = [request.requestMethod length] > 0 ? [request.requestMethod uppercaseString] : @"GET";
+    
+    return [NSString stringWithFormat:@"%@ %@", method, [components componentsJoinedByString:@"/"]];
 }
 
 #pragma mark - NSObject
@@ -506,8 +1266,27 @@ NSString *URLWithPath(NSString *path) {
 - (id)init {
     if (self = [super init]) {
         self.queue = [[JXHTTPOperationQueue alloc] init];
+        self.queue.adjustsConcurrencyAutomatically = YES;
         self.defaultCallbackQueue = [NSOperationQueue mainQueue];
+        self.baseURL = [NSURL URLWithString:TMAPIClientDefaultBaseURLString];
         self.timeoutInterval = TMAPIClientDefaultRequestTimeoutInterval;
+        self.inFlightCallbacks = [NSMutableDictionary dictionary];
+        self.inFlightRequests = [NSMutableDictionary dictionary];
+        self.ownerTokens = [NSMapTable weakToStrongObjectsMapTable];
+        self.coalescesRequests = YES;
+        self.responseCache = [JXHTTPResponseCache sharedCache];
+        self.maximumRetryCount = TMAPIClientDefaultMaximumRetryCount;
+        self.retryBackoffInterval = TMAPIClientDefaultRetryBackoffInterval;
+        self.hedgesRequests = YES;
+        self.adaptsTimeoutIntervals = YES;
+        self.latencyHistory = [[TMLatencyHistory alloc] init];
+        self.connectionManager = [JXHTTPConnectionManager sharedManager];
+        self.resumableUploadChunkLength = TMAPIClientDefaultResumableUploadChunkLength;
+        self.queuedActions = [NSMutableDictionary dictionary];
+        self.actionBatchingInterval = TMAPIClientDefaultActionBatchingInterval;
+        
+        NSString *cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+        self.resumableUploadDirectory = [cachesPath stringByAppendingPathComponent:@"TMResumableUploads"];
     }
     
     return self;
@@ -0,0 +1,71 @@
+//
+//  TMCancellationToken.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Tells every stage of a piece of work (sending a request, parsing its response, importing the result) that it is no
+ longer wanted, either because it was cancelled or because its deadline passed.
+
+ A token can have child tokens, which are cancelled along with it and never have a later deadline than it. Handlers added
+ with `addCancellationHandler:` are called once, on an arbitrary thread, when the token is cancelled or expires.
+
+ Thread safe.
+ */
+@interface TMCancellationToken : NSObject
+
+/// Date after which the token expires, `nil` if it never does
+@property (nonatomic, strong, readonly) NSDate *deadline;
+
+/// Whether the token or one of its ancestors has been cancelled
+@property (readonly, getter = isCancelled) BOOL cancelled;
+
+/// Whether the deadline has passed without the token having been cancelled
+@property (readonly, getter = isExpired) BOOL expired;
+
+/**
+ `nil` while the work is still wanted, otherwise an `NSURLErrorDomain` error: `NSURLErrorCancelled` if the token was
+ cancelled, `NSURLErrorTimedOut` if it expired.
+ */
+@property (readonly) NSError *error;
+
+/// Seconds left until the deadline, `DBL_MAX` if there is none and 0 once the token is cancelled or expired
+@property (readonly) NSTimeInterval remainingTime;
+
+/// A token that expires a number of seconds from now
++ (instancetype)tokenWithTimeout:(NSTimeInterval)timeout;
+
+/**
+ Create a token.
+
+ @param deadlineOrNil Date after which the token expires
+ */
+- (id)initWithDeadline:(NSDate *)deadlineOrNil;
+
+/**
+ A token that is cancelled when this one is, and expires a number of seconds from now or at this token's deadline,
+ whichever comes first.
+
+ @param timeout Seconds until the child token expires, or 0 to only inherit this token's deadline
+ */
+- (TMCancellationToken *)childTokenWithTimeout:(NSTimeInterval)timeout;
+
+/// Cancel the token and its children. Does nothing if it has already been cancelled or has expired.
+- (void)cancel;
+
+/**
+ Add a block to call when the token is cancelled or expires. It is called straight away if that has already happened.
+
+ @return An object to pass to `removeCancellationHandler:` once the handler is no longer needed
+ */
+- (id)addCancellationHandler:(dispatch_block_t)handler;
+
+/// Remove a handler that hasn't been called yet. Does nothing if it has been, or if `registration` is `nil`.
+- (void)removeCancellationHandler:(id)registration;
+
+@end
@@ -0,0 +1,180 @@
+//
+//  TMCancellationToken.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMCancellationToken.h"
+
+@interface TMCancellationToken()
+
+@property (nonatomic, strong) NSDate *deadline;
+@property (nonatomic, strong) NSMutableDictionary *handlers;
+@property (nonatomic) NSUInteger lastHandlerID;
+@property (nonatomic) BOOL wasCancelled;
+@property (nonatomic) BOOL handlersCalled;
+@property (nonatomic, weak) TMCancellationToken *parent;
+@property (nonatomic, strong) id parentRegistration;
+
+@end
+
+@implementation TMCancellationToken
+
++ (instancetype)tokenWithTimeout:(NSTimeInterval)timeout {
+    return [[self alloc] initWithDeadline:[NSDate dateWithTimeIntervalSinceNow:timeout]];
+}
+
+- (id)init {
+    return [self initWithDeadline:nil];
+}
+
+- (id)initWithDeadline:(NSDate *)deadlineOrNil {
+    if (self = [super init]) {
+        self.deadline = deadlineOrNil;
+        self.handlers = [NSMutableDictionary dictionary];
+
+        if (deadlineOrNil) {
+            __weak TMCancellationToken *weakSelf = self;
+
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX([deadlineOrNil timeIntervalSinceNow], 0) * NSEC_PER_SEC)),
+                           dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [weakSelf callHandlers];
+            });
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_parent removeCancellationHandler:_parentRegistration];
+}
+
+- (TMCancellationToken *)childTokenWithTimeout:(NSTimeInterval)timeout {
+    NSDate *deadline = timeout > 0 ? [NSDate dateWithTimeIntervalSinceNow:timeout] : nil;
+
+    if (self.deadline && (!deadline || [self.deadline compare:deadline] == NSOrderedAscending)) {
+        deadline = self.deadline;
+    }
+
+    TMCancellationToken *child = [[TMCancellationToken alloc] initWithDeadline:deadline];
+    child.parent = self;
+
+    __weak TMCancellationToken *weakSelf = self;
+    __weak TMCancellationToken *weakChild = child;
+
+    child.parentRegistration = [self addCancellationHandler:^{
+        if ([weakSelf isCancelled]) {
+            [weakChild cancel];
+        }
+    }];
+
+    return child;
+}
+
+#pragma mark - State
+
+- (BOOL)isCancelled {
+    @synchronized (self) {
+        return self.wasCancelled;
+    }
+}
+
+- (BOOL)isExpired {
+    @synchronized (self) {
+        return !self.wasCancelled && self.deadline && [self.deadline timeIntervalSinceNow] <= 0;
+    }
+}
+
+- (NSError *)error {
+    if ([self isCancelled]) {
+        return [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+    }
+
+    if ([self isExpired]) {
+        return [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+    }
+
+    return nil;
+}
+
+- (NSTimeInterval)remainingTime {
+    @synchronized (self) {
+        if (self.wasCancelled) {
+            return 0;
+        }
+
+        return self.deadline ? MAX([self.deadline timeIntervalSinceNow], 0) : DBL_MAX;
+    }
+}
+
+#pragma mark - Cancellation
+
+- (void)cancel {
+    @synchronized (self) {
+        if (self.wasCancelled || [self isExpired]) {
+            return;
+        }
+
+        self.wasCancelled = YES;
+    }
+
+    [self callHandlers];
+}
+
+- (id)addCancellationHandler:(dispatch_block_t)handler {
+    if (!handler) {
+        return nil;
+    }
+
+    @synchronized (self) {
+        if (!self.handlersCalled) {
+            NSNumber *registration = @(++self.lastHandlerID);
+            self.handlers[registration] = [handler copy];
+
+            return registration;
+        }
+    }
+
+    handler();
+
+    return nil;
+}
+
+- (void)removeCancellationHandler:(id)registration {
+    if (!registration) {
+        return;
+    }
+
+    @synchronized (self) {
+        [self.handlers removeObjectForKey:registration];
+    }
+}
+
+- (void)callHandlers {
+    NSArray *handlers = nil;
+
+    @synchronized (self) {
+        if (self.handlersCalled) {
+            return;
+        }
+
+        self.handlersCalled = YES;
+
+        handlers = [self.handlers allValues];
+        [self.handlers removeAllObjects];
+    }
+
+    // The parent no longer needs to pass its cancellation on
+
+    [self.parent removeCancellationHandler:self.parentRegistration];
+    self.parentRegistration = nil;
+
+    for (dispatch_block_t handler in handlers) {
+        handler();
+    }
+}
+
+@end
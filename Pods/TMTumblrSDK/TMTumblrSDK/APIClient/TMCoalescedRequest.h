@@ -0,0 +1,33 @@
+//
+//  TMCoalescedRequest.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "JXHTTP.h"
+
+/**
+ Watches a request that shares its response with identical ones for cancellation. A request that was attached to one in 
+ flight instead of being sent is never started, but it stays a handle on the shared request: cancelling it detaches it, 
+ and it is marked finished when the shared request is done.
+ */
+@interface TMCoalescedRequest : NSObject
+
+/// The request that was attached
+@property (nonatomic, strong, readonly) JXHTTPOperation *request;
+
+/**
+ @param request Request that was attached to an identical one in flight
+ @param cancellationBlock Called once if the request is cancelled before `finish`, on the thread that cancelled it
+ */
+- (id)initWithRequest:(JXHTTPOperation *)request cancellationBlock:(dispatch_block_t)cancellationBlock;
+
+/// Start watching the request for cancellation. Calls the cancellation block right away if it was already cancelled.
+- (void)start;
+
+/// Stop watching the request, and mark it finished if it was never started. Does nothing if it was cancelled first.
+- (void)finish;
+
+@end
@@ -0,0 +1,98 @@
+//
+//  TMCoalescedRequest.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMCoalescedRequest.h"
+
+static void *TMCoalescedRequestCancellationContext = &TMCoalescedRequestCancellationContext;
+
+@interface TMCoalescedRequest()
+
+@property (nonatomic, strong) JXHTTPOperation *request;
+@property (nonatomic, copy) dispatch_block_t cancellationBlock;
+@property (nonatomic) BOOL observing;
+@property (nonatomic) BOOL done;
+
+@end
+
+@implementation TMCoalescedRequest
+
+- (id)initWithRequest:(JXHTTPOperation *)request cancellationBlock:(dispatch_block_t)cancellationBlock {
+    if (self = [super init]) {
+        self.request = request;
+        self.cancellationBlock = cancellationBlock;
+    }
+    
+    return self;
+}
+
+- (void)start {
+    @synchronized (self) {
+        if (self.done) {
+            return;
+        }
+        
+        [self.request addObserver:self forKeyPath:@"isCancelled" options:0 context:TMCoalescedRequestCancellationContext];
+        self.observing = YES;
+    }
+    
+    if ([self.request isCancelled]) {
+        [self requestWasCancelled];
+    }
+}
+
+- (void)finish {
+    // A request that was sent finishes on its own, only one that was never started needs marking
+    
+    if ([self stop] && ![self.request isExecuting] && ![self.request isFinished]) {
+        [self.request finish];
+    }
+}
+
+#pragma mark - Private
+
+- (void)requestWasCancelled {
+    if ([self stop] && self.cancellationBlock) {
+        self.cancellationBlock();
+    }
+}
+
+/**
+ Stop observing the request. Returns `NO` if `finish` or a cancellation got there first, so that only one of them acts.
+ */
+- (BOOL)stop {
+    @synchronized (self) {
+        if (self.done) {
+            return NO;
+        }
+        
+        self.done = YES;
+        
+        if (self.observing) {
+            [self.request removeObserver:self forKeyPath:@"isCancelled" context:TMCoalescedRequestCancellationContext];
+            self.observing = NO;
+        }
+        
+        return YES;
+    }
+}
+
+#pragma mark - NSKeyValueObserving
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change
+                       context:(void *)context {
+    if (context != TMCoalescedRequestCancellationContext) {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+        return;
+    }
+    
+    if ([self.request isCancelled]) {
+        [self requestWasCancelled];
+    }
+}
+
+@end
@@ -0,0 +1,42 @@
+//
+//  TMLatencyHistory.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Records the most recent latency samples for each of a set of keys (e.g. API endpoints) and answers percentile queries
+ over them.
+
+ Thread safe.
+ */
+@interface TMLatencyHistory : NSObject
+
+/// Maximum number of samples kept per key. Older samples are discarded first.
+@property (nonatomic, readonly) NSUInteger sampleLimit;
+
+/**
+ Create a latency history.
+
+ @param sampleLimit Maximum number of samples to keep per key
+ */
+- (id)initWithSampleLimit:(NSUInteger)sampleLimit;
+
+- (void)addLatency:(NSTimeInterval)latency forKey:(NSString *)key;
+
+- (NSUInteger)sampleCountForKey:(NSString *)key;
+
+/**
+ @param percentile A number between 0 and 1, e.g. `0.95`
+ @return The smallest recorded latency that at least `percentile` of the samples for the key are less than or equal to,
+ or 0 if there are no samples for the key
+ */
+- (NSTimeInterval)latencyAtPercentile:(double)percentile forKey:(NSString *)key;
+
+- (void)removeAllSamples;
+
+@end
@@ -0,0 +1,95 @@
+//
+//  TMLatencyHistory.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMLatencyHistory.h"
+
+static NSUInteger const TMLatencyHistoryDefaultSampleLimit = 64;
+
+@interface TMLatencyHistory()
+
+@property (nonatomic) NSUInteger sampleLimit;
+@property (nonatomic, strong) NSMutableDictionary *samples;
+
+@end
+
+@implementation TMLatencyHistory
+
+- (id)init {
+    return [self initWithSampleLimit:TMLatencyHistoryDefaultSampleLimit];
+}
+
+- (id)initWithSampleLimit:(NSUInteger)sampleLimit {
+    if (self = [super init]) {
+        self.sampleLimit = MAX(sampleLimit, 1);
+        self.samples = [NSMutableDictionary dictionary];
+    }
+
+    return self;
+}
+
+- (void)addLatency:(NSTimeInterval)latency forKey:(NSString *)key {
+    if (!key || latency < 0) {
+        return;
+    }
+
+    @synchronized (self.samples) {
+        NSMutableArray *samples = self.samples[key];
+
+        if (!samples) {
+            samples = [NSMutableArray arrayWithCapacity:self.sampleLimit];
+            self.samples[key] = samples;
+        }
+
+        if ([samples count] >= self.sampleLimit) {
+            [samples removeObjectAtIndex:0];
+        }
+
+        [samples addObject:@(latency)];
+    }
+}
+
+- (NSUInteger)sampleCountForKey:(NSString *)key {
+    if (!key) {
+        return 0;
+    }
+
+    @synchronized (self.samples) {
+        return [self.samples[key] count];
+    }
+}
+
+- (NSTimeInterval)latencyAtPercentile:(double)percentile forKey:(NSString *)key {
+    if (!key) {
+        return 0;
+    }
+
+    NSArray *samples = nil;
+
+    @synchronized (self.samples) {
+        samples = [self.samples[key] copy];
+    }
+
+    if ([samples count] == 0) {
+        return 0;
+    }
+
+    // Nearest-rank percentile; the sample limit keeps the sort cheap
+
+    NSArray *sortedSamples = [samples sortedArrayUsingSelector:@selector(compare:)];
+    NSUInteger rank = (NSUInteger)ceil(MIN(MAX(percentile, 0), 1) * [sortedSamples count]);
+
+    return [sortedSamples[rank > 0 ? rank - 1 : 0] doubleValue];
+}
+
+- (void)removeAllSamples {
+    @synchronized (self.samples) {
+        [self.samples removeAllObjects];
+    }
+}
+
+@end
@@ -0,0 +1,135 @@
+//
+//  TMResumableUpload.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "JXHTTP.h"
+
+extern NSString * const TMResumableUploadErrorDomain;
+
+typedef NS_ENUM(NSInteger, TMResumableUploadErrorCode) {
+    /// The file changed size or modification date since the upload began
+    TMResumableUploadErrorFileChanged = 1,
+    /// A chunk couldn't be read from the file
+    TMResumableUploadErrorFileUnreadable,
+    /// A chunk wasn't acknowledged by the server, `NSUnderlyingErrorKey` holds the request's error if there was one
+    TMResumableUploadErrorChunkRejected,
+    /// The request block returned a request without a `JXHTTPMultipartBody` to add the chunk to
+    TMResumableUploadErrorInvalidRequest
+};
+
+@class TMResumableUpload;
+
+/**
+ Returns a signed, unstarted POST request to the upload's URL whose body is a `JXHTTPMultipartBody` containing the
+ given parameters. The chunk's bytes are added to the body afterwards. The upload stops with
+ `TMResumableUploadErrorInvalidRequest` if the body is anything else.
+ */
+typedef JXHTTPOperation * (^TMResumableUploadRequestBlock)(NSURL *URL, NSDictionary *parameters);
+
+typedef void (^TMResumableUploadProgressBlock)(TMResumableUpload *upload);
+
+/// Called with the request for the last chunk when the upload succeeded, or `nil` and an error when it stopped
+typedef void (^TMResumableUploadCompletionBlock)(TMResumableUpload *upload, JXHTTPOperation *request, NSError *error);
+
+/**
+ Uploads a file in fixed-size chunks, saving its progress to disk after every chunk the server acknowledges, so that an
+ upload interrupted by a failure or by the app being terminated can carry on from the first unacknowledged chunk instead
+ of from the start of the file.
+
+ Each chunk is sent as a multipart POST to the upload's URL containing the upload's parameters and these fields:
+
+ - `upload_id`: The upload's identifier, the same for every chunk
+ - `offset`: Position of the chunk in the file
+ - `total_length`: Length of the file
+ - `chunk_md5`: Hex MD5 digest of the chunk, for the server to verify
+ - `data`: The chunk's bytes
+
+ Any `2xx` response acknowledges the chunk. The server is expected to accept a chunk it has already acknowledged again
+ without effect, since the acknowledgement itself may have been lost. The response to the last chunk is the result of
+ the upload.
+
+ Chunks are sent one at a time. A chunk that fails to send because of a connection error, a timeout, or a `408`, `429`
+ or `5xx` response is sent again after a randomized exponential backoff, up to `maximumRetryCount` times; past that, or
+ on any other response, the upload stops and its saved progress is kept for a later `startOnQueue:`.
+
+ Thread safe.
+ */
+@interface TMResumableUpload : NSObject
+
+/// Unique identifier, also used as the name of the upload's progress file
+@property (nonatomic, copy, readonly) NSString *identifier;
+
+@property (nonatomic, copy, readonly) NSString *filePath;
+
+/// URL chunks are posted to
+@property (nonatomic, strong, readonly) NSURL *URL;
+
+/// Fields sent along with every chunk. Must only contain property list objects, since they're saved with the progress.
+@property (nonatomic, copy, readonly) NSDictionary *parameters;
+
+@property (nonatomic, copy, readonly) NSString *contentType;
+
+@property (nonatomic, copy, readonly) NSString *fileName;
+
+/// Length of every chunk except the last one
+@property (nonatomic, readonly) NSUInteger chunkLength;
+
+@property (nonatomic, readonly) long long fileLength;
+
+@property (nonatomic, readonly) NSUInteger chunkCount;
+
+/// Number of chunks acknowledged by the server, always the first ones in the file
+@property (readonly) NSUInteger acknowledgedChunkCount;
+
+@property (readonly) long long acknowledgedByteCount;
+
+/// Whether a chunk is being sent or waiting to be sent again
+@property (readonly, getter = isUploading) BOOL uploading;
+
+/// Maximum number of times a single chunk is sent again after a transient failure. Default: 3
+@property (nonatomic) NSUInteger maximumRetryCount;
+
+/// Base of the exponential backoff between retries. Default: 1 second
+@property (nonatomic) NSTimeInterval retryBackoffInterval;
+
+/// Must be set before the upload is started
+@property (nonatomic, copy) TMResumableUploadRequestBlock requestBlock;
+
+/// Called after each acknowledged chunk, on the chunk request's block queue
+@property (nonatomic, copy) TMResumableUploadProgressBlock progressBlock;
+
+/// Called once each time the upload succeeds or stops, on the last request's block queue
+@property (nonatomic, copy) TMResumableUploadCompletionBlock completionBlock;
+
+/**
+ Create a new upload. Nothing is written to disk until it is started.
+
+ @param directory Directory the upload's progress file is saved in
+ */
+- (id)initWithFilePath:(NSString *)filePath URL:(NSURL *)URL parameters:(NSDictionary *)parameters
+           contentType:(NSString *)contentTypeOrNil fileName:(NSString *)fileNameOrNil chunkLength:(NSUInteger)chunkLength
+             directory:(NSString *)directory;
+
+/**
+ Uploads whose progress was saved in a directory and that haven't finished, e.g. when the app was terminated during
+ them. Progress files that can't be read are removed.
+ */
++ (NSArray *)pendingUploadsInDirectory:(NSString *)directory;
+
+/**
+ Send the first unacknowledged chunk and the ones after it, adding each request to a queue. Does nothing if the upload is
+ already in progress or has finished.
+ */
+- (void)startOnQueue:(JXHTTPOperationQueue *)queue;
+
+/// Stop sending chunks, keeping the saved progress. The completion block isn't called.
+- (void)cancel;
+
+/// Stop sending chunks and remove the saved progress
+- (void)discard;
+
+@end
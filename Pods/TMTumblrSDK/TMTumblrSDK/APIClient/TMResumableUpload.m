@@ -0,0 +1,420 @@
+//
+//  TMResumableUpload.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMResumableUpload.h"
+#import <CommonCrypto/CommonDigest.h>
+
+NSString * const TMResumableUploadErrorDomain = @"TMResumableUploadErrorDomain";
+
+static NSUInteger const TMResumableUploadDefaultMaximumRetryCount = 3;
+
+static NSTimeInterval const TMResumableUploadDefaultRetryBackoffInterval = 1;
+
+static NSString * const TMResumableUploadProgressFileExtension = @"plist";
+
+@interface TMResumableUpload()
+
+@property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, copy) NSString *filePath;
+@property (nonatomic, strong) NSURL *URL;
+@property (nonatomic, copy) NSDictionary *parameters;
+@property (nonatomic, copy) NSString *contentType;
+@property (nonatomic, copy) NSString *fileName;
+@property (nonatomic) NSUInteger chunkLength;
+@property (nonatomic) long long fileLength;
+@property (nonatomic) NSTimeInterval fileModificationTime;
+@property (nonatomic, copy) NSString *directory;
+@property NSUInteger acknowledgedChunkCount;
+@property BOOL uploading;
+@property (nonatomic, strong) JXHTTPOperationQueue *queue;
+@property (nonatomic, strong) JXHTTPOperation *currentRequest;
+@property (nonatomic, strong) NSFileHandle *fileHandle;
+@property (nonatomic) NSUInteger chunkRetryCount;
+@property (nonatomic) NSUInteger generation;
+
+@end
+
+static NSString *MD5HexDigest(NSData *data) {
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5([data bytes], (CC_LONG)[data length], digest);
+
+    NSMutableString *hexDigest = [NSMutableString stringWithCapacity:CC_MD5_DIGEST_LENGTH * 2];
+
+    for (NSUInteger i = 0; i < CC_MD5_DIGEST_LENGTH; i++) {
+        [hexDigest appendFormat:@"%02x", digest[i]];
+    }
+
+    return hexDigest;
+}
+
+@implementation TMResumableUpload
+
+- (id)initWithFilePath:(NSString *)filePath URL:(NSURL *)URL parameters:(NSDictionary *)parameters
+           contentType:(NSString *)contentTypeOrNil fileName:(NSString *)fileNameOrNil chunkLength:(NSUInteger)chunkLength
+             directory:(NSString *)directory {
+    if (self = [self init]) {
+        NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:filePath error:nil];
+
+        self.identifier = [[NSProcessInfo processInfo] globallyUniqueString];
+        self.filePath = filePath;
+        self.URL = URL;
+        self.parameters = parameters;
+        self.contentType = contentTypeOrNil;
+        self.fileName = fileNameOrNil;
+        self.chunkLength = MAX(chunkLength, 1);
+        self.fileLength = [attributes[NSFileSize] longLongValue];
+        self.fileModificationTime = [attributes[NSFileModificationDate] timeIntervalSinceReferenceDate];
+        self.directory = directory;
+    }
+
+    return self;
+}
+
+- (id)initWithProgressFile:(NSString *)path {
+    NSDictionary *progress = [NSDictionary dictionaryWithContentsOfFile:path];
+    NSString *URLString = progress[@"URL"];
+
+    if (!progress[@"identifier"] || !progress[@"filePath"] || !URLString || [progress[@"chunkLength"] unsignedIntegerValue] == 0) {
+        return nil;
+    }
+
+    if (self = [self init]) {
+        self.identifier = progress[@"identifier"];
+        self.filePath = progress[@"filePath"];
+        self.URL = [NSURL URLWithString:URLString];
+        self.parameters = progress[@"parameters"];
+        self.contentType = progress[@"contentType"];
+        self.fileName = progress[@"fileName"];
+        self.chunkLength = [progress[@"chunkLength"] unsignedIntegerValue];
+        self.fileLength = [progress[@"fileLength"] longLongValue];
+        self.fileModificationTime = [progress[@"fileModificationTime"] doubleValue];
+        self.acknowledgedChunkCount = [progress[@"acknowledgedChunkCount"] unsignedIntegerValue];
+        self.directory = [path stringByDeletingLastPathComponent];
+    }
+
+    return self;
+}
+
+- (id)init {
+    if (self = [super init]) {
+        self.maximumRetryCount = TMResumableUploadDefaultMaximumRetryCount;
+        self.retryBackoffInterval = TMResumableUploadDefaultRetryBackoffInterval;
+    }
+
+    return self;
+}
+
++ (NSArray *)pendingUploadsInDirectory:(NSString *)directory {
+    NSMutableArray *uploads = [NSMutableArray array];
+
+    for (NSString *name in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:nil]) {
+        if (![[name pathExtension] isEqualToString:TMResumableUploadProgressFileExtension]) {
+            continue;
+        }
+
+        NSString *path = [directory stringByAppendingPathComponent:name];
+        TMResumableUpload *upload = [[self alloc] initWithProgressFile:path];
+
+        if (upload && upload.acknowledgedChunkCount < upload.chunkCount) {
+            [uploads addObject:upload];
+        } else {
+            [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+        }
+    }
+
+    return uploads;
+}
+
+#pragma mark - Progress
+
+- (NSUInteger)chunkCount {
+    // An empty file is still sent as one empty chunk, so that the server sees the upload
+
+    return (NSUInteger)MAX((self.fileLength + self.chunkLength - 1) / self.chunkLength, 1);
+}
+
+- (long long)acknowledgedByteCount {
+    return MIN((long long)self.acknowledgedChunkCount * self.chunkLength, self.fileLength);
+}
+
+- (NSString *)progressFilePath {
+    NSString *name = [self.identifier stringByAppendingPathExtension:TMResumableUploadProgressFileExtension];
+
+    return [self.directory stringByAppendingPathComponent:name];
+}
+
+- (void)saveProgress {
+    NSMutableDictionary *progress = [NSMutableDictionary dictionary];
+    progress[@"identifier"] = self.identifier;
+    progress[@"filePath"] = self.filePath;
+    progress[@"URL"] = [self.URL absoluteString];
+    progress[@"chunkLength"] = @(self.chunkLength);
+    progress[@"fileLength"] = @(self.fileLength);
+    progress[@"fileModificationTime"] = @(self.fileModificationTime);
+    progress[@"acknowledgedChunkCount"] = @(self.acknowledgedChunkCount);
+
+    if (self.parameters) {
+        progress[@"parameters"] = self.parameters;
+    }
+
+    if (self.contentType) {
+        progress[@"contentType"] = self.contentType;
+    }
+
+    if (self.fileName) {
+        progress[@"fileName"] = self.fileName;
+    }
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil
+                                                    error:nil];
+    [progress writeToFile:[self progressFilePath] atomically:YES];
+}
+
+- (void)removeProgress {
+    [[NSFileManager defaultManager] removeItemAtPath:[self progressFilePath] error:nil];
+}
+
+#pragma mark - Uploading
+
+- (void)startOnQueue:(JXHTTPOperationQueue *)queue {
+    @synchronized (self) {
+        if (self.uploading || self.acknowledgedChunkCount >= self.chunkCount) {
+            return;
+        }
+
+        self.uploading = YES;
+        self.queue = queue;
+        self.chunkRetryCount = 0;
+    }
+
+    NSError *error = [self openFile];
+
+    if (error) {
+        [self stopWithRequest:nil error:error];
+        return;
+    }
+
+    [self saveProgress];
+    [self sendNextChunk];
+}
+
+- (void)cancel {
+    JXHTTPOperation *request = nil;
+
+    @synchronized (self) {
+        self.generation++;
+        self.uploading = NO;
+
+        request = self.currentRequest;
+        self.currentRequest = nil;
+
+        [self.fileHandle closeFile];
+        self.fileHandle = nil;
+    }
+
+    [request cancel];
+}
+
+- (void)discard {
+    [self cancel];
+    [self removeProgress];
+}
+
+- (NSError *)openFile {
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.filePath error:nil];
+
+    // Chunks the server has already acknowledged must still be the file's first bytes
+
+    if (!attributes || [attributes[NSFileSize] longLongValue] != self.fileLength
+        || [attributes[NSFileModificationDate] timeIntervalSinceReferenceDate] != self.fileModificationTime) {
+        return [NSError errorWithDomain:TMResumableUploadErrorDomain code:TMResumableUploadErrorFileChanged userInfo:nil];
+    }
+
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:self.filePath];
+
+    if (!fileHandle) {
+        return [NSError errorWithDomain:TMResumableUploadErrorDomain code:TMResumableUploadErrorFileUnreadable userInfo:nil];
+    }
+
+    @synchronized (self) {
+        self.fileHandle = fileHandle;
+    }
+
+    return nil;
+}
+
+- (void)sendNextChunk {
+    NSUInteger index = 0;
+    NSUInteger generation = 0;
+    NSData *chunk = nil;
+
+    long long offset = 0;
+    NSUInteger length = 0;
+
+    @synchronized (self) {
+        if (!self.uploading) {
+            return;
+        }
+
+        index = self.acknowledgedChunkCount;
+        generation = self.generation;
+        offset = (long long)index * self.chunkLength;
+        length = (NSUInteger)MIN((long long)self.chunkLength, self.fileLength - offset);
+
+        [self.fileHandle seekToFileOffset:(unsigned long long)offset];
+        chunk = [self.fileHandle readDataOfLength:length];
+    }
+
+    if ([chunk length] != length) {
+        [self stopWithRequest:nil error:[NSError errorWithDomain:TMResumableUploadErrorDomain
+                                                            code:TMResumableUploadErrorFileUnreadable userInfo:nil]];
+        return;
+    }
+
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionaryWithDictionary:self.parameters];
+    parameters[@"upload_id"] = self.identifier;
+    parameters[@"offset"] = [NSString stringWithFormat:@"%lld", offset];
+    parameters[@"total_length"] = [NSString stringWithFormat:@"%lld", self.fileLength];
+    parameters[@"chunk_md5"] = MD5HexDigest(chunk);
+
+    JXHTTPOperation *request = self.requestBlock(self.URL, parameters);
+    request.priorityClass = JXHTTPOperationPriorityClassBulkUpload;
+
+    // The body can't be swapped for one built here, since the request may already be signed over it
+
+    if (![request.requestBody isKindOfClass:[JXHTTPMultipartBody class]]) {
+        [self stopWithRequest:nil error:[NSError errorWithDomain:TMResumableUploadErrorDomain
+                                                            code:TMResumableUploadErrorInvalidRequest userInfo:nil]];
+        return;
+    }
+
+    [(JXHTTPMultipartBody *)request.requestBody addData:chunk forKey:@"data"
+                                            contentType:self.contentType ?: @"application/octet-stream"
+                                               fileName:self.fileName ?: [self.filePath lastPathComponent]];
+
+    request.didFinishLoadingBlock = ^(JXHTTPOperation *operation) {
+        [self chunkRequestDidFinish:operation index:index generation:generation];
+    };
+
+    request.didFailBlock = ^(JXHTTPOperation *operation) {
+        [self chunkRequestDidFinish:operation index:index generation:generation];
+    };
+
+    @synchronized (self) {
+        if (generation != self.generation) {
+            return;
+        }
+
+        self.currentRequest = request;
+    }
+
+    [self.queue addOperation:request];
+}
+
+- (void)chunkRequestDidFinish:(JXHTTPOperation *)request index:(NSUInteger)index generation:(NSUInteger)generation {
+    BOOL acknowledged = !request.error && request.responseStatusCode/100 == 2;
+    BOOL finished = NO;
+    BOOL retry = NO;
+    NSTimeInterval backoffInterval = 0;
+
+    @synchronized (self) {
+        if (generation != self.generation || !self.uploading) {
+            return;
+        }
+
+        self.currentRequest = nil;
+
+        if (acknowledged) {
+            self.acknowledgedChunkCount = index + 1;
+            self.chunkRetryCount = 0;
+
+            finished = self.acknowledgedChunkCount >= self.chunkCount;
+        } else if (self.chunkRetryCount < self.maximumRetryCount && [self shouldRetryRequest:request]) {
+            self.chunkRetryCount++;
+            retry = YES;
+
+            NSTimeInterval ceiling = self.retryBackoffInterval * pow(2, self.chunkRetryCount - 1);
+            backoffInterval = ceiling * (arc4random_uniform(UINT32_MAX) / (double)UINT32_MAX);
+        }
+    }
+
+    if (finished) {
+        [self removeProgress];
+        [self stopWithRequest:request error:nil];
+    } else if (acknowledged) {
+        [self saveProgress];
+
+        if (self.progressBlock) {
+            self.progressBlock(self);
+        }
+
+        [self sendNextChunk];
+    } else if (retry) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(backoffInterval * NSEC_PER_SEC)),
+                       dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            @synchronized (self) {
+                if (generation != self.generation) {
+                    return;
+                }
+            }
+
+            [self sendNextChunk];
+        });
+    } else {
+        NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+
+        if (request.error) {
+            userInfo[NSUnderlyingErrorKey] = request.error;
+        }
+
+        [self stopWithRequest:nil error:[NSError errorWithDomain:TMResumableUploadErrorDomain
+                                                            code:TMResumableUploadErrorChunkRejected userInfo:userInfo]];
+    }
+}
+
+- (void)stopWithRequest:(JXHTTPOperation *)request error:(NSError *)error {
+    @synchronized (self) {
+        self.uploading = NO;
+
+        [self.fileHandle closeFile];
+        self.fileHandle = nil;
+    }
+
+    if (self.completionBlock) {
+        self.completionBlock(self, request, error);
+    }
+}
+
+- (BOOL)shouldRetryRequest:(JXHTTPOperation *)request {
+    // Chunks are idempotent by design, so unlike other POST requests any transient failure is worth retrying
+
+    if (!request.error) {
+        NSInteger statusCode = request.responseStatusCode;
+
+        return statusCode == 408 || statusCode == 429 || statusCode/100 == 5;
+    }
+
+    if (![request.error.domain isEqualToString:NSURLErrorDomain]) {
+        return NO;
+    }
+
+    switch (request.error.code) {
+        case NSURLErrorCannotFindHost:
+        case NSURLErrorCannotConnectToHost:
+        case NSURLErrorDNSLookupFailed:
+        case NSURLErrorNotConnectedToInternet:
+        case NSURLErrorTimedOut:
+        case NSURLErrorNetworkConnectionLost:
+            return YES;
+
+        default:
+            return NO;
+    }
+}
+
+@end
@@ -0,0 +1,92 @@
+//
+//  TMRetryingRequest.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "JXHTTP.h"
+
+typedef JXHTTPOperation * (^TMRetryingRequestCopyBlock)(JXHTTPOperation *request);
+
+typedef void (^TMRetryingRequestAttemptBlock)(JXHTTPOperation *attempt);
+
+/**
+ Sends a request, sending fresh copies of it again if it fails in a way that is worth retrying, and optionally racing a
+ hedged copy against it if it is slow to respond.
+
+ Retries wait a random interval of up to `retryBackoffInterval * 2^(n-1)` seconds before the nth retry ("full jitter"
+ exponential backoff). Transport errors are retried when the request is idempotent, and for any method when the
+ connection was never established, since the server can't have acted on it. `408`, `429` and `5xx` responses are only
+ retried for idempotent requests.
+
+ A hedged copy is sent at most once, `hedgeInterval` seconds after the first attempt started, if it hasn't received a
+ response by then. Whichever attempt receives a response first wins and the other one is cancelled, so a hedge costs at
+ most one extra request header round trip.
+
+ Cancelling the original request stops any retries and hedges that follow it.
+ */
+@interface TMRetryingRequest : NSObject
+
+/// The first attempt. Its cancellation cancels the whole request.
+@property (nonatomic, strong, readonly) JXHTTPOperation *request;
+
+/// Queue every attempt is added to
+@property (nonatomic, strong, readonly) JXHTTPOperationQueue *queue;
+
+/// Maximum number of times the request is sent again after failing. Default: 0
+@property (nonatomic) NSUInteger maximumRetryCount;
+
+/// Base of the exponential backoff between retries. Default: 0.5 seconds
+@property (nonatomic) NSTimeInterval retryBackoffInterval;
+
+/// Longest wait before any single retry. Default: 30 seconds
+@property (nonatomic) NSTimeInterval maximumRetryBackoffInterval;
+
+/// Seconds to wait for a response before sending a hedged copy of an idempotent request. Default: 0, never hedge
+@property (nonatomic) NSTimeInterval hedgeInterval;
+
+/// Whether an attempt that fails after part of its response body has been received may be retried. Default: `YES`
+@property (nonatomic) BOOL retriesPartialResponses;
+
+/// Returns a fresh, unstarted copy of the request to send as a retry or hedge, or `nil` if it can't be copied
+@property (nonatomic, copy) TMRetryingRequestCopyBlock copyBlock;
+
+/**
+ Called with every attempt, including the first, before it is added to the queue. Must not set the attempt's
+ `didStartBlock`, `didReceiveResponseBlock`, `didFinishLoadingBlock` or `didFailBlock`.
+ */
+@property (nonatomic, copy) TMRetryingRequestAttemptBlock prepareBlock;
+
+/// Called on the winning attempt's block queue when it receives a response that won't be retried. A retry after a
+/// partial response can win again.
+@property (nonatomic, copy) TMRetryingRequestAttemptBlock responseBlock;
+
+/// Called once, on the final attempt's block queue, when it has finished loading or failed and won't be retried
+@property (nonatomic, copy) TMRetryingRequestAttemptBlock completionBlock;
+
+/// Number of retries sent so far
+@property (readonly) NSUInteger retryCount;
+
+/// Whether a hedged copy was sent
+@property (readonly) BOOL didHedge;
+
+/// Whether `cancel` was called or the original request was cancelled
+@property (readonly, getter = isCancelled) BOOL cancelled;
+
+- (id)initWithRequest:(JXHTTPOperation *)request queue:(JXHTTPOperationQueue *)queue;
+
+/// Add the first attempt to the queue
+- (void)start;
+
+/// Cancel every attempt in flight and any retry or hedge waiting to be sent. The completion block isn't called.
+- (void)cancel;
+
+/// Whether an attempt is the one whose response is being used. Attempts have no winner until one receives a response.
+- (BOOL)isWinningAttempt:(JXHTTPOperation *)attempt;
+
+/// Whether a request with this method can be sent more than once without changing its effect
++ (BOOL)isIdempotentMethod:(NSString *)method;
+
+@end
@@ -0,0 +1,309 @@
+//
+//  TMRetryingRequest.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMRetryingRequest.h"
+
+static NSTimeInterval const TMRetryingRequestDefaultBackoffInterval = 0.5;
+
+static NSTimeInterval const TMRetryingRequestDefaultMaximumBackoffInterval = 30;
+
+@interface TMRetryingRequest()
+
+@property (nonatomic, strong) JXHTTPOperation *request;
+@property (nonatomic, strong) JXHTTPOperationQueue *queue;
+@property (nonatomic, strong) NSMutableArray *attempts;
+@property (nonatomic, strong) JXHTTPOperation *winningAttempt;
+@property (nonatomic) BOOL completed;
+@property NSUInteger retryCount;
+@property BOOL didHedge;
+@property BOOL wasCancelled;
+@property BOOL didCancelRequest;
+
+@end
+
+@implementation TMRetryingRequest
+
+- (id)initWithRequest:(JXHTTPOperation *)request queue:(JXHTTPOperationQueue *)queue {
+    if (self = [super init]) {
+        self.request = request;
+        self.queue = queue;
+        self.attempts = [NSMutableArray array];
+        self.maximumRetryCount = 0;
+        self.retryBackoffInterval = TMRetryingRequestDefaultBackoffInterval;
+        self.maximumRetryBackoffInterval = TMRetryingRequestDefaultMaximumBackoffInterval;
+        self.hedgeInterval = 0;
+        self.retriesPartialResponses = YES;
+    }
+
+    return self;
+}
+
+- (void)start {
+    [self sendAttempt:self.request];
+}
+
+- (void)cancel {
+    self.wasCancelled = YES;
+
+    [self.request cancel];
+    [self cancelAttemptsExcept:nil];
+
+    @synchronized (self) {
+        self.completed = YES;
+    }
+}
+
+- (BOOL)isCancelled {
+    // Cancelling a request that has already finished has no effect on it, so retries can't rely on its state alone. A
+    // hedge that wins cancels the original request too, which doesn't cancel the whole request.
+
+    return self.wasCancelled || ([self.request isCancelled] && !self.didCancelRequest);
+}
+
+- (BOOL)isWinningAttempt:(JXHTTPOperation *)attempt {
+    @synchronized (self) {
+        return self.winningAttempt == attempt;
+    }
+}
+
++ (BOOL)isIdempotentMethod:(NSString *)method {
+    static NSSet *idempotentMethods;
+    static dispatch_once_t predicate;
+    dispatch_once(&predicate, ^{
+        idempotentMethods = [NSSet setWithObjects:@"GET", @"HEAD", @"OPTIONS", @"PUT", @"DELETE", nil];
+    });
+
+    return [method length] == 0 || [idempotentMethods containsObject:[method uppercaseString]];
+}
+
+#pragma mark - Attempts
+
+- (void)sendAttempt:(JXHTTPOperation *)attempt {
+    if (self.prepareBlock) {
+        self.prepareBlock(attempt);
+    }
+
+    BOOL first = attempt == self.request;
+
+    // Attempts retain this object through their blocks until they finish or are discarded
+
+    attempt.didStartBlock = ^(JXHTTPOperation *operation) {
+        if (first) {
+            [self scheduleHedgeForAttempt:operation];
+        }
+    };
+
+    attempt.didReceiveResponseBlock = ^(JXHTTPOperation *operation) {
+        [self attemptDidReceiveResponse:operation];
+    };
+
+    attempt.didFinishLoadingBlock = ^(JXHTTPOperation *operation) {
+        [self attemptDidFinish:operation failed:NO];
+    };
+
+    attempt.didFailBlock = ^(JXHTTPOperation *operation) {
+        [self attemptDidFinish:operation failed:YES];
+    };
+
+    @synchronized (self) {
+        [self.attempts addObject:attempt];
+    }
+
+    [self.queue addOperation:attempt];
+}
+
+- (void)attemptDidReceiveResponse:(JXHTTPOperation *)attempt {
+    if ([self isCancelled]) {
+        [self cancelAttemptsExcept:nil];
+        return;
+    }
+
+    // A response that will be retried doesn't win the race, a hedge still in flight may do better
+
+    if ([self shouldRetryStatusCode:attempt.responseStatusCode]) {
+        return;
+    }
+
+    @synchronized (self) {
+        if (self.winningAttempt || self.completed) {
+            return;
+        }
+
+        self.winningAttempt = attempt;
+    }
+
+    [self cancelAttemptsExcept:attempt];
+
+    if (self.responseBlock) {
+        self.responseBlock(attempt);
+    }
+}
+
+- (void)attemptDidFinish:(JXHTTPOperation *)attempt failed:(BOOL)failed {
+    if ([self isCancelled]) {
+        [self cancelAttemptsExcept:nil];
+        return;
+    }
+
+    JXHTTPOperation *retry = nil;
+    NSTimeInterval backoffInterval = 0;
+
+    @synchronized (self) {
+        [self.attempts removeObject:attempt];
+        [self discardBlocksOfAttempt:attempt];
+
+        if (self.completed || (self.winningAttempt && self.winningAttempt != attempt)) {
+            return;
+        }
+
+        // Another attempt is still racing this one, leave the outcome to it
+
+        if (!self.winningAttempt && [self.attempts count] > 0) {
+            return;
+        }
+
+        if (self.retryCount < self.maximumRetryCount && [self shouldRetryAttempt:attempt failed:failed] && self.copyBlock) {
+            retry = self.copyBlock(self.request);
+        }
+
+        if (retry) {
+            self.retryCount++;
+            self.winningAttempt = nil;
+
+            NSTimeInterval ceiling = MIN(self.retryBackoffInterval * pow(2, self.retryCount - 1), self.maximumRetryBackoffInterval);
+            backoffInterval = ceiling * (arc4random_uniform(UINT32_MAX) / (double)UINT32_MAX);
+        } else {
+            self.completed = YES;
+        }
+    }
+
+    if (retry) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(backoffInterval * NSEC_PER_SEC)),
+                       dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            if ([self isCancelled]) {
+                return;
+            }
+
+            [self sendAttempt:retry];
+        });
+
+        return;
+    }
+
+    if (self.completionBlock) {
+        self.completionBlock(attempt);
+    }
+
+    self.prepareBlock = nil;
+    self.responseBlock = nil;
+    self.completionBlock = nil;
+    self.copyBlock = nil;
+}
+
+- (void)scheduleHedgeForAttempt:(JXHTTPOperation *)attempt {
+    if (self.hedgeInterval <= 0 || ![[self class] isIdempotentMethod:self.request.requestMethod]) {
+        return;
+    }
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.hedgeInterval * NSEC_PER_SEC)),
+                   dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        JXHTTPOperation *hedge = nil;
+
+        @synchronized (self) {
+            if (self.didHedge || self.winningAttempt || self.completed || self.retryCount > 0
+                || ![self.attempts containsObject:attempt] || [self isCancelled]) {
+                return;
+            }
+
+            hedge = self.copyBlock ? self.copyBlock(self.request) : nil;
+            self.didHedge = hedge != nil;
+        }
+
+        if (hedge) {
+            [self sendAttempt:hedge];
+        }
+    });
+}
+
+- (void)cancelAttemptsExcept:(JXHTTPOperation *)survivor {
+    NSArray *attempts = nil;
+
+    @synchronized (self) {
+        attempts = [self.attempts copy];
+
+        [self.attempts removeAllObjects];
+
+        if (survivor) {
+            [self.attempts addObject:survivor];
+        }
+    }
+
+    for (JXHTTPOperation *attempt in attempts) {
+        if (attempt != survivor) {
+            // Cancelled operations don't call their blocks, so they're discarded here
+
+            [self discardBlocksOfAttempt:attempt];
+
+            if (attempt == self.request && ![attempt isCancelled]) {
+                self.didCancelRequest = YES;
+            }
+
+            [attempt cancel];
+        }
+    }
+}
+
+- (void)discardBlocksOfAttempt:(JXHTTPOperation *)attempt {
+    attempt.didStartBlock = nil;
+    attempt.didReceiveResponseBlock = nil;
+    attempt.didFinishLoadingBlock = nil;
+    attempt.didFailBlock = nil;
+}
+
+#pragma mark - Retry policy
+
+- (BOOL)shouldRetryAttempt:(JXHTTPOperation *)attempt failed:(BOOL)failed {
+    BOOL idempotent = [[self class] isIdempotentMethod:self.request.requestMethod];
+
+    if (!failed) {
+        return [self shouldRetryStatusCode:attempt.responseStatusCode];
+    }
+
+    if (![attempt.error.domain isEqualToString:NSURLErrorDomain]) {
+        return NO;
+    }
+
+    if (attempt.bytesDownloaded > 0 && !self.retriesPartialResponses) {
+        return NO;
+    }
+
+    switch (attempt.error.code) {
+        case NSURLErrorCannotFindHost:
+        case NSURLErrorCannotConnectToHost:
+        case NSURLErrorDNSLookupFailed:
+        case NSURLErrorNotConnectedToInternet:
+            return YES;
+
+        case NSURLErrorTimedOut:
+        case NSURLErrorNetworkConnectionLost:
+            return idempotent;
+
+        default:
+            return NO;
+    }
+}
+
+- (BOOL)shouldRetryStatusCode:(NSInteger)statusCode {
+    if (![[self class] isIdempotentMethod:self.request.requestMethod]) {
+        return NO;
+    }
+
+    return statusCode == 408 || statusCode == 429 || statusCode/100 == 5;
+}
+
+@end
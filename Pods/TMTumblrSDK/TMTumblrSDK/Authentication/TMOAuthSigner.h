@@ -0,0 +1,67 @@
+//
+//  TMOAuthSigner.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/// Keys of the request dictionaries passed to `-[TMOAuthSigner headersForRequests:]`
+extern NSString * const TMOAuthSignerURLKey;
+extern NSString * const TMOAuthSignerMethodKey;
+extern NSString * const TMOAuthSignerPostParametersKey;
+extern NSString * const TMOAuthSignerNonceKey;
+
+/**
+ Builds the same authentication headers as `TMOAuth`, for one set of credentials. The HMAC-SHA1 key bytes are built
+ once when the signer is created instead of once per request, and each header is built from a single buffer.
+
+ Signers are immutable, so one can be shared between threads.
+ */
+@interface TMOAuthSigner : NSObject
+
+/// OAuth consumer key
+@property (nonatomic, copy, readonly) NSString *consumerKey;
+
+/// OAuth user token
+@property (nonatomic, copy, readonly) NSString *token;
+
+/**
+ Create a signer.
+
+ @param consumerKey OAuth consumer key
+ @param consumerSecret OAuth consumer secret
+ @param token OAuth user token
+ @param tokenSecret OAuth user secret
+ */
+- (id)initWithConsumerKey:(NSString *)consumerKey consumerSecret:(NSString *)consumerSecret token:(NSString *)token
+              tokenSecret:(NSString *)tokenSecret;
+
+/// Whether the signer was created with exactly these credentials
+- (BOOL)isSignerForConsumerKey:(NSString *)consumerKey consumerSecret:(NSString *)consumerSecret token:(NSString *)token
+                   tokenSecret:(NSString *)tokenSecret;
+
+/**
+ Build an authentication header for a Tumblr API request.
+
+ @param URL API request URL
+ @param method HTTP method (GET or POST)
+ @param postParameters POST body parameters
+ @param nonce Unique request identifier
+ */
+- (NSString *)headerForURL:(NSURL *)URL method:(NSString *)method postParameters:(NSDictionary *)postParameters
+                     nonce:(NSString *)nonce;
+
+/**
+ Build authentication headers for several requests at once, sharing one timestamp and one working buffer.
+
+ @param requests Dictionaries with `TMOAuthSignerURLKey`, `TMOAuthSignerMethodKey` and `TMOAuthSignerNonceKey` values,
+ and optionally a `TMOAuthSignerPostParametersKey` value
+
+ @return Header values, in the same order as the requests
+ */
+- (NSArray *)headersForRequests:(NSArray *)requests;
+
+@end
@@ -0,0 +1,184 @@
+//
+//  TMOAuthSigner.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMOAuthSigner.h"
+
+#import <CommonCrypto/CommonHMAC.h>
+#import "TMSDKFunctions.h"
+
+NSString * const TMOAuthSignerURLKey = @"URL";
+NSString * const TMOAuthSignerMethodKey = @"method";
+NSString * const TMOAuthSignerPostParametersKey = @"postParameters";
+NSString * const TMOAuthSignerNonceKey = @"nonce";
+
+static NSUInteger const TMOAuthSignerBufferCapacity = 1024;
+
+// Base64 of a SHA-1 digest: 20 bytes in, 28 characters out, including one `=` of padding
+#define TMOAuthSignatureLength (((CC_SHA1_DIGEST_LENGTH + 2) / 3) * 4)
+
+static const char TMOAuthBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+@interface TMOAuthSigner()
+
+@property (nonatomic, copy) NSString *consumerKey;
+@property (nonatomic, copy) NSString *consumerSecret;
+@property (nonatomic, copy) NSString *token;
+@property (nonatomic, copy) NSString *tokenSecret;
+@property (nonatomic, copy) NSData *key;
+
+NSString *TMOAuthSignerTimestamp(NSDate *date);
+
+void TMOAuthSignerBase64Encode(const uint8_t *bytes, NSUInteger length, char *output);
+
+BOOL TMOAuthSignerStringsEqual(NSString *string, NSString *otherString);
+
+@end
+
+@implementation TMOAuthSigner
+
+- (id)initWithConsumerKey:(NSString *)consumerKey consumerSecret:(NSString *)consumerSecret token:(NSString *)token
+              tokenSecret:(NSString *)tokenSecret {
+    if (self = [super init]) {
+        self.consumerKey = consumerKey;
+        self.consumerSecret = consumerSecret;
+        self.token = token;
+        self.tokenSecret = tokenSecret;
+
+        NSString *keyString = [NSString stringWithFormat:@"%@&%@", consumerSecret, tokenSecret ? tokenSecret : @""];
+        self.key = [keyString dataUsingEncoding:NSUTF8StringEncoding];
+    }
+
+    return self;
+}
+
+- (BOOL)isSignerForConsumerKey:(NSString *)consumerKey consumerSecret:(NSString *)consumerSecret token:(NSString *)token
+                   tokenSecret:(NSString *)tokenSecret {
+    return TMOAuthSignerStringsEqual(self.consumerKey, consumerKey)
+        && TMOAuthSignerStringsEqual(self.consumerSecret, consumerSecret)
+        && TMOAuthSignerStringsEqual(self.token, token)
+        && TMOAuthSignerStringsEqual(self.tokenSecret, tokenSecret);
+}
+
+- (NSString *)headerForURL:(NSURL *)URL method:(NSString *)method postParameters:(NSDictionary *)postParameters
+                     nonce:(NSString *)nonce {
+    NSMutableData *buffer = [[NSMutableData alloc] initWithCapacity:TMOAuthSignerBufferCapacity];
+
+    return [self headerForURL:URL method:method postParameters:postParameters nonce:nonce
+                    timestamp:TMOAuthSignerTimestamp([NSDate date]) buffer:buffer];
+}
+
+- (NSArray *)headersForRequests:(NSArray *)requests {
+    NSMutableArray *headers = [[NSMutableArray alloc] initWithCapacity:requests.count];
+    NSMutableData *buffer = [[NSMutableData alloc] initWithCapacity:TMOAuthSignerBufferCapacity];
+    NSString *timestamp = TMOAuthSignerTimestamp([NSDate date]);
+
+    for (NSDictionary *request in requests) {
+        [headers addObject:[self headerForURL:request[TMOAuthSignerURLKey] method:request[TMOAuthSignerMethodKey]
+                               postParameters:request[TMOAuthSignerPostParametersKey]
+                                        nonce:request[TMOAuthSignerNonceKey] timestamp:timestamp buffer:buffer]];
+    }
+
+    return headers;
+}
+
+#pragma mark - Private
+
+- (NSString *)headerForURL:(NSURL *)URL method:(NSString *)method postParameters:(NSDictionary *)postParameters
+                     nonce:(NSString *)nonce timestamp:(NSString *)timestamp buffer:(NSMutableData *)buffer {
+    NSString *token = self.token.length > 0 ? self.token : nil;
+
+    NSMutableDictionary *signatureParameters = [[NSMutableDictionary alloc] initWithDictionary:@{
+                                                @"oauth_timestamp" : timestamp,
+                                                @"oauth_nonce" : nonce,
+                                                @"oauth_version" : @"1.0",
+                                                @"oauth_signature_method" : @"HMAC-SHA1",
+                                                @"oauth_consumer_key" : self.consumerKey,
+                                                }];
+
+    if (token)
+        signatureParameters[@"oauth_token"] = token;
+
+    [signatureParameters addEntriesFromDictionary:TMQueryStringToDictionary(URL.query)];
+    [signatureParameters addEntriesFromDictionary:postParameters];
+
+    NSString *URLString = [URL absoluteString];
+    NSRange queryRange = [URLString rangeOfString:@"?"];
+    NSString *baseURLString = queryRange.location == NSNotFound ? URLString : [URLString substringToIndex:queryRange.location];
+
+    // Base string: method&encoded URL&encoded parameter string
+    [buffer setLength:0];
+    [buffer appendData:[method dataUsingEncoding:NSUTF8StringEncoding]];
+    [buffer appendBytes:"&" length:1];
+    TMAppendURLEncoded(buffer, baseURLString);
+    [buffer appendBytes:"&" length:1];
+    TMAppendURLEncodedQueryString(buffer, signatureParameters);
+
+    uint8_t digest[CC_SHA1_DIGEST_LENGTH];
+    CCHmacContext context;
+    CCHmacInit(&context, kCCHmacAlgSHA1, [self.key bytes], [self.key length]);
+    CCHmacUpdate(&context, [buffer bytes], [buffer length]);
+    CCHmacFinal(&context, digest);
+
+    char signatureBytes[TMOAuthSignatureLength];
+    TMOAuthSignerBase64Encode(digest, CC_SHA1_DIGEST_LENGTH, signatureBytes);
+
+    NSString *signature = [[NSString alloc] initWithBytes:signatureBytes length:TMOAuthSignatureLength
+                                                 encoding:NSASCIIStringEncoding];
+
+    // The base string is no longer needed, so the header reuses its buffer
+    NSArray *headerKeys = @[@"oauth_consumer_key", @"oauth_nonce", @"oauth_signature", @"oauth_signature_method",
+                            @"oauth_timestamp", @"oauth_token", @"oauth_version"];
+    NSArray *headerValues = @[self.consumerKey, nonce, signature, @"HMAC-SHA1", timestamp, token ?: [NSNull null], @"1.0"];
+
+    [buffer setLength:0];
+    [buffer appendBytes:"OAuth " length:6];
+
+    for (NSUInteger i = 0; i < headerKeys.count; i++) {
+        id value = headerValues[i];
+
+        if (value == [NSNull null])
+            continue;
+
+        if ([buffer length] > 6)
+            [buffer appendBytes:"," length:1];
+
+        [buffer appendData:[headerKeys[i] dataUsingEncoding:NSASCIIStringEncoding]];
+        [buffer appendBytes:"=\"" length:2];
+        TMAppendURLEncoded(buffer, value);
+        [buffer appendBytes:"\"" length:1];
+    }
+
+    return [[NSString alloc] initWithData:buffer encoding:NSUTF8StringEncoding];
+}
+
+NSString *TMOAuthSignerTimestamp(NSDate *date) {
+    return [NSString stringWithFormat:@"%f", round([date timeIntervalSince1970])];
+}
+
+void TMOAuthSignerBase64Encode(const uint8_t *bytes, NSUInteger length, char *output) {
+    for (NSUInteger i = 0; i < length; i += 3) {
+        uint32_t group = (uint32_t)bytes[i] << 16;
+
+        if (i + 1 < length)
+            group |= (uint32_t)bytes[i + 1] << 8;
+
+        if (i + 2 < length)
+            group |= bytes[i + 2];
+
+        *output++ = TMOAuthBase64Alphabet[(group >> 18) & 0x3F];
+        *output++ = TMOAuthBase64Alphabet[(group >> 12) & 0x3F];
+        *output++ = i + 1 < length ? TMOAuthBase64Alphabet[(group >> 6) & 0x3F] : '=';
+        *output++ = i + 2 < length ? TMOAuthBase64Alphabet[group & 0x3F] : '=';
+    }
+}
+
+BOOL TMOAuthSignerStringsEqual(NSString *string, NSString *otherString) {
+    return string == otherString || [string isEqualToString:otherString];
+}
+
+@end
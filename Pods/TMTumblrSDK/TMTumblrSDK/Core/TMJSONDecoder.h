@@ -0,0 +1,36 @@
+//
+//  TMJSONDecoder.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ JSON decoder that returns lazy views instead of fully built object trees.
+
+ Decoding makes a single pass over the document, recording the position of every value in a compact tape. Objects and
+ arrays are returned as `NSDictionary` and `NSArray` subclasses backed by that tape; a value is only turned into an
+ `NSString`, `NSNumber`, `NSNull`, or nested view when it is accessed, and is not cached. Reading a handful of fields out
+ of a large document therefore costs little more than scanning it.
+
+ Views retain the data they were decoded from and are immutable, so they are safe to pass between threads. String
+ contents are scanned 16 bytes at a time where SSE2 or NEON is available.
+
+ The pass validates the document as strictly as `NSJSONSerialization` does: invalid UTF-8, control characters or bad
+ escapes in strings, and numbers that don't follow the JSON grammar or overflow a double all fail the decode.
+ */
+@interface TMJSONDecoder : NSObject
+
+/**
+ Decode a JSON document.
+
+ @param data UTF-8 encoded JSON
+ @param error Set if the document is not well formed
+ @return A lazy `NSDictionary` or `NSArray`, a scalar value, or `nil` if the document is not well formed
+ */
++ (id)JSONObjectWithData:(NSData *)data error:(NSError **)error;
+
+@end
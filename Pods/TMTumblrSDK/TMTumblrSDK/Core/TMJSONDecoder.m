@@ -0,0 +1,789 @@
+//
+//  TMJSONDecoder.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMJSONDecoder.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#import <arm_neon.h>
+#elif defined(__SSE2__)
+#import <emmintrin.h>
+#endif
+
+static NSUInteger const TMJSONDecoderMaximumDepth = 256;
+
+static NSString * const TMJSONDecoderErrorDomain = @"TMJSONDecoderErrorDomain";
+
+typedef NS_ENUM(uint8_t, TMJSONTapeType) {
+    TMJSONTapeTypeObject,
+    TMJSONTapeTypeArray,
+    TMJSONTapeTypeString,
+    TMJSONTapeTypeNumber,
+    TMJSONTapeTypeTrue,
+    TMJSONTapeTypeFalse,
+    TMJSONTapeTypeNull
+};
+
+/**
+ One value in the document. Object members are stored as a key entry immediately followed by its value.
+ */
+typedef struct {
+    uint32_t start;     // Offset of the first byte (after the opening quote, for strings)
+    uint32_t length;    // Number of bytes (excluding quotes, for strings), or number of children, for containers
+    uint32_t next;      // Index of the entry following this value and all of its descendants
+    TMJSONTapeType type;
+    BOOL escaped;       // String contains at least one escape sequence
+} TMJSONTapeEntry;
+
+#pragma mark - Tape
+
+@interface TMJSONTape : NSObject
+
+@property (nonatomic, strong, readonly) NSData *data;
+@property (nonatomic, readonly) const uint8_t *bytes;
+@property (nonatomic, readonly) const TMJSONTapeEntry *entries;
+
+- (id)initWithData:(NSData *)data;
+
+- (BOOL)parse;
+
+- (id)objectForEntryAtIndex:(uint32_t)index;
+
+- (NSString *)stringForEntryAtIndex:(uint32_t)index;
+
+- (BOOL)entryAtIndex:(uint32_t)index isEqualToKey:(NSString *)key bytes:(const char *)bytes length:(NSUInteger)length;
+
+@end
+
+#pragma mark - Views
+
+@interface TMJSONLazyDictionary : NSDictionary
+
+- (id)initWithTape:(TMJSONTape *)tape index:(uint32_t)index;
+
+@end
+
+@interface TMJSONLazyArray : NSArray
+
+- (id)initWithTape:(TMJSONTape *)tape index:(uint32_t)index;
+
+@end
+
+#pragma mark - Scanning
+
+/**
+ Return the offset of the first quote, backslash or control character in the given bytes, or `length` if there isn't
+ one. Control characters aren't allowed in strings unescaped, so any of them ends the string too.
+ */
+static inline NSUInteger TMJSONFindStringDelimiter(const uint8_t *bytes, NSUInteger length) {
+    NSUInteger i = 0;
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    uint8x16_t quote = vdupq_n_u8('"');
+    uint8x16_t backslash = vdupq_n_u8('\\');
+    uint8x16_t space = vdupq_n_u8(0x20);
+
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t block = vld1q_u8(bytes + i);
+        uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(block, quote), vceqq_u8(block, backslash)),
+                                      vcltq_u8(block, space));
+        uint8x8_t folded = vorr_u8(vget_low_u8(matches), vget_high_u8(matches));
+
+        if (vget_lane_u64(vreinterpret_u64_u8(folded), 0)) {
+            break;
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i quote = _mm_set1_epi8('"');
+    __m128i backslash = _mm_set1_epi8('\\');
+    __m128i lastControl = _mm_set1_epi8(0x1F);
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(bytes + i));
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(block, lastControl), block);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                                               _mm_cmpeq_epi8(block, backslash)), control));
+
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; i < length; i++) {
+        if (bytes[i] == '"' || bytes[i] == '\\' || bytes[i] < 0x20) {
+            return i;
+        }
+    }
+
+    return length;
+}
+
+/**
+ Whether the bytes are well formed UTF-8: no overlong forms, surrogates, or code points past U+10FFFF.
+ */
+static BOOL TMJSONIsValidUTF8(const uint8_t *bytes, NSUInteger length) {
+    NSUInteger i = 0;
+
+    while (i < length) {
+        // Runs of ASCII are skipped eight bytes at a time
+
+        if (i + 8 <= length) {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(word));
+
+            if (!(word & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        uint8_t byte = bytes[i];
+
+        if (byte < 0x80) {
+            i++;
+            continue;
+        }
+
+        NSUInteger continuationCount;
+        uint8_t minimum = 0x80;
+        uint8_t maximum = 0xBF;
+
+        if (byte >= 0xC2 && byte <= 0xDF) {
+            continuationCount = 1;
+        } else if (byte >= 0xE0 && byte <= 0xEF) {
+            continuationCount = 2;
+            minimum = byte == 0xE0 ? 0xA0 : 0x80;
+            maximum = byte == 0xED ? 0x9F : 0xBF;
+        } else if (byte >= 0xF0 && byte <= 0xF4) {
+            continuationCount = 3;
+            minimum = byte == 0xF0 ? 0x90 : 0x80;
+            maximum = byte == 0xF4 ? 0x8F : 0xBF;
+        } else {
+            return NO;
+        }
+
+        if (i + continuationCount >= length || bytes[i + 1] < minimum || bytes[i + 1] > maximum) {
+            return NO;
+        }
+
+        for (NSUInteger j = 2; j <= continuationCount; j++) {
+            if ((bytes[i + j] & 0xC0) != 0x80) {
+                return NO;
+            }
+        }
+
+        i += continuationCount + 1;
+    }
+
+    return YES;
+}
+
+static inline int TMJSONHexValue(uint8_t character) {
+    if (character >= '0' && character <= '9') {
+        return character - '0';
+    } else if (character >= 'a' && character <= 'f') {
+        return character - 'a' + 10;
+    } else if (character >= 'A' && character <= 'F') {
+        return character - 'A' + 10;
+    }
+
+    return -1;
+}
+
+static inline BOOL TMJSONIsWhitespace(uint8_t character) {
+    return character == ' ' || character == '\n' || character == '\r' || character == '\t';
+}
+
+@implementation TMJSONTape {
+    TMJSONTapeEntry *_entries;
+    uint32_t _count;
+    uint32_t _capacity;
+    NSUInteger _position;
+    NSUInteger _length;
+}
+
+- (void)dealloc {
+    free(_entries);
+}
+
+- (id)initWithData:(NSData *)data {
+    if (self = [super init]) {
+        _data = data;
+        _bytes = [data bytes];
+        _length = [data length];
+    }
+
+    return self;
+}
+
+- (const TMJSONTapeEntry *)entries {
+    return _entries;
+}
+
+#pragma mark - Parsing
+
+- (BOOL)parse {
+    if (_length >= UINT32_MAX || !TMJSONIsValidUTF8(_bytes, _length)) {
+        return NO;
+    }
+
+    // A generous first guess avoids most reallocations; roughly one value per eight bytes for typical API responses
+
+    _capacity = (uint32_t)MAX(_length / 8, 16);
+    _entries = malloc(_capacity * sizeof(TMJSONTapeEntry));
+
+    if (!_entries || ![self parseValueAtDepth:0]) {
+        return NO;
+    }
+
+    [self skipWhitespace];
+
+    return _position == _length;
+}
+
+- (uint32_t)appendEntryWithType:(TMJSONTapeType)type start:(NSUInteger)start {
+    if (_count == _capacity) {
+        uint32_t capacity = _capacity * 2;
+        TMJSONTapeEntry *entries = realloc(_entries, capacity * sizeof(TMJSONTapeEntry));
+
+        if (!entries) {
+            return UINT32_MAX;
+        }
+
+        _entries = entries;
+        _capacity = capacity;
+    }
+
+    _entries[_count] = (TMJSONTapeEntry){ .start = (uint32_t)start, .length = 0, .next = _count + 1, .type = type,
+                                          .escaped = NO };
+
+    return _count++;
+}
+
+- (void)skipWhitespace {
+    while (_position < _length && TMJSONIsWhitespace(_bytes[_position])) {
+        _position++;
+    }
+}
+
+- (BOOL)parseValueAtDepth:(NSUInteger)depth {
+    [self skipWhitespace];
+
+    if (_position == _length) {
+        return NO;
+    }
+
+    switch (_bytes[_position]) {
+        case '{':
+        case '[':
+            return depth < TMJSONDecoderMaximumDepth && [self parseContainerAtDepth:depth];
+        case '"':
+            return [self parseString];
+        case 't':
+            return [self parseLiteral:"true" length:4 type:TMJSONTapeTypeTrue];
+        case 'f':
+            return [self parseLiteral:"false" length:5 type:TMJSONTapeTypeFalse];
+        case 'n':
+            return [self parseLiteral:"null" length:4 type:TMJSONTapeTypeNull];
+        default:
+            return [self parseNumber];
+    }
+}
+
+- (BOOL)parseContainerAtDepth:(NSUInteger)depth {
+    BOOL isObject = _bytes[_position] == '{';
+    uint8_t terminator = isObject ? '}' : ']';
+
+    uint32_t index = [self appendEntryWithType:isObject ? TMJSONTapeTypeObject : TMJSONTapeTypeArray start:_position];
+    if (index == UINT32_MAX) {
+        return NO;
+    }
+
+    _position++;
+    [self skipWhitespace];
+
+    uint32_t childCount = 0;
+
+    if (_position < _length && _bytes[_position] == terminator) {
+        _position++;
+    } else {
+        while (YES) {
+            if (isObject) {
+                [self skipWhitespace];
+
+                if (_position == _length || _bytes[_position] != '"' || ![self parseString]) {
+                    return NO;
+                }
+
+                [self skipWhitespace];
+
+                if (_position == _length || _bytes[_position++] != ':') {
+                    return NO;
+                }
+            }
+
+            if (![self parseValueAtDepth:depth + 1]) {
+                return NO;
+            }
+
+            childCount++;
+
+            [self skipWhitespace];
+
+            if (_position == _length) {
+                return NO;
+            }
+
+            uint8_t character = _bytes[_position++];
+
+            if (character == terminator) {
+                break;
+            } else if (character != ',') {
+                return NO;
+            }
+        }
+    }
+
+    _entries[index].length = childCount;
+    _entries[index].next = _count;
+
+    return YES;
+}
+
+- (BOOL)parseString {
+    NSUInteger start = ++_position;
+    BOOL escaped = NO;
+
+    while (YES) {
+        if (_position >= _length) {
+            return NO;
+        }
+
+        _position += TMJSONFindStringDelimiter(_bytes + _position, _length - _position);
+
+        if (_position == _length) {
+            return NO;
+        }
+
+        if (_bytes[_position] == '"') {
+            break;
+        }
+
+        if (_bytes[_position] != '\\' || ![self skipEscape]) {
+            return NO;
+        }
+
+        escaped = YES;
+    }
+
+    uint32_t index = [self appendEntryWithType:TMJSONTapeTypeString start:start];
+    if (index == UINT32_MAX) {
+        return NO;
+    }
+
+    _entries[index].length = (uint32_t)(_position - start);
+    _entries[index].escaped = escaped;
+
+    _position++;
+
+    return YES;
+}
+
+/**
+ Skip the escape sequence at the current position, which must be a backslash. A `\\u` escape of a UTF-16 surrogate has
+ to be one half of a pair, as `NSJSONSerialization` requires.
+ */
+- (BOOL)skipEscape {
+    if (_position + 1 >= _length) {
+        return NO;
+    }
+
+    switch (_bytes[_position + 1]) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            _position += 2;
+            return YES;
+        case 'u':
+            break;
+        default:
+            return NO;
+    }
+
+    int codeUnit = [self codeUnitAtPosition:_position];
+
+    if (codeUnit < 0 || (codeUnit >= 0xDC00 && codeUnit <= 0xDFFF)) {
+        return NO;
+    }
+
+    _position += 6;
+
+    if (codeUnit >= 0xD800 && codeUnit <= 0xDBFF) {
+        int lowSurrogate = [self codeUnitAtPosition:_position];
+
+        if (lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF) {
+            return NO;
+        }
+
+        _position += 6;
+    }
+
+    return YES;
+}
+
+/**
+ The code unit of a `\\uXXXX` escape starting at a position, or -1 if there isn't a well formed one there.
+ */
+- (int)codeUnitAtPosition:(NSUInteger)position {
+    if (_length - position < 6 || _bytes[position] != '\\' || _bytes[position + 1] != 'u') {
+        return -1;
+    }
+
+    int codeUnit = 0;
+
+    for (NSUInteger i = position + 2; i < position + 6; i++) {
+        int value = TMJSONHexValue(_bytes[i]);
+
+        if (value < 0) {
+            return -1;
+        }
+
+        codeUnit = codeUnit << 4 | value;
+    }
+
+    return codeUnit;
+}
+
+- (BOOL)parseLiteral:(const char *)literal length:(NSUInteger)length type:(TMJSONTapeType)type {
+    if (_length - _position < length || memcmp(_bytes + _position, literal, length) != 0) {
+        return NO;
+    }
+
+    if ([self appendEntryWithType:type start:_position] == UINT32_MAX) {
+        return NO;
+    }
+
+    _position += length;
+
+    return YES;
+}
+
+/**
+ Numbers must follow the JSON grammar exactly: an optional minus sign, an integer part without leading zeros, then an
+ optional fraction and exponent, each with at least one digit.
+ */
+- (BOOL)parseNumber {
+    NSUInteger start = _position;
+
+    if (_position < _length && _bytes[_position] == '-') {
+        _position++;
+    }
+
+    if (_position < _length && _bytes[_position] == '0') {
+        _position++;
+    } else if (![self skipDigits]) {
+        return NO;
+    }
+
+    BOOL simple = YES;
+
+    if (_position < _length && _bytes[_position] == '.') {
+        _position++;
+        simple = NO;
+
+        if (![self skipDigits]) {
+            return NO;
+        }
+    }
+
+    if (_position < _length && (_bytes[_position] == 'e' || _bytes[_position] == 'E')) {
+        _position++;
+        simple = NO;
+
+        if (_position < _length && (_bytes[_position] == '+' || _bytes[_position] == '-')) {
+            _position++;
+        }
+
+        if (![self skipDigits]) {
+            return NO;
+        }
+    }
+
+    uint32_t index = [self appendEntryWithType:TMJSONTapeTypeNumber start:start];
+    if (index == UINT32_MAX) {
+        return NO;
+    }
+
+    _entries[index].length = (uint32_t)(_position - start);
+
+    // Only numbers that could overflow need converting now, so that they fail the parse rather than a later access
+
+    return simple && _position - start < 19 ? YES : [self numberForEntry:&_entries[index]] != nil;
+}
+
+- (BOOL)skipDigits {
+    NSUInteger start = _position;
+
+    while (_position < _length && _bytes[_position] >= '0' && _bytes[_position] <= '9') {
+        _position++;
+    }
+
+    return _position > start;
+}
+
+#pragma mark - Materializing
+
+- (id)objectForEntryAtIndex:(uint32_t)index {
+    const TMJSONTapeEntry *entry = &_entries[index];
+
+    switch (entry->type) {
+        case TMJSONTapeTypeObject:
+            return [[TMJSONLazyDictionary alloc] initWithTape:self index:index];
+        case TMJSONTapeTypeArray:
+            return [[TMJSONLazyArray alloc] initWithTape:self index:index];
+        case TMJSONTapeTypeString:
+            return [self stringForEntryAtIndex:index] ?: [NSNull null];
+        case TMJSONTapeTypeNumber:
+            return [self numberForEntry:entry] ?: [NSNull null];
+        case TMJSONTapeTypeTrue:
+            return @YES;
+        case TMJSONTapeTypeFalse:
+            return @NO;
+        case TMJSONTapeTypeNull:
+            return [NSNull null];
+    }
+
+    return nil;
+}
+
+- (NSString *)stringForEntryAtIndex:(uint32_t)index {
+    const TMJSONTapeEntry *entry = &_entries[index];
+
+    if (!entry->escaped) {
+        return [[NSString alloc] initWithBytes:_bytes + entry->start length:entry->length encoding:NSUTF8StringEncoding];
+    }
+
+    // Escapes are rare enough in practice to leave to the system parser, quotes included
+
+    NSData *quoted = [[NSData alloc] initWithBytesNoCopy:(void *)(_bytes + entry->start - 1) length:entry->length + 2
+                                            freeWhenDone:NO];
+
+    id string = [NSJSONSerialization JSONObjectWithData:quoted options:NSJSONReadingAllowFragments error:nil];
+
+    return [string isKindOfClass:[NSString class]] ? string : nil;
+}
+
+/**
+ The number in an entry, or `nil` if it is out of range for a double.
+ */
+- (NSNumber *)numberForEntry:(const TMJSONTapeEntry *)entry {
+    char stackBuffer[64];
+    char *buffer = entry->length < sizeof(stackBuffer) ? stackBuffer : malloc(entry->length + 1);
+
+    if (!buffer) {
+        return nil;
+    }
+
+    memcpy(buffer, _bytes + entry->start, entry->length);
+    buffer[entry->length] = '\0';
+
+    NSNumber *number = nil;
+    char *end = NULL;
+
+    if (!memchr(buffer, '.', entry->length) && !memchr(buffer, 'e', entry->length) && !memchr(buffer, 'E', entry->length)) {
+        errno = 0;
+        long long value = strtoll(buffer, &end, 10);
+
+        if (*end == '\0' && errno == 0) {
+            number = @(value);
+        }
+    }
+
+    if (!number) {
+        double value = strtod(buffer, &end);
+
+        if (*end == '\0' && isfinite(value)) {
+            number = @(value);
+        }
+    }
+
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+
+    return number;
+}
+
+- (BOOL)entryAtIndex:(uint32_t)index isEqualToKey:(NSString *)key bytes:(const char *)bytes length:(NSUInteger)length {
+    const TMJSONTapeEntry *entry = &_entries[index];
+
+    if (entry->escaped) {
+        return [[self stringForEntryAtIndex:index] isEqualToString:key];
+    }
+
+    return entry->length == length && memcmp(bytes, _bytes + entry->start, length) == 0;
+}
+
+@end
+
+#pragma mark - TMJSONLazyDictionary
+
+@implementation TMJSONLazyDictionary {
+    TMJSONTape *_tape;
+    uint32_t _index;
+}
+
+- (id)initWithTape:(TMJSONTape *)tape index:(uint32_t)index {
+    if (self = [super init]) {
+        _tape = tape;
+        _index = index;
+    }
+
+    return self;
+}
+
+- (NSUInteger)count {
+    return _tape.entries[_index].length;
+}
+
+- (id)objectForKey:(id)key {
+    if (![key isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+
+    // The key's bytes are looked up once, and most entries are then ruled out by their length alone
+
+    const char *keyBytes = [key UTF8String];
+
+    if (!keyBytes) {
+        return nil;
+    }
+
+    NSUInteger keyLength = strlen(keyBytes);
+    const TMJSONTapeEntry *entries = _tape.entries;
+    uint32_t end = entries[_index].next;
+
+    for (uint32_t keyIndex = _index + 1; keyIndex < end; keyIndex = entries[keyIndex + 1].next) {
+        if ([_tape entryAtIndex:keyIndex isEqualToKey:key bytes:keyBytes length:keyLength]) {
+            return [_tape objectForEntryAtIndex:keyIndex + 1];
+        }
+    }
+
+    return nil;
+}
+
+- (NSEnumerator *)keyEnumerator {
+    const TMJSONTapeEntry *entries = _tape.entries;
+    uint32_t end = entries[_index].next;
+
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:[self count]];
+
+    for (uint32_t keyIndex = _index + 1; keyIndex < end; keyIndex = entries[keyIndex + 1].next) {
+        NSString *key = [_tape stringForEntryAtIndex:keyIndex];
+
+        if (key) {
+            [keys addObject:key];
+        }
+    }
+
+    return [keys objectEnumerator];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+@end
+
+#pragma mark - TMJSONLazyArray
+
+@implementation TMJSONLazyArray {
+    TMJSONTape *_tape;
+    uint32_t *_childIndexes;
+    uint32_t _count;
+}
+
+- (void)dealloc {
+    free(_childIndexes);
+}
+
+- (id)initWithTape:(TMJSONTape *)tape index:(uint32_t)index {
+    if (self = [super init]) {
+        _tape = tape;
+
+        // Children are found up front so that random access doesn't have to walk the tape
+
+        const TMJSONTapeEntry *entries = tape.entries;
+        _count = entries[index].length;
+        _childIndexes = malloc(MAX(_count, 1) * sizeof(uint32_t));
+
+        if (!_childIndexes) {
+            return nil;
+        }
+
+        uint32_t childIndex = index + 1;
+
+        for (uint32_t i = 0; i < _count; i++) {
+            _childIndexes[i] = childIndex;
+            childIndex = entries[childIndex].next;
+        }
+    }
+
+    return self;
+}
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"Index %lu beyond bounds [0 .. %lu]", (unsigned long)index,
+                                                   (unsigned long)_count];
+    }
+
+    return [_tape objectForEntryAtIndex:_childIndexes[index]];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+@end
+
+#pragma mark - TMJSONDecoder
+
+@implementation TMJSONDecoder
+
++ (id)JSONObjectWithData:(NSData *)data error:(NSError **)error {
+    // Views point into the data, so it must not change underneath them
+
+    if ([data isKindOfClass:[NSMutableData class]]) {
+        data = [data copy];
+    }
+
+    TMJSONTape *tape = [[TMJSONTape alloc] initWithData:data];
+
+    if (![data length] || ![tape parse]) {
+        if (error) {
+            *error = [NSError errorWithDomain:TMJSONDecoderErrorDomain code:0
+                                     userInfo:@{ NSLocalizedDescriptionKey : @"The data is not well formed JSON" }];
+        }
+
+        return nil;
+    }
+
+    return [tape objectForEntryAtIndex:0];
+}
+
+@end
@@ -0,0 +1,65 @@
+//
+//  TMJSONStreamParser.h
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+typedef void (^TMJSONStreamParserElementBlock)(id element);
+
+/**
+ Push-style JSON parser that emits each element of a single array inside a document as soon as that element has been
+ fully received, without waiting for (or building objects for) the rest of the document.
+
+ Bytes are fed in as they arrive using `appendBytes:length:`. The parser only scans the structure of the document
+ outside of the target array; each element is decoded with `TMJSONDecoder` once its closing byte is seen.
+ Parts of the document outside of the emitted elements are only checked structurally: the document must be a single
+ object or array made of balanced brackets, strings and literals.
+
+ Not thread safe. Bytes must be appended serially and in order, and the element block is called synchronously from
+ `appendBytes:length:`.
+ */
+@interface TMJSONStreamParser : NSObject
+
+/// Dot-separated object keys leading to the target array, e.g. `response.posts`. An empty key path targets a root array.
+@property (nonatomic, copy, readonly) NSString *keyPath;
+
+/// Number of elements emitted so far
+@property (nonatomic, readonly) NSUInteger elementCount;
+
+/// Number of bytes consumed so far
+@property (nonatomic, readonly) unsigned long long byteCount;
+
+/// The error that stopped the parser, if any. Once set, further bytes are ignored.
+@property (nonatomic, strong, readonly) NSError *error;
+
+/**
+ Create a parser.
+
+ @param keyPath Dot-separated object keys leading to the array whose elements should be emitted
+ @param elementBlock Called with each element of the target array, in order
+ */
+- (id)initWithKeyPath:(NSString *)keyPath elementBlock:(TMJSONStreamParserElementBlock)elementBlock;
+
+/**
+ Feed the next bytes of the document to the parser.
+
+ @return `NO` if the parser has failed, in which case `error` is set
+ */
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length;
+
+/// Feed the next bytes of the document to the parser, one contiguous range at a time.
+- (BOOL)appendData:(NSData *)data;
+
+/**
+ Signal the end of the document.
+
+ @return `NO` if the parser has failed, the document was incomplete, or the target array never appeared in it, in which
+ case `error` is set
+ */
+- (BOOL)finish;
+
+@end
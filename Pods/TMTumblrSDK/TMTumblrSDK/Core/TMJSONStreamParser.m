@@ -0,0 +1,291 @@
+//
+//  TMJSONStreamParser.m
+//  TMTumblrSDK
+//
+//  Created by agent on 10/18/26.
+//  Copyright (c) 2026 Tumblr. All rights reserved.
+//
+
+#import "TMJSONStreamParser.h"
+#import "TMJSONDecoder.h"
+
+static NSUInteger const TMJSONStreamParserMaximumDepth = 256;
+
+static NSString * const TMJSONStreamParserErrorDomain = @"TMJSONStreamParserErrorDomain";
+
+// Bytes that can appear outside of strings in numbers, `true`, `false` and `null`
+static const bool TMJSONStreamParserLiteralBytes[256] = {
+    ['0' ... '9'] = true, ['-'] = true, ['+'] = true, ['.'] = true, ['e'] = true, ['E'] = true,
+    ['t'] = true, ['r'] = true, ['u'] = true, ['f'] = true, ['a'] = true, ['l'] = true, ['s'] = true, ['n'] = true
+};
+
+typedef struct {
+    uint8_t type;       // '{' or '['
+    BOOL onPath;        // Every ancestor key matched the corresponding key path component
+    BOOL expectingKey;  // Next string in this object is a key
+    BOOL keyMatched;    // Most recent key in this object matched the next key path component
+} TMJSONStreamFrame;
+
+@interface TMJSONStreamParser()
+
+@property (nonatomic, copy) NSString *keyPath;
+@property (nonatomic) NSUInteger elementCount;
+@property (nonatomic) unsigned long long byteCount;
+@property (nonatomic, strong) NSError *error;
+@property (nonatomic, copy) TMJSONStreamParserElementBlock elementBlock;
+@property (nonatomic, copy) NSArray *keyPathComponents;
+@property (nonatomic, strong) NSMutableData *keyBuffer;
+@property (nonatomic, strong) NSMutableData *elementBuffer;
+
+@end
+
+@implementation TMJSONStreamParser {
+    TMJSONStreamFrame _frames[TMJSONStreamParserMaximumDepth];
+    NSUInteger _depth;
+    BOOL _inString;
+    BOOL _escaped;
+    BOOL _capturingKey;
+    BOOL _capturingElement;
+    BOOL _foundTarget;
+    BOOL _rootClosed;
+}
+
+- (id)initWithKeyPath:(NSString *)keyPath elementBlock:(TMJSONStreamParserElementBlock)elementBlock {
+    if (self = [super init]) {
+        self.keyPath = keyPath ?: @"";
+        self.elementBlock = elementBlock;
+        self.keyBuffer = [[NSMutableData alloc] init];
+        self.elementBuffer = [[NSMutableData alloc] init];
+
+        NSMutableArray *components = [NSMutableArray array];
+
+        for (NSString *component in [self.keyPath componentsSeparatedByString:@"."]) {
+            if ([component length]) {
+                [components addObject:[component dataUsingEncoding:NSUTF8StringEncoding]];
+            }
+        }
+
+        self.keyPathComponents = components;
+    }
+
+    return self;
+}
+
+- (BOOL)appendData:(NSData *)data {
+    __block BOOL succeeded = YES;
+
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        *stop = !(succeeded = [self appendBytes:bytes length:byteRange.length]);
+    }];
+
+    return succeeded;
+}
+
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length {
+    if (self.error) {
+        return NO;
+    }
+
+    const uint8_t *characters = bytes;
+    NSUInteger keyStart = 0;
+    NSUInteger elementStart = 0;
+    NSUInteger targetDepth = [self.keyPathComponents count] + 1;
+
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t character = characters[i];
+
+        if (_inString) {
+            if (_escaped) {
+                _escaped = NO;
+            } else if (character == '\\') {
+                _escaped = YES;
+            } else if (character == '"') {
+                _inString = NO;
+
+                if (_capturingKey) {
+                    [self.keyBuffer appendBytes:characters + keyStart length:i - keyStart];
+
+                    TMJSONStreamFrame *frame = &_frames[_depth - 1];
+                    frame->keyMatched = [self.keyBuffer isEqualToData:self.keyPathComponents[_depth - 1]];
+
+                    _capturingKey = NO;
+                }
+            }
+
+            continue;
+        }
+
+        if (character == ' ' || character == '\n' || character == '\r' || character == '\t') {
+            continue;
+        }
+
+        // Anything but a single object or array (e.g. an HTML error page) isn't a document this parser can read
+
+        if (!_depth && (_rootClosed || (character != '{' && character != '['))) {
+            return [self failWithDescription:@"Not a JSON object or array"];
+        }
+
+        TMJSONStreamFrame *top = _depth ? &_frames[_depth - 1] : NULL;
+        BOOL topIsTarget = _depth == targetDepth && top->type == '[' && top->onPath;
+
+        // An element of the target array ends at the next separator or closing bracket at the array's own depth
+
+        if (topIsTarget && _capturingElement && (character == ',' || character == ']')) {
+            [self.elementBuffer appendBytes:characters + elementStart length:i - elementStart];
+
+            if (![self emitElement]) {
+                return NO;
+            }
+        } else if (topIsTarget && !_capturingElement && character != ',' && character != ']') {
+            _capturingElement = YES;
+            elementStart = i;
+        }
+
+        switch (character) {
+            case '{':
+            case '[': {
+                if (_depth == TMJSONStreamParserMaximumDepth) {
+                    return [self failWithDescription:@"Maximum nesting depth exceeded"];
+                }
+
+                BOOL onPath = NO;
+
+                if (!top) {
+                    onPath = YES;
+                } else if (top->type == '{' && top->onPath && top->keyMatched) {
+                    onPath = YES;
+                }
+
+                TMJSONStreamFrame *frame = &_frames[_depth];
+                frame->type = character;
+                frame->onPath = onPath && _depth < targetDepth;
+                frame->expectingKey = character == '{';
+                frame->keyMatched = NO;
+
+                if (character == '[' && frame->onPath && _depth + 1 == targetDepth) {
+                    _foundTarget = YES;
+                }
+
+                _depth++;
+
+                break;
+            }
+
+            case '}':
+            case ']': {
+                if (!top || top->type != (character == '}' ? '{' : '[')) {
+                    return [self failWithDescription:@"Unbalanced closing bracket"];
+                }
+
+                _depth--;
+                _rootClosed = _depth == 0;
+
+                break;
+            }
+
+            case ',': {
+                if (top && top->type == '{') {
+                    top->expectingKey = YES;
+                }
+
+                break;
+            }
+
+            case '"': {
+                _inString = YES;
+
+                if (top && top->type == '{' && top->expectingKey) {
+                    top->expectingKey = NO;
+                    top->keyMatched = NO;
+
+                    // Only keys that could continue the key path are worth comparing
+
+                    if (top->onPath && _depth < targetDepth) {
+                        _capturingKey = YES;
+                        keyStart = i + 1;
+                        [self.keyBuffer setLength:0];
+                    }
+                }
+
+                break;
+            }
+
+            case ':':
+                break;
+
+            default: {
+                if (!TMJSONStreamParserLiteralBytes[character]) {
+                    return [self failWithDescription:@"Unexpected character"];
+                }
+
+                break;
+            }
+        }
+    }
+
+    if (_capturingKey) {
+        [self.keyBuffer appendBytes:characters + keyStart length:length - keyStart];
+    }
+
+    if (_capturingElement) {
+        [self.elementBuffer appendBytes:characters + elementStart length:length - elementStart];
+    }
+
+    self.byteCount += length;
+
+    return YES;
+}
+
+- (BOOL)finish {
+    if (self.error) {
+        return NO;
+    }
+
+    if (_depth || _inString || !_rootClosed) {
+        return [self failWithDescription:@"Unexpected end of document"];
+    }
+
+    // A document without the target array would otherwise look like one whose array is empty
+
+    if (!_foundTarget) {
+        return [self failWithDescription:@"Key path not found"];
+    }
+
+    return YES;
+}
+
+#pragma mark - Private
+
+- (BOOL)emitElement {
+    NSError *error = nil;
+
+    // The element's view keeps its bytes, so hand the buffer over rather than copying it
+
+    NSData *elementData = self.elementBuffer;
+    self.elementBuffer = [[NSMutableData alloc] init];
+    _capturingElement = NO;
+
+    id element = [TMJSONDecoder JSONObjectWithData:elementData error:&error];
+
+    if (!element) {
+        self.error = error;
+        return NO;
+    }
+
+    self.elementCount++;
+
+    if (self.elementBlock) {
+        self.elementBlock(element);
+    }
+
+    return YES;
+}
+
+- (BOOL)failWithDescription:(NSString *)description {
+    self.error = [NSError errorWithDomain:TMJSONStreamParserErrorDomain code:0
+                                 userInfo:@{ NSLocalizedDescriptionKey : description }];
+
+    return NO;
+}
+
+@end
@@ -18,4 +18,11 @@ NSDictionary *TMQueryStringToDictionary(NSString *query);
 
 NSString *TMDictionaryToQueryString(NSDictionary *dictionary);
 
+/// Appends the percent-encoded UTF-8 bytes of a string (or of an object's `stringValue`) to `data`.
+void TMAppendURLEncoded(NSMutableData *data, id value);
+
+/// Appends what `TMURLEncode(TMDictionaryToQueryString(dictionary))` would return to `data`, without building either
+/// intermediate string. This is the parameter part of an OAuth signature base string.
+void TMAppendURLEncodedQueryString(NSMutableData *data, NSDictionary *dictionary);
+
 @end
@@ -8,39 +8,404 @@
 
 #import "TMSDKFunctions.h"
 
+/*
+ Queries are tokenized and encoded over their UTF-8 bytes instead of being split into strings and run through
+ CoreFoundation piece by piece. Anything CoreFoundation might treat differently (raw non-ASCII bytes, malformed
+ escapes, keys that only differ by case) falls back to it, so the results are exactly the same.
+ */
+
+static const bool TMURLUnreservedBytes[256] = {
+    ['A' ... 'Z'] = true, ['a' ... 'z'] = true, ['0' ... '9'] = true,
+    ['-'] = true, ['.'] = true, ['_'] = true, ['~'] = true
+};
+
+static const char TMURLHexDigits[] = "0123456789ABCDEF";
+
+#define TMStackArenaLength 512
+
+typedef struct {
+    uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger capacity;
+} TMByteBuffer;
+
+typedef struct {
+    __unsafe_unretained NSString *key;
+    const uint8_t *bytes;
+    NSUInteger length;
+} TMSortKey;
+
+#pragma mark - Buffer
+
+static void TMByteBufferReserve(TMByteBuffer *buffer, NSUInteger length) {
+    if (buffer->length + length <= buffer->capacity)
+        return;
+
+    NSUInteger capacity = MAX(MAX(buffer->capacity * 2, buffer->length + length), (NSUInteger)128);
+
+    buffer->bytes = reallocf(buffer->bytes, capacity);
+    buffer->capacity = buffer->bytes ? capacity : 0;
+
+    if (!buffer->bytes)
+        buffer->length = 0;
+}
+
+static void TMByteBufferAppend(TMByteBuffer *buffer, const void *bytes, NSUInteger length) {
+    TMByteBufferReserve(buffer, length);
+
+    if (buffer->bytes) {
+        memcpy(buffer->bytes + buffer->length, bytes, length);
+        buffer->length += length;
+    }
+}
+
+// Encoding twice escapes the `%` of every escape again, as if the encoded bytes were run through a second time
+static void TMByteBufferAppendEncodedBytes(TMByteBuffer *buffer, const uint8_t *bytes, NSUInteger length,
+                                           BOOL encodeTwice) {
+    TMByteBufferReserve(buffer, length * (encodeTwice ? 5 : 3));
+
+    if (!buffer->bytes)
+        return;
+
+    uint8_t *output = buffer->bytes + buffer->length;
+
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t byte = bytes[i];
+
+        if (TMURLUnreservedBytes[byte]) {
+            *output++ = byte;
+        } else {
+            *output++ = '%';
+
+            if (encodeTwice) {
+                *output++ = '2';
+                *output++ = '5';
+            }
+
+            *output++ = TMURLHexDigits[byte >> 4];
+            *output++ = TMURLHexDigits[byte & 0x0F];
+        }
+    }
+
+    buffer->length = output - buffer->bytes;
+}
+
+// NO if the string isn't valid UTF-16, in which case CoreFoundation doesn't encode it either
+static BOOL TMByteBufferAppendEncodedString(TMByteBuffer *buffer, NSString *string, BOOL encodeTwice) {
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(cfString);
+
+    if (!length)
+        return YES;
+
+    const char *cString = CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8);
+
+    if (cString) {
+        TMByteBufferAppendEncodedBytes(buffer, (const uint8_t *)cString, (NSUInteger)length, encodeTwice);
+        return YES;
+    }
+
+    uint8_t stackBytes[TMStackArenaLength];
+    CFIndex maxLength = length * 3;
+    uint8_t *bytes = maxLength <= (CFIndex)sizeof(stackBytes) ? stackBytes : malloc(maxLength);
+    CFIndex usedLength = 0;
+
+    CFIndex convertedLength = CFStringGetBytes(cfString, CFRangeMake(0, length), kCFStringEncodingUTF8, 0, false, bytes,
+                                               maxLength, &usedLength);
+
+    if (convertedLength == length)
+        TMByteBufferAppendEncodedBytes(buffer, bytes, (NSUInteger)usedLength, encodeTwice);
+
+    if (bytes != stackBytes)
+        free(bytes);
+
+    return convertedLength == length;
+}
+
+// The literal text around encoded values is only encoded once when the values are encoded twice
+static void TMByteBufferAppendLiteral(TMByteBuffer *buffer, const char *literal, BOOL encodeTwice) {
+    if (encodeTwice)
+        TMByteBufferAppendEncodedBytes(buffer, (const uint8_t *)literal, strlen(literal), NO);
+    else
+        TMByteBufferAppend(buffer, literal, strlen(literal));
+}
+
+static void TMByteBufferAppendEncodedValue(TMByteBuffer *buffer, id value, BOOL encodeTwice) {
+    NSString *string = [value isKindOfClass:[NSString class]] ? value : [value stringValue];
+
+    if (!TMByteBufferAppendEncodedString(buffer, string, encodeTwice))
+        TMByteBufferAppendLiteral(buffer, "(null)", encodeTwice);
+}
+
+static void TMByteBufferAppendParameter(TMByteBuffer *buffer, NSString *key, id value, BOOL encodeTwice) {
+    if (buffer->length)
+        TMByteBufferAppendLiteral(buffer, "&", encodeTwice);
+
+    TMByteBufferAppendEncodedValue(buffer, key, encodeTwice);
+    TMByteBufferAppendLiteral(buffer, "=", encodeTwice);
+    TMByteBufferAppendEncodedValue(buffer, value, encodeTwice);
+}
+
+static void TMByteBufferAppendToData(TMByteBuffer *buffer, NSMutableData *data) {
+    if (buffer->length)
+        [data appendBytes:buffer->bytes length:buffer->length];
+
+    free(buffer->bytes);
+}
+
+static NSString *TMByteBufferString(TMByteBuffer *buffer) {
+    if (!buffer->length) {
+        free(buffer->bytes);
+        return @"";
+    }
+
+    return [[NSString alloc] initWithBytesNoCopy:buffer->bytes length:buffer->length encoding:NSASCIIStringEncoding
+                                    freeWhenDone:YES];
+}
+
+#pragma mark - Decoding
+
+static int TMHexDigitValue(uint8_t byte) {
+    if (byte >= '0' && byte <= '9')
+        return byte - '0';
+    if (byte >= 'A' && byte <= 'F')
+        return byte - 'A' + 10;
+    if (byte >= 'a' && byte <= 'f')
+        return byte - 'a' + 10;
+    return -1;
+}
+
+// Decodes into the arena, which must hold `length` bytes. nil if CoreFoundation should decide what the bytes mean.
+static NSString *TMCreateDecodedString(const uint8_t *bytes, NSUInteger length, uint8_t *arena) {
+    NSUInteger decodedLength = 0;
+
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t byte = bytes[i];
+
+        if (byte >= 0x80)
+            return nil;
+
+        if (byte == '%') {
+            int high = i + 2 < length ? TMHexDigitValue(bytes[i + 1]) : -1;
+            int low = i + 2 < length ? TMHexDigitValue(bytes[i + 2]) : -1;
+
+            if (high < 0 || low < 0)
+                return nil;
+
+            byte = (uint8_t)(high << 4 | low);
+            i += 2;
+        }
+
+        arena[decodedLength++] = byte;
+    }
+
+    // A byte order mark could be dropped by the conversion
+    if (decodedLength >= 3 && arena[0] == 0xEF && arena[1] == 0xBB && arena[2] == 0xBF)
+        return nil;
+
+    return (__bridge_transfer NSString *)CFStringCreateWithBytes(NULL, arena, decodedLength, kCFStringEncodingUTF8, false);
+}
+
+static NSString *TMDecodedStringFromBytes(const uint8_t *bytes, NSUInteger length, uint8_t *arena) {
+    NSString *string = TMCreateDecodedString(bytes, length, arena);
+
+    if (string)
+        return string;
+
+    NSString *encodedString = (__bridge_transfer NSString *)CFStringCreateWithBytes(NULL, bytes, length,
+                                                                                    kCFStringEncodingUTF8, false);
+    return TMURLDecode(encodedString);
+}
+
+#pragma mark - Sorting
+
+static uint8_t TMLowercaseByte(uint8_t byte) {
+    return byte >= 'A' && byte <= 'Z' ? byte + ('a' - 'A') : byte;
+}
+
+static int TMCompareSortKeys(const void *a, const void *b) {
+    const TMSortKey *keyA = a;
+    const TMSortKey *keyB = b;
+    NSUInteger length = MIN(keyA->length, keyB->length);
+
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t byteA = TMLowercaseByte(keyA->bytes[i]);
+        uint8_t byteB = TMLowercaseByte(keyB->bytes[i]);
+
+        if (byteA != byteB)
+            return byteA < byteB ? -1 : 1;
+    }
+
+    if (keyA->length == keyB->length)
+        return 0;
+
+    return keyA->length < keyB->length ? -1 : 1;
+}
+
+// nil unless every key is ASCII and no two differ only by case, which caseInsensitiveCompare: sorts the same way
+static NSArray *TMBytewiseSortedKeys(NSArray *keys) {
+    NSUInteger count = keys.count;
+    NSUInteger totalLength = 0;
+
+    for (NSString *key in keys) {
+        if (![key isKindOfClass:[NSString class]])
+            return nil;
+
+        totalLength += key.length;
+    }
+
+    TMSortKey *sortKeys = malloc(count * sizeof(TMSortKey));
+    uint8_t *keyBytes = malloc(MAX(totalLength, (NSUInteger)1));
+    NSUInteger offset = 0;
+    NSUInteger index = 0;
+    BOOL sortable = YES;
+
+    for (NSString *key in keys) {
+        CFIndex length = CFStringGetLength((__bridge CFStringRef)key);
+        CFIndex usedLength = 0;
+
+        CFStringGetBytes((__bridge CFStringRef)key, CFRangeMake(0, length), kCFStringEncodingASCII, 0, false,
+                         keyBytes + offset, length, &usedLength);
+
+        if (usedLength != length) {
+            sortable = NO;
+            break;
+        }
+
+        sortKeys[index++] = (TMSortKey){ key, keyBytes + offset, (NSUInteger)length };
+        offset += length;
+    }
+
+    NSMutableArray *sortedKeys = nil;
+
+    if (sortable) {
+        qsort(sortKeys, count, sizeof(TMSortKey), TMCompareSortKeys);
+
+        for (NSUInteger i = 1; sortable && i < count; i++)
+            sortable = TMCompareSortKeys(&sortKeys[i - 1], &sortKeys[i]) != 0;
+    }
+
+    if (sortable) {
+        sortedKeys = [[NSMutableArray alloc] initWithCapacity:count];
+
+        for (NSUInteger i = 0; i < count; i++)
+            [sortedKeys addObject:sortKeys[i].key];
+    }
+
+    free(sortKeys);
+    free(keyBytes);
+
+    return sortedKeys;
+}
+
+static NSArray *TMSortedKeys(NSDictionary *dictionary) {
+    NSArray *keys = [dictionary allKeys];
+
+    if (keys.count < 2)
+        return keys;
+
+    return TMBytewiseSortedKeys(keys) ?: [keys sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)];
+}
+
+#pragma mark - Query Strings
+
+static void TMByteBufferAppendQueryString(TMByteBuffer *buffer, NSDictionary *dictionary, BOOL encodeTwice) {
+    for (NSString *key in TMSortedKeys(dictionary)) {
+        id value = dictionary[key];
+
+        if ([value isKindOfClass:[NSArray class]]) {
+            for (NSString *arrayValue in (NSArray *)value)
+                TMByteBufferAppendParameter(buffer, key, arrayValue, encodeTwice);
+        } else
+            TMByteBufferAppendParameter(buffer, key, value, encodeTwice);
+    }
+}
+
 @implementation TMSDKFunctions
 
 NSString *TMURLDecode(NSString *string) {
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    const char *cString = cfString ? CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8) : NULL;
+
+    if (cString) {
+        NSUInteger length = (NSUInteger)CFStringGetLength(cfString);
+        uint8_t stackArena[TMStackArenaLength];
+        uint8_t *arena = length <= sizeof(stackArena) ? stackArena : malloc(length);
+
+        NSString *decodedString = TMCreateDecodedString((const uint8_t *)cString, length, arena);
+
+        if (arena != stackArena)
+            free(arena);
+
+        if (decodedString)
+            return decodedString;
+    }
+
     return (NSString *)CFBridgingRelease(CFURLCreateStringByReplacingPercentEscapes(NULL, (CFStringRef)string,
                                                                                     CFSTR("")));
 }
 
 NSString *TMURLEncode(id value) {
     NSString *string;
-    
+
     if ([value isKindOfClass:[NSString class]])
         string = (NSString *)value;
     else
         string = [value stringValue];
-    
-    return (NSString *)CFBridgingRelease(CFURLCreateStringByAddingPercentEscapes(NULL, (CFStringRef)string, NULL,
-                                                                                 CFSTR("!*'();:@&=+$,/?%#[]%"), kCFStringEncodingUTF8));
+
+    TMByteBuffer buffer = { NULL, 0, 0 };
+
+    if (!TMByteBufferAppendEncodedString(&buffer, string, NO)) {
+        free(buffer.bytes);
+        return nil;
+    }
+
+    return TMByteBufferString(&buffer);
 }
 
 NSDictionary *TMQueryStringToDictionary(NSString *query) {
     NSMutableDictionary *mutableParameterDictionary = [[NSMutableDictionary alloc] init];
-    
-    NSArray *parameters = [query componentsSeparatedByString:@"&"];
-    
-    for (NSString *parameter in parameters) {
-        NSArray *keyValuePair = [parameter componentsSeparatedByString:@"="];
-        
-        if (keyValuePair.count == 2) {
-            NSString *key = TMURLDecode(keyValuePair[0]);
-            NSString *value = TMURLDecode(keyValuePair[1]);
-            
+
+    CFStringRef cfQuery = (__bridge CFStringRef)query;
+    CFIndex queryLength = cfQuery ? CFStringGetLength(cfQuery) : 0;
+
+    const uint8_t *bytes = cfQuery ? (const uint8_t *)CFStringGetCStringPtr(cfQuery, kCFStringEncodingUTF8) : NULL;
+    uint8_t *copiedBytes = NULL;
+    NSUInteger length = (NSUInteger)queryLength;
+
+    if (!bytes && queryLength) {
+        CFIndex usedLength = 0;
+        copiedBytes = malloc(queryLength * 3);
+        CFStringGetBytes(cfQuery, CFRangeMake(0, queryLength), kCFStringEncodingUTF8, '?', false, copiedBytes,
+                         queryLength * 3, &usedLength);
+
+        bytes = copiedBytes;
+        length = (NSUInteger)usedLength;
+    }
+
+    // Every key and value is decoded into the same arena, nothing decodes to more bytes than it started with
+    uint8_t stackArena[TMStackArenaLength];
+    uint8_t *arena = length <= sizeof(stackArena) ? stackArena : malloc(length);
+
+    NSUInteger parameterStart = 0;
+
+    while (bytes && parameterStart <= length) {
+        const uint8_t *parameterEnd = memchr(bytes + parameterStart, '&', length - parameterStart);
+        NSUInteger parameterLength = parameterEnd ? (NSUInteger)(parameterEnd - bytes) - parameterStart
+                                                  : length - parameterStart;
+        const uint8_t *parameter = bytes + parameterStart;
+
+        // Exactly one `=`, anything else isn't a key/value pair
+        const uint8_t *separator = memchr(parameter, '=', parameterLength);
+
+        if (separator && !memchr(separator + 1, '=', parameter + parameterLength - separator - 1)) {
+            NSUInteger keyLength = (NSUInteger)(separator - parameter);
+
+            NSString *key = TMDecodedStringFromBytes(parameter, keyLength, arena);
+            NSString *value = TMDecodedStringFromBytes(separator + 1, parameterLength - keyLength - 1, arena);
+
             id existingValueForKey = mutableParameterDictionary[key];
-            
+
             if (existingValueForKey) {
                 if ([existingValueForKey isKindOfClass:[NSMutableArray class]])
                     [(NSMutableArray *)existingValueForKey addObject:value];
@@ -50,29 +415,35 @@ NSDictionary *TMQueryStringToDictionary(NSString *query) {
             } else
                 [mutableParameterDictionary setObject:value forKey:key];
         }
+
+        parameterStart += parameterLength + 1;
     }
-    
+
+    if (arena != stackArena)
+        free(arena);
+
+    free(copiedBytes);
+
     return [NSDictionary dictionaryWithDictionary:mutableParameterDictionary];
 }
 
 NSString *TMDictionaryToQueryString(NSDictionary *dictionary) {
-    NSMutableArray *parameters = [NSMutableArray array];
-    
-    void (^addParameter)(NSString *key, NSString *value) = ^(NSString *key, NSString *value) {
-        [parameters addObject:[NSString stringWithFormat:@"%@=%@", TMURLEncode(key), TMURLEncode(value)]];
-    };
-    
-    for (NSString *key in [[dictionary allKeys] sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)]) {
-        id value = dictionary[key];
-        
-        if ([value isKindOfClass:[NSArray class]]) {
-            for (NSString *arrayValue in (NSArray *)value)
-                addParameter(key, arrayValue);
-        } else
-            addParameter(key, value);
-    }
-    
-    return [parameters componentsJoinedByString:@"&"];
+    TMByteBuffer buffer = { NULL, 0, 0 };
+    TMByteBufferAppendQueryString(&buffer, dictionary, NO);
+
+    return TMByteBufferString(&buffer);
+}
+
+void TMAppendURLEncoded(NSMutableData *data, id value) {
+    TMByteBuffer buffer = { NULL, 0, 0 };
+    TMByteBufferAppendEncodedValue(&buffer, value, NO);
+    TMByteBufferAppendToData(&buffer, data);
+}
+
+void TMAppendURLEncodedQueryString(NSMutableData *data, NSDictionary *dictionary) {
+    TMByteBuffer buffer = { NULL, 0, 0 };
+    TMByteBufferAppendQueryString(&buffer, dictionary, YES);
+    TMByteBufferAppendToData(&buffer, data);
 }
 
 @end